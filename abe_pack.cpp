@@ -0,0 +1,269 @@
+////////////////////////////////////////////////////////////////////////////////
+// ABE mesh packer: converts an ABE v100 mesh to v101, i.e. with an index buffer
+// by rend::encodeIndexBuffer; vertices get reordered by first use in the index
+// buffer, which is what the codec thrives on; the result gets decoded back and
+// verified, and the decode gets timed
+//
+// build as: $ g++ -O3 abe_pack.cpp rendIndexCodec.cpp
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <vector>
+
+#include "timer.h"
+#include "rendIndexCodec.hpp"
+
+// reader of an in-memory file
+struct Cursor
+{
+	const uint8_t* pos;
+	const uint8_t* end;
+
+	template < typename T >
+	bool read(T& out)
+	{
+		if (size_t(end - pos) < sizeof(out))
+			return false;
+
+		memcpy(&out, pos, sizeof(out));
+		pos += sizeof(out);
+		return true;
+	}
+
+	const uint8_t* take(const size_t span)
+	{
+		if (size_t(end - pos) < span)
+			return 0;
+
+		const uint8_t* const start = pos;
+		pos += span;
+		return start;
+	}
+};
+
+template < typename T >
+static void put(
+	std::vector< uint8_t >& out,
+	const T& val)
+{
+	out.insert(out.end(),
+		reinterpret_cast< const uint8_t* >(&val),
+		reinterpret_cast< const uint8_t* >(&val) + sizeof(val));
+}
+
+static bool load(
+	const char* const filename,
+	std::vector< uint8_t >& content)
+{
+	FILE* const file = fopen(filename, "rb");
+
+	if (0 == file)
+		return false;
+
+	fseek(file, 0, SEEK_END);
+	const long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	content.resize(size_t(size));
+	const bool success = 0 < size && 1 == fread(&content.front(), content.size(), 1, file);
+	fclose(file);
+
+	return success;
+}
+
+int main(
+	int argc,
+	char** argv)
+{
+	if (3 != argc) {
+		fprintf(stderr, "usage: %s <input_v100.mesh> <output_v101.mesh>\n", argv[0]);
+		return -1;
+	}
+
+	std::vector< uint8_t > content;
+
+	if (!load(argv[1], content)) {
+		fprintf(stderr, "error: failure reading '%s'\n", argv[1]);
+		return -1;
+	}
+
+	static const uint32_t sMagic = 0x6873656d;
+	static const uint32_t sVersion = 100;
+	static const uint32_t sVersionIndexCodec = 101;
+
+	Cursor in = { &content.front(), &content.front() + content.size() };
+	uint32_t magic, version;
+	uint8_t softwareSkinning;
+	uint16_t primitiveType, num_attr;
+
+	if (!in.read(magic) || !in.read(version) || magic != sMagic || version != sVersion ||
+		!in.read(softwareSkinning) || !in.read(primitiveType) || !in.read(num_attr) ||
+		0 == in.take(sizeof(uint16_t[5]) * num_attr)) {
+
+		fprintf(stderr, "error: '%s' is not an ABE v%u mesh\n", argv[1], sVersion);
+		return -1;
+	}
+
+	const uint8_t* const attr_end = in.pos;
+	uint32_t num_vertices;
+	uint16_t num_buffers;
+
+	if (!in.read(num_vertices) || !in.read(num_buffers)) {
+		fprintf(stderr, "error: truncated mesh\n");
+		return -1;
+	}
+
+	struct Buffer {
+		uint16_t bind_index;
+		uint16_t vertex_size;
+		const uint8_t* data;
+	};
+	std::vector< Buffer > buffer(num_buffers);
+
+	for (size_t i = 0; i < num_buffers; ++i) {
+		if (!in.read(buffer[i].bind_index) || !in.read(buffer[i].vertex_size) ||
+			0 == (buffer[i].data = in.take(size_t(buffer[i].vertex_size) * num_vertices))) {
+
+			fprintf(stderr, "error: truncated mesh\n");
+			return -1;
+		}
+	}
+
+	uint16_t index_format;
+	uint32_t num_indices;
+
+	if (!in.read(index_format) || !in.read(num_indices) || 1 < index_format) {
+		fprintf(stderr, "error: truncated mesh or unsupported index buffer\n");
+		return -1;
+	}
+
+	const size_t sizeof_index = 0 == index_format ? sizeof(uint16_t) : sizeof(uint32_t);
+	const uint8_t* const raw_index = in.take(sizeof_index * num_indices);
+
+	if (0 == raw_index || 0 == num_indices || 0 != num_indices % 3) {
+		fprintf(stderr, "error: truncated mesh or unsupported index buffer\n");
+		return -1;
+	}
+
+	const uint8_t* const tail = in.pos; // bounds
+	const size_t sizeof_tail = size_t(in.end - in.pos);
+
+	// reorder vertices by first use
+	std::vector< uint32_t > index(num_indices);
+	std::vector< uint32_t > remap(num_vertices, uint32_t(-1));
+	std::vector< uint32_t > order;
+	order.reserve(num_vertices);
+
+	for (size_t i = 0; i < num_indices; ++i) {
+		uint32_t idx = 0;
+		memcpy(&idx, raw_index + i * sizeof_index, sizeof_index);
+
+		if (num_vertices <= idx) {
+			fprintf(stderr, "error: out-of-bounds index\n");
+			return -1;
+		}
+
+		if (uint32_t(-1) == remap[idx]) {
+			remap[idx] = uint32_t(order.size());
+			order.push_back(idx);
+		}
+
+		index[i] = remap[idx];
+	}
+
+	// unreferenced vertices go last
+	for (uint32_t i = 0; i < num_vertices; ++i)
+		if (uint32_t(-1) == remap[i])
+			order.push_back(i);
+
+	std::vector< uint8_t > encoded;
+	rend::encodeIndexBuffer(encoded, &index.front(), index.size());
+
+	// verify the round trip, as triangles modulo rotation, and time the decode
+	std::vector< uint8_t > decoded(sizeof_index * num_indices);
+	uint64_t best = uint64_t(-1);
+
+	for (unsigned r = 0; r < 16; ++r) {
+		const uint64_t t0 = timer_ns();
+
+		if (!rend::decodeIndexBuffer(&decoded.front(), num_indices, sizeof_index, &encoded.front(), encoded.size())) {
+			fprintf(stderr, "error: decode failure\n");
+			return -1;
+		}
+
+		const uint64_t dt = timer_ns() - t0;
+
+		if (dt < best)
+			best = dt;
+	}
+
+	for (size_t i = 0; i < num_indices; i += 3) {
+		uint32_t tri[3] = { 0, 0, 0 };
+		memcpy(tri + 0, &decoded[(i + 0) * sizeof_index], sizeof_index);
+		memcpy(tri + 1, &decoded[(i + 1) * sizeof_index], sizeof_index);
+		memcpy(tri + 2, &decoded[(i + 2) * sizeof_index], sizeof_index);
+
+		bool match = false;
+
+		for (unsigned r = 0; r < 3 && !match; ++r)
+			match = tri[0] == index[i + r] && tri[1] == index[i + (r + 1) % 3] && tri[2] == index[i + (r + 2) % 3];
+
+		if (!match) {
+			fprintf(stderr, "error: round-trip mismatch at face %u\n", unsigned(i / 3));
+			return -1;
+		}
+	}
+
+	// compose the output
+	std::vector< uint8_t > out;
+	put(out, magic);
+	put(out, sVersionIndexCodec);
+	out.insert(out.end(), static_cast< const uint8_t* >(&content.front()) + sizeof(magic) + sizeof(version), attr_end);
+	put(out, num_vertices);
+	put(out, num_buffers);
+
+	for (size_t i = 0; i < num_buffers; ++i) {
+		put(out, buffer[i].bind_index);
+		put(out, buffer[i].vertex_size);
+
+		for (size_t j = 0; j < num_vertices; ++j)
+			out.insert(out.end(),
+				buffer[i].data + order[j] * buffer[i].vertex_size,
+				buffer[i].data + order[j] * buffer[i].vertex_size + buffer[i].vertex_size);
+	}
+
+	put(out, index_format);
+	put(out, num_indices);
+	put(out, uint32_t(encoded.size()));
+	out.insert(out.end(), encoded.begin(), encoded.end());
+	out.insert(out.end(), tail, tail + sizeof_tail);
+
+	FILE* const file = fopen(argv[2], "wb");
+
+	if (0 == file || 1 != fwrite(&out.front(), out.size(), 1, file)) {
+		fprintf(stderr, "error: failure writing '%s'\n", argv[2]);
+
+		if (0 != file)
+			fclose(file);
+
+		return -1;
+	}
+
+	fclose(file);
+
+	const size_t sizeof_ib = sizeof_index * num_indices;
+
+	fprintf(stdout,
+		"faces: %u\n"
+		"index data: %zu -> %zu bytes (%.2fx, %.2f bits per face)\n"
+		"file: %zu -> %zu bytes\n"
+		"decode: %.3f ms (%.1f MB/s of index data)\n",
+		num_indices / 3,
+		sizeof_ib, encoded.size(), double(sizeof_ib) / encoded.size(), encoded.size() * 8. / (num_indices / 3),
+		content.size(), out.size(),
+		best * 1e-6, sizeof_ib / (best * 1e-9) / (1 << 20));
+
+	return 0;
+}
@@ -20,6 +20,7 @@
 #include "stream.hpp"
 #include "util_tex.hpp"
 #include "util_misc.hpp"
+#include "util_preload.hpp"
 #include "pure_macro.hpp"
 
 #include "rendVertAttr.hpp"
@@ -184,6 +185,8 @@ bool deinit_resources()
 	if (!check_context(__FUNCTION__))
 		return false;
 
+	util::shared_file_preload().drop();
+
 	for (unsigned i = 0; i < sizeof(g_shader_prog) / sizeof(g_shader_prog[0]); ++i)
 	{
 		glDeleteProgram(g_shader_prog[i]);
@@ -270,6 +273,16 @@ bool init_resources(
 #endif
 	scoped_ptr< deinit_resources_t, scoped_functor > on_error(deinit_resources);
 
+	/////////////////////////////////////////////////////////////////
+	// have the reads of the assets below go out together; the loaders map them, so warm the page cache
+
+	const char* const asset[] = {
+		"asset/shader/conic.glslv",
+		"asset/shader/conic.glslf"
+	};
+
+	util::shared_file_preload().warm(asset, sizeof(asset) / sizeof(asset[0]));
+
 	/////////////////////////////////////////////////////////////////
 
 	glEnable(GL_CULL_FACE);
@@ -377,6 +390,9 @@ bool init_resources(
 	glBindVertexArrayOES(0);
 
 #endif
+	// assets not taken by now are not going to be
+	util::shared_file_preload().drop();
+
 	on_error.reset();
 	return true;
 }
@@ -15,8 +15,10 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <cmath>
+#include <algorithm>
 #include <string>
 #include <sstream>
+#include <vector>
 
 #include "scoped.hpp"
 #include "stream.hpp"
@@ -24,9 +26,14 @@
 #include "rendIndexedTrilist.hpp"
 #include "rendSkeleton.hpp"
 #include "util_misc.hpp"
+#include "util_preload.hpp"
 #include "pure_macro.hpp"
 
 #include "rendVertAttr.hpp"
+#include "rendVertQuant.hpp"
+#include "rendCluster.hpp"
+#include "rendLod.hpp"
+#include "rendMeshPager.hpp"
 
 using util::scoped_ptr;
 using util::scoped_functor;
@@ -40,10 +47,18 @@ namespace { // anonymous
 #include "rendVertAttr_setupVertAttrPointers.hpp"
 #undef SETUP_VERTEX_ATTR_POINTERS_MASK
 
+// quantized vertex: snorm16 position in the quantization domain of the mesh
 struct Vertex {
-	GLfloat pos[3];
+	GLshort pos[4];
 };
 
+const rend::VertexFormat& getVertexFormat()
+{
+	static rend::VertexFormat format;
+	format.pos = rend::AttrFormat(3, GL_SHORT, GL_TRUE);
+	return format;
+}
+
 } // namespace
 
 namespace { // anonymous
@@ -54,12 +69,38 @@ const char arg_app[]       = "app";
 const char arg_anim_step[] = "anim_step";
 const char arg_mesh[]      = "mesh";
 const char arg_rot_axes[]  = "rot_axes";
+const char arg_cluster[]   = "cluster";
+const char arg_lod[]       = "lod";
+const char arg_batch16[]   = "batch16";
+const char arg_paged[]     = "paged";
 
 const char* g_mesh_filename = "asset/mesh/tetra.mesh";
 float g_angle;
 float g_angle_step = .0125f;
 float g_rot_axis[] = { 1.f, 1.f, 1.f };
 simd::matx4 g_matx_fit;
+simd::matx4 g_matx_dequant;
+
+rend::ClusterSet g_cluster_set(0);
+std::vector< rend::DrawRange > g_draw_range;
+
+rend::LodChain g_lod_chain(0);
+float g_lod_pixel_error = 1.f;
+unsigned g_lod_first_face[rend::LodChain::max_levels];
+unsigned g_lod_num_faces[rend::LodChain::max_levels];
+
+// draw list of a mesh split into batches of 16-bit indices
+util::TrilistBatches g_batches;
+bool g_batch16;
+
+// out-of-core mesh, paged in by chunks through a pool of GL buffers
+const char* g_paged_filename;
+unsigned g_paged_pool;
+rend::MeshPager g_pager;
+std::vector< rend::PagedDraw > g_paged_draw;
+
+float g_bound_centre[3];
+float g_bound_radius;
 
 #if PLATFORM_EGL
 EGLDisplay g_display = EGL_NO_DISPLAY;
@@ -92,6 +133,7 @@ enum {
 enum {
 	VBO_SKIN_VTX,
 	VBO_SKIN_IDX,
+	VBO_SKIN_LOD_IDX,
 
 	VBO_COUNT,
 	VBO_FORCE_UINT = -1U
@@ -109,6 +151,7 @@ GLuint g_shader_frag[PROG_COUNT];
 GLuint g_shader_prog[PROG_COUNT];
 
 unsigned g_num_faces[MESH_COUNT];
+unsigned g_num_verts[MESH_COUNT];
 GLenum g_index_type;
 
 rend::ActiveAttrSemantics g_active_attr_semantics[PROG_COUNT];
@@ -161,14 +204,50 @@ int parse_cli(
 			return 3;
 		}
 	}
+	else
+	if (i + 1 < argc && !strcmp(argv[i], arg_cluster)) {
+		if (1 == sscanf(argv[i + 1], "%u", &g_cluster_set.max_faces)) {
+			return 1;
+		}
+	}
+	else
+	if (i + 2 < argc && !strcmp(argv[i], arg_lod)) {
+		if (1 == sscanf(argv[i + 1], "%u", &g_lod_chain.num_levels) && rend::LodChain::max_levels >= g_lod_chain.num_levels &&
+			1 == sscanf(argv[i + 2], "%f", &g_lod_pixel_error) && 0.f < g_lod_pixel_error) {
+			return 2;
+		}
+	}
+	else
+	if (!strcmp(argv[i], arg_batch16)) {
+		g_batch16 = true;
+		return 0;
+	}
+	else
+	if (i + 2 < argc && !strcmp(argv[i], arg_paged)) {
+		if (1 == sscanf(argv[i + 2], "%u", &g_paged_pool) && 0 != g_paged_pool) {
+			g_paged_filename = argv[i + 1];
+			return 2;
+		}
+	}
 
 	stream::cerr << "app options:\n"
 		"\t" << arg_prefix << arg_app << " " << arg_mesh <<
-		" <filename>\t\t\t\t: use specified mesh file of coordinates and indices\n"
+		" <filename>\t\t\t\t: use specified mesh file of coordinates and indices, or binary PLY scan (*.ply)\n"
 		"\t" << arg_prefix << arg_app << " " << arg_anim_step <<
 		" <step>\t\t\t\t: use specified animation step; entire animation is 1.0\n"
 		"\t" << arg_prefix << arg_app << " " << arg_rot_axes <<
-		" <int> <int> <int>\t\t\t: rotate mesh around the specified mask for x, y and z axes; default is 1 1 1 -- all axes\n\n";
+		" <int> <int> <int>\t\t\t: rotate mesh around the specified mask for x, y and z axes; default is 1 1 1 -- all axes\n"
+		"\t" << arg_prefix << arg_app << " " << arg_cluster <<
+		" <n>\t\t\t\t\t: split mesh into clusters of up to n faces, culled per frame; default is 0 -- no clusters\n"
+		"\t" << arg_prefix << arg_app << " " << arg_lod <<
+		" <n> <pixels>\t\t\t\t: generate n (up to " << unsigned(rend::LodChain::max_levels) <<
+		") LOD levels, selected per frame by projected error in pixels; default is 0 -- no LODs\n"
+		"\t" << arg_prefix << arg_app << " " << arg_batch16 <<
+		"\t\t\t\t\t: split meshes beyond 16-bit indices into batches of 16-bit indices, even when 32-bit indices\n"
+		"\t\t\t\t\t\t\t  are supported; LODs are not available with batches\n"
+		"\t" << arg_prefix << arg_app << " " << arg_paged <<
+		" <filename> <n>\t\t\t: page in the specified paged mesh by chunks through a pool of n chunks, in place\n"
+		"\t\t\t\t\t\t\t  of the mesh file; clusters and LODs do not apply\n\n";
 
 	return -1;
 }
@@ -199,12 +278,81 @@ bool check_context(
 
 } // namespace
 
+namespace { // anonymous
+
+bool isPLY(
+	const char* const filename)
+{
+	const size_t len = strlen(filename);
+	return len > 4 && !strcmp(filename + len - 4, ".ply");
+}
+
+// load-time mesh processing: clusterize, then build LODs over the clustered faces
+bool filterMesh(
+	void* const,
+	const float* const vertex,
+	const unsigned floats_per_vertex,
+	const unsigned num_verts,
+	uint32_t* const index,
+	const unsigned num_faces)
+{
+	if (g_cluster_set.max_faces &&
+		!rend::clusterizeTrilist(g_cluster_set, vertex, floats_per_vertex, num_verts, index, num_faces)) {
+
+		stream::cerr << __FUNCTION__ << " failed at clusterizeTrilist\n";
+		return false;
+	}
+
+	if (g_lod_chain.num_levels &&
+		!rend::buildLodChain(g_lod_chain, vertex, floats_per_vertex, num_verts, index, num_faces)) {
+
+		stream::cerr << __FUNCTION__ << " failed at buildLodChain\n";
+		return false;
+	}
+
+	return true;
+}
+
+// upload all LOD levels to a single index buffer of the specified index type, releasing the
+// CPU copies of the levels
+template < typename INDEX_T >
+bool uploadLodChain(
+	const GLuint vbo_idx)
+{
+	std::vector< INDEX_T > index;
+	unsigned num_faces = 0;
+
+	for (unsigned i = 0; i < g_lod_chain.num_levels; ++i) {
+		std::vector< uint32_t >& level = g_lod_chain.level[i].index;
+
+		g_lod_first_face[i] = num_faces;
+		g_lod_num_faces[i] = level.size() / 3;
+		num_faces += g_lod_num_faces[i];
+
+		index.insert(index.end(), level.begin(), level.end());
+		std::vector< uint32_t >().swap(level);
+	}
+
+	if (index.empty())
+		return true;
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo_idx);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(INDEX_T) * index.size(), &index.front(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	return !util::reportGLError();
+}
+
+} // namespace
+
 bool
 hook::deinit_resources()
 {
 	if (!check_context(__FUNCTION__))
 		return false;
 
+	util::shared_file_preload().drop();
+
 	for (unsigned i = 0; i < sizeof(g_shader_prog) / sizeof(g_shader_prog[0]); ++i) {
 		glDeleteProgram(g_shader_prog[i]);
 		g_shader_prog[i] = 0;
@@ -228,6 +376,8 @@ hook::deinit_resources()
 	glDeleteBuffers(sizeof(g_vbo) / sizeof(g_vbo[0]), g_vbo);
 	memset(g_vbo, 0, sizeof(g_vbo));
 
+	g_pager.close();
+
 #if PLATFORM_EGL
 	g_display = EGL_NO_DISPLAY;
 	g_context = EGL_NO_CONTEXT;
@@ -293,6 +443,23 @@ hook::init_resources(
 #endif
 	scoped_ptr< deinit_resources_t, scoped_functor > on_error(deinit_resources);
 
+	/////////////////////////////////////////////////////////////////
+	// have the reads of the assets below go out together; the text-mesh parser gets its file in a
+	// buffer, while the loaders that map or stream their files get them in the page cache
+
+	const bool mesh_buffered = 0 == g_paged_filename && !isPLY(g_mesh_filename);
+
+	const char* const asset[] = {
+		mesh_buffered ? 0 : g_mesh_filename,
+		"asset/shader/blinn.glslv",
+		"asset/shader/blinn.glslf"
+	};
+
+	util::shared_file_preload().warm(asset, sizeof(asset) / sizeof(asset[0]));
+
+	if (mesh_buffered)
+		util::shared_file_preload().request(&g_mesh_filename, 1);
+
 	/////////////////////////////////////////////////////////////////
 
 	glEnable(GL_CULL_FACE);
@@ -333,21 +500,15 @@ hook::init_resources(
 	g_shader_prog[PROG_SKIN] = glCreateProgram();
 	assert(g_shader_prog[PROG_SKIN]);
 
-	if (!util::setupProgram(
+	if (!util::submitProgram(
 			g_shader_prog[PROG_SKIN],
 			g_shader_vert[PROG_SKIN],
 			g_shader_frag[PROG_SKIN]))
 	{
-		stream::cerr << __FUNCTION__ << " failed at setupProgram\n";
+		stream::cerr << __FUNCTION__ << " failed at submitProgram\n";
 		return false;
 	}
 
-	g_uni[PROG_SKIN][UNI_MVP]       = glGetUniformLocation(g_shader_prog[PROG_SKIN], "mvp");
-	g_uni[PROG_SKIN][UNI_LP_OBJ]    = glGetUniformLocation(g_shader_prog[PROG_SKIN], "lp_obj");
-	g_uni[PROG_SKIN][UNI_VP_OBJ]    = glGetUniformLocation(g_shader_prog[PROG_SKIN], "vp_obj");
-
-	g_active_attr_semantics[PROG_SKIN].registerVertexAttr(glGetAttribLocation(g_shader_prog[PROG_SKIN], "at_Vertex"));
-
 	/////////////////////////////////////////////////////////////////
 
 #if PLATFORM_GL_OES_vertex_array_object
@@ -365,19 +526,93 @@ hook::init_resources(
 	float bbox_min[3];
 	float bbox_max[3];
 
-	if (!util::fill_indexed_trilist_from_file_P(
+	const util::TrilistFilter filter = { filterMesh, 0 };
+
+	// without 32-bit indices, large meshes get split into batches of 16-bit indices
+	bool batch16 = g_batch16;
+
+#if PLATFORM_GL == 0
+	if (!util::hasGLExtension("GL_OES_element_index_uint"))
+		batch16 = true;
+
+#endif
+	if (g_paged_filename) {
+		// paged meshes come in chunks of 16-bit indices and their own proxy
+		g_cluster_set.max_faces = 0;
+		g_lod_chain.num_levels = 0;
+
+		if (!g_pager.open(g_paged_filename, g_paged_pool)) {
+			stream::cerr << __FUNCTION__ << " failed at MeshPager::open\n";
+			return false;
+		}
+
+		memcpy(bbox_min, g_pager.getHeader().vmin, sizeof(bbox_min));
+		memcpy(bbox_max, g_pager.getHeader().vmax, sizeof(bbox_max));
+
+		g_paged_draw.resize(g_pager.getHeader().num_chunks);
+		g_index_type = GL_UNSIGNED_SHORT;
+	}
+	else
+	if (isPLY(g_mesh_filename)) {
+		// PLY scans get streamed straight to the GL buffers -- no load-time processing
+		g_cluster_set.max_faces = 0;
+		g_lod_chain.num_levels = 0;
+
+		const uintptr_t semantics_offset[4] = {
+			offsetof(Vertex, pos),
+			uintptr_t(-1),
+			uintptr_t(-1),
+			uintptr_t(-1)
+		};
+
+		if (!util::fill_indexed_trilist_from_file_PLY(
+				g_mesh_filename,
+				g_vbo[VBO_SKIN_VTX],
+				g_vbo[VBO_SKIN_IDX],
+				semantics_offset,
+				sizeof(Vertex),
+				true,
+				g_num_verts[MESH_SKIN],
+				g_num_faces[MESH_SKIN],
+				g_index_type,
+				bbox_min,
+				bbox_max))
+		{
+			stream::cerr << __FUNCTION__ << " failed at fill_indexed_trilist_from_file_PLY\n";
+			return false;
+		}
+
+		if (GL_UNSIGNED_INT == g_index_type && batch16) {
+			stream::cerr << __FUNCTION__ << " requires GL_OES_element_index_uint for PLY meshes beyond 16-bit indices\n";
+			return false;
+		}
+	}
+	else
+	if (!util::fill_indexed_trilist_from_file_P_snorm16(
 			g_mesh_filename,
 			g_vbo[VBO_SKIN_VTX],
 			g_vbo[VBO_SKIN_IDX],
 			g_num_faces[MESH_SKIN],
 			g_index_type,
 			bbox_min,
-			bbox_max))
+			bbox_max,
+			g_cluster_set.max_faces || g_lod_chain.num_levels ? &filter : 0,
+			batch16 ? &g_batches : 0))
 	{
-		stream::cerr << __FUNCTION__ << " failed at fill_indexed_trilist_from_file_P\n";
+		stream::cerr << __FUNCTION__ << " failed at fill_indexed_trilist_from_file_P_snorm16\n";
 		return false;
 	}
 
+	// LOD indices refer to the vertices of the unsplit mesh
+	if (1 < g_batches.size() && g_lod_chain.num_levels) {
+		stream::cerr << __FUNCTION__ << " discards LODs of a mesh split into batches\n";
+
+		for (unsigned i = 0; i < g_lod_chain.num_levels; ++i)
+			std::vector< uint32_t >().swap(g_lod_chain.level[i].index);
+
+		g_lod_chain.num_levels = 0;
+	}
+
 	const float centre[3] = {
 		(bbox_min[0] + bbox_max[0]) * .5f,
 		(bbox_min[1] + bbox_max[1]) * .5f,
@@ -398,6 +633,38 @@ hook::init_resources(
 		-centre[1] * rcp_extent,
 		-centre[2] * rcp_extent, 1.f);
 
+	// positions come quantized -- their dequantization gets prepended to the mvp
+	float dequant[4][4];
+	rend::QuantDomain(bbox_min, bbox_max, true).get_dequant_matx(dequant);
+
+	g_matx_dequant = simd::matx4(dequant);
+	g_draw_range.resize(g_cluster_set.num_clusters);
+
+	if (!(GL_UNSIGNED_INT == g_index_type ?
+			uploadLodChain< uint32_t >(g_vbo[VBO_SKIN_LOD_IDX]) :
+			uploadLodChain< uint16_t >(g_vbo[VBO_SKIN_LOD_IDX]))) {
+
+		stream::cerr << __FUNCTION__ << " failed at uploadLodChain\n";
+		return false;
+	}
+
+	g_bound_centre[0] = centre[0];
+	g_bound_centre[1] = centre[1];
+	g_bound_centre[2] = centre[2];
+	g_bound_radius = sqrtf(extent[0] * extent[0] + extent[1] * extent[1] + extent[2] * extent[2]);
+
+	// the program is needed from here on; its compile and link went on while loading the mesh
+	if (!util::checkProgram(g_shader_prog[PROG_SKIN])) {
+		stream::cerr << __FUNCTION__ << " failed at checkProgram\n";
+		return false;
+	}
+
+	g_uni[PROG_SKIN][UNI_MVP]       = glGetUniformLocation(g_shader_prog[PROG_SKIN], "mvp");
+	g_uni[PROG_SKIN][UNI_LP_OBJ]    = glGetUniformLocation(g_shader_prog[PROG_SKIN], "lp_obj");
+	g_uni[PROG_SKIN][UNI_VP_OBJ]    = glGetUniformLocation(g_shader_prog[PROG_SKIN], "vp_obj");
+
+	g_active_attr_semantics[PROG_SKIN].registerVertexAttr(glGetAttribLocation(g_shader_prog[PROG_SKIN], "at_Vertex"));
+
 #if PLATFORM_GL_OES_vertex_array_object
 	glBindVertexArrayOES(g_vao[PROG_SKIN]);
 
@@ -405,7 +672,7 @@ hook::init_resources(
 	glBindBuffer(GL_ARRAY_BUFFER, g_vbo[VBO_SKIN_VTX]);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_vbo[VBO_SKIN_IDX]);
 
-	if (!setupVertexAttrPointers< Vertex >(g_active_attr_semantics[PROG_SKIN])) {
+	if (!setupVertexAttrPointers< Vertex >(g_active_attr_semantics[PROG_SKIN], 0, getVertexFormat())) {
 		stream::cerr << __FUNCTION__ << "failed at setupVertexAttrPointers\n";
 		return false;
 	}
@@ -419,6 +686,9 @@ hook::init_resources(
 	glBindVertexArrayOES(0);
 
 #endif
+	// assets not taken by now are not going to be
+	util::shared_file_preload().drop();
+
 	on_error.reset();
 	return true;
 }
@@ -525,6 +795,7 @@ hook::render_frame(GLuint /* primary_fbo */)
 
 	const matx4_persp proj(l, r, b, t, n, f);
 	const simd::matx4 mvp = simd::matx4().mul(mv, proj);
+	const simd::matx4 mvp_quant = simd::matx4().mul(g_matx_dequant, mvp);
 
 	const simd::vect3 lp_obj = simd::vect3(
 		mv[0][0] + mv[0][2],
@@ -536,11 +807,32 @@ hook::render_frame(GLuint /* primary_fbo */)
 	const float aspect = float(vp[3]) / vp[2];
 
 	const rend::dense_matx4 dense_mvp = rend::dense_matx4(
+			mvp_quant[0][0] * aspect, mvp_quant[0][1], mvp_quant[0][2], mvp_quant[0][3],
+			mvp_quant[1][0] * aspect, mvp_quant[1][1], mvp_quant[1][2], mvp_quant[1][3],
+			mvp_quant[2][0] * aspect, mvp_quant[2][1], mvp_quant[2][2], mvp_quant[2][3],
+			mvp_quant[3][0] * aspect, mvp_quant[3][1], mvp_quant[3][2], mvp_quant[3][3]);
+
+	/////////////////////////////////////////////////////////////////
+	// select LOD, and at full detail cull clusters, if any -- both in object space
+
+	const rend::dense_matx4 dense_mvp_obj = rend::dense_matx4(
 			mvp[0][0] * aspect, mvp[0][1], mvp[0][2], mvp[0][3],
 			mvp[1][0] * aspect, mvp[1][1], mvp[1][2], mvp[1][3],
 			mvp[2][0] * aspect, mvp[2][1], mvp[2][2], mvp[2][3],
 			mvp[3][0] * aspect, mvp[3][1], mvp[3][2], mvp[3][3]);
 
+	const unsigned lod = rend::selectLod(g_lod_chain, dense_mvp_obj,
+		g_bound_centre, g_bound_radius, vp[3], g_lod_pixel_error);
+
+	unsigned num_draw_ranges = 0;
+
+	if (0 == lod && g_cluster_set.num_clusters)
+		num_draw_ranges = rend::cullClusters(g_cluster_set, dense_mvp_obj, &g_draw_range.front());
+
+	// page in chunks by visibility and projected size, also in object space
+	if (g_paged_filename)
+		g_pager.update(dense_mvp_obj, vp[3]);
+
 	/////////////////////////////////////////////////////////////////
 
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -597,7 +889,65 @@ hook::render_frame(GLuint /* primary_fbo */)
 	DEBUG_GL_ERR()
 
 #endif
-	glDrawElements(GL_TRIANGLES, g_num_faces[MESH_SKIN] * 3, g_index_type, 0);
+	const uintptr_t sizeof_face = 3 * (GL_UNSIGNED_INT == g_index_type ? sizeof(uint32_t) : sizeof(uint16_t));
+
+	if (g_paged_filename) {
+		// each chunk, resident or proxy, has buffers of its own; restore the original bindings after use
+		const unsigned num_draws = g_pager.getDraws(&g_paged_draw.front());
+
+		for (unsigned i = 0; i < num_draws; ++i) {
+			glBindBuffer(GL_ARRAY_BUFFER, g_paged_draw[i].vbo_vtx);
+			setupVertexAttrPointers< Vertex >(g_active_attr_semantics[PROG_SKIN], 0, getVertexFormat());
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_paged_draw[i].vbo_idx);
+			glDrawElements(GL_TRIANGLES, g_paged_draw[i].num_faces * 3, GL_UNSIGNED_SHORT,
+				(GLvoid*)(g_paged_draw[i].first_face * sizeof(uint16_t[3])));
+		}
+
+		glBindBuffer(GL_ARRAY_BUFFER, g_vbo[VBO_SKIN_VTX]);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_vbo[VBO_SKIN_IDX]);
+	}
+	else
+	if (lod) {
+		// LODs have their own index buffer; restore the original binding after use (part of VAO state)
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_vbo[VBO_SKIN_LOD_IDX]);
+		glDrawElements(GL_TRIANGLES, g_lod_num_faces[lod - 1] * 3, g_index_type,
+			(GLvoid*)(g_lod_first_face[lod - 1] * sizeof_face));
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_vbo[VBO_SKIN_IDX]);
+	}
+	else
+	if (1 < g_batches.size()) {
+		// per batch: rebase the vertex attributes to the batch, draw its faces or its share of the
+		// visible clusters; faces keep their numbering across batches
+		for (util::TrilistBatches::const_iterator it = g_batches.begin(); it != g_batches.end(); ++it) {
+			setupVertexAttrPointers< Vertex >(g_active_attr_semantics[PROG_SKIN], it->first_vertex * sizeof(Vertex), getVertexFormat());
+
+			if (0 == g_cluster_set.num_clusters) {
+				glDrawElements(GL_TRIANGLES, it->num_faces * 3, g_index_type,
+					(GLvoid*)(it->first_face * sizeof_face));
+				continue;
+			}
+
+			for (unsigned i = 0; i < num_draw_ranges; ++i) {
+				const unsigned first = std::max(g_draw_range[i].first_face, it->first_face);
+				const unsigned last = std::min(g_draw_range[i].first_face + g_draw_range[i].num_faces, it->first_face + it->num_faces);
+
+				if (first < last)
+					glDrawElements(GL_TRIANGLES, (last - first) * 3, g_index_type,
+						(GLvoid*)(first * sizeof_face));
+			}
+		}
+	}
+	else
+	if (g_cluster_set.num_clusters) {
+		for (unsigned i = 0; i < num_draw_ranges; ++i)
+			glDrawElements(GL_TRIANGLES, g_draw_range[i].num_faces * 3, g_index_type,
+				(GLvoid*)(g_draw_range[i].first_face * sizeof_face));
+	}
+	else
+	if (g_num_faces[MESH_SKIN])
+		glDrawElements(GL_TRIANGLES, g_num_faces[MESH_SKIN] * 3, g_index_type, 0);
+	else
+		glDrawArrays(GL_POINTS, 0, g_num_verts[MESH_SKIN]);
 
 	DEBUG_GL_ERR()
 
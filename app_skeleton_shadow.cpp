@@ -26,6 +26,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <sched.h>
 #include <cmath>
 #include <string>
 #include <sstream>
@@ -34,7 +35,10 @@
 #include "stream.hpp"
 #include "vectsimd.hpp"
 #include "util_tex.hpp"
+#include "util_tex_cache.hpp"
+#include "util_tex_stream.hpp"
 #include "util_misc.hpp"
+#include "util_preload.hpp"
 #include "pure_macro.hpp"
 
 #include "rendIndexedTrilist.hpp"
@@ -91,15 +95,23 @@ const char arg_normal[]     = "normal_map";
 const char arg_albedo[]     = "albedo_map";
 const char arg_anim_step[]  = "anim_step";
 const char arg_shadow_res[] = "shadow_res";
+const char arg_ogre[]       = "ogre";
+const char arg_gltf[]       = "gltf";
 
 struct TexDesc {
 	const char* filename;
 	unsigned w;
 	unsigned h;
+	util::PixFormat format; // of the upload
 };
 
-TexDesc g_normal = { "asset/texture/unperturbed_normal.raw", 8, 8 };
-TexDesc g_albedo = { "none", 16, 16 };
+TexDesc g_normal = { "asset/texture/unperturbed_normal.raw", 8, 8, util::PIX_FORMAT_RGBA8888 };
+TexDesc g_albedo = { "none", 16, 16, util::PIX_FORMAT_RGBA8888 };
+
+bool g_ogre;
+bool g_gltf;
+const char* g_mesh_filename = "asset/mesh/Ahmed_GEO.mesh";
+const char* g_skeleton_filename = "asset/mesh/Ahmed_GEO.skeleton";
 
 float g_anim_step = .0125f;
 simd::matx4 g_matx_fit;
@@ -200,6 +212,7 @@ GLuint g_vao[PROG_COUNT];
 #endif
 GLuint g_fbo; // single
 GLuint g_tex[TEX_COUNT];
+util::texture_cache::handle g_tex_handle[TEX_COUNT]; // of textures from the shared cache
 GLuint g_vbo[VBO_COUNT];
 GLuint g_shader_vert[PROG_COUNT];
 GLuint g_shader_frag[PROG_COUNT];
@@ -265,6 +278,20 @@ int parse_cli(
 			return 1;
 		}
 	}
+	else
+	if (i + 2 < argc && !strcmp(argv[i], arg_ogre)) {
+		g_ogre = true;
+		g_mesh_filename = argv[i + 1];
+		g_skeleton_filename = argv[i + 2];
+		return 2;
+	}
+	else
+	if (i + 1 < argc && !strcmp(argv[i], arg_gltf)) {
+		g_gltf = true;
+		g_mesh_filename = argv[i + 1];
+		g_skeleton_filename = argv[i + 1];
+		return 1;
+	}
 
 	stream::cerr << "app options:\n"
 		"\t" << arg_prefix << arg_app << " " << arg_normal <<
@@ -274,7 +301,11 @@ int parse_cli(
 		"\t" << arg_prefix << arg_app << " " << arg_anim_step <<
 		" <step>\t\t\t\t: use specified animation step; entire animation is 1.0\n"
 		"\t" << arg_prefix << arg_app << " " << arg_shadow_res <<
-		" <pot>\t\t\t\t: use specified shadow buffer resolution (POT); default is " << fbo_default_res << "\n\n";
+		" <pot>\t\t\t\t: use specified shadow buffer resolution (POT); default is " << fbo_default_res << "\n"
+		"\t" << arg_prefix << arg_app << " " << arg_ogre <<
+		" <mesh> <skeleton>\t\t: use specified Ogre mesh and skeleton files as the skinned asset\n"
+		"\t" << arg_prefix << arg_app << " " << arg_gltf <<
+		" <filename>\t\t\t: use specified binary glTF (.glb) file as the skinned asset\n\n";
 
 	return -1;
 }
@@ -359,6 +390,8 @@ hook::deinit_resources()
 	if (!check_context(__FUNCTION__))
 		return false;
 
+	util::shared_file_preload().drop();
+
 	for (unsigned i = 0; i < sizeof(g_shader_prog) / sizeof(g_shader_prog[0]); ++i) {
 		glDeleteProgram(g_shader_prog[i]);
 		g_shader_prog[i] = 0;
@@ -377,9 +410,27 @@ hook::deinit_resources()
 	glDeleteFramebuffers(1, &g_fbo);
 	g_fbo = 0;
 
-	glDeleteTextures(sizeof(g_tex) / sizeof(g_tex[0]), g_tex);
+	glDeleteTextures(1, &g_tex[TEX_SHADOW]);
+
+	util::texture_cache& tex_cache = util::shared_texture_cache();
+
+	for (unsigned i = 0; i < sizeof(g_tex_handle) / sizeof(g_tex_handle[0]); ++i)
+		if (0 != g_tex_handle[i])
+			tex_cache.release(g_tex_handle[i]);
+
+	memset(g_tex_handle, 0, sizeof(g_tex_handle));
 	memset(g_tex, 0, sizeof(g_tex));
 
+	const util::texture_cache::stats& tex_stats = tex_cache.get_stats();
+
+	stream::cout << "texture cache hits: " << tex_stats.hits << ", misses: " << tex_stats.misses <<
+		", resident: " << tex_stats.num_resident << " textures of " << tex_stats.bytes_resident << " bytes\n";
+
+	// cached textures go along with the GL context
+	tex_cache.purge();
+	tex_cache.set_streamer(0);
+	util::shared_texture_streamer().deinit();
+
 #if PLATFORM_GL_OES_vertex_array_object
 	glDeleteVertexArraysOES(sizeof(g_vao) / sizeof(g_vao[0]), g_vao);
 	memset(g_vao, 0, sizeof(g_vao));
@@ -453,6 +504,28 @@ hook::init_resources(
 #endif
 	scoped_ptr< deinit_resources_t, scoped_functor > on_error(deinit_resources);
 
+	/////////////////////////////////////////////////////////////////
+	// have the reads of the assets below go out together; the ABE and Ogre skeleton parsers get
+	// their file in a buffer, while the loaders that map their files, glTF skeletons included, get
+	// them in the page cache
+
+	const char* const asset[] = {
+		g_normal.filename,
+		g_albedo.filename,
+		"asset/shader/blinn_shadow_skinning.glslv",
+		"asset/shader/blinn_shadow.glslf",
+		"asset/shader/mvp.glslv",
+		"asset/shader/basic.glslf",
+		"asset/shader/mvp_skinning.glslv",
+		"asset/shader/depth.glslf",
+		g_mesh_filename
+	};
+
+	util::shared_file_preload().warm(asset, sizeof(asset) / sizeof(asset[0]));
+
+	if (!g_gltf)
+		util::shared_file_preload().request(&g_skeleton_filename, 1);
+
 	/////////////////////////////////////////////////////////////////
 	// set up various patches to the shaders
 
@@ -484,24 +557,36 @@ hook::init_resources(
 	/////////////////////////////////////////////////////////////////
 	// reserve all necessary texture objects
 
-	glGenTextures(sizeof(g_tex) / sizeof(g_tex[0]), g_tex);
-
-	for (unsigned i = 0; i < sizeof(g_tex) / sizeof(g_tex[0]); ++i)
-		assert(g_tex[i]);
+	glGenTextures(1, &g_tex[TEX_SHADOW]);
+	assert(g_tex[TEX_SHADOW]);
 
 	/////////////////////////////////////////////////////////////////
-	// load textures
+	// acquire textures from the shared cache
+
+	util::texture_cache& tex_cache = util::shared_texture_cache();
+	util::texture_streamer& tex_streamer = util::shared_texture_streamer();
 
-	if (!util::setupTexture2D(g_tex[TEX_NORMAL], g_normal.filename, g_normal.w, g_normal.h)) {
-		stream::cerr << __FUNCTION__ << " failed at setupTexture2D\n";
+	// on GLES3 the texture content streams in past the init
+	if (tex_streamer.init())
+		tex_cache.set_streamer(&tex_streamer);
+
+	g_tex_handle[TEX_NORMAL] = tex_cache.acquire(g_normal.filename, g_normal.w, g_normal.h, false, util::MIP_MODE_NORMAL, g_normal.format);
+
+	if (0 == g_tex_handle[TEX_NORMAL]) {
+		stream::cerr << __FUNCTION__ << " failed at texture_cache::acquire\n";
 		return false;
 	}
 
-	if (!util::setupTexture2D(g_tex[TEX_ALBEDO], g_albedo.filename, g_albedo.w, g_albedo.h)) {
-		stream::cerr << __FUNCTION__ << " failed at setupTexture2D\n";
+	g_tex_handle[TEX_ALBEDO] = tex_cache.acquire(g_albedo.filename, g_albedo.w, g_albedo.h, false, util::MIP_MODE_SRGB, g_albedo.format);
+
+	if (0 == g_tex_handle[TEX_ALBEDO]) {
+		stream::cerr << __FUNCTION__ << " failed at texture_cache::acquire\n";
 		return false;
 	}
 
+	g_tex[TEX_NORMAL] = tex_cache.get_name(g_tex_handle[TEX_NORMAL]);
+	g_tex[TEX_ALBEDO] = tex_cache.get_name(g_tex_handle[TEX_ALBEDO]);
+
 	/////////////////////////////////////////////////////////////////
 	// init the program/uniforms matrix to all empty
 
@@ -533,33 +618,15 @@ hook::init_resources(
 	g_shader_prog[PROG_SKIN] = glCreateProgram();
 	assert(g_shader_prog[PROG_SKIN]);
 
-	if (!util::setupProgram(
+	if (!util::submitProgram(
 			g_shader_prog[PROG_SKIN],
 			g_shader_vert[PROG_SKIN],
 			g_shader_frag[PROG_SKIN]))
 	{
-		stream::cerr << __FUNCTION__ << " failed at setupProgram\n";
+		stream::cerr << __FUNCTION__ << " failed at submitProgram\n";
 		return false;
 	}
 
-	/////////////////////////////////////////////////////////////////
-	// query the program about known uniform vars and vertex attribs
-
-	g_uni[PROG_SKIN][UNI_MVP]     = glGetUniformLocation(g_shader_prog[PROG_SKIN], "mvp");
-	g_uni[PROG_SKIN][UNI_MVP_LIT] = glGetUniformLocation(g_shader_prog[PROG_SKIN], "mvp_lit");
-	g_uni[PROG_SKIN][UNI_BONE]    = glGetUniformLocation(g_shader_prog[PROG_SKIN], "bone");
-	g_uni[PROG_SKIN][UNI_LP_OBJ]  = glGetUniformLocation(g_shader_prog[PROG_SKIN], "lp_obj");
-	g_uni[PROG_SKIN][UNI_VP_OBJ]  = glGetUniformLocation(g_shader_prog[PROG_SKIN], "vp_obj");
-
-	g_uni[PROG_SKIN][UNI_SAMPLER_NORMAL] = glGetUniformLocation(g_shader_prog[PROG_SKIN], "normal_map");
-	g_uni[PROG_SKIN][UNI_SAMPLER_ALBEDO] = glGetUniformLocation(g_shader_prog[PROG_SKIN], "albedo_map");
-	g_uni[PROG_SKIN][UNI_SAMPLER_SHADOW] = glGetUniformLocation(g_shader_prog[PROG_SKIN], "shadow_map");
-
-	g_active_attr_semantics[PROG_SKIN].registerVertexAttr(glGetAttribLocation(g_shader_prog[PROG_SKIN], "at_Vertex"));
-	g_active_attr_semantics[PROG_SKIN].registerNormalAttr(glGetAttribLocation(g_shader_prog[PROG_SKIN], "at_Normal"));
-	g_active_attr_semantics[PROG_SKIN].registerBlendWAttr(glGetAttribLocation(g_shader_prog[PROG_SKIN], "at_Weight"));
-	g_active_attr_semantics[PROG_SKIN].registerTCoordAttr(glGetAttribLocation(g_shader_prog[PROG_SKIN], "at_MultiTexCoord0"));
-
 	/////////////////////////////////////////////////////////////////
 	// create shader program SKEL from two shaders
 
@@ -582,23 +649,15 @@ hook::init_resources(
 	g_shader_prog[PROG_SKEL] = glCreateProgram();
 	assert(g_shader_prog[PROG_SKEL]);
 
-	if (!util::setupProgram(
+	if (!util::submitProgram(
 			g_shader_prog[PROG_SKEL],
 			g_shader_vert[PROG_SKEL],
 			g_shader_frag[PROG_SKEL]))
 	{
-		stream::cerr << __FUNCTION__ << " failed at setupProgram\n";
+		stream::cerr << __FUNCTION__ << " failed at submitProgram\n";
 		return false;
 	}
 
-	/////////////////////////////////////////////////////////////////
-	// query the program about known uniform vars and vertex attribs
-
-	g_uni[PROG_SKEL][UNI_MVP]         = glGetUniformLocation(g_shader_prog[PROG_SKEL], "mvp");
-	g_uni[PROG_SKEL][UNI_SOLID_COLOR] = glGetUniformLocation(g_shader_prog[PROG_SKEL], "solid_color");
-
-	g_active_attr_semantics[PROG_SKEL].registerVertexAttr(glGetAttribLocation(g_shader_prog[PROG_SKEL], "at_Vertex"));
-
 	/////////////////////////////////////////////////////////////////
 	// create shader program SHADOW from two shaders
 
@@ -621,33 +680,24 @@ hook::init_resources(
 	g_shader_prog[PROG_SHADOW] = glCreateProgram();
 	assert(g_shader_prog[PROG_SHADOW]);
 
-	if (!util::setupProgram(
+	if (!util::submitProgram(
 			g_shader_prog[PROG_SHADOW],
 			g_shader_vert[PROG_SHADOW],
 			g_shader_frag[PROG_SHADOW]))
 	{
-		stream::cerr << __FUNCTION__ << " failed at setupProgram\n";
+		stream::cerr << __FUNCTION__ << " failed at submitProgram\n";
 		return false;
 	}
 
-	/////////////////////////////////////////////////////////////////
-	// query the program about known uniform vars and vertex attribs
-
-	g_uni[PROG_SHADOW][UNI_MVP]  = glGetUniformLocation(g_shader_prog[PROG_SHADOW], "mvp");
-	g_uni[PROG_SHADOW][UNI_BONE] = glGetUniformLocation(g_shader_prog[PROG_SHADOW], "bone");
-
-	g_active_attr_semantics[PROG_SHADOW].registerVertexAttr(glGetAttribLocation(g_shader_prog[PROG_SHADOW], "at_Vertex"));
-	g_active_attr_semantics[PROG_SHADOW].registerBlendWAttr(glGetAttribLocation(g_shader_prog[PROG_SHADOW], "at_Weight"));
-
 	/////////////////////////////////////////////////////////////////
 	// load the skeleton for the main geometric asset
 
 	g_bone_count = BONE_CAPACITY;
 
-	const char* const skeleton_filename = "asset/mesh/Ahmed_GEO.skeleton";
+	if (!(g_gltf ? rend::loadSkeletonAnimationGLB : g_ogre ? rend::loadSkeletonAnimationOgre : rend::loadSkeletonAnimationABE)(
+			g_skeleton_filename, &g_bone_count, g_bone_mat, g_bone, g_animations, g_durations)) {
 
-	if (!rend::loadSkeletonAnimationABE(skeleton_filename, &g_bone_count, g_bone_mat, g_bone, g_animations, g_durations)) {
-		stream::cerr << __FUNCTION__ << " failed to load skeleton file " << skeleton_filename << '\n';
+		stream::cerr << __FUNCTION__ << " failed to load skeleton file " << g_skeleton_filename << '\n';
 		return false;
 	}
 
@@ -687,10 +737,8 @@ hook::init_resources(
 		offsetof(sk::Vertex, txc)
 	};
 
-	const char* const mesh_filename = "asset/mesh/Ahmed_GEO.mesh";
-
-	if (!util::fill_indexed_trilist_from_file_ABE(
-			mesh_filename,
+	if (!(g_gltf ? util::fill_indexed_trilist_from_file_GLB : g_ogre ? util::fill_indexed_trilist_from_file_Ogre : util::fill_indexed_trilist_from_file_ABE)(
+			g_mesh_filename,
 			g_vbo[VBO_SKIN_VTX],
 			g_vbo[VBO_SKIN_IDX],
 			semantics_offset,
@@ -699,7 +747,7 @@ hook::init_resources(
 			bbox_min,
 			bbox_max))
 	{
-		stream::cerr << __FUNCTION__ << " failed at fill_indexed_trilist_from_file_ABE\n";
+		stream::cerr << __FUNCTION__ << " failed to load mesh file " << g_mesh_filename << '\n';
 		return false;
 	}
 
@@ -723,6 +771,109 @@ hook::init_resources(
 		-centre[1] * rcp_extent,
 		-centre[2] * rcp_extent, 1.f);
 
+	/////////////////////////////////////////////////////////////////
+	// set up the texture to be used as depth in the single FBO
+
+	glBindTexture(GL_TEXTURE_2D, g_tex[TEX_SHADOW]);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+#if DEPTH_PRECISION_24
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_STENCIL_OES, g_fbo_res, g_fbo_res, 0,
+		GL_DEPTH_STENCIL_OES, GL_UNSIGNED_INT_24_8_OES, 0);
+#else
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, g_fbo_res, g_fbo_res, 0,
+		GL_DEPTH_COMPONENT, GL_UNSIGNED_SHORT, 0);
+#endif
+
+	if (util::reportGLError()) {
+		stream::cerr << __FUNCTION__ << " failed at shadow texture setup\n";
+		return false;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	/////////////////////////////////////////////////////////////////
+	// set up the single FBO
+
+	glGenFramebuffers(1, &g_fbo);
+	assert(g_fbo);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, g_fbo);
+
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, g_tex[TEX_SHADOW], 0);
+
+#if DEPTH_PRECISION_24
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_TEXTURE_2D, g_tex[TEX_SHADOW], 0);
+
+#endif
+	const GLenum fbo_success = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+
+	if (GL_FRAMEBUFFER_COMPLETE != fbo_success) {
+		stream::cerr << __FUNCTION__ << " failed at glCheckFramebufferStatus\n";
+		return false;
+	}
+
+	glDrawBuffers(0, nullptr);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	/////////////////////////////////////////////////////////////////
+	// the programs are needed from here on; their compile and link went on while loading the assets,
+	// and while the driver is still on them, upload the texture content streamed in meanwhile
+
+	for (unsigned i = 0; i < PROG_COUNT; ++i)
+		while (!util::isProgramComplete(g_shader_prog[i]) &&
+			(tex_streamer.is_pending(g_tex[TEX_NORMAL]) || tex_streamer.is_pending(g_tex[TEX_ALBEDO]))) {
+
+			tex_streamer.update();
+			sched_yield();
+		}
+
+	for (unsigned i = 0; i < PROG_COUNT; ++i)
+		if (!util::checkProgram(g_shader_prog[i])) {
+			stream::cerr << __FUNCTION__ << " failed at checkProgram\n";
+			return false;
+		}
+
+	/////////////////////////////////////////////////////////////////
+	// query program SKIN about known uniform vars and vertex attribs
+
+	g_uni[PROG_SKIN][UNI_MVP]     = glGetUniformLocation(g_shader_prog[PROG_SKIN], "mvp");
+	g_uni[PROG_SKIN][UNI_MVP_LIT] = glGetUniformLocation(g_shader_prog[PROG_SKIN], "mvp_lit");
+	g_uni[PROG_SKIN][UNI_BONE]    = glGetUniformLocation(g_shader_prog[PROG_SKIN], "bone");
+	g_uni[PROG_SKIN][UNI_LP_OBJ]  = glGetUniformLocation(g_shader_prog[PROG_SKIN], "lp_obj");
+	g_uni[PROG_SKIN][UNI_VP_OBJ]  = glGetUniformLocation(g_shader_prog[PROG_SKIN], "vp_obj");
+
+	g_uni[PROG_SKIN][UNI_SAMPLER_NORMAL] = glGetUniformLocation(g_shader_prog[PROG_SKIN], "normal_map");
+	g_uni[PROG_SKIN][UNI_SAMPLER_ALBEDO] = glGetUniformLocation(g_shader_prog[PROG_SKIN], "albedo_map");
+	g_uni[PROG_SKIN][UNI_SAMPLER_SHADOW] = glGetUniformLocation(g_shader_prog[PROG_SKIN], "shadow_map");
+
+	g_active_attr_semantics[PROG_SKIN].registerVertexAttr(glGetAttribLocation(g_shader_prog[PROG_SKIN], "at_Vertex"));
+	g_active_attr_semantics[PROG_SKIN].registerNormalAttr(glGetAttribLocation(g_shader_prog[PROG_SKIN], "at_Normal"));
+	g_active_attr_semantics[PROG_SKIN].registerBlendWAttr(glGetAttribLocation(g_shader_prog[PROG_SKIN], "at_Weight"));
+	g_active_attr_semantics[PROG_SKIN].registerTCoordAttr(glGetAttribLocation(g_shader_prog[PROG_SKIN], "at_MultiTexCoord0"));
+
+	/////////////////////////////////////////////////////////////////
+	// query program SKEL about known uniform vars and vertex attribs
+
+	g_uni[PROG_SKEL][UNI_MVP]         = glGetUniformLocation(g_shader_prog[PROG_SKEL], "mvp");
+	g_uni[PROG_SKEL][UNI_SOLID_COLOR] = glGetUniformLocation(g_shader_prog[PROG_SKEL], "solid_color");
+
+	g_active_attr_semantics[PROG_SKEL].registerVertexAttr(glGetAttribLocation(g_shader_prog[PROG_SKEL], "at_Vertex"));
+
+	/////////////////////////////////////////////////////////////////
+	// query program SHADOW about known uniform vars and vertex attribs
+
+	g_uni[PROG_SHADOW][UNI_MVP]  = glGetUniformLocation(g_shader_prog[PROG_SHADOW], "mvp");
+	g_uni[PROG_SHADOW][UNI_BONE] = glGetUniformLocation(g_shader_prog[PROG_SHADOW], "bone");
+
+	g_active_attr_semantics[PROG_SHADOW].registerVertexAttr(glGetAttribLocation(g_shader_prog[PROG_SHADOW], "at_Vertex"));
+	g_active_attr_semantics[PROG_SHADOW].registerBlendWAttr(glGetAttribLocation(g_shader_prog[PROG_SHADOW], "at_Weight"));
+
 #if DRAW_SKELETON
 	/////////////////////////////////////////////////////////////////
 	// forward-declare VBO_SKEL_VTX; dynamically updated per frame
@@ -774,55 +925,8 @@ hook::init_resources(
 	glBindVertexArrayOES(0);
 
 #endif
-	/////////////////////////////////////////////////////////////////
-	// set up the texture to be used as depth in the single FBO
-
-	glBindTexture(GL_TEXTURE_2D, g_tex[TEX_SHADOW]);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-#if DEPTH_PRECISION_24
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_STENCIL_OES, g_fbo_res, g_fbo_res, 0,
-		GL_DEPTH_STENCIL_OES, GL_UNSIGNED_INT_24_8_OES, 0);
-#else
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, g_fbo_res, g_fbo_res, 0,
-		GL_DEPTH_COMPONENT, GL_UNSIGNED_SHORT, 0);
-#endif
-
-	if (util::reportGLError()) {
-		stream::cerr << __FUNCTION__ << " failed at shadow texture setup\n";
-		return false;
-	}
-
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	/////////////////////////////////////////////////////////////////
-	// set up the single FBO
-
-	glGenFramebuffers(1, &g_fbo);
-	assert(g_fbo);
-
-	glBindFramebuffer(GL_FRAMEBUFFER, g_fbo);
-
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, g_tex[TEX_SHADOW], 0);
-
-#if DEPTH_PRECISION_24
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_TEXTURE_2D, g_tex[TEX_SHADOW], 0);
-
-#endif
-	const GLenum fbo_success = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-
-	if (GL_FRAMEBUFFER_COMPLETE != fbo_success) {
-		stream::cerr << __FUNCTION__ << " failed at glCheckFramebufferStatus\n";
-		return false;
-	}
-
-	glDrawBuffers(0, nullptr);
-
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	// assets not taken by now are not going to be
+	util::shared_file_preload().drop();
 
 	on_error.reset();
 	return true;
@@ -879,6 +983,11 @@ hook::render_frame(GLuint primary_fbo)
 	if (!check_context(__FUNCTION__))
 		return false;
 
+	/////////////////////////////////////////////////////////////////
+	// upload the texture content streamed in since the last frame
+
+	util::shared_texture_streamer().update();
+
 	/////////////////////////////////////////////////////////////////
 	// fast-forward the skeleton animation to current time
 
@@ -14,13 +14,17 @@
 #include <string.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <sched.h>
 #include <cmath>
 
 #include "scoped.hpp"
 #include "stream.hpp"
 #include "vectsimd.hpp"
 #include "util_tex.hpp"
+#include "util_tex_cache.hpp"
+#include "util_tex_stream.hpp"
 #include "util_misc.hpp"
+#include "util_preload.hpp"
 #include "pure_macro.hpp"
 
 #include "rendSkeleton.hpp"
@@ -60,10 +64,11 @@ struct TexDesc {
 	const char* filename;
 	unsigned w;
 	unsigned h;
+	util::PixFormat format; // of the upload
 };
 
-TexDesc g_normal = { "asset/texture/chesterfield.raw", 1024, 1024 };
-TexDesc g_albedo = { "asset/texture/navy_blue_scrapbook_paper.raw", 512, 512 };
+TexDesc g_normal = { "asset/texture/chesterfield.raw", 1024, 1024, util::PIX_FORMAT_RG88 };
+TexDesc g_albedo = { "asset/texture/navy_blue_scrapbook_paper.raw", 512, 512, util::PIX_FORMAT_RGBA8888 };
 
 const unsigned bone_count = 13;
 
@@ -128,6 +133,7 @@ GLuint g_vao[PROG_COUNT];
 
 #endif
 GLuint g_tex[TEX_COUNT];
+util::texture_cache::handle g_tex_handle[TEX_COUNT]; // of textures from the shared cache
 GLuint g_vbo[VBO_COUNT];
 GLuint g_shader_vert[PROG_COUNT];
 GLuint g_shader_frag[PROG_COUNT];
@@ -430,6 +436,8 @@ bool deinit_resources()
 	if (!check_context(__FUNCTION__))
 		return false;
 
+	util::shared_file_preload().drop();
+
 	for (unsigned i = 0; i < sizeof(g_shader_prog) / sizeof(g_shader_prog[0]); ++i) {
 		glDeleteProgram(g_shader_prog[i]);
 		g_shader_prog[i] = 0;
@@ -445,9 +453,25 @@ bool deinit_resources()
 		g_shader_frag[i] = 0;
 	}
 
-	glDeleteTextures(sizeof(g_tex) / sizeof(g_tex[0]), g_tex);
+	util::texture_cache& tex_cache = util::shared_texture_cache();
+
+	for (unsigned i = 0; i < sizeof(g_tex_handle) / sizeof(g_tex_handle[0]); ++i)
+		if (0 != g_tex_handle[i])
+			tex_cache.release(g_tex_handle[i]);
+
+	memset(g_tex_handle, 0, sizeof(g_tex_handle));
 	memset(g_tex, 0, sizeof(g_tex));
 
+	const util::texture_cache::stats& tex_stats = tex_cache.get_stats();
+
+	stream::cout << "texture cache hits: " << tex_stats.hits << ", misses: " << tex_stats.misses <<
+		", resident: " << tex_stats.num_resident << " textures of " << tex_stats.bytes_resident << " bytes\n";
+
+	// cached textures go along with the GL context
+	tex_cache.purge();
+	tex_cache.set_streamer(0);
+	util::shared_texture_streamer().deinit();
+
 #if PLATFORM_GL_OES_vertex_array_object
 	glDeleteVertexArraysOES(sizeof(g_vao) / sizeof(g_vao[0]), g_vao);
 	memset(g_vao, 0, sizeof(g_vao));
@@ -502,6 +526,18 @@ bool init_resources(
 #endif
 	scoped_ptr< deinit_resources_t, scoped_functor > on_error(deinit_resources);
 
+	/////////////////////////////////////////////////////////////////
+	// have the reads of the assets below go out together; the loaders map them, so warm the page cache
+
+	const char* const asset[] = {
+		g_normal.filename,
+		g_albedo.filename,
+		"asset/shader/phong_skinning_bump_tang.glslv",
+		"asset/shader/phong_bump_tang.glslf"
+	};
+
+	util::shared_file_preload().warm(asset, sizeof(asset) / sizeof(asset[0]));
+
 	/////////////////////////////////////////////////////////////////
 	// set up misc control bits and values
 
@@ -517,26 +553,34 @@ bool init_resources(
 	glClearDepthf(1.f);
 
 	/////////////////////////////////////////////////////////////////
-	// reserve all necessary texture objects
+	// acquire textures from the shared cache
 
-	glGenTextures(sizeof(g_tex) / sizeof(g_tex[0]), g_tex);
+	util::texture_cache& tex_cache = util::shared_texture_cache();
+	util::texture_streamer& tex_streamer = util::shared_texture_streamer();
 
-	for (unsigned i = 0; i < sizeof(g_tex) / sizeof(g_tex[0]); ++i)
-		assert(g_tex[i]);
+	// on GLES3 the texture content streams in past the init
+	if (tex_streamer.init())
+		tex_cache.set_streamer(&tex_streamer);
 
-	/////////////////////////////////////////////////////////////////
-	// load textures
+	GLenum normal_format;
 
-	if (!util::setupTexture2D(g_tex[TEX_NORMAL], g_normal.filename, g_normal.w, g_normal.h)) {
-		stream::cerr << __FUNCTION__ << " failed at setupTexture2D\n";
+	g_tex_handle[TEX_NORMAL] = tex_cache.acquire(g_normal.filename, g_normal.w, g_normal.h, false, util::MIP_MODE_NORMAL, g_normal.format, &normal_format);
+
+	if (0 == g_tex_handle[TEX_NORMAL]) {
+		stream::cerr << __FUNCTION__ << " failed at texture_cache::acquire\n";
 		return false;
 	}
 
-	if (!util::setupTexture2D(g_tex[TEX_ALBEDO], g_albedo.filename, g_albedo.w, g_albedo.h)) {
-		stream::cerr << __FUNCTION__ << " failed at setupTexture2D\n";
+	g_tex_handle[TEX_ALBEDO] = tex_cache.acquire(g_albedo.filename, g_albedo.w, g_albedo.h, false, util::MIP_MODE_SRGB, g_albedo.format);
+
+	if (0 == g_tex_handle[TEX_ALBEDO]) {
+		stream::cerr << __FUNCTION__ << " failed at texture_cache::acquire\n";
 		return false;
 	}
 
+	g_tex[TEX_NORMAL] = tex_cache.get_name(g_tex_handle[TEX_NORMAL]);
+	g_tex[TEX_ALBEDO] = tex_cache.get_name(g_tex_handle[TEX_ALBEDO]);
+
 	/////////////////////////////////////////////////////////////////
 	// init the program/uniforms matrix to all empty
 
@@ -558,7 +602,15 @@ bool init_resources(
 	g_shader_frag[PROG_SKIN] = glCreateShader(GL_FRAGMENT_SHADER);
 	assert(g_shader_frag[PROG_SKIN]);
 
-	if (!util::setupShader(g_shader_frag[PROG_SKIN], "asset/shader/phong_bump_tang.glslf")) {
+	// normal maps of x and y only get their z reconstructed
+	const std::string patch[] = {
+		"false; // normal map of x and y only",
+		2 == util::textureFormatComponents(normal_format) ? "true; // normal map of x and y only" : "false; // normal map of x and y only"
+	};
+
+	if (!util::setupShaderWithPatch(g_shader_frag[PROG_SKIN], "asset/shader/phong_bump_tang.glslf",
+			sizeof(patch) / sizeof(patch[0]) / 2, patch))
+	{
 		stream::cerr << __FUNCTION__ << " failed at setupShader\n";
 		return false;
 	}
@@ -566,31 +618,15 @@ bool init_resources(
 	g_shader_prog[PROG_SKIN] = glCreateProgram();
 	assert(g_shader_prog[PROG_SKIN]);
 
-	if (!util::setupProgram(
+	if (!util::submitProgram(
 			g_shader_prog[PROG_SKIN],
 			g_shader_vert[PROG_SKIN],
 			g_shader_frag[PROG_SKIN]))
 	{
-		stream::cerr << __FUNCTION__ << " failed at setupProgram\n";
+		stream::cerr << __FUNCTION__ << " failed at submitProgram\n";
 		return false;
 	}
 
-	/////////////////////////////////////////////////////////////////
-	// query the program about known uniform vars and vertex attribs
-
-	g_uni[PROG_SKIN][UNI_MVP]    = glGetUniformLocation(g_shader_prog[PROG_SKIN], "mvp");
-	g_uni[PROG_SKIN][UNI_BONE]   = glGetUniformLocation(g_shader_prog[PROG_SKIN], "bone");
-	g_uni[PROG_SKIN][UNI_LP_OBJ] = glGetUniformLocation(g_shader_prog[PROG_SKIN], "lp_obj");
-	g_uni[PROG_SKIN][UNI_VP_OBJ] = glGetUniformLocation(g_shader_prog[PROG_SKIN], "vp_obj");
-
-	g_uni[PROG_SKIN][UNI_SAMPLER_NORMAL] = glGetUniformLocation(g_shader_prog[PROG_SKIN], "normal_map");
-	g_uni[PROG_SKIN][UNI_SAMPLER_ALBEDO] = glGetUniformLocation(g_shader_prog[PROG_SKIN], "albedo_map");
-
-	g_active_attr_semantics[PROG_SKIN].registerVertexAttr(glGetAttribLocation(g_shader_prog[PROG_SKIN], "at_Vertex"));
-	g_active_attr_semantics[PROG_SKIN].registerNormalAttr(glGetAttribLocation(g_shader_prog[PROG_SKIN], "at_Normal"));
-	g_active_attr_semantics[PROG_SKIN].registerBlendWAttr(glGetAttribLocation(g_shader_prog[PROG_SKIN], "at_Weight"));
-	g_active_attr_semantics[PROG_SKIN].registerTCoordAttr(glGetAttribLocation(g_shader_prog[PROG_SKIN], "at_MultiTexCoord0"));
-
 	/////////////////////////////////////////////////////////////////
 	// set up skeleton in binding pose
 
@@ -752,8 +788,6 @@ bool init_resources(
 	for (unsigned i = 0; i < sizeof(g_vao) / sizeof(g_vao[0]); ++i)
 		assert(g_vao[i]);
 
-	glBindVertexArrayOES(g_vao[PROG_SKIN]);
-
 #endif
 	glGenBuffers(sizeof(g_vbo) / sizeof(g_vbo[0]), g_vbo);
 
@@ -761,7 +795,7 @@ bool init_resources(
 		assert(g_vbo[i]);
 
 	/////////////////////////////////////////////////////////////////
-	// bind VBOs and upload the geom asset
+	// upload the geom asset
 
 	glBindBuffer(GL_ARRAY_BUFFER, g_vbo[VBO_SKIN_VTX]);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(arr), arr, GL_STATIC_DRAW);
@@ -773,9 +807,48 @@ bool init_resources(
 
 	DEBUG_GL_ERR()
 
+	/////////////////////////////////////////////////////////////////
+	// the program is needed from here on; while the driver is still on it, upload the texture
+	// content streamed in meanwhile
+
+	while (!util::isProgramComplete(g_shader_prog[PROG_SKIN]) &&
+		(tex_streamer.is_pending(g_tex[TEX_NORMAL]) || tex_streamer.is_pending(g_tex[TEX_ALBEDO]))) {
+
+		tex_streamer.update();
+		sched_yield();
+	}
+
+	if (!util::checkProgram(g_shader_prog[PROG_SKIN])) {
+		stream::cerr << __FUNCTION__ << " failed at checkProgram\n";
+		return false;
+	}
+
+	/////////////////////////////////////////////////////////////////
+	// query the program about known uniform vars and vertex attribs
+
+	g_uni[PROG_SKIN][UNI_MVP]    = glGetUniformLocation(g_shader_prog[PROG_SKIN], "mvp");
+	g_uni[PROG_SKIN][UNI_BONE]   = glGetUniformLocation(g_shader_prog[PROG_SKIN], "bone");
+	g_uni[PROG_SKIN][UNI_LP_OBJ] = glGetUniformLocation(g_shader_prog[PROG_SKIN], "lp_obj");
+	g_uni[PROG_SKIN][UNI_VP_OBJ] = glGetUniformLocation(g_shader_prog[PROG_SKIN], "vp_obj");
+
+	g_uni[PROG_SKIN][UNI_SAMPLER_NORMAL] = glGetUniformLocation(g_shader_prog[PROG_SKIN], "normal_map");
+	g_uni[PROG_SKIN][UNI_SAMPLER_ALBEDO] = glGetUniformLocation(g_shader_prog[PROG_SKIN], "albedo_map");
+
+	g_active_attr_semantics[PROG_SKIN].registerVertexAttr(glGetAttribLocation(g_shader_prog[PROG_SKIN], "at_Vertex"));
+	g_active_attr_semantics[PROG_SKIN].registerNormalAttr(glGetAttribLocation(g_shader_prog[PROG_SKIN], "at_Normal"));
+	g_active_attr_semantics[PROG_SKIN].registerBlendWAttr(glGetAttribLocation(g_shader_prog[PROG_SKIN], "at_Weight"));
+	g_active_attr_semantics[PROG_SKIN].registerTCoordAttr(glGetAttribLocation(g_shader_prog[PROG_SKIN], "at_MultiTexCoord0"));
+
 	/////////////////////////////////////////////////////////////////
 	// set up the vertex attrib mapping for all attrib inputs
 
+#if PLATFORM_GL_OES_vertex_array_object
+	glBindVertexArrayOES(g_vao[PROG_SKIN]);
+
+#endif
+	glBindBuffer(GL_ARRAY_BUFFER, g_vbo[VBO_SKIN_VTX]);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_vbo[VBO_SKIN_IDX]);
+
 	if (!setupVertexAttrPointers< Vertex >(g_active_attr_semantics[PROG_SKIN])) {
 		stream::cerr << __FUNCTION__ << " failed at setupVertexAttrPointers\n";
 		return false;
@@ -799,6 +872,9 @@ bool init_resources(
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
+	// assets not taken by now are not going to be
+	util::shared_file_preload().drop();
+
 	on_error.reset();
 	return true;
 }
@@ -860,6 +936,11 @@ bool render_frame(GLuint /* primary_fbo */)
 	if (!check_context(__FUNCTION__))
 		return false;
 
+	/////////////////////////////////////////////////////////////////
+	// upload the texture content streamed in since the last frame
+
+	util::shared_texture_streamer().update();
+
 	/////////////////////////////////////////////////////////////////
 	// clear the framebuffer (both color and depth)
 
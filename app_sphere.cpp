@@ -14,15 +14,22 @@
 #include <string.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <sched.h>
 #include <math.h>
+#include <vector>
 
 #include "scoped.hpp"
 #include "stream.hpp"
 #include "util_tex.hpp"
+#include "util_tex_cache.hpp"
+#include "util_tex_stream.hpp"
 #include "util_misc.hpp"
+#include "util_preload.hpp"
 #include "pure_macro.hpp"
 
 #include "rendVertAttr.hpp"
+#include "rendVertQuant.hpp"
+#include "rendSphere.hpp"
 
 using util::scoped_ptr;
 using util::scoped_functor;
@@ -39,13 +46,25 @@ namespace { // anonymous
 #include "rendVertAttr_setupVertAttrPointers.hpp"
 #undef SETUP_VERTEX_ATTR_POINTERS_MASK
 
+// quantized vertex: snorm16 position in the quantization domain of the mesh, octahedral snorm16
+// normal and tangent, half-float tcoord -- 20 bytes vs 44 bytes of the all-float layout
 struct Vertex {
-	GLfloat pos[3];
-	GLfloat nrm[3];
-	GLfloat tan[3];
-	GLfloat txc[2];
+	GLshort pos[4];
+	GLshort nrm[2];
+	GLshort tan[2];
+	GLushort txc[2];
 };
 
+const rend::VertexFormat& getVertexFormat()
+{
+	static rend::VertexFormat format;
+	format.pos = rend::AttrFormat(3, GL_SHORT, GL_TRUE);
+	format.nrm = rend::AttrFormat(2, GL_SHORT, GL_TRUE);
+	format.tan = rend::AttrFormat(2, GL_SHORT, GL_TRUE);
+	format.txc = rend::AttrFormat(2, GL_HALF_FLOAT_OES, GL_FALSE);
+	return format;
+}
+
 const char arg_prefix[]    = "--";
 const char arg_app[]       = "app";
 
@@ -53,17 +72,27 @@ const char arg_normal[]    = "normal_map";
 const char arg_albedo[]    = "albedo_map";
 const char arg_tile[]      = "tile";
 const char arg_anim_step[] = "anim_step";
+const char arg_sphere[]    = "sphere";
+
+const char* const sphere_topology_name[] = {
+	"polar",
+	"cube",
+	"ico"
+};
 
 struct TexDesc {
 	const char* filename;
 	unsigned w;
 	unsigned h;
+	util::PixFormat format; // of the upload
 };
 
-TexDesc g_normal = { "asset/texture/slate_normal.raw", 1024, 1024 };
-TexDesc g_albedo = { "asset/texture/slate_albedo.raw", 1024, 1024 };
+TexDesc g_normal = { "asset/texture/slate_normal.raw", 1024, 1024, util::PIX_FORMAT_RG88 };
+TexDesc g_albedo = { "asset/texture/slate_albedo.raw", 1024, 1024, util::PIX_FORMAT_RGBA8888 };
 
 float g_tile = 1.f;
+rend::SphereTopology g_sphere_topology = rend::SPHERE_CUBE;
+unsigned g_sphere_lod = 3;
 float g_angle = 0.f;
 float g_angle_step = .0125f;
 
@@ -121,12 +150,14 @@ GLuint g_vao[PROG_COUNT];
 
 #endif
 GLuint g_tex[TEX_COUNT];
+util::texture_cache::handle g_tex_handle[TEX_COUNT]; // of textures from the shared cache
 GLuint g_vbo[VBO_COUNT];
 GLuint g_shader_vert[PROG_COUNT];
 GLuint g_shader_frag[PROG_COUNT];
 GLuint g_shader_prog[PROG_COUNT];
 
 unsigned g_num_faces[MESH_COUNT];
+rend::QuantDomain g_domain[MESH_COUNT];
 
 rend::ActiveAttrSemantics g_active_attr_semantics[PROG_COUNT];
 
@@ -185,6 +216,15 @@ int parse_cli(
 			return 1;
 		}
 	}
+	else
+	if (i + 2 < argc && !strcmp(argv[i], arg_sphere)) {
+		for (unsigned j = 0; j < sizeof(sphere_topology_name) / sizeof(sphere_topology_name[0]); ++j) {
+			if (!strcmp(argv[i + 1], sphere_topology_name[j]) && 1 == sscanf(argv[i + 2], "%u", &g_sphere_lod)) {
+				g_sphere_topology = rend::SphereTopology(j);
+				return 2;
+			}
+		}
+	}
 
 	stream::cerr << "app options:\n"
 		"\t" << arg_prefix << arg_app << " " << arg_normal <<
@@ -194,7 +234,9 @@ int parse_cli(
 		"\t" << arg_prefix << arg_app << " " << arg_tile <<
 		" <n>\t\t\t\t\t: tile texture maps the specified number of times along U, half as much along V\n"
 		"\t" << arg_prefix << arg_app << " " << arg_anim_step <<
-		" <step>\t\t\t\t: use specified rotation step\n\n";
+		" <step>\t\t\t\t: use specified rotation step\n"
+		"\t" << arg_prefix << arg_app << " " << arg_sphere <<
+		" <polar|cube|ico> <lod>\t\t: use specified sphere topology and LOD; default is cube 3\n\n";
 
 	return -1;
 }
@@ -227,33 +269,55 @@ public:
 	}
 };
 
-bool createIndexedPolarSphere(
+// quantize a vertex from its float attributes
+void setVertex(
+	Vertex& v,
+	const rend::QuantDomain& domain,
+	const float (& pos)[3],
+	const float (& nrm)[3],
+	const float (& tan)[3],
+	const float (& txc)[2])
+{
+	domain.quantize(pos, v.pos);
+	rend::quant_octahedral_snorm16(nrm, v.nrm);
+	rend::quant_octahedral_snorm16(tan, v.tan);
+	v.txc[0] = rend::quant_half(txc[0]);
+	v.txc[1] = rend::quant_half(txc[1]);
+}
+
+bool createIndexedSphere(
 	const GLuint vbo_arr,
 	const GLuint vbo_idx,
 	unsigned& num_faces,
-	const int aspect_u_over_v,
-	const int rows = 33,
-	const int cols = 65) __attribute__ ((noinline));
+	rend::QuantDomain& domain,
+	const int aspect_u_over_v) __attribute__ ((noinline));
 
-// bend a polar sphere from a grid of the specified dimensions
-bool createIndexedPolarSphere(
+// produce a unit sphere of the selected topology and LOD
+bool createIndexedSphere(
 	const GLuint vbo_arr,
 	const GLuint vbo_idx,
 	unsigned& num_faces,
-	const int aspect_u_over_v,
-	const int rows,
-	const int cols)
+	rend::QuantDomain& domain,
+	const int aspect_u_over_v)
 {
 	assert(vbo_arr && vbo_idx);
 
 	const float r = 1.f;
-
-	assert(rows > 2);
-	assert(cols > 3);
+	const float bmin[3] = { -r, -r, -r };
+	const float bmax[3] = {  r,  r,  r };
+	domain = rend::QuantDomain(bmin, bmax, true);
 
 	typedef uint16_t Index;
-	const size_t num_verts = (rows - 2) * cols + 2 * (cols - 1);
-	const size_t num_tris = ((rows - 3) * 2 + 2) * (cols - 1);
+	std::vector< rend::SphereVertex > vertex;
+	std::vector< Index > index;
+
+	if (!rend::createSphere(g_sphere_topology, g_sphere_lod, g_tile, g_tile / aspect_u_over_v, vertex, index)) {
+		stream::cerr << __FUNCTION__ << " failed at createSphere\n";
+		return false;
+	}
+
+	const size_t num_verts = vertex.size();
+	const size_t num_tris = index.size() / 3;
 	num_faces = num_tris;
 
 	glBindBuffer(GL_ARRAY_BUFFER, vbo_arr);
@@ -264,138 +328,23 @@ bool createIndexedPolarSphere(
 		return false;
 	}
 
-	scoped_ptr< Vertex, unmap_vtx_buffer > arr(
-		reinterpret_cast< Vertex* >(glMapBufferOES(GL_ARRAY_BUFFER, GL_WRITE_ONLY_OES)));
-	unsigned ai = 0;
-
-	// north pole
-	for (int j = 0; j < cols - 1; ++j) {
-		assert(ai < num_verts);
-
-		const float azim = j * 2 * M_PI / (cols - 1);
-		const float sin_azim = sinf(azim);
-		const float cos_azim = cosf(azim);
-
-		arr()[ai].pos[0] = 0.f;
-		arr()[ai].pos[1] = 0.f;
-		arr()[ai].pos[2] = r;
-
-		arr()[ai].nrm[0] = 0.f;
-		arr()[ai].nrm[1] = 0.f;
-		arr()[ai].nrm[2] = 1.f;
-
-		arr()[ai].tan[0] = -sin_azim;
-		arr()[ai].tan[1] = cos_azim;
-		arr()[ai].tan[2] = 0;
-
-		arr()[ai].txc[0] = g_tile * (j + .5f) / (cols - 1);
-		arr()[ai].txc[1] = g_tile * (1.f / aspect_u_over_v);
-		++ai;
-	}
-
-	// interior
-	for (int i = 1; i < rows - 1; ++i)
-		for (int j = 0; j < cols; ++j) {
-			assert(ai < num_verts);
-
-			const float azim = j * 2 * M_PI / (cols - 1);
-			const float decl = M_PI_2 - i * M_PI / (rows - 1);
-			const float sin_azim = sinf(azim);
-			const float cos_azim = cosf(azim);
-			const float sin_decl = sinf(decl);
-			const float cos_decl = cosf(decl);
-
-			arr()[ai].pos[0] = r * cos_decl * cos_azim;
-			arr()[ai].pos[1] = r * cos_decl * sin_azim;
-			arr()[ai].pos[2] = r * sin_decl;
-
-			arr()[ai].nrm[0] = cos_decl * cos_azim;
-			arr()[ai].nrm[1] = cos_decl * sin_azim;
-			arr()[ai].nrm[2] = sin_decl;
-
-			arr()[ai].tan[0] = -sin_azim;
-			arr()[ai].tan[1] = cos_azim;
-			arr()[ai].tan[2] = 0;
-
-			arr()[ai].txc[0] = g_tile * j / (cols - 1);
-			arr()[ai].txc[1] = g_tile * (rows - 1 - i) / (aspect_u_over_v * rows - aspect_u_over_v);
-			++ai;
-		}
-
-	// south pole
-	for (int j = 0; j < cols - 1; ++j) {
-		assert(ai < num_verts);
-
-		const float azim = j * 2 * M_PI / (cols - 1);
-		const float sin_azim = sinf(azim);
-		const float cos_azim = cosf(azim);
-
-		arr()[ai].pos[0] = 0.f;
-		arr()[ai].pos[1] = 0.f;
-		arr()[ai].pos[2] = -r;
-
-		arr()[ai].nrm[0] = 0.f;
-		arr()[ai].nrm[1] = 0.f;
-		arr()[ai].nrm[2] = -1.f;
-
-		arr()[ai].tan[0] = -sin_azim;
-		arr()[ai].tan[1] = cos_azim;
-		arr()[ai].tan[2] = 0;
+	{
+		scoped_ptr< Vertex, unmap_vtx_buffer > arr(
+			reinterpret_cast< Vertex* >(glMapBufferOES(GL_ARRAY_BUFFER, GL_WRITE_ONLY_OES)));
 
-		arr()[ai].txc[0] = g_tile * (j + .5f) / (cols - 1);
-		arr()[ai].txc[1] = 0.f;
-		++ai;
+		for (size_t i = 0; i < num_verts; ++i)
+			setVertex(arr()[i], domain, vertex[i].pos, vertex[i].pos, vertex[i].tan, vertex[i].txc);
 	}
 
-	assert(ai == num_verts);
-
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo_idx);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(Index[3]) * num_tris, nullptr, GL_STATIC_DRAW);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(Index) * index.size(), &index.front(), GL_STATIC_DRAW);
 
 	if (util::reportGLError()) {
 		stream::cerr << __FUNCTION__ << " failed at glBindBuffer/glBufferData for ELEMENT_ARRAY_BUFFER\n";
 		return false;
 	}
 
-	scoped_ptr< Index[3], unmap_idx_buffer > idx(
-		reinterpret_cast< Index(*)[3] >(glMapBufferOES(GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY_OES)));
-	unsigned ii = 0;
-
-	// north pole
-	for (unsigned j = 0; j < cols - 1; ++j) {
-		assert(ii < num_tris);
-		idx()[ii][0] = Index(j);
-		idx()[ii][1] = Index(j + cols - 1);
-		idx()[ii][2] = Index(j + cols);
-		++ii;
-	}
-
-	// interior
-	for (int i = 1; i < rows - 2; ++i)
-		for (int j = 0; j < cols - 1; ++j) {
-			assert(ii < num_tris);
-			idx()[ii][0] = Index(j + i * cols);
-			idx()[ii][1] = Index(j + i * cols - 1);
-			idx()[ii][2] = Index(j + (i + 1) * cols);
-			++ii;
-
-			assert(ii < num_tris);
-			idx()[ii][0] = Index(j + (i + 1) * cols - 1);
-			idx()[ii][1] = Index(j + (i + 1) * cols);
-			idx()[ii][2] = Index(j + i * cols - 1);
-			++ii;
-		}
-
-	// south pole
-	for (unsigned j = 0; j < cols - 1; ++j) {
-		assert(ii < num_tris);
-		idx()[ii][0] = Index(j + (rows - 2) * cols);
-		idx()[ii][1] = Index(j + (rows - 2) * cols - 1);
-		idx()[ii][2] = Index(j + (rows - 2) * cols + cols - 1);
-		++ii;
-	}
-
-	assert(ii == num_tris);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 	stream::cout << "number of vertices: " << num_verts << "\nnumber of faces: " << num_tris << '\n';
 
 	return true;
@@ -444,6 +393,8 @@ bool deinit_resources()
 	if (!check_context(__FUNCTION__))
 		return false;
 
+	util::shared_file_preload().drop();
+
 	for (unsigned i = 0; i < sizeof(g_shader_prog) / sizeof(g_shader_prog[0]); ++i) {
 		glDeleteProgram(g_shader_prog[i]);
 		g_shader_prog[i] = 0;
@@ -459,9 +410,25 @@ bool deinit_resources()
 		g_shader_frag[i] = 0;
 	}
 
-	glDeleteTextures(sizeof(g_tex) / sizeof(g_tex[0]), g_tex);
+	util::texture_cache& tex_cache = util::shared_texture_cache();
+
+	for (unsigned i = 0; i < sizeof(g_tex_handle) / sizeof(g_tex_handle[0]); ++i)
+		if (0 != g_tex_handle[i])
+			tex_cache.release(g_tex_handle[i]);
+
+	memset(g_tex_handle, 0, sizeof(g_tex_handle));
 	memset(g_tex, 0, sizeof(g_tex));
 
+	const util::texture_cache::stats& tex_stats = tex_cache.get_stats();
+
+	stream::cout << "texture cache hits: " << tex_stats.hits << ", misses: " << tex_stats.misses <<
+		", resident: " << tex_stats.num_resident << " textures of " << tex_stats.bytes_resident << " bytes\n";
+
+	// cached textures go along with the GL context
+	tex_cache.purge();
+	tex_cache.set_streamer(0);
+	util::shared_texture_streamer().deinit();
+
 #if PLATFORM_GL_OES_vertex_array_object
 	glDeleteVertexArraysOES(sizeof(g_vao) / sizeof(g_vao[0]), g_vao);
 	memset(g_vao, 0, sizeof(g_vao));
@@ -520,6 +487,18 @@ bool init_resources(
 #endif
 	scoped_ptr< deinit_resources_t, scoped_functor > on_error(deinit_resources);
 
+	/////////////////////////////////////////////////////////////////
+	// have the reads of the assets below go out together; the loaders map them, so warm the page cache
+
+	const char* const asset[] = {
+		g_normal.filename,
+		g_albedo.filename,
+		"asset/shader/blinn_bump_tang.glslv",
+		"asset/shader/blinn_bump_tang.glslf"
+	};
+
+	util::shared_file_preload().warm(asset, sizeof(asset) / sizeof(asset[0]));
+
 	/////////////////////////////////////////////////////////////////
 	// set up misc control bits and values
 
@@ -534,26 +513,47 @@ bool init_resources(
 	glClearColor(red, green, blue, alpha);
 
 	/////////////////////////////////////////////////////////////////
-	// reserve all necessary texture objects
+	// half-float tcoords need vertex half-float support
 
-	glGenTextures(sizeof(g_tex) / sizeof(g_tex[0]), g_tex);
-
-	for (unsigned i = 0; i < sizeof(g_tex) / sizeof(g_tex[0]); ++i)
-		assert(g_tex[i]);
+#if PLATFORM_GL == 0
+	if (!util::hasGLExtension("GL_OES_vertex_half_float")) {
+		stream::cerr << __FUNCTION__ << " requires GL_OES_vertex_half_float\n";
+		return false;
+	}
 
+#endif
 	/////////////////////////////////////////////////////////////////
-	// load textures
+	// acquire textures from the shared cache
+
+	util::texture_cache& tex_cache = util::shared_texture_cache();
+	util::texture_streamer& tex_streamer = util::shared_texture_streamer();
+
+	// on GLES3 the texture content streams in past the init
+	if (tex_streamer.init())
+		tex_cache.set_streamer(&tex_streamer);
 
-	if (!util::setupTexture2D(g_tex[TEX_NORMAL], g_normal.filename, g_normal.w, g_normal.h)) {
-		stream::cerr << __FUNCTION__ << " failed at setupTexture2D\n";
+	// the sphere textures stream only as fine as the sphere shows them
+	tex_streamer.set_on_demand(true);
+
+	GLenum normal_format;
+
+	g_tex_handle[TEX_NORMAL] = tex_cache.acquire(g_normal.filename, g_normal.w, g_normal.h, false, util::MIP_MODE_NORMAL, g_normal.format, &normal_format);
+
+	if (0 == g_tex_handle[TEX_NORMAL]) {
+		stream::cerr << __FUNCTION__ << " failed at texture_cache::acquire\n";
 		return false;
 	}
 
-	if (!util::setupTexture2D(g_tex[TEX_ALBEDO], g_albedo.filename, g_albedo.w, g_albedo.h)) {
-		stream::cerr << __FUNCTION__ << " failed at setupTexture2D\n";
+	g_tex_handle[TEX_ALBEDO] = tex_cache.acquire(g_albedo.filename, g_albedo.w, g_albedo.h, false, util::MIP_MODE_SRGB, g_albedo.format);
+
+	if (0 == g_tex_handle[TEX_ALBEDO]) {
+		stream::cerr << __FUNCTION__ << " failed at texture_cache::acquire\n";
 		return false;
 	}
 
+	g_tex[TEX_NORMAL] = tex_cache.get_name(g_tex_handle[TEX_NORMAL]);
+	g_tex[TEX_ALBEDO] = tex_cache.get_name(g_tex_handle[TEX_ALBEDO]);
+
 	/////////////////////////////////////////////////////////////////
 	// init the program/uniforms matrix to all empty
 
@@ -575,7 +575,15 @@ bool init_resources(
 	g_shader_frag[PROG_SPHERE] = glCreateShader(GL_FRAGMENT_SHADER);
 	assert(g_shader_frag[PROG_SPHERE]);
 
-	if (!util::setupShader(g_shader_frag[PROG_SPHERE], "asset/shader/blinn_bump_tang.glslf")) {
+	// normal maps of x and y only get their z reconstructed
+	const std::string patch[] = {
+		"false; // normal map of x and y only",
+		2 == util::textureFormatComponents(normal_format) ? "true; // normal map of x and y only" : "false; // normal map of x and y only"
+	};
+
+	if (!util::setupShaderWithPatch(g_shader_frag[PROG_SPHERE], "asset/shader/blinn_bump_tang.glslf",
+			sizeof(patch) / sizeof(patch[0]) / 2, patch))
+	{
 		stream::cerr << __FUNCTION__ << " failed at setupShader\n";
 		return false;
 	}
@@ -583,12 +591,57 @@ bool init_resources(
 	g_shader_prog[PROG_SPHERE] = glCreateProgram();
 	assert(g_shader_prog[PROG_SPHERE]);
 
-	if (!util::setupProgram(
+	if (!util::submitProgram(
 			g_shader_prog[PROG_SPHERE],
 			g_shader_vert[PROG_SPHERE],
 			g_shader_frag[PROG_SPHERE]))
 	{
-		stream::cerr << __FUNCTION__ << " failed at setupProgram\n";
+		stream::cerr << __FUNCTION__ << " failed at submitProgram\n";
+		return false;
+	}
+
+	/////////////////////////////////////////////////////////////////
+	// reserve VAO (if available) and all necessary VBOs
+
+#if PLATFORM_GL_OES_vertex_array_object
+	glGenVertexArraysOES(sizeof(g_vao) / sizeof(g_vao[0]), g_vao);
+
+	for (unsigned i = 0; i < sizeof(g_vao) / sizeof(g_vao[0]); ++i)
+		assert(g_vao[i]);
+
+#endif
+	glGenBuffers(sizeof(g_vbo) / sizeof(g_vbo[0]), g_vbo);
+
+	for (unsigned i = 0; i < sizeof(g_vbo) / sizeof(g_vbo[0]); ++i)
+		assert(g_vbo[i]);
+
+	/////////////////////////////////////////////////////////////////
+	// produce some geometric asset and put that in the VBOs
+
+	if (!createIndexedSphere(
+			g_vbo[VBO_SPHERE_VTX],
+			g_vbo[VBO_SPHERE_IDX],
+			g_num_faces[MESH_SPHERE],
+			g_domain[MESH_SPHERE],
+			g_normal.w == g_normal.h ? 2 : 1))
+	{
+		stream::cerr << __FUNCTION__ << " failed at createIndexedSphere\n";
+		return false;
+	}
+
+	/////////////////////////////////////////////////////////////////
+	// the program is needed from here on; its compile and link went on while producing the sphere, and
+	// while the driver is still on it, upload the texture content streamed in meanwhile
+
+	while (!util::isProgramComplete(g_shader_prog[PROG_SPHERE]) &&
+		(tex_streamer.is_pending(g_tex[TEX_NORMAL]) || tex_streamer.is_pending(g_tex[TEX_ALBEDO]))) {
+
+		tex_streamer.update();
+		sched_yield();
+	}
+
+	if (!util::checkProgram(g_shader_prog[PROG_SPHERE])) {
+		stream::cerr << __FUNCTION__ << " failed at checkProgram\n";
 		return false;
 	}
 
@@ -608,29 +661,16 @@ bool init_resources(
 	g_active_attr_semantics[PROG_SPHERE].registerTCoordAttr(glGetAttribLocation(g_shader_prog[PROG_SPHERE], "at_MultiTexCoord0"));
 
 	/////////////////////////////////////////////////////////////////
-	// reserve VAO (if available) and all necessary VBOs
+	// set up the vertex attrib mapping for all attrib inputs
 
 #if PLATFORM_GL_OES_vertex_array_object
-	glGenVertexArraysOES(sizeof(g_vao) / sizeof(g_vao[0]), g_vao);
-
-	for (unsigned i = 0; i < sizeof(g_vao) / sizeof(g_vao[0]); ++i)
-		assert(g_vao[i]);
-
 	glBindVertexArrayOES(g_vao[PROG_SPHERE]);
 
 #endif
-	glGenBuffers(sizeof(g_vbo) / sizeof(g_vbo[0]), g_vbo);
-
-	for (unsigned i = 0; i < sizeof(g_vbo) / sizeof(g_vbo[0]); ++i)
-		assert(g_vbo[i]);
-
-	/////////////////////////////////////////////////////////////////
-	// set up the vertex attrib mapping for all attrib inputs
-
 	glBindBuffer(GL_ARRAY_BUFFER, g_vbo[VBO_SPHERE_VTX]);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_vbo[VBO_SPHERE_IDX]);
 
-	if (!setupVertexAttrPointers< Vertex >(g_active_attr_semantics[PROG_SPHERE])) {
+	if (!setupVertexAttrPointers< Vertex >(g_active_attr_semantics[PROG_SPHERE], 0, getVertexFormat())) {
 		stream::cerr << __FUNCTION__ << " failed at setupVertexAttrPointers\n";
 		return false;
 	}
@@ -653,18 +693,8 @@ bool init_resources(
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
-	/////////////////////////////////////////////////////////////////
-	// produce some geometric asset and put that in the VBOs
-
-	if (!createIndexedPolarSphere(
-			g_vbo[VBO_SPHERE_VTX],
-			g_vbo[VBO_SPHERE_IDX],
-			g_num_faces[MESH_SPHERE],
-			g_normal.w == g_normal.h ? 2 : 1))
-	{
-		stream::cerr << __FUNCTION__ << " failed at createIndexedPolarSphere\n";
-		return false;
-	}
+	// assets not taken by now are not going to be
+	util::shared_file_preload().drop();
 
 	on_error.reset();
 	return true;
@@ -764,6 +794,11 @@ bool render_frame(GLuint /* primary_fbo */)
 	if (!check_context(__FUNCTION__))
 		return false;
 
+	/////////////////////////////////////////////////////////////////
+	// upload the texture content streamed in since the last frame
+
+	util::shared_texture_streamer().update();
+
 	/////////////////////////////////////////////////////////////////
 	// clear the framebuffer (color-only)
 
@@ -775,6 +810,14 @@ bool render_frame(GLuint /* primary_fbo */)
 	GLint vp[4];
 	glGetIntegerv(GL_VIEWPORT, vp);
 
+	/////////////////////////////////////////////////////////////////
+	// report the texture demand: the texture wraps g_tile times around the equator of the sphere
+
+	const float tex_extent = M_PI * vp[3] / g_tile;
+
+	util::shared_texture_streamer().set_demand(g_tex[TEX_NORMAL], tex_extent);
+	util::shared_texture_streamer().set_demand(g_tex[TEX_ALBEDO], tex_extent);
+
 	/////////////////////////////////////////////////////////////////
 	// produce rotational matrix from Euler angles
 
@@ -788,13 +831,17 @@ bool render_frame(GLuint /* primary_fbo */)
 	const float aspect = float(vp[3]) / vp[2];
 
 	// expand to 4x4, sign-inverting z in all original columns (for GL screen space)
-	const GLfloat mvp[4][4] = {
+	GLfloat mvp[4][4] = {
 		{  p1[0][0] * aspect,  p1[0][1], -p1[0][2],  0.f },
 		{  p1[1][0] * aspect,  p1[1][1], -p1[1][2],  0.f },
 		{  p1[2][0] * aspect,  p1[2][1], -p1[2][2],  0.f },
 		{  0.f,                0.f,       0.f,       1.f }
 	};
 
+	// positions come quantized -- fold their dequantization into the mvp; the domain is isotropic
+	// and centred at the origin, so object-space light and viewer directions remain valid as-is
+	g_domain[MESH_SPHERE].fold_dequant(mvp);
+
 	g_angle = fmodf(g_angle + g_angle_step, 2.f * M_PI);
 
 	/////////////////////////////////////////////////////////////////
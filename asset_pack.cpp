@@ -0,0 +1,212 @@
+////////////////////////////////////////////////////////////////////////////////
+// asset-pack builder: packs files and directory trees to an asset pack of
+// util_pack, under the names they go by on the command line, e.g.
+// asset/shader/basic.glslf, which is how the apps name them; content goes in
+// the order of the arguments, directories walked in name order, so list what
+// the apps load first, first; -z stores entries in the block container of
+// util_lz where that pays off
+//
+// build as: $ g++ -O3 -pthread asset_pack.cpp util_lz.cpp util_file.cpp util_pack.cpp util_preload.cpp
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <dirent.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "util_file.hpp"
+#include "util_lz.hpp"
+#include "util_pack.hpp"
+
+// names of the files under a path, directories walked in name order
+static bool collect(
+	std::string path,
+	std::vector< std::string >& names)
+{
+	while (0 == path.compare(0, 2, "./"))
+		path.erase(0, 2);
+
+	while (1 < path.size() && '/' == path[path.size() - 1])
+		path.erase(path.size() - 1);
+
+	struct stat filestat;
+
+	if (-1 == stat(path.c_str(), &filestat)) {
+		fprintf(stderr, "error: cannot stat '%s'\n", path.c_str());
+		return false;
+	}
+
+	if (S_ISREG(filestat.st_mode)) {
+		names.push_back(path);
+		return true;
+	}
+
+	if (!S_ISDIR(filestat.st_mode))
+		return true;
+
+	DIR* const dir = opendir(path.c_str());
+
+	if (0 == dir) {
+		fprintf(stderr, "error: cannot open directory '%s'\n", path.c_str());
+		return false;
+	}
+
+	std::vector< std::string > children;
+
+	while (const dirent* const entry = readdir(dir))
+		if (0 != strcmp(entry->d_name, ".") && 0 != strcmp(entry->d_name, ".."))
+			children.push_back(entry->d_name);
+
+	closedir(dir);
+	std::sort(children.begin(), children.end());
+
+	for (size_t i = 0; i < children.size(); ++i)
+		if (!collect(path + '/' + children[i], names))
+			return false;
+
+	return true;
+}
+
+struct ByName
+{
+	const std::vector< std::string >* names;
+
+	bool operator()(
+		const uint32_t a,
+		const uint32_t b) const
+	{
+		return strcmp((*names)[a].c_str(), (*names)[b].c_str()) < 0;
+	}
+};
+
+static bool pad(
+	FILE* const file,
+	const uint64_t size)
+{
+	static const uint8_t zero[util::pack_alignment] = { 0 };
+	const size_t count = size_t((util::pack_alignment - size % util::pack_alignment) % util::pack_alignment);
+
+	return 0 == count || 1 == fwrite(zero, count, 1, file);
+}
+
+int main(
+	int argc,
+	char** argv)
+{
+	bool compress = false;
+	int arg = 1;
+
+	if (arg < argc && 0 == strcmp(argv[arg], "-z")) {
+		compress = true;
+		++arg;
+	}
+
+	if (arg + 2 > argc) {
+		fprintf(stderr, "usage: %s [-z] <output.pack> <file|dir> [<file|dir> ...]\n", argv[0]);
+		return -1;
+	}
+
+	const char* const output = argv[arg++];
+	std::vector< std::string > names;
+
+	for (; arg < argc; ++arg)
+		if (!collect(argv[arg], names))
+			return -1;
+
+	// the directory goes by name, the content by the order of collection
+	std::vector< uint32_t > order(names.size());
+
+	for (size_t i = 0; i < order.size(); ++i)
+		order[i] = uint32_t(i);
+
+	const ByName by_name = { &names };
+	std::sort(order.begin(), order.end(), by_name);
+
+	for (size_t i = 1; i < order.size(); ++i)
+		if (names[order[i - 1]] == names[order[i]]) {
+			fprintf(stderr, "error: duplicate name '%s'\n", names[order[i]].c_str());
+			return -1;
+		}
+
+	std::vector< util::PackEntry > entry(names.size());
+	std::vector< uint32_t > entry_of(names.size());
+	std::string name_table;
+
+	for (size_t i = 0; i < order.size(); ++i) {
+		entry_of[order[i]] = uint32_t(i);
+		entry[i].name = uint32_t(name_table.size());
+		name_table.append(names[order[i]].c_str(), names[order[i]].size() + 1);
+	}
+
+	const uint64_t dir_size = util::pack_header_size + sizeof(util::PackEntry) * entry.size() + name_table.size();
+	uint64_t offset = (dir_size + util::pack_alignment - 1) / util::pack_alignment * util::pack_alignment;
+
+	FILE* const file = fopen(output, "wb");
+
+	if (0 == file) {
+		fprintf(stderr, "error: cannot open '%s'\n", output);
+		return -1;
+	}
+
+	// content first, past the room for the directory
+	bool success = 0 == fseek(file, long(offset), SEEK_SET);
+	uint64_t total = 0;
+
+	for (size_t i = 0; i < names.size() && success; ++i) {
+		util::mapped_file content;
+
+		if (!content.open(names[i].c_str())) {
+			fclose(file);
+			return -1;
+		}
+
+		std::vector< uint8_t > packed;
+		const uint8_t* data = content.data();
+		uint64_t size = content.length();
+		uint32_t flags = 0;
+
+		if (compress && 0 != size) {
+			util::lz_compress(content.data(), content.length(), packed);
+
+			if (packed.size() < content.length()) {
+				data = &packed[0];
+				size = packed.size();
+				flags = util::PACK_FLAG_LZ;
+			}
+		}
+
+		util::PackEntry& e = entry[entry_of[i]];
+		e.offset = offset;
+		e.size = size;
+		e.flags = flags;
+
+		success = (0 == size || 1 == fwrite(data, size_t(size), 1, file)) && pad(file, size);
+		offset += (size + util::pack_alignment - 1) / util::pack_alignment * util::pack_alignment;
+		total += content.length();
+	}
+
+	const uint32_t header[3] = { uint32_t(entry.size()), uint32_t(name_table.size()), 0 };
+
+	success = success &&
+		0 == fseek(file, 0, SEEK_SET) &&
+		1 == fwrite("APK1", 4, 1, file) &&
+		1 == fwrite(header, sizeof(header), 1, file) &&
+		(entry.empty() || 1 == fwrite(&entry[0], sizeof(util::PackEntry) * entry.size(), 1, file)) &&
+		(name_table.empty() || 1 == fwrite(name_table.data(), name_table.size(), 1, file)) &&
+		pad(file, dir_size);
+
+	if (0 != fclose(file) || !success) {
+		fprintf(stderr, "error: failure writing '%s'\n", output);
+		return -1;
+	}
+
+	fprintf(stdout, "%u entries, %llu bytes of content, %llu bytes of pack\n",
+		unsigned(entry.size()), (unsigned long long) total, (unsigned long long) offset);
+
+	return 0;
+}
@@ -0,0 +1,123 @@
+////////////////////////////////////////////////////////////////////////////////
+// microbenchmark of vertex gather: per-attribute memcpy, as the mesh loaders
+// used to do it, vs rend::gatherVertices on one and on all CPUs
+//
+// build as: $ g++ -O3 bench_vert_gather.cpp rendVertGather.cpp -lpthread
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <vector>
+
+#include "timer.h"
+#include "rendVertGather.hpp"
+
+enum {
+	SEMANTIC_POS,
+	SEMANTIC_BON,
+	SEMANTIC_NRM,
+	SEMANTIC_TXC,
+
+	SEMANTIC_COUNT
+};
+
+// layout of the output vertex: { pos, bon, nrm, txc }
+const size_t dst_stride = sizeof(float[12]);
+const size_t dst_offset[SEMANTIC_COUNT] = { 0, 12, 28, 40 };
+
+// sources: pos and nrm interleaved in one buffer, bon and txc in buffers of their own
+size_t src_size[SEMANTIC_COUNT] = { 12, 16, 12, 8 };
+size_t src_offset[SEMANTIC_COUNT] = { 0, 0, 12, 0 };
+size_t src_stride[SEMANTIC_COUNT] = { 24, 16, 24, 8 };
+
+static void gather_memcpy(
+	uint8_t* dst,
+	const uint8_t* const (& src)[SEMANTIC_COUNT],
+	const size_t num_verts)
+{
+	for (size_t i = 0; i < num_verts; ++i) {
+		for (size_t j = 0; j < SEMANTIC_COUNT; ++j)
+			memcpy(dst + dst_offset[j], src[j] + i * src_stride[j] + src_offset[j], src_size[j]);
+
+		dst += dst_stride;
+	}
+}
+
+int main(
+	int argc,
+	char** argv)
+{
+	size_t num_verts = 1 << 20;
+	unsigned reps = 16;
+
+	if ((1 < argc && 1 != sscanf(argv[1], "%zu", &num_verts)) ||
+		(2 < argc && 1 != sscanf(argv[2], "%u", &reps))) {
+
+		fprintf(stderr, "usage: %s [num_verts [reps]]\n", argv[0]);
+		return -1;
+	}
+
+	std::vector< float > pos_nrm(num_verts * 6);
+	std::vector< float > bon(num_verts * 4);
+	std::vector< float > txc(num_verts * 2);
+
+	for (size_t i = 0; i < pos_nrm.size(); ++i)
+		pos_nrm[i] = float(i);
+	for (size_t i = 0; i < bon.size(); ++i)
+		bon[i] = float(i) * .5f;
+	for (size_t i = 0; i < txc.size(); ++i)
+		txc[i] = float(i) * .25f;
+
+	const uint8_t* const src[SEMANTIC_COUNT] = {
+		reinterpret_cast< const uint8_t* >(&pos_nrm.front()),
+		reinterpret_cast< const uint8_t* >(&bon.front()),
+		reinterpret_cast< const uint8_t* >(&pos_nrm.front()),
+		reinterpret_cast< const uint8_t* >(&txc.front())
+	};
+
+	rend::GatherLayout layout(dst_stride);
+	const rend::GatherFormat format[SEMANTIC_COUNT] = {
+		rend::GATHER_FLOAT3,
+		rend::GATHER_FLOAT4,
+		rend::GATHER_FLOAT3,
+		rend::GATHER_FLOAT2
+	};
+
+	for (size_t j = 0; j < SEMANTIC_COUNT; ++j)
+		layout.add(src[j] + src_offset[j], src_stride[j], dst_offset[j], format[j]);
+
+	std::vector< uint8_t > ref(num_verts * dst_stride);
+	std::vector< uint8_t > out(num_verts * dst_stride);
+	const double mbytes = double(num_verts * dst_stride) / (1 << 20);
+
+	const char* const name[] = { "memcpy", "gather, 1 thread", "gather, auto threads" };
+	const unsigned threads[] = { 0, 1, 0 };
+
+	for (size_t k = 0; k < sizeof(name) / sizeof(name[0]); ++k) {
+		uint64_t best = uint64_t(-1);
+
+		for (unsigned r = 0; r < reps; ++r) {
+			const uint64_t t0 = timer_ns();
+
+			if (0 == k)
+				gather_memcpy(&ref.front(), src, num_verts);
+			else
+				rend::gatherVertices(layout, &out.front(), num_verts, threads[k]);
+
+			const uint64_t dt = timer_ns() - t0;
+
+			if (dt < best)
+				best = dt;
+		}
+
+		if (0 != k && 0 != memcmp(&ref.front(), &out.front(), ref.size())) {
+			fprintf(stderr, "%s: output mismatch\n", name[k]);
+			return 1;
+		}
+
+		fprintf(stdout, "%-24s: %8.3f ms, %8.1f MB/s\n", name[k], best * 1e-6, mbytes / (best * 1e-9));
+	}
+
+	return 0;
+}
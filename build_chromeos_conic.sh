@@ -10,6 +10,9 @@ SOURCES_CXX=(
 	main_chromeos.cpp
 	app_conic.cpp
 	util_file.cpp
+	util_lz.cpp
+	util_pack.cpp
+	util_preload.cpp
 	util_misc.cpp
 )
 CXXFLAGS=(
@@ -21,6 +24,8 @@ CXXFLAGS=(
 	-DPLATFORM_GLES
 	-DPLATFORM_GL_OES_vertex_array_object
 	-DPLATFORM_GL_KHR_debug
+	-DPLATFORM_GL_OES_get_program_binary
+	-DPLATFORM_GL_KHR_parallel_shader_compile
 	-I./khronos
 	-I./libdrm
 	-I./protocol
@@ -29,6 +34,7 @@ LFLAGS=(
 #	-fuse-ld=lld
 	/usr/lib/libwayland-client.so
 	-lrt
+	-lpthread
 	-ldl
 	/usr/lib/libEGL.so
 	/usr/lib/libGLESv2.so
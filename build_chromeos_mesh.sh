@@ -10,7 +10,16 @@ SOURCES_CXX=(
 	main_chromeos.cpp
 	app_mesh.cpp
 	rendIndexedTrilist.cpp
+	rendIndexedTrilist_PLY.cpp
+	rendVertGather.cpp
+	rendIndexCodec.cpp
+	rendCluster.cpp
+	rendLod.cpp
+	rendMeshPager.cpp
 	util_file.cpp
+	util_lz.cpp
+	util_pack.cpp
+	util_preload.cpp
 	util_misc.cpp
 )
 CXXFLAGS=(
@@ -23,6 +32,8 @@ CXXFLAGS=(
 	-DPLATFORM_GLES
 	-DPLATFORM_GL_OES_vertex_array_object
 	-DPLATFORM_GL_KHR_debug
+	-DPLATFORM_GL_OES_get_program_binary
+	-DPLATFORM_GL_KHR_parallel_shader_compile
 	-I./khronos
 	-I./libdrm
 	-I./protocol
@@ -31,6 +42,7 @@ LFLAGS=(
 #	-fuse-ld=lld
 	/usr/lib/libwayland-client.so
 	-lrt
+	-lpthread
 	-ldl
 	/usr/lib/libEGL.so
 	/usr/lib/libGLESv2.so
@@ -11,7 +11,15 @@ SOURCES_CXX=(
 	app_skinning.cpp
 	rendSkeleton.cpp
 	util_tex.cpp
+	util_tex_cache.cpp
+	util_tex_stream.cpp
+	util_mip.cpp
+	util_pix.cpp
+	util_height.cpp
 	util_file.cpp
+	util_lz.cpp
+	util_pack.cpp
+	util_preload.cpp
 	util_misc.cpp
 )
 CXXFLAGS=(
@@ -23,6 +31,8 @@ CXXFLAGS=(
 	-DPLATFORM_GLES
 	-DPLATFORM_GL_OES_vertex_array_object
 	-DPLATFORM_GL_KHR_debug
+	-DPLATFORM_GL_OES_get_program_binary
+	-DPLATFORM_GL_KHR_parallel_shader_compile
 	-I./khronos
 	-I./libdrm
 	-I./protocol
@@ -31,6 +41,7 @@ LFLAGS=(
 #	-fuse-ld=lld
 	/usr/lib/libwayland-client.so
 	-lrt
+	-lpthread
 	-ldl
 	/usr/lib/libEGL.so
 	/usr/lib/libGLESv2.so
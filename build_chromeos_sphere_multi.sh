@@ -9,8 +9,17 @@ SOURCES_C=(
 SOURCES_CXX=(
 	main_chromeos.cpp
 	app_sphere_multi.cpp
+	rendSphere.cpp
 	util_tex.cpp
+	util_tex_cache.cpp
+	util_tex_stream.cpp
+	util_mip.cpp
+	util_pix.cpp
+	util_height.cpp
 	util_file.cpp
+	util_lz.cpp
+	util_pack.cpp
+	util_preload.cpp
 	util_misc.cpp
 )
 CXXFLAGS=(
@@ -23,6 +32,8 @@ CXXFLAGS=(
 	-DPLATFORM_GLES
 	-DPLATFORM_GL_OES_vertex_array_object
 	-DPLATFORM_GL_KHR_debug
+	-DPLATFORM_GL_OES_get_program_binary
+	-DPLATFORM_GL_KHR_parallel_shader_compile
 	-I./khronos
 	-I./libdrm
 	-I./protocol
@@ -31,6 +42,7 @@ LFLAGS=(
 #	-fuse-ld=lld
 	/usr/lib/libwayland-client.so
 	-lrt
+	-lpthread
 	-ldl
 	/usr/lib/libEGL.so
 	/usr/lib/libGLESv2.so
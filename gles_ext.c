@@ -39,6 +39,15 @@ PFNGLOBJECTPTRLABELKHRPROC       glObjectPtrLabelKHR;
 PFNGLGETOBJECTPTRLABELKHRPROC    glGetObjectPtrLabelKHR;
 PFNGLGETPOINTERVKHRPROC          glGetPointervKHR;
 
+#endif
+#if PLATFORM_GL_OES_get_program_binary
+PFNGLGETPROGRAMBINARYOESPROC glGetProgramBinaryOES;
+PFNGLPROGRAMBINARYOESPROC    glProgramBinaryOES;
+
+#endif
+#if PLATFORM_GL_KHR_parallel_shader_compile
+PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glMaxShaderCompilerThreadsKHR;
+
 #endif
 void init_gles_ext(void) {
 
@@ -77,6 +86,15 @@ void init_gles_ext(void) {
 	glGetObjectPtrLabelKHR    = (PFNGLGETOBJECTPTRLABELKHRPROC)    eglGetProcAddress("glGetObjectPtrLabelKHR");
 	glGetPointervKHR          = (PFNGLGETPOINTERVKHRPROC)          eglGetProcAddress("glGetPointervKHR");
 
+#endif
+#if PLATFORM_GL_OES_get_program_binary
+	glGetProgramBinaryOES = (PFNGLGETPROGRAMBINARYOESPROC) eglGetProcAddress("glGetProgramBinaryOES");
+	glProgramBinaryOES    = (PFNGLPROGRAMBINARYOESPROC)    eglGetProcAddress("glProgramBinaryOES");
+
+#endif
+#if PLATFORM_GL_KHR_parallel_shader_compile
+	glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC) eglGetProcAddress("glMaxShaderCompilerThreadsKHR");
+
 #endif
 }
 
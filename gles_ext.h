@@ -38,6 +38,15 @@ extern PFNGLOBJECTPTRLABELKHRPROC       glObjectPtrLabelKHR;
 extern PFNGLGETOBJECTPTRLABELKHRPROC    glGetObjectPtrLabelKHR;
 extern PFNGLGETPOINTERVKHRPROC          glGetPointervKHR;
 
+#endif
+#if PLATFORM_GL_OES_get_program_binary
+extern PFNGLGETPROGRAMBINARYOESPROC glGetProgramBinaryOES;
+extern PFNGLPROGRAMBINARYOESPROC    glProgramBinaryOES;
+
+#endif
+#if PLATFORM_GL_KHR_parallel_shader_compile
+extern PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glMaxShaderCompilerThreadsKHR;
+
 #endif
 #if __cplusplus
 extern "C" {
@@ -0,0 +1,91 @@
+////////////////////////////////////////////////////////////////////////////////
+// block-container packer: compresses a file -- a .raw texture, a binary mesh,
+// anything mapped_file or get_buffer_from_file loads -- to the block container
+// of util_lz, which those decompress at load in place of the original; inputs
+// that are containers already get unpacked first, so -d amounts to an unpack
+//
+// build as: $ g++ -O3 -pthread lz_pack.cpp util_lz.cpp util_file.cpp util_pack.cpp util_preload.cpp
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <vector>
+
+#include "util_file.hpp"
+#include "util_lz.hpp"
+
+int main(
+	int argc,
+	char** argv)
+{
+	bool unpack = false;
+	unsigned block_kib = util::lz_default_block_size >> 10;
+	int arg = 1;
+
+	for (; arg + 2 < argc; ++arg) {
+		if (0 == strcmp(argv[arg], "-d"))
+			unpack = true;
+		else
+		if (0 == strcmp(argv[arg], "-b") && arg + 3 < argc && 1 == sscanf(argv[arg + 1], "%u", &block_kib))
+			++arg;
+		else
+			break;
+	}
+
+	if (arg + 2 != argc || 0 == block_kib || size_t(util::lz_max_block_size >> 10) < block_kib) {
+		fprintf(stderr, "usage: %s [-d] [-b block_kib] <input> <output>\n", argv[0]);
+		return -1;
+	}
+
+	const char* const input = argv[arg];
+	const char* const output = argv[arg + 1];
+
+	// containers come out of the mapping decompressed
+	util::mapped_file file;
+
+	if (!file.open(input)) {
+		fprintf(stderr, "error: cannot read '%s'\n", input);
+		return -1;
+	}
+
+	std::vector< uint8_t > packed;
+	const uint8_t* out = file.data();
+	size_t out_size = file.length();
+
+	if (!unpack) {
+		util::lz_compress(file.data(), file.length(), packed, size_t(block_kib) << 10);
+
+		// verify the round trip before anything goes out
+		std::vector< uint8_t > check(file.length());
+
+		if (!util::lz_decompress(&packed[0], packed.size(), check.empty() ? 0 : &check[0], check.size()) ||
+			(!check.empty() && 0 != memcmp(&check[0], file.data(), check.size()))) {
+
+			fprintf(stderr, "error: round trip failed for '%s'\n", input);
+			return -1;
+		}
+
+		out = &packed[0];
+		out_size = packed.size();
+	}
+
+	FILE* const f = fopen(output, "wb");
+
+	if (0 == f) {
+		fprintf(stderr, "error: cannot open '%s'\n", output);
+		return -1;
+	}
+
+	const bool success = 0 == out_size || 1 == fwrite(out, out_size, 1, f);
+
+	if (0 != fclose(f) || !success) {
+		fprintf(stderr, "error: failure writing '%s'\n", output);
+		return -1;
+	}
+
+	fprintf(stdout, "%s: %u -> %u bytes (%.1f%%)\n", input, unsigned(file.length()), unsigned(out_size),
+		0 != file.length() ? 100.0 * out_size / file.length() : 100.0);
+
+	return 0;
+}
@@ -21,6 +21,7 @@
 
 #include "stream.hpp"
 #include "util_file.hpp"
+#include "util_pack.hpp"
 #include "util_misc.hpp"
 #include "scoped.hpp"
 #include "pure_macro.hpp"
@@ -77,6 +78,7 @@ const char arg_bitness[]       = "bitness";
 const char arg_fsaa[]          = "fsaa";
 const char arg_drawcalls[]     = "drawcalls";
 const char arg_device[]        = "device";
+const char arg_pack[]          = "pack";
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // wayland interfaces
@@ -1227,6 +1229,7 @@ struct Param {
 	unsigned fsaa;          // fsaa number of samples
 	unsigned frames;        // frames to run
 	unsigned drawcalls;     // repeated drawcalls
+	const char* pack;       // asset pack
 };
 
 static int
@@ -1295,6 +1298,13 @@ parse_cli(const int argc, char** const argv, struct Param& param)
 			continue;
 		}
 
+		if (i + 1 < argc && !strcmp(argv[i] + prefix_len, arg_pack)) {
+			param.pack = argv[i + 1];
+
+			i += 1;
+			continue;
+		}
+
 		cli_err = true;
 	}
 
@@ -1312,7 +1322,9 @@ parse_cli(const int argc, char** const argv, struct Param& param)
 			"\t" << util::arg_prefix << arg_drawcalls <<
 			" <positive_integer>\t\t: set number of drawcalls per frame; may be ignored by apps\n"
 			"\t" << util::arg_prefix << arg_device <<
-			" <unsigned_integer>\t\t: device index in /dev/dri/cardN sequence\n" <<
+			" <unsigned_integer>\t\t: device index in /dev/dri/cardN sequence\n"
+			"\t" << util::arg_prefix << arg_pack <<
+			" <filename>\t\t\t: load assets from specified pack, before loose files\n" <<
 			"\t" << util::arg_prefix << util::arg_app <<
 			" <option> [<arguments>]\t\t: app-specific option\n";
 
@@ -1346,6 +1358,7 @@ int main(
 	param.fsaa = 0;
 	param.frames = -1U;
 	param.drawcalls = 0;
+	param.pack = NULL;
 
 	if (parse_cli(argc, argv, param))
 		return EXIT_FAILURE;
@@ -1361,6 +1374,12 @@ int main(
 	if (drawcalls && !hook::set_num_drawcalls(drawcalls))
 		stream::cerr << "drawcalls argument ignored by app\n";
 
+	// one mapping of the pack serves all asset loads to follow; its read-ahead overlaps the GL setup
+	if (NULL != param.pack && !util::shared_asset_pack().open(param.pack)) {
+		stream::cerr << "Error opening asset pack\n";
+		return EXIT_FAILURE;
+	}
+
 	// set up GLES
 	EGL egl(image_w, image_h);
 
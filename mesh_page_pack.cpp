@@ -0,0 +1,404 @@
+////////////////////////////////////////////////////////////////////////////////
+// paged-mesh packer: converts a text mesh of positions (as loaded by
+// fill_indexed_trilist_from_file_P) to a paged mesh for rend::MeshPager; faces
+// get split by a kd-tree over their centroids into chunks of 16-bit indices,
+// and a proxy gets produced by LOD generation over the entire mesh, its faces
+// assigned to the chunks by the same kd-tree
+//
+// build as: $ g++ -O3 -DMESH_INDEX_START=1 mesh_page_pack.cpp rendLod.cpp
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include "stream.hpp"
+#include "rendLod.hpp"
+#include "rendVertQuant.hpp"
+#include "rendMeshPager.hpp"
+
+#ifndef MESH_INDEX_START
+#define MESH_INDEX_START 0
+#endif
+
+namespace stream {
+in cin;
+out cout;
+out cerr;
+} // namespace stream
+
+// faces per chunk such that a chunk never exceeds 16-bit indices
+static const unsigned max_chunk_faces = 65536 / 3;
+
+struct Mesh
+{
+	std::vector< float > vertex;	// xyz
+	std::vector< uint32_t > index;	// trilist
+	float vmin[3];
+	float vmax[3];
+};
+
+// kd-tree node over face centroids; leaves are chunks
+struct Node
+{
+	unsigned axis;
+	float split;
+	uint32_t child[2];
+	uint32_t chunk;
+};
+
+static const uint32_t leaf_none = uint32_t(-1);
+
+struct ByAxis
+{
+	const float* centroid;
+	unsigned axis;
+
+	bool operator()(
+		const uint32_t a,
+		const uint32_t b) const
+	{
+		return centroid[a * 3 + axis] < centroid[b * 3 + axis];
+	}
+};
+
+static bool load(
+	const char* const filename,
+	Mesh& mesh)
+{
+	FILE* const file = fopen(filename, "r");
+
+	if (0 == file)
+		return false;
+
+	for (int i = 0; i < 3; ++i) {
+		mesh.vmin[i] = INFINITY;
+		mesh.vmax[i] = -INFINITY;
+	}
+
+	bool success = true;
+	unsigned nv;
+
+	// same layout as the text-mesh loaders: blocks of vertices and faces, indices local to a block
+	while (success && 1 == fscanf(file, "%u", &nv) && 0 != nv) {
+		const size_t base = mesh.vertex.size() / 3;
+
+		for (unsigned i = 0; i < nv && success; ++i) {
+			float v[3];
+			success = 3 == fscanf(file, "%f %f %f", v + 0, v + 1, v + 2);
+
+			for (int j = 0; j < 3; ++j) {
+				mesh.vertex.push_back(v[j]);
+				mesh.vmin[j] = fminf(mesh.vmin[j], v[j]);
+				mesh.vmax[j] = fmaxf(mesh.vmax[j], v[j]);
+			}
+		}
+
+		unsigned nf = 0;
+		success = success && 1 == fscanf(file, "%u", &nf) && 0 != nf;
+
+		for (unsigned i = 0; i < nf && success; ++i) {
+			unsigned f[3];
+			success = 3 == fscanf(file, "%u %u %u", f + 0, f + 1, f + 2);
+
+			for (int j = 0; j < 3 && success; ++j) {
+				success = f[j] - MESH_INDEX_START < nv;
+				mesh.index.push_back(uint32_t(base + f[j] - MESH_INDEX_START));
+			}
+		}
+	}
+
+	fclose(file);
+	return success && !mesh.index.empty();
+}
+
+// split the faces [begin, end) of the face list into leaves of no more than chunk_faces faces
+static uint32_t build(
+	std::vector< Node >& tree,
+	std::vector< uint32_t >& face,
+	const size_t begin,
+	const size_t end,
+	const float* const centroid,
+	const unsigned chunk_faces,
+	std::vector< std::pair< size_t, size_t > >& leaf)
+{
+	const uint32_t id = uint32_t(tree.size());
+	const Node node = { 0, 0.f, { leaf_none, leaf_none }, leaf_none };
+	tree.push_back(node);
+
+	if (end - begin <= chunk_faces) {
+		tree[id].chunk = uint32_t(leaf.size());
+		leaf.push_back(std::make_pair(begin, end));
+		return id;
+	}
+
+	float cmin[3] = { INFINITY, INFINITY, INFINITY };
+	float cmax[3] = { -INFINITY, -INFINITY, -INFINITY };
+
+	for (size_t i = begin; i < end; ++i)
+		for (unsigned j = 0; j < 3; ++j) {
+			cmin[j] = fminf(cmin[j], centroid[face[i] * 3 + j]);
+			cmax[j] = fmaxf(cmax[j], centroid[face[i] * 3 + j]);
+		}
+
+	unsigned axis = 0;
+
+	for (unsigned j = 1; j < 3; ++j)
+		if (cmax[j] - cmin[j] > cmax[axis] - cmin[axis])
+			axis = j;
+
+	const size_t mid = begin + (end - begin) / 2;
+	const ByAxis by_axis = { centroid, axis };
+	std::nth_element(face.begin() + begin, face.begin() + mid, face.begin() + end, by_axis);
+
+	tree[id].axis = axis;
+	tree[id].split = centroid[face[mid] * 3 + axis];
+
+	const uint32_t child0 = build(tree, face, begin, mid, centroid, chunk_faces, leaf);
+	const uint32_t child1 = build(tree, face, mid, end, centroid, chunk_faces, leaf);
+
+	tree[id].child[0] = child0;
+	tree[id].child[1] = child1;
+
+	return id;
+}
+
+static uint32_t findChunk(
+	const std::vector< Node >& tree,
+	const float (& c)[3])
+{
+	uint32_t id = 0;
+
+	while (leaf_none == tree[id].chunk)
+		id = tree[id].child[c[tree[id].axis] < tree[id].split ? 0 : 1];
+
+	return tree[id].chunk;
+}
+
+static void getCentroid(
+	const Mesh& mesh,
+	const uint32_t* const tri,
+	float (& c)[3])
+{
+	for (unsigned j = 0; j < 3; ++j)
+		c[j] = (mesh.vertex[tri[0] * 3 + j] + mesh.vertex[tri[1] * 3 + j] + mesh.vertex[tri[2] * 3 + j]) * (1.f / 3.f);
+}
+
+// append the vertices (quantized) and 16-bit indices of a list of faces; return number of vertices
+static uint32_t putGeometry(
+	std::vector< uint8_t >& out,
+	const Mesh& mesh,
+	const rend::QuantDomain& domain,
+	const uint32_t* const tri,
+	const size_t num_faces,
+	std::vector< uint32_t >& remap,
+	float (& centre)[3],
+	float& radius)
+{
+	std::vector< uint32_t > vert;
+	std::vector< uint16_t > index(num_faces * 3);
+
+	for (size_t i = 0; i < num_faces * 3; ++i) {
+		const uint32_t v = tri[i];
+
+		if (uint32_t(-1) == remap[v]) {
+			remap[v] = uint32_t(vert.size());
+			vert.push_back(v);
+		}
+
+		index[i] = uint16_t(remap[v]);
+	}
+
+	float bmin[3] = { INFINITY, INFINITY, INFINITY };
+	float bmax[3] = { -INFINITY, -INFINITY, -INFINITY };
+
+	for (size_t i = 0; i < vert.size(); ++i) {
+		const float (& p)[3] = reinterpret_cast< const float (&)[3] >(mesh.vertex[vert[i] * 3]);
+		int16_t q[4];
+		domain.quantize(p, q);
+
+		out.insert(out.end(), reinterpret_cast< const uint8_t* >(q), reinterpret_cast< const uint8_t* >(q + 4));
+
+		for (unsigned j = 0; j < 3; ++j) {
+			bmin[j] = fminf(bmin[j], p[j]);
+			bmax[j] = fmaxf(bmax[j], p[j]);
+		}
+	}
+
+	out.insert(out.end(), reinterpret_cast< const uint8_t* >(&index.front()), reinterpret_cast< const uint8_t* >(&index.front() + index.size()));
+	out.resize((out.size() + 3) & ~size_t(3));
+
+	for (unsigned j = 0; j < 3; ++j)
+		centre[j] = (bmin[j] + bmax[j]) * .5f;
+
+	radius = 0.f;
+
+	for (size_t i = 0; i < vert.size(); ++i) {
+		const float* const p = &mesh.vertex[vert[i] * 3];
+		const float d[3] = { p[0] - centre[0], p[1] - centre[1], p[2] - centre[2] };
+		radius = fmaxf(radius, sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]));
+	}
+
+	// restore the remap for the next user
+	for (size_t i = 0; i < vert.size(); ++i)
+		remap[vert[i]] = uint32_t(-1);
+
+	return uint32_t(vert.size());
+}
+
+int main(
+	int argc,
+	char** argv)
+{
+	stream::cin.open(stdin);
+	stream::cout.open(stdout);
+	stream::cerr.open(stderr);
+
+	unsigned chunk_faces = 16384;
+	unsigned proxy_levels = rend::LodChain::max_levels;
+
+	if (3 > argc ||
+		(3 < argc && (1 != sscanf(argv[3], "%u", &chunk_faces) || 0 == chunk_faces || max_chunk_faces < chunk_faces)) ||
+		(4 < argc && (1 != sscanf(argv[4], "%u", &proxy_levels) || rend::LodChain::max_levels < proxy_levels))) {
+
+		fprintf(stderr, "usage: %s <input.mesh> <output.paged> [chunk_faces (up to %u) [proxy_levels (up to %u)]]\n",
+			argv[0], max_chunk_faces, unsigned(rend::LodChain::max_levels));
+		return -1;
+	}
+
+	Mesh mesh;
+
+	if (!load(argv[1], mesh)) {
+		fprintf(stderr, "error: failure reading '%s'\n", argv[1]);
+		return -1;
+	}
+
+	const size_t num_verts = mesh.vertex.size() / 3;
+	const size_t num_faces = mesh.index.size() / 3;
+
+	// chunks: kd-split of the faces by centroid
+	std::vector< float > centroid(num_faces * 3);
+	std::vector< uint32_t > face(num_faces);
+
+	for (size_t i = 0; i < num_faces; ++i) {
+		getCentroid(mesh, &mesh.index[i * 3], reinterpret_cast< float (&)[3] >(centroid[i * 3]));
+		face[i] = uint32_t(i);
+	}
+
+	std::vector< Node > tree;
+	std::vector< std::pair< size_t, size_t > > leaf;
+	build(tree, face, 0, num_faces, &centroid.front(), chunk_faces, leaf);
+
+	// proxy: the coarsest LOD of the entire mesh, faces sorted by chunk
+	rend::LodChain chain(proxy_levels, .25f);
+
+	if (proxy_levels && !rend::buildLodChain(chain, &mesh.vertex.front(), 3, num_verts, &mesh.index.front(), num_faces)) {
+		fprintf(stderr, "error: failure generating proxy\n");
+		return -1;
+	}
+
+	const std::vector< uint32_t >& proxy_src = chain.num_levels ? chain.level[chain.num_levels - 1].index : mesh.index;
+	const size_t proxy_faces = proxy_src.size() / 3;
+
+	std::vector< uint32_t > proxy_chunk(proxy_faces);
+	std::vector< uint32_t > proxy_count(leaf.size() + 1, 0);
+
+	for (size_t i = 0; i < proxy_faces; ++i) {
+		float c[3];
+		getCentroid(mesh, &proxy_src[i * 3], c);
+		proxy_chunk[i] = findChunk(tree, c);
+		proxy_count[proxy_chunk[i] + 1]++;
+	}
+
+	for (size_t i = 1; i < proxy_count.size(); ++i)
+		proxy_count[i] += proxy_count[i - 1];
+
+	std::vector< uint32_t > proxy_index(proxy_src.size());
+	std::vector< uint32_t > proxy_fill(proxy_count.begin(), proxy_count.end() - 1);
+
+	for (size_t i = 0; i < proxy_faces; ++i) {
+		const uint32_t dst = proxy_fill[proxy_chunk[i]]++;
+		memcpy(&proxy_index[dst * 3], &proxy_src[i * 3], sizeof(uint32_t[3]));
+	}
+
+	// compose the output
+	const rend::QuantDomain domain(mesh.vmin, mesh.vmax, true);
+	std::vector< uint32_t > remap(num_verts, uint32_t(-1));
+	std::vector< rend::PagedChunk > chunk(leaf.size());
+	std::vector< uint8_t > data;
+
+	rend::PagedMeshHeader header;
+	memset(&header, 0, sizeof(header));
+
+	header.file_magic = rend::PagedMeshHeader::magic;
+	header.file_version = rend::PagedMeshHeader::version;
+	memcpy(header.vmin, mesh.vmin, sizeof(header.vmin));
+	memcpy(header.vmax, mesh.vmax, sizeof(header.vmax));
+	header.num_chunks = uint32_t(leaf.size());
+
+	const uint64_t data_offset = sizeof(header) + sizeof(rend::PagedChunk) * leaf.size();
+	std::vector< uint32_t > tri;
+
+	for (size_t i = 0; i < leaf.size(); ++i) {
+		rend::PagedChunk& c = chunk[i];
+
+		tri.clear();
+
+		for (size_t j = leaf[i].first; j < leaf[i].second; ++j)
+			tri.insert(tri.end(), &mesh.index[face[j] * 3], &mesh.index[face[j] * 3] + 3);
+
+		c.offset = data_offset + data.size();
+		c.num_faces = uint32_t(leaf[i].second - leaf[i].first);
+		c.num_verts = putGeometry(data, mesh, domain, &tri.front(), c.num_faces, remap, c.centre, c.radius);
+		c.proxy_first_face = proxy_count[i];
+		c.proxy_num_faces = proxy_count[i + 1] - proxy_count[i];
+
+		header.max_chunk_verts = std::max(header.max_chunk_verts, c.num_verts);
+		header.max_chunk_faces = std::max(header.max_chunk_faces, c.num_faces);
+	}
+
+	if (proxy_faces) {
+		float centre[3], radius;
+
+		header.proxy_offset = data_offset + data.size();
+		header.proxy_faces = uint32_t(proxy_faces);
+		header.proxy_verts = putGeometry(data, mesh, domain, &proxy_index.front(), proxy_faces, remap, centre, radius);
+
+		if (uint32_t(1) + uint16_t(-1) < header.proxy_verts) {
+			fprintf(stderr, "error: proxy of %u vertices exceeds 16-bit indices; use more proxy levels\n", header.proxy_verts);
+			return -1;
+		}
+	}
+
+	FILE* const file = fopen(argv[2], "wb");
+
+	if (0 == file ||
+		1 != fwrite(&header, sizeof(header), 1, file) ||
+		1 != fwrite(&chunk.front(), sizeof(rend::PagedChunk) * chunk.size(), 1, file) ||
+		1 != fwrite(&data.front(), data.size(), 1, file)) {
+
+		fprintf(stderr, "error: failure writing '%s'\n", argv[2]);
+
+		if (0 != file)
+			fclose(file);
+
+		return -1;
+	}
+
+	fclose(file);
+
+	fprintf(stdout,
+		"faces: %zu\n"
+		"chunks: %u, largest: %u vertices, %u faces\n"
+		"proxy: %u vertices, %u faces\n"
+		"file: %zu bytes\n",
+		num_faces,
+		header.num_chunks, header.max_chunk_verts, header.max_chunk_faces,
+		header.proxy_verts, header.proxy_faces,
+		size_t(data_offset + data.size()));
+
+	return 0;
+}
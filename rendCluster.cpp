@@ -0,0 +1,435 @@
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <cmath>
+#include <vector>
+
+#include "stream.hpp"
+#include "rendCluster.hpp"
+
+namespace { // anonymous
+
+// faces join a cluster only if their normal is within ~60 degrees of the cluster's mean normal
+const float cone_coherence = .5f;
+
+// no-cone marker; exceeds any sine
+const float cutoff_none = 2.f;
+
+typedef float v4f __attribute__ ((vector_size(4 * sizeof(float))));
+typedef int32_t v4i __attribute__ ((vector_size(4 * sizeof(int32_t))));
+
+inline v4f
+load(
+	const float (& src)[4])
+{
+	v4f r;
+	memcpy(&r, src, sizeof(r));
+	return r;
+}
+
+inline v4f
+splat(
+	const float x)
+{
+	const v4f r = { x, x, x, x };
+	return r;
+}
+
+inline float
+dot3(
+	const float* const a,
+	const float* const b)
+{
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+inline float
+det3(
+	const float a0, const float a1, const float a2,
+	const float b0, const float b1, const float b2,
+	const float c0, const float c1, const float c2)
+{
+	return a0 * (b1 * c2 - b2 * c1) - a1 * (b0 * c2 - b2 * c0) + a2 * (b0 * c1 - b1 * c0);
+}
+
+// determinant of a 4x4 matrix, by cofactor expansion along the last column
+float
+det4(
+	const float (& m)[4][4])
+{
+	float det = 0.f;
+	float sign = -1.f;
+
+	for (unsigned i = 0; i < 4; ++i, sign = -sign) {
+		const unsigned r0 = i > 0 ? 0 : 1;
+		const unsigned r1 = i > 1 ? 1 : 2;
+		const unsigned r2 = i > 2 ? 2 : 3;
+
+		det += sign * m[i][3] * det3(
+			m[r0][0], m[r0][1], m[r0][2],
+			m[r1][0], m[r1][1], m[r1][2],
+			m[r2][0], m[r2][1], m[r2][2]);
+	}
+
+	return det;
+}
+
+// set the bounds of a cluster of faces in the bounds storage
+void
+setClusterBounds(
+	rend::ClusterBounds4& bounds,
+	const unsigned lane,
+	const float* const vertex,
+	const unsigned floats_per_vertex,
+	const uint32_t* const index,
+	const float* const normal,
+	const uint32_t* const face,
+	const unsigned num_faces)
+{
+	const float* const p0 = vertex + size_t(index[face[0] * 3]) * floats_per_vertex;
+	float bmin[3] = { p0[0], p0[1], p0[2] };
+	float bmax[3] = { p0[0], p0[1], p0[2] };
+	float axis[3] = { 0.f, 0.f, 0.f };
+
+	for (unsigned i = 0; i < num_faces; ++i) {
+		for (unsigned j = 0; j < 3; ++j) {
+			const float* const p = vertex + size_t(index[face[i] * 3 + j]) * floats_per_vertex;
+
+			for (unsigned k = 0; k < 3; ++k) {
+				bmin[k] = fminf(bmin[k], p[k]);
+				bmax[k] = fmaxf(bmax[k], p[k]);
+			}
+		}
+
+		const float* const n = normal + face[i] * 3;
+		axis[0] += n[0];
+		axis[1] += n[1];
+		axis[2] += n[2];
+	}
+
+	const float centre[3] = {
+		(bmin[0] + bmax[0]) * .5f,
+		(bmin[1] + bmax[1]) * .5f,
+		(bmin[2] + bmax[2]) * .5f
+	};
+	float radius2 = 0.f;
+
+	for (unsigned i = 0; i < num_faces; ++i)
+		for (unsigned j = 0; j < 3; ++j) {
+			const float* const p = vertex + size_t(index[face[i] * 3 + j]) * floats_per_vertex;
+			const float d[3] = { p[0] - centre[0], p[1] - centre[1], p[2] - centre[2] };
+
+			radius2 = fmaxf(radius2, dot3(d, d));
+		}
+
+	float cutoff = cutoff_none;
+	const float axis_len = sqrtf(dot3(axis, axis));
+
+	if (0.f < axis_len) {
+		axis[0] /= axis_len;
+		axis[1] /= axis_len;
+		axis[2] /= axis_len;
+
+		float min_dp = 1.f;
+
+		for (unsigned i = 0; i < num_faces; ++i) {
+			const float* const n = normal + face[i] * 3;
+
+			// degenerate faces are invisible, so they do not affect the cone
+			if (0.f != n[0] || 0.f != n[1] || 0.f != n[2])
+				min_dp = fminf(min_dp, dot3(axis, n));
+		}
+
+		// a cone of half-angle 90 degrees or more culls nothing
+		if (0.f < min_dp)
+			cutoff = sqrtf(1.f - min_dp * min_dp);
+	}
+
+	bounds.centre_x[lane] = centre[0];
+	bounds.centre_y[lane] = centre[1];
+	bounds.centre_z[lane] = centre[2];
+	bounds.radius[lane] = sqrtf(radius2);
+	bounds.axis_x[lane] = axis[0];
+	bounds.axis_y[lane] = axis[1];
+	bounds.axis_z[lane] = axis[2];
+	bounds.cutoff[lane] = cutoff;
+}
+
+} // namespace
+
+namespace rend
+{
+
+bool
+clusterizeTrilist(
+	ClusterSet& set,
+	const float* const vertex,
+	const unsigned floats_per_vertex,
+	const unsigned num_verts,
+	uint32_t* const index,
+	const unsigned num_faces)
+{
+	assert(vertex);
+	assert(index);
+	assert(3 <= floats_per_vertex);
+	assert(0 != set.max_faces);
+
+	set.num_clusters = 0;
+	set.cluster.clear();
+	set.bounds.clear();
+
+	// unit face normals, nil for degenerate faces
+	std::vector< float > normal(size_t(num_faces) * 3);
+
+	// vertex-to-face adjacency
+	std::vector< uint32_t > adj_start(num_verts + 1, 0);
+	std::vector< uint32_t > adj(size_t(num_faces) * 3);
+
+	for (size_t i = 0; i < size_t(num_faces) * 3; ++i) {
+		if (index[i] >= num_verts) {
+			stream::cerr << __FUNCTION__ << " encountered out-of-range index\n";
+			return false;
+		}
+
+		++adj_start[index[i] + 1];
+	}
+
+	for (unsigned i = 0; i < num_verts; ++i)
+		adj_start[i + 1] += adj_start[i];
+
+	std::vector< uint32_t > adj_fill(adj_start.begin(), adj_start.end() - 1);
+
+	for (unsigned i = 0; i < num_faces; ++i) {
+		const float* const p0 = vertex + size_t(index[i * 3 + 0]) * floats_per_vertex;
+		const float* const p1 = vertex + size_t(index[i * 3 + 1]) * floats_per_vertex;
+		const float* const p2 = vertex + size_t(index[i * 3 + 2]) * floats_per_vertex;
+
+		const float e0[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+		const float e1[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+		float* const n = &normal[i * 3];
+
+		n[0] = e0[1] * e1[2] - e0[2] * e1[1];
+		n[1] = e0[2] * e1[0] - e0[0] * e1[2];
+		n[2] = e0[0] * e1[1] - e0[1] * e1[0];
+
+		const float len = sqrtf(dot3(n, n));
+
+		if (0.f < len) {
+			n[0] /= len;
+			n[1] /= len;
+			n[2] /= len;
+		}
+		else
+			n[0] = n[1] = n[2] = 0.f;
+
+		for (unsigned j = 0; j < 3; ++j)
+			adj[adj_fill[index[i * 3 + j]]++] = i;
+	}
+
+	// grow clusters breadth-first over shared vertices, seeding in original face order
+	std::vector< uint32_t > order;
+	std::vector< uint32_t > queue;
+	std::vector< uint8_t > assigned(num_faces, 0);
+
+	order.reserve(num_faces);
+	unsigned seed = 0;
+
+	while (order.size() < num_faces) {
+		while (assigned[seed])
+			++seed;
+
+		const size_t first = order.size();
+		float cone[3] = { 0.f, 0.f, 0.f };
+
+		queue.clear();
+		queue.push_back(seed);
+
+		for (size_t q = 0; q < queue.size() && order.size() - first < set.max_faces; ++q) {
+			const uint32_t f = queue[q];
+
+			if (assigned[f])
+				continue;
+
+			const float* const n = &normal[f * 3];
+
+			// degenerate faces go anywhere
+			if (0.f != dot3(n, n) && dot3(n, cone) < cone_coherence * sqrtf(dot3(cone, cone)))
+				continue;
+
+			assigned[f] = 1;
+			order.push_back(f);
+
+			cone[0] += n[0];
+			cone[1] += n[1];
+			cone[2] += n[2];
+
+			for (unsigned j = 0; j < 3; ++j) {
+				const uint32_t v = index[f * 3 + j];
+
+				for (uint32_t k = adj_start[v]; k < adj_start[v + 1]; ++k)
+					if (!assigned[adj[k]])
+						queue.push_back(adj[k]);
+			}
+		}
+
+		const DrawRange range = { uint32_t(first), uint32_t(order.size() - first) };
+		set.cluster.push_back(range);
+	}
+
+	set.num_clusters = set.cluster.size();
+
+	// bounds, with padding lanes marked cone-less
+	ClusterBounds4 pad;
+	memset(&pad, 0, sizeof(pad));
+
+	for (unsigned i = 0; i < 4; ++i)
+		pad.cutoff[i] = cutoff_none;
+
+	set.bounds.resize((set.num_clusters + 3) / 4, pad);
+
+	for (unsigned i = 0; i < set.num_clusters; ++i)
+		setClusterBounds(set.bounds[i / 4], i % 4,
+			vertex, floats_per_vertex, index, &normal.front(),
+			&order[set.cluster[i].first_face], set.cluster[i].num_faces);
+
+	// reorder the faces so clusters are contiguous
+	const std::vector< uint32_t > src(index, index + size_t(num_faces) * 3);
+
+	for (unsigned i = 0; i < num_faces; ++i) {
+		index[i * 3 + 0] = src[order[i] * 3 + 0];
+		index[i * 3 + 1] = src[order[i] * 3 + 1];
+		index[i * 3 + 2] = src[order[i] * 3 + 2];
+	}
+
+	stream::cout << "number of clusters: " << set.num_clusters << '\n';
+	return true;
+}
+
+bool
+clusterizeTrilistFilter(
+	void* const ctx,
+	const float* const vertex,
+	const unsigned floats_per_vertex,
+	const unsigned num_verts,
+	uint32_t* const index,
+	const unsigned num_faces)
+{
+	assert(ctx);
+
+	return clusterizeTrilist(
+		*reinterpret_cast< ClusterSet* >(ctx),
+		vertex,
+		floats_per_vertex,
+		num_verts,
+		index,
+		num_faces);
+}
+
+unsigned
+cullClusters(
+	const ClusterSet& set,
+	const float (& mvp)[16],
+	DrawRange* const out)
+{
+	assert(out || 0 == set.num_clusters);
+
+	const float (& m)[4][4] = reinterpret_cast< const float (&)[4][4] >(mvp);
+
+	// object-space frustum planes: clip_w + clip_{x,y,z} >= 0 and clip_w - clip_{x,y,z} >= 0
+	float plane[6][4];
+
+	for (unsigned i = 0; i < 3; ++i)
+		for (unsigned j = 0; j < 4; ++j) {
+			plane[i * 2 + 0][j] = m[j][3] + m[j][i];
+			plane[i * 2 + 1][j] = m[j][3] - m[j][i];
+		}
+
+	for (unsigned i = 0; i < 6; ++i) {
+		const float len = sqrtf(dot3(plane[i], plane[i]));
+
+		if (0.f < len)
+			for (unsigned j = 0; j < 4; ++j)
+				plane[i][j] /= len;
+	}
+
+	// object-space eye: the point of nil clip x, y and w; at infinity for parallel projections
+	const float det_eye = det3(
+		m[0][0], m[1][0], m[2][0],
+		m[0][1], m[1][1], m[2][1],
+		m[0][3], m[1][3], m[2][3]);
+	const bool cone_cull = 0.f != det_eye;
+	float eye[3] = { 0.f, 0.f, 0.f };
+
+	if (cone_cull) {
+		eye[0] = -det3(
+			m[3][0], m[1][0], m[2][0],
+			m[3][1], m[1][1], m[2][1],
+			m[3][3], m[1][3], m[2][3]) / det_eye;
+		eye[1] = -det3(
+			m[0][0], m[3][0], m[2][0],
+			m[0][1], m[3][1], m[2][1],
+			m[0][3], m[3][3], m[2][3]) / det_eye;
+		eye[2] = -det3(
+			m[0][0], m[1][0], m[3][0],
+			m[0][1], m[1][1], m[3][1],
+			m[0][3], m[1][3], m[3][3]) / det_eye;
+	}
+
+	// a mirroring mvp turns object-space CCW faces into screen-space CW ones
+	const v4f axis_sign = splat(det4(m) < 0.f ? 1.f : -1.f);
+	const v4f eye_x = splat(eye[0]);
+	const v4f eye_y = splat(eye[1]);
+	const v4f eye_z = splat(eye[2]);
+	const v4f zero = splat(0.f);
+
+	unsigned num_ranges = 0;
+
+	for (unsigned i = 0; i < set.bounds.size(); ++i) {
+		const ClusterBounds4& bounds = set.bounds[i];
+
+		const v4f cx = load(bounds.centre_x);
+		const v4f cy = load(bounds.centre_y);
+		const v4f cz = load(bounds.centre_z);
+		const v4f r = load(bounds.radius);
+
+		v4i visible = cx == cx; // all-true
+
+		for (unsigned j = 0; j < 6; ++j) {
+			const v4f dist =
+				cx * splat(plane[j][0]) +
+				cy * splat(plane[j][1]) +
+				cz * splat(plane[j][2]) + splat(plane[j][3]);
+
+			visible &= dist + r >= zero;
+		}
+
+		if (cone_cull) {
+			const v4f vx = cx - eye_x;
+			const v4f vy = cy - eye_y;
+			const v4f vz = cz - eye_z;
+			const v4f cutoff = load(bounds.cutoff);
+
+			// dot(v, axis) - r >= cutoff * length(v), sans the sqrt
+			const v4f t = (vx * load(bounds.axis_x) + vy * load(bounds.axis_y) + vz * load(bounds.axis_z)) * axis_sign - r;
+			const v4i backfacing = (t >= zero) & (t * t >= cutoff * cutoff * (vx * vx + vy * vy + vz * vz));
+
+			visible &= ~backfacing;
+		}
+
+		for (unsigned j = 0; j < 4 && i * 4 + j < set.num_clusters; ++j) {
+			if (!visible[j])
+				continue;
+
+			const DrawRange& cluster = set.cluster[i * 4 + j];
+
+			if (num_ranges && out[num_ranges - 1].first_face + out[num_ranges - 1].num_faces == cluster.first_face)
+				out[num_ranges - 1].num_faces += cluster.num_faces;
+			else
+				out[num_ranges++] = cluster;
+		}
+	}
+
+	return num_ranges;
+}
+
+} // namespace rend
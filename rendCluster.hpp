@@ -0,0 +1,90 @@
+#ifndef rend_cluster_H__
+#define rend_cluster_H__
+
+#include <stdint.h>
+#include <vector>
+
+namespace rend
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// load-time clusterization of indexed trilists: faces are grouped into clusters of spatially- and
+// directionally-coherent faces, the index buffer gets reordered so that each cluster occupies a
+// contiguous range, and each cluster gets a bounding sphere and a backface cone; at draw time
+// clusters get frustum- and cone-culled on the CPU into a compacted list of draw ranges
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// a range of faces of the index buffer
+struct DrawRange
+{
+	uint32_t first_face;
+	uint32_t num_faces;
+};
+
+// bounds of four consecutive clusters in SoA layout; a cluster is backfacing from eye point e when
+//
+//	dot(centre - e, axis) >= cutoff * length(centre - e) + radius
+//
+// cutoff is the sine of the half-angle of the normal cone; cutoff > 1 marks a cluster with no
+// usable cone
+struct ClusterBounds4
+{
+	float centre_x[4];
+	float centre_y[4];
+	float centre_z[4];
+	float radius[4];
+	float axis_x[4];
+	float axis_y[4];
+	float axis_z[4];
+	float cutoff[4];
+};
+
+struct ClusterSet
+{
+	unsigned max_faces;						// target faces per cluster
+	unsigned num_clusters;
+	std::vector< DrawRange > cluster;		// per-cluster face range, ascending and contiguous
+	std::vector< ClusterBounds4 > bounds;	// per-cluster bounds, four clusters per element
+
+	ClusterSet(
+		const unsigned max_faces = 124)
+	: max_faces(max_faces)
+	, num_clusters(0)
+	{}
+};
+
+// clusterize a trilist of 32-bit indices, reordering its faces in place; vertex positions are
+// the first three floats of each vertex
+bool
+clusterizeTrilist(
+	ClusterSet& set,
+	const float* const vertex,
+	const unsigned floats_per_vertex,
+	const unsigned num_verts,
+	uint32_t* const index,
+	const unsigned num_faces);
+
+// util::TrilistFilter-compatible clusterizer; ctx is a ClusterSet
+bool
+clusterizeTrilistFilter(
+	void* const ctx,
+	const float* const vertex,
+	const unsigned floats_per_vertex,
+	const unsigned num_verts,
+	uint32_t* const index,
+	const unsigned num_faces);
+
+// cull the clusters against the frustum of the specified mvp (16 floats, row-vector convention,
+// i.e. clip = obj * mvp, as passed to glUniformMatrix4fv) and against the eye point implied by
+// the mvp, assuming CCW front faces and culled back faces; visible clusters are written to out
+// as draw ranges, adjacent ones merged, out having room for set.num_clusters ranges; return
+// number of draw ranges
+unsigned
+cullClusters(
+	const ClusterSet& set,
+	const float (& mvp)[16],
+	DrawRange* const out);
+
+} // namespace rend
+
+#endif // rend_cluster_H__
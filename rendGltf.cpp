@@ -0,0 +1,1557 @@
+#if defined(PLATFORM_GL)
+	#include <GL/gl.h>
+	#include "gles_gl_mapping.hpp"
+#else
+	#include <GLES2/gl2.h>
+	#include <GLES2/gl2ext.h>
+	#include "gles_ext.h"
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+#include "scoped.hpp"
+#include "stream.hpp"
+#include "util_file.hpp"
+#include "rendIndexedTrilist.hpp"
+#include "rendVertGather.hpp"
+#include "rendSkeleton.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// binary glTF 2.0 (.glb) loaders: the file gets mapped, its JSON chunk parsed into a flat DOM, and
+// accessors resolved to strided views straight into the mapped binary chunk; vertex and index data
+// matching the output layout get handed to glBufferData as they are, the rest goes through the
+// gather kernels; skins and animations get read from the mapping into rend::Bone and rend::Track
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace { // anonymous
+
+struct JsonNode
+{
+	enum Type {
+		TYPE_NULL,
+		TYPE_BOOL,
+		TYPE_NUMBER,
+		TYPE_STRING,
+		TYPE_ARRAY,
+		TYPE_OBJECT,
+
+		TYPE_FORCE_UINT = -1U
+	};
+
+	Type type;
+	const char* key;		// member name, when the parent is an object; escapes are kept as-is
+	uint32_t key_len;
+	const char* str;		// string value; escapes are kept as-is
+	uint32_t str_len;
+	double number;			// number value, or 1/0 for bools
+	uint32_t count;			// number of children
+	uint32_t first;			// index of the first child, or 0
+	uint32_t next;			// index of the next sibling, or 0
+};
+
+// recursive-descent parser of a JSON text into a flat array of nodes, the root being node 0
+class JsonParser
+{
+	enum { max_depth = 64 };
+
+	const char* pos;
+	const char* end;
+	std::vector< JsonNode >& node;
+
+	void skipSpace()
+	{
+		while (pos != end && (' ' == *pos || '\t' == *pos || '\n' == *pos || '\r' == *pos))
+			++pos;
+	}
+
+	bool parseString(const char*& str, uint32_t& len)
+	{
+		if (pos == end || '"' != *pos)
+			return false;
+
+		str = ++pos;
+
+		while (pos != end && '"' != *pos) {
+			if ('\\' == *pos && ++pos == end)
+				return false;
+			++pos;
+		}
+
+		if (pos == end)
+			return false;
+
+		len = uint32_t(pos++ - str);
+		return true;
+	}
+
+	bool parseValue(const uint32_t idx, const unsigned depth);
+
+public:
+	JsonParser(const char* const text, const size_t len, std::vector< JsonNode >& node)
+	: pos(text)
+	, end(text + len)
+	, node(node)
+	{}
+
+	bool parse()
+	{
+		node.clear();
+		node.push_back(JsonNode());
+		node.back().key = 0;
+		node.back().key_len = 0;
+
+		if (!parseValue(0, 0))
+			return false;
+
+		skipSpace();
+		return pos == end;
+	}
+};
+
+bool JsonParser::parseValue(const uint32_t idx, const unsigned depth)
+{
+	skipSpace();
+
+	if (pos == end || max_depth == depth)
+		return false;
+
+	node[idx].str = 0;
+	node[idx].str_len = 0;
+	node[idx].number = 0.0;
+	node[idx].count = 0;
+	node[idx].first = 0;
+	node[idx].next = 0;
+
+	const char c = *pos;
+
+	if ('{' == c || '[' == c) {
+		const bool object = '{' == c;
+		node[idx].type = object ? JsonNode::TYPE_OBJECT : JsonNode::TYPE_ARRAY;
+		++pos;
+		skipSpace();
+
+		if (pos != end && (object ? '}' : ']') == *pos) {
+			++pos;
+			return true;
+		}
+
+		uint32_t prev = 0;
+
+		while (true) {
+			const uint32_t child = uint32_t(node.size());
+			node.push_back(JsonNode());
+			node[child].key = 0;
+			node[child].key_len = 0;
+
+			if (object) {
+				skipSpace();
+
+				if (!parseString(node[child].key, node[child].key_len))
+					return false;
+
+				skipSpace();
+
+				if (pos == end || ':' != *pos++)
+					return false;
+			}
+
+			if (!parseValue(child, depth + 1))
+				return false;
+
+			if (0 == prev)
+				node[idx].first = child;
+			else
+				node[prev].next = child;
+
+			prev = child;
+			++node[idx].count;
+
+			skipSpace();
+
+			if (pos == end)
+				return false;
+
+			if (',' == *pos) {
+				++pos;
+				continue;
+			}
+
+			if ((object ? '}' : ']') != *pos++)
+				return false;
+
+			return true;
+		}
+	}
+
+	if ('"' == c) {
+		node[idx].type = JsonNode::TYPE_STRING;
+		return parseString(node[idx].str, node[idx].str_len);
+	}
+
+	static const struct {
+		const char* literal;
+		JsonNode::Type type;
+		double value;
+	} literal[] = {
+		{ "true",  JsonNode::TYPE_BOOL, 1.0 },
+		{ "false", JsonNode::TYPE_BOOL, 0.0 },
+		{ "null",  JsonNode::TYPE_NULL, 0.0 }
+	};
+
+	for (size_t i = 0; i < sizeof(literal) / sizeof(literal[0]); ++i) {
+		const size_t len = strlen(literal[i].literal);
+
+		if (size_t(end - pos) >= len && 0 == memcmp(pos, literal[i].literal, len)) {
+			node[idx].type = literal[i].type;
+			node[idx].number = literal[i].value;
+			pos += len;
+			return true;
+		}
+	}
+
+	// numbers get copied out for strtod, as the text is not nil-terminated
+	char buf[64];
+	size_t len = 0;
+
+	while (pos + len != end && len < sizeof(buf) - 1 && 0 != pos[len] && 0 != strchr("+-.0123456789eE", pos[len]))
+		++len;
+
+	if (0 == len)
+		return false;
+
+	memcpy(buf, pos, len);
+	buf[len] = '\0';
+
+	char* num_end;
+	node[idx].type = JsonNode::TYPE_NUMBER;
+	node[idx].number = strtod(buf, &num_end);
+
+	if (num_end != buf + len)
+		return false;
+
+	pos += len;
+	return true;
+}
+
+enum ComponentType {
+	COMPONENT_BYTE           = 5120,
+	COMPONENT_UNSIGNED_BYTE  = 5121,
+	COMPONENT_SHORT          = 5122,
+	COMPONENT_UNSIGNED_SHORT = 5123,
+	COMPONENT_UNSIGNED_INT   = 5125,
+	COMPONENT_FLOAT          = 5126,
+
+	COMPONENT_FORCE_UINT = -1U
+};
+
+size_t sizeOfComponent(const uint32_t type)
+{
+	switch (type) {
+	case COMPONENT_BYTE:
+	case COMPONENT_UNSIGNED_BYTE:
+		return 1;
+	case COMPONENT_SHORT:
+	case COMPONENT_UNSIGNED_SHORT:
+		return 2;
+	case COMPONENT_UNSIGNED_INT:
+	case COMPONENT_FLOAT:
+		return 4;
+	}
+
+	return 0;
+}
+
+// strided view of an accessor within the binary chunk
+struct Accessor
+{
+	const uint8_t* data;		// first element
+	size_t stride;				// bytes between consecutive elements
+	uint32_t count;
+	uint32_t component_type;
+	uint32_t num_components;
+	bool normalized;
+	uint32_t view;				// buffer view of the accessor
+	const JsonNode* min;		// optional bounds of the accessor, or nil
+	const JsonNode* max;
+
+	bool is(const uint32_t type, const uint32_t components) const
+	{
+		return type == component_type && components == num_components && (COMPONENT_FLOAT == type || !normalized);
+	}
+
+	size_t sizeofElement() const
+	{
+		return sizeOfComponent(component_type) * num_components;
+	}
+
+	// fetch component i of element idx, as float, normalized if so flagged
+	float fetch(const size_t idx, const unsigned i) const
+	{
+		const uint8_t* const src = data + idx * stride + i * sizeOfComponent(component_type);
+
+		switch (component_type) {
+		case COMPONENT_BYTE: {
+				int8_t val;
+				memcpy(&val, src, sizeof(val));
+				return normalized ? fmaxf(val / 127.f, -1.f) : float(val);
+			}
+		case COMPONENT_UNSIGNED_BYTE: {
+				uint8_t val;
+				memcpy(&val, src, sizeof(val));
+				return normalized ? val / 255.f : float(val);
+			}
+		case COMPONENT_SHORT: {
+				int16_t val;
+				memcpy(&val, src, sizeof(val));
+				return normalized ? fmaxf(val / 32767.f, -1.f) : float(val);
+			}
+		case COMPONENT_UNSIGNED_SHORT: {
+				uint16_t val;
+				memcpy(&val, src, sizeof(val));
+				return normalized ? val / 65535.f : float(val);
+			}
+		case COMPONENT_UNSIGNED_INT: {
+				uint32_t val;
+				memcpy(&val, src, sizeof(val));
+				return float(val);
+			}
+		}
+
+		float val;
+		memcpy(&val, src, sizeof(val));
+		return val;
+	}
+
+	// fetch component i of element idx of an integral accessor
+	uint32_t fetchUint(const size_t idx, const unsigned i) const
+	{
+		const size_t sizeof_component = sizeOfComponent(component_type);
+		const uint8_t* const src = data + idx * stride + i * sizeof_component;
+		uint32_t val = 0;
+
+		switch (sizeof_component) {
+		case 1:
+			val = *src;
+			break;
+		case 2: {
+				uint16_t val16;
+				memcpy(&val16, src, sizeof(val16));
+				val = val16;
+			}
+			break;
+		default:
+			memcpy(&val, src, sizeof(val));
+			break;
+		}
+
+		return val;
+	}
+};
+
+// mapping of a .glb file, along with the DOM of its JSON chunk
+class GlbFile : util::non_copyable
+{
+	util::mapped_file file;
+	const uint8_t* bin;
+	size_t bin_len;
+	std::vector< JsonNode > node;
+
+public:
+	GlbFile()
+	: bin(0)
+	, bin_len(0)
+	{}
+
+	bool open(const char* const filename);
+
+	// whether the specified span is within the binary chunk
+	bool contains(const uint8_t* const start, const size_t len) const
+	{
+		return 0 != bin && bin <= start && start <= bin + bin_len && len <= size_t(bin + bin_len - start);
+	}
+
+	const JsonNode* root() const
+	{
+		return &node.front();
+	}
+
+	// member of an object by name, or nil
+	const JsonNode* get(const JsonNode* const obj, const char* const key) const
+	{
+		if (0 == obj || JsonNode::TYPE_OBJECT != obj->type)
+			return 0;
+
+		const size_t len = strlen(key);
+
+		for (uint32_t i = obj->first; 0 != i; i = node[i].next)
+			if (len == node[i].key_len && 0 == memcmp(node[i].key, key, len))
+				return &node[i];
+
+		return 0;
+	}
+
+	// element of an array by index, or nil
+	const JsonNode* at(const JsonNode* const arr, const uint32_t idx) const
+	{
+		if (0 == arr || JsonNode::TYPE_ARRAY != arr->type || idx >= arr->count)
+			return 0;
+
+		uint32_t i = arr->first;
+
+		for (uint32_t j = 0; j < idx; ++j)
+			i = node[i].next;
+
+		return &node[i];
+	}
+
+	// element of a top-level array, e.g. "nodes", by index, or nil
+	const JsonNode* at(const char* const key, const uint32_t idx) const
+	{
+		return at(get(root(), key), idx);
+	}
+
+	const JsonNode* next(const JsonNode* const val) const
+	{
+		return 0 != val->next ? &node[val->next] : 0;
+	}
+
+	bool getAccessor(const uint32_t idx, Accessor& out) const;
+};
+
+bool getUint(
+	const JsonNode* const val,
+	uint32_t& out)
+{
+	if (0 == val || JsonNode::TYPE_NUMBER != val->type || 0.0 > val->number || 4294967295.0 < val->number ||
+		val->number != double(uint32_t(val->number))) {
+
+		return false;
+	}
+
+	out = uint32_t(val->number);
+	return true;
+}
+
+bool isString(
+	const JsonNode* const val,
+	const char* const str)
+{
+	return 0 != val && JsonNode::TYPE_STRING == val->type &&
+		strlen(str) == val->str_len && 0 == memcmp(val->str, str, val->str_len);
+}
+
+// read an array of floats of the exact specified length
+bool getFloats(
+	const GlbFile& glb,
+	const JsonNode* const arr,
+	float* const out,
+	const uint32_t count)
+{
+	if (0 == arr || JsonNode::TYPE_ARRAY != arr->type || count != arr->count)
+		return false;
+
+	const JsonNode* val = glb.at(arr, 0);
+
+	for (uint32_t i = 0; i < count; ++i, val = glb.next(val)) {
+		if (JsonNode::TYPE_NUMBER != val->type)
+			return false;
+
+		out[i] = float(val->number);
+	}
+
+	return true;
+}
+
+bool GlbFile::open(const char* const filename)
+{
+	assert(0 == file.data());
+
+	if (!file.open(filename, false)) {
+		stream::cerr << "error: failure at mmap '" << filename << "'\n";
+		return false;
+	}
+
+	const uint8_t* const data = file.data();
+	const size_t size = file.length();
+
+	// header: magic, version, length; chunks: length, type, content padded to 4 bytes
+	uint32_t header[3];
+	uint32_t chunk[2];
+
+	if (size < sizeof(header) + sizeof(chunk)) {
+		fprintf(stderr, "%s encountered truncated file\n", __FUNCTION__);
+		return false;
+	}
+
+	memcpy(header, data, sizeof(header));
+	memcpy(chunk, data + sizeof(header), sizeof(chunk));
+
+	if (0x46546c67 != header[0] || 2 != header[1] || size < header[2]) {
+		fprintf(stderr, "%s encountered non-glb or unsupported version\n", __FUNCTION__);
+		return false;
+	}
+
+	const size_t json_start = sizeof(header) + sizeof(chunk);
+
+	if (0x4e4f534a != chunk[1] || header[2] - json_start < chunk[0]) {
+		fprintf(stderr, "%s encountered missing or truncated JSON chunk\n", __FUNCTION__);
+		return false;
+	}
+
+	const size_t json_end = json_start + chunk[0];
+
+	// the binary chunk is optional, e.g. for files referencing external buffers only
+	if (header[2] - json_end >= sizeof(chunk)) {
+		memcpy(chunk, data + json_end, sizeof(chunk));
+
+		if (0x004e4942 == chunk[1]) {
+			if (header[2] - json_end - sizeof(chunk) < chunk[0]) {
+				fprintf(stderr, "%s encountered truncated binary chunk\n", __FUNCTION__);
+				return false;
+			}
+
+			bin = data + json_end + sizeof(chunk);
+			bin_len = chunk[0];
+		}
+	}
+
+	if (!JsonParser(reinterpret_cast< const char* >(data + json_start), chunk[0] ? json_end - json_start : 0, node).parse() ||
+		JsonNode::TYPE_OBJECT != root()->type) {
+
+		fprintf(stderr, "%s encountered malformed JSON chunk\n", __FUNCTION__);
+		return false;
+	}
+
+	return true;
+}
+
+bool GlbFile::getAccessor(const uint32_t idx, Accessor& out) const
+{
+	const JsonNode* const accessor = at("accessors", idx);
+	uint32_t view_idx;
+
+	if (0 == accessor || !getUint(get(accessor, "bufferView"), view_idx) || 0 != get(accessor, "sparse")) {
+		fprintf(stderr, "%s encountered missing, view-less or sparse accessor %u\n", __FUNCTION__, idx);
+		return false;
+	}
+
+	const JsonNode* const view = at("bufferViews", view_idx);
+	uint32_t buffer_idx;
+	uint32_t view_offset = 0;
+	uint32_t view_len;
+	uint32_t view_stride = 0;
+
+	if (0 == view || !getUint(get(view, "buffer"), buffer_idx) || !getUint(get(view, "byteLength"), view_len) ||
+		(0 != get(view, "byteOffset") && !getUint(get(view, "byteOffset"), view_offset)) ||
+		(0 != get(view, "byteStride") && !getUint(get(view, "byteStride"), view_stride))) {
+
+		fprintf(stderr, "%s encountered malformed buffer view %u\n", __FUNCTION__, view_idx);
+		return false;
+	}
+
+	if (0 != buffer_idx || 0 == bin || 0 != get(at("buffers", 0), "uri")) {
+		fprintf(stderr, "%s encountered buffer other than the binary chunk\n", __FUNCTION__);
+		return false;
+	}
+
+	if (bin_len < view_offset || bin_len - view_offset < view_len) {
+		fprintf(stderr, "%s encountered out-of-bounds buffer view %u\n", __FUNCTION__, view_idx);
+		return false;
+	}
+
+	static const struct {
+		const char* name;
+		uint32_t num_components;
+	} type[] = {
+		{ "SCALAR", 1 },
+		{ "VEC2",   2 },
+		{ "VEC3",   3 },
+		{ "VEC4",   4 },
+		{ "MAT4",  16 }
+	};
+
+	const JsonNode* const type_str = get(accessor, "type");
+	uint32_t num_components = 0;
+
+	for (size_t i = 0; i < sizeof(type) / sizeof(type[0]) && 0 == num_components; ++i)
+		if (isString(type_str, type[i].name))
+			num_components = type[i].num_components;
+
+	uint32_t component_type;
+	uint32_t offset = 0;
+	uint32_t count;
+
+	if (0 == num_components || !getUint(get(accessor, "componentType"), component_type) ||
+		0 == sizeOfComponent(component_type) || !getUint(get(accessor, "count"), count) ||
+		(0 != get(accessor, "byteOffset") && !getUint(get(accessor, "byteOffset"), offset))) {
+
+		fprintf(stderr, "%s encountered malformed accessor %u\n", __FUNCTION__, idx);
+		return false;
+	}
+
+	const JsonNode* const normalized = get(accessor, "normalized");
+	const size_t sizeof_elem = sizeOfComponent(component_type) * num_components;
+	const size_t stride = 0 != view_stride ? view_stride : sizeof_elem;
+
+	if (view_len < offset || (0 != count && view_len - offset < stride * (count - 1) + sizeof_elem)) {
+		fprintf(stderr, "%s encountered out-of-bounds accessor %u\n", __FUNCTION__, idx);
+		return false;
+	}
+
+	out.data = bin + view_offset + offset;
+	out.stride = stride;
+	out.count = count;
+	out.component_type = component_type;
+	out.num_components = num_components;
+	out.normalized = 0 != normalized && 0.0 != normalized->number;
+	out.view = view_idx;
+	out.min = get(accessor, "min");
+	out.max = get(accessor, "max");
+	return true;
+}
+
+// joints of the first skin along with all their ancestor nodes, in bone order, i.e. parents ahead of
+// children; the ancestors that are not joints carry the transforms from the joints up to the scene
+struct SkinBones
+{
+	std::vector< uint32_t > node;		// per bone, its node
+	std::vector< uint8_t > parent;		// per bone, parent bone or 255
+	std::vector< uint32_t > joint;		// per bone, its joint of the skin or -1
+	std::vector< uint32_t > bone;		// per joint of the skin, its bone
+	std::vector< uint32_t > bone_of;	// per node, its bone or -1
+};
+
+bool getSkinBones(
+	const GlbFile& glb,
+	SkinBones& skin)
+{
+	const JsonNode* const nodes = glb.get(glb.root(), "nodes");
+	const JsonNode* const joints = glb.get(glb.at("skins", 0), "joints");
+
+	if (0 == nodes || 0 == joints || JsonNode::TYPE_ARRAY != joints->type || 0 == joints->count) {
+		fprintf(stderr, "%s encountered no skin\n", __FUNCTION__);
+		return false;
+	}
+
+	if (255 < joints->count) {
+		fprintf(stderr, "%s encountered too many joints\n", __FUNCTION__);
+		return false;
+	}
+
+	// parent of each node, from the children lists
+	const uint32_t num_nodes = nodes->count;
+	std::vector< uint32_t > parent(num_nodes, uint32_t(-1));
+	uint32_t i = 0;
+
+	for (const JsonNode* n = glb.at(nodes, 0); 0 != n; n = glb.next(n), ++i) {
+		const JsonNode* const children = glb.get(n, "children");
+
+		for (const JsonNode* c = glb.at(children, 0); 0 != c; c = glb.next(c)) {
+			uint32_t child;
+
+			if (!getUint(c, child) || num_nodes <= child || uint32_t(-1) != parent[child] || i == child) {
+				fprintf(stderr, "%s encountered malformed node hierarchy\n", __FUNCTION__);
+				return false;
+			}
+
+			parent[child] = i;
+		}
+	}
+
+	const uint32_t num_joints = joints->count;
+	std::vector< uint32_t > joint_node(num_joints);
+	std::vector< uint32_t > joint_of(num_nodes, uint32_t(-1));
+	i = 0;
+
+	for (const JsonNode* j = glb.at(joints, 0); 0 != j; j = glb.next(j), ++i) {
+		if (!getUint(j, joint_node[i]) || num_nodes <= joint_node[i] || uint32_t(-1) != joint_of[joint_node[i]]) {
+			fprintf(stderr, "%s encountered malformed joint list\n", __FUNCTION__);
+			return false;
+		}
+
+		joint_of[joint_node[i]] = i;
+	}
+
+	// emit the ancestor chain of each joint parents first; a chain longer than the node count is a cycle
+	skin.node.clear();
+	skin.parent.clear();
+	skin.joint.clear();
+	skin.bone.assign(num_joints, uint32_t(-1));
+	skin.bone_of.assign(num_nodes, uint32_t(-1));
+	std::vector< uint32_t > chain;
+
+	for (i = 0; i < num_joints; ++i) {
+		chain.clear();
+
+		for (uint32_t n = joint_node[i]; uint32_t(-1) != n && uint32_t(-1) == skin.bone_of[n]; n = parent[n]) {
+			if (num_nodes == chain.size()) {
+				fprintf(stderr, "%s encountered cyclic node hierarchy\n", __FUNCTION__);
+				return false;
+			}
+
+			chain.push_back(n);
+		}
+
+		if (255 < skin.node.size() + chain.size()) {
+			fprintf(stderr, "%s encountered too many bones\n", __FUNCTION__);
+			return false;
+		}
+
+		for (std::vector< uint32_t >::const_reverse_iterator it = chain.rbegin(); it != chain.rend(); ++it) {
+			const uint32_t n = *it;
+			skin.bone_of[n] = uint32_t(skin.node.size());
+			skin.node.push_back(n);
+			skin.parent.push_back(uint32_t(-1) != parent[n] ? uint8_t(skin.bone_of[parent[n]]) : uint8_t(255));
+			skin.joint.push_back(joint_of[n]);
+		}
+
+		skin.bone[i] = skin.bone_of[joint_node[i]];
+	}
+
+	return true;
+}
+
+// rest transform of a node, from its TRS or by decomposition of its matrix
+bool getNodeTransform(
+	const GlbFile& glb,
+	const JsonNode* const node,
+	float (&position)[3],
+	float (&orientation)[4],
+	float (&scale)[3])
+{
+	const JsonNode* const matrix = glb.get(node, "matrix");
+
+	if (0 != matrix) {
+		// column-major, column-vector convention
+		float m[16];
+
+		if (!getFloats(glb, matrix, m, 16))
+			return false;
+
+		for (unsigned i = 0; i < 3; ++i) {
+			position[i] = m[12 + i];
+			scale[i] = sqrtf(m[i * 4 + 0] * m[i * 4 + 0] + m[i * 4 + 1] * m[i * 4 + 1] + m[i * 4 + 2] * m[i * 4 + 2]);
+
+			if (0.f == scale[i])
+				return false;
+
+			m[i * 4 + 0] /= scale[i];
+			m[i * 4 + 1] /= scale[i];
+			m[i * 4 + 2] /= scale[i];
+		}
+
+		// r(row, col) = m[col * 4 + row]
+		const float r00 = m[0], r10 = m[1], r20 = m[2];
+		const float r01 = m[4], r11 = m[5], r21 = m[6];
+		const float r02 = m[8], r12 = m[9], r22 = m[10];
+		const float trace = r00 + r11 + r22;
+		float* const q = orientation;
+
+		if (0.f < trace) {
+			const float s = .5f / sqrtf(trace + 1.f);
+			q[3] = .25f / s;
+			q[0] = (r21 - r12) * s;
+			q[1] = (r02 - r20) * s;
+			q[2] = (r10 - r01) * s;
+		}
+		else
+		if (r00 > r11 && r00 > r22) {
+			const float s = 2.f * sqrtf(1.f + r00 - r11 - r22);
+			q[3] = (r21 - r12) / s;
+			q[0] = .25f * s;
+			q[1] = (r01 + r10) / s;
+			q[2] = (r02 + r20) / s;
+		}
+		else
+		if (r11 > r22) {
+			const float s = 2.f * sqrtf(1.f + r11 - r00 - r22);
+			q[3] = (r02 - r20) / s;
+			q[0] = (r01 + r10) / s;
+			q[1] = .25f * s;
+			q[2] = (r12 + r21) / s;
+		}
+		else {
+			const float s = 2.f * sqrtf(1.f + r22 - r00 - r11);
+			q[3] = (r10 - r01) / s;
+			q[0] = (r02 + r20) / s;
+			q[1] = (r12 + r21) / s;
+			q[2] = .25f * s;
+		}
+
+		return true;
+	}
+
+	const JsonNode* const t = glb.get(node, "translation");
+	const JsonNode* const r = glb.get(node, "rotation");
+	const JsonNode* const s = glb.get(node, "scale");
+
+	position[0] = position[1] = position[2] = 0.f;
+	orientation[0] = orientation[1] = orientation[2] = 0.f;
+	orientation[3] = 1.f;
+	scale[0] = scale[1] = scale[2] = 1.f;
+
+	return (0 == t || getFloats(glb, t, position, 3)) &&
+		(0 == r || getFloats(glb, r, orientation, 4)) &&
+		(0 == s || getFloats(glb, s, scale, 3));
+}
+
+// -ffast-math-proof finiteness test
+bool isfinite(const float c)
+{
+	const uint32_t exp_mask = 0x7f800000;
+	uint32_t ic;
+	memcpy(&ic, &c, sizeof(ic));
+	return exp_mask != (ic & exp_mask);
+}
+
+// max bone index representable in the bon[4] layout
+const unsigned bone_index_limit = 64;
+
+// a primitive of a mesh, by its accessors
+struct Primitive
+{
+	enum {
+		ATTR_POSITION,
+		ATTR_JOINTS,
+		ATTR_NORMAL,
+		ATTR_TEXCOORD,
+		ATTR_WEIGHTS,
+
+		ATTR_COUNT
+	};
+
+	Accessor attr[ATTR_COUNT];
+	bool has_attr[ATTR_COUNT];
+	Accessor index;
+	bool has_index;
+};
+
+bool getPrimitive(
+	const GlbFile& glb,
+	const JsonNode* const prim,
+	Primitive& out)
+{
+	uint32_t mode = 4;
+
+	if (0 != glb.get(prim, "mode") && (!getUint(glb.get(prim, "mode"), mode) || 4 != mode)) {
+		fprintf(stderr, "%s encountered non-trilist primitive\n", __FUNCTION__);
+		return false;
+	}
+
+	static const char* const attr_name[Primitive::ATTR_COUNT] = {
+		"POSITION",
+		"JOINTS_0",
+		"NORMAL",
+		"TEXCOORD_0",
+		"WEIGHTS_0"
+	};
+
+	const JsonNode* const attributes = glb.get(prim, "attributes");
+
+	for (unsigned i = 0; i < Primitive::ATTR_COUNT; ++i) {
+		const JsonNode* const attr = glb.get(attributes, attr_name[i]);
+		uint32_t idx;
+
+		out.has_attr[i] = 0 != attr;
+
+		if (0 != attr && (!getUint(attr, idx) || !glb.getAccessor(idx, out.attr[i])))
+			return false;
+	}
+
+	const JsonNode* const indices = glb.get(prim, "indices");
+	uint32_t idx;
+
+	out.has_index = 0 != indices;
+
+	if (0 != indices && (!getUint(indices, idx) || !glb.getAccessor(idx, out.index)))
+		return false;
+
+	if (!out.has_attr[Primitive::ATTR_POSITION] || !out.attr[Primitive::ATTR_POSITION].is(COMPONENT_FLOAT, 3)) {
+		fprintf(stderr, "%s encountered missing or non-float3 positions\n", __FUNCTION__);
+		return false;
+	}
+
+	const uint32_t num_verts = out.attr[Primitive::ATTR_POSITION].count;
+
+	for (unsigned i = 0; i < Primitive::ATTR_COUNT; ++i) {
+		if (out.has_attr[i] && num_verts != out.attr[i].count) {
+			fprintf(stderr, "%s encountered mismatching attribute counts\n", __FUNCTION__);
+			return false;
+		}
+	}
+
+	if ((out.has_attr[Primitive::ATTR_NORMAL] && !out.attr[Primitive::ATTR_NORMAL].is(COMPONENT_FLOAT, 3)) ||
+		(out.has_attr[Primitive::ATTR_TEXCOORD] && !out.attr[Primitive::ATTR_TEXCOORD].is(COMPONENT_FLOAT, 2))) {
+
+		fprintf(stderr, "%s encountered unsupported normal or tcoord type\n", __FUNCTION__);
+		return false;
+	}
+
+	if ((out.has_attr[Primitive::ATTR_JOINTS] && (4 != out.attr[Primitive::ATTR_JOINTS].num_components ||
+			(COMPONENT_UNSIGNED_BYTE != out.attr[Primitive::ATTR_JOINTS].component_type &&
+			 COMPONENT_UNSIGNED_SHORT != out.attr[Primitive::ATTR_JOINTS].component_type))) ||
+		(out.has_attr[Primitive::ATTR_WEIGHTS] && 4 != out.attr[Primitive::ATTR_WEIGHTS].num_components) ||
+		out.has_attr[Primitive::ATTR_JOINTS] != out.has_attr[Primitive::ATTR_WEIGHTS]) {
+
+		fprintf(stderr, "%s encountered unsupported or unpaired joints and weights\n", __FUNCTION__);
+		return false;
+	}
+
+	if (out.has_index) {
+		const uint32_t type = out.index.component_type;
+
+		if (1 != out.index.num_components || 0 != out.index.count % 3 || out.index.sizeofElement() != out.index.stride ||
+			(COMPONENT_UNSIGNED_BYTE != type && COMPONENT_UNSIGNED_SHORT != type && COMPONENT_UNSIGNED_INT != type)) {
+
+			fprintf(stderr, "%s encountered unsupported indices\n", __FUNCTION__);
+			return false;
+		}
+	}
+	else
+	if (0 != num_verts % 3) {
+		fprintf(stderr, "%s encountered non-indexed primitive of partial triangles\n", __FUNCTION__);
+		return false;
+	}
+
+	return true;
+}
+
+// primitives of the meshes of the skinned nodes of the first skin, or of all mesh nodes when there
+// are no skins; node transforms are not applied, per the skinning semantics of the former
+bool getPrimitives(
+	const GlbFile& glb,
+	std::vector< Primitive >& out)
+{
+	const bool skinned = 0 != glb.at("skins", 0);
+	const JsonNode* const meshes = glb.get(glb.root(), "meshes");
+	std::vector< bool > taken(0 != meshes ? meshes->count : 0, false);
+
+	for (const JsonNode* n = glb.at("nodes", 0); 0 != n; n = glb.next(n)) {
+		uint32_t mesh;
+		uint32_t skin;
+
+		if (!getUint(glb.get(n, "mesh"), mesh))
+			continue;
+
+		if (skinned && (!getUint(glb.get(n, "skin"), skin) || 0 != skin))
+			continue;
+
+		if (taken.size() <= mesh) {
+			fprintf(stderr, "%s encountered out-of-bounds mesh index\n", __FUNCTION__);
+			return false;
+		}
+
+		if (taken[mesh])
+			continue;
+
+		taken[mesh] = true;
+
+		for (const JsonNode* p = glb.at(glb.get(glb.at(meshes, mesh), "primitives"), 0); 0 != p; p = glb.next(p)) {
+			out.push_back(Primitive());
+
+			if (!getPrimitive(glb, p, out.back()))
+				return false;
+		}
+	}
+
+	if (out.empty()) {
+		fprintf(stderr, "%s encountered no mesh primitives\n", __FUNCTION__);
+		return false;
+	}
+
+	return true;
+}
+
+// pack the bone influences of a vertex into the bon[4] layout of the skinning shaders: normalized
+// weights of the first three influences in xyz, and the four 6-bit bone indices in w; no
+// influences means root of weight 1
+bool packBone(
+	const Accessor& joints,
+	const Accessor& weights,
+	const SkinBones& skin,
+	const size_t idx,
+	float (&bon)[4])
+{
+	unsigned index[4] = { 0, 0, 0, 0 };
+	float weight[4];
+
+	for (unsigned i = 0; i < 4; ++i) {
+		weight[i] = weights.fetch(idx, i);
+
+		if (0.f == weight[i])
+			continue;
+
+		const uint32_t joint = joints.fetchUint(idx, i);
+
+		if (skin.bone.size() <= joint || bone_index_limit <= skin.bone[joint]) {
+			fprintf(stderr, "%s encountered out-of-bounds joint index %u\n", __FUNCTION__, joint);
+			return false;
+		}
+
+		index[i] = skin.bone[joint];
+	}
+
+	const float sum = weight[0] + weight[1] + weight[2] + weight[3];
+
+	if (0.f >= sum) {
+		bon[0] = 1.f;
+		bon[1] = 0.f;
+		bon[2] = 0.f;
+		bon[3] = 0.f;
+		return true;
+	}
+
+	const float rcp_sum = 1.f / sum;
+
+	bon[0] = weight[0] * rcp_sum;
+	bon[1] = weight[1] * rcp_sum;
+	bon[2] = weight[2] * rcp_sum;
+	bon[3] = float(index[0] + (index[1] << 6) + (index[2] << 12) + (index[3] << 18));
+	return true;
+}
+
+struct PackedBone {
+	float bon[4];
+};
+
+} // namespace
+
+namespace util {
+
+bool
+fill_indexed_trilist_from_file_GLB(
+	const char* const filename,
+	const GLuint vbo_arr,
+	const GLuint vbo_idx,
+	const uintptr_t (&semantics_offset)[4],
+	unsigned& num_faces,
+	GLenum& index_type,
+	float (&bmin)[3],
+	float (&bmax)[3])
+{
+	assert(filename);
+	GlbFile glb;
+
+	if (!glb.open(filename))
+		return false;
+
+	SkinBones skin;
+	std::vector< Primitive > prim;
+
+	if ((0 != glb.at("skins", 0) && !getSkinBones(glb, skin)) || !getPrimitives(glb, prim))
+		return false;
+
+	// these are the semantics we care about currently and
+	// this is the order we want them in in the output buffer
+	enum {
+		SEMANTIC_POS,
+		SEMANTIC_BON,
+		SEMANTIC_NRM,
+		SEMANTIC_TXC,
+
+		SEMANTIC_COUNT
+	};
+
+	static const size_t semantics_size[SEMANTIC_COUNT] = {
+		sizeof(float[3]),
+		sizeof(float[4]),
+		sizeof(float[3]),
+		sizeof(float[2])
+	};
+
+	size_t sizeof_vertex = 0;
+
+	for (unsigned i = 0; i < SEMANTIC_COUNT; ++i)
+		if (uintptr_t(-1) != semantics_offset[i])
+			sizeof_vertex += semantics_size[i];
+
+	const bool want_bon = uintptr_t(-1) != semantics_offset[SEMANTIC_BON];
+	const bool want_nrm = uintptr_t(-1) != semantics_offset[SEMANTIC_NRM];
+	const bool want_txc = uintptr_t(-1) != semantics_offset[SEMANTIC_TXC];
+
+	const float inf = 1.f / 0.f;
+	bmin[0] = bmin[1] = bmin[2] = inf;
+	bmax[0] = bmax[1] = bmax[2] = -inf;
+
+	uint64_t vertexCount = 0;
+	uint64_t indexCount = 0;
+
+	for (std::vector< Primitive >::const_iterator it = prim.begin(); it != prim.end(); ++it) {
+		if ((want_nrm && !it->has_attr[Primitive::ATTR_NORMAL]) ||
+			(want_txc && !it->has_attr[Primitive::ATTR_TEXCOORD])) {
+
+			fprintf(stderr, "%s encountered mesh missing normal or tcoord\n", __FUNCTION__);
+			return false;
+		}
+
+		const Accessor& pos = it->attr[Primitive::ATTR_POSITION];
+		const uint32_t subVertCount = pos.count;
+		const uint32_t subIdxCount = it->has_index ? it->index.count : subVertCount;
+
+		// validate the indices ahead of mapping the output; this also faults in their pages
+		if (it->has_index) {
+			uint32_t max_index = 0;
+
+			switch (it->index.component_type) {
+			case COMPONENT_UNSIGNED_BYTE:
+				for (uint32_t i = 0; i < subIdxCount; ++i)
+					max_index = std::max(max_index, uint32_t(it->index.data[i]));
+				break;
+
+			case COMPONENT_UNSIGNED_SHORT:
+				for (uint32_t i = 0; i < subIdxCount; ++i) {
+					uint16_t index;
+					memcpy(&index, it->index.data + i * sizeof(index), sizeof(index));
+					max_index = std::max(max_index, uint32_t(index));
+				}
+				break;
+
+			default:
+				for (uint32_t i = 0; i < subIdxCount; ++i) {
+					uint32_t index;
+					memcpy(&index, it->index.data + i * sizeof(index), sizeof(index));
+					max_index = std::max(max_index, index);
+				}
+				break;
+			}
+
+			if (subIdxCount && max_index >= subVertCount) {
+				fprintf(stderr, "%s encountered out-of-bounds index\n", __FUNCTION__);
+				return false;
+			}
+		}
+
+		// bounds from the mandatory accessor min/max, or from the positions if absent
+		float pmin[3];
+		float pmax[3];
+
+		if (!getFloats(glb, pos.min, pmin, 3) || !getFloats(glb, pos.max, pmax, 3)) {
+			pmin[0] = pmin[1] = pmin[2] = inf;
+			pmax[0] = pmax[1] = pmax[2] = -inf;
+
+			for (uint32_t i = 0; i < subVertCount; ++i)
+				for (unsigned j = 0; j < 3; ++j) {
+					const float p = pos.fetch(i, j);
+					pmin[j] = fminf(pmin[j], p);
+					pmax[j] = fmaxf(pmax[j], p);
+				}
+		}
+
+		for (unsigned j = 0; j < 3; ++j) {
+			bmin[j] = fminf(bmin[j], pmin[j]);
+			bmax[j] = fmaxf(bmax[j], pmax[j]);
+		}
+
+		vertexCount += subVertCount;
+		indexCount += subIdxCount;
+	}
+
+	if (!isfinite(bmin[0]) || !isfinite(bmin[1]) || !isfinite(bmin[2]) ||
+		!isfinite(bmax[0]) || !isfinite(bmax[1]) || !isfinite(bmax[2])) {
+
+		fprintf(stderr, "%s encountered empty or non-finite bounds\n", __FUNCTION__);
+		return false;
+	}
+
+	if (vertexCount > (uint64_t(1) << 32)) {
+		fprintf(stderr, "total vertex count of primitives exceeds indexing capacity\n");
+		return false;
+	}
+
+	// a single primitive of 16- or 32-bit indices gets its index buffer straight from the mapping
+	const Primitive& prim0 = prim.front();
+	const bool direct_idx = 1 == prim.size() && prim0.has_index &&
+		COMPONENT_UNSIGNED_BYTE != prim0.index.component_type;
+
+	size_t sizeof_index = vertexCount > (uint64_t(1) << 16) ? sizeof(uint32_t) : sizeof(uint16_t);
+
+	if (direct_idx)
+		sizeof_index = prim0.index.sizeofElement();
+
+	index_type = sizeof(uint16_t) == sizeof_index ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+	// a single primitive of one interleaved view matching the output layout gets its vertex buffer
+	// straight from the mapping; bones get composed, so their presence rules that out
+	const Accessor& pos0 = prim0.attr[Primitive::ATTR_POSITION];
+	const uint8_t* const base0 = pos0.data - semantics_offset[SEMANTIC_POS];
+	bool direct_vtx = 1 == prim.size() && !want_bon && sizeof_vertex == pos0.stride;
+
+	const struct {
+		bool want;
+		unsigned attr;
+		unsigned semantic;
+	} direct_attr[] = {
+		{ want_nrm, Primitive::ATTR_NORMAL,   SEMANTIC_NRM },
+		{ want_txc, Primitive::ATTR_TEXCOORD, SEMANTIC_TXC }
+	};
+
+	for (size_t i = 0; i < sizeof(direct_attr) / sizeof(direct_attr[0]) && direct_vtx; ++i) {
+		const Accessor& attr = prim0.attr[direct_attr[i].attr];
+		direct_vtx = !direct_attr[i].want || (pos0.view == attr.view && pos0.stride == attr.stride &&
+			base0 + semantics_offset[direct_attr[i].semantic] == attr.data);
+	}
+
+	// the attributes tile the vertex, so the span of their first and last elements has to be in the
+	// binary chunk; that is not a given for position at a non-zero offset
+	direct_vtx = direct_vtx && glb.contains(base0, size_t(pos0.count) * sizeof_vertex);
+
+	const GLsizeiptr sizeArr = GLsizeiptr(vertexCount) * sizeof_vertex;
+	const GLsizeiptr sizeIdx = GLsizeiptr(indexCount) * sizeof_index;
+
+	fprintf(stdout, "vertex size: %u\n", uint32_t(sizeof_vertex));
+	fprintf(stdout, "direct upload of vertices: %s, indices: %s\n", direct_vtx ? "yes" : "no", direct_idx ? "yes" : "no");
+
+	glBindBuffer(GL_ARRAY_BUFFER,         vbo_arr);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo_idx);
+
+	glBufferData(GL_ARRAY_BUFFER,         sizeArr, direct_vtx ? base0 : 0, GL_STATIC_DRAW);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeIdx, direct_idx ? prim0.index.data : 0, GL_STATIC_DRAW);
+
+	void* bitsArr = direct_vtx ? 0 : glMapBufferOES(GL_ARRAY_BUFFER,         GL_WRITE_ONLY_OES);
+	void* bitsIdx = direct_idx ? 0 : glMapBufferOES(GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY_OES);
+	bool success = (direct_vtx || 0 != bitsArr) && (direct_idx || 0 != bitsIdx);
+
+	if (!success)
+		fprintf(stderr, "%s failed to map the output buffers\n", __FUNCTION__);
+
+	size_t offsIdx = 0;
+
+	// gather the output buffers straight from the file mapping
+	for (std::vector< Primitive >::const_iterator it = prim.begin(); success && it != prim.end(); ++it) {
+		const size_t subVertCount = it->attr[Primitive::ATTR_POSITION].count;
+
+		// fill in the vertices
+		if (!direct_vtx) {
+			int8_t* typedBitsArr = reinterpret_cast< int8_t* >(bitsArr);
+			std::vector< PackedBone > bone;
+
+			if (want_bon) {
+				bone.resize(subVertCount);
+
+				const PackedBone root = { { 1.f, 0.f, 0.f, 0.f } };
+
+				if (it->has_attr[Primitive::ATTR_JOINTS] && !skin.bone.empty()) {
+					for (size_t i = 0; success && i < subVertCount; ++i)
+						success = packBone(it->attr[Primitive::ATTR_JOINTS], it->attr[Primitive::ATTR_WEIGHTS], skin, i, bone[i].bon);
+				}
+				else
+					std::fill(bone.begin(), bone.end(), root);
+			}
+
+			rend::GatherLayout layout(sizeof_vertex);
+
+			const struct {
+				unsigned attr;
+				unsigned semantic;
+				rend::GatherFormat format;
+			} stream[] = {
+				{ Primitive::ATTR_POSITION, SEMANTIC_POS, rend::GATHER_FLOAT3 },
+				{ Primitive::ATTR_NORMAL,   SEMANTIC_NRM, rend::GATHER_FLOAT3 },
+				{ Primitive::ATTR_TEXCOORD, SEMANTIC_TXC, rend::GATHER_FLOAT2 }
+			};
+
+			for (size_t j = 0; j < sizeof(stream) / sizeof(stream[0]); ++j) {
+				if (uintptr_t(-1) == semantics_offset[stream[j].semantic])
+					continue;
+
+				const Accessor& attr = it->attr[stream[j].attr];
+				layout.add(attr.data, attr.stride, semantics_offset[stream[j].semantic], stream[j].format);
+			}
+
+			if (want_bon && subVertCount)
+				layout.add(bone.front().bon, sizeof(PackedBone), semantics_offset[SEMANTIC_BON], rend::GATHER_FLOAT4);
+
+			if (success && !rend::gatherVertices(layout, typedBitsArr, subVertCount)) {
+				fprintf(stderr, "%s encountered unsupported output layout\n", __FUNCTION__);
+				success = false;
+			}
+
+			typedBitsArr += sizeof_vertex * subVertCount;
+			bitsArr = typedBitsArr;
+		}
+
+		// fill in the indices, rebased and widened as needed
+		if (!direct_idx) {
+			const size_t subIdxCount = it->has_index ? it->index.count : subVertCount;
+
+			if (sizeof(uint16_t) == sizeof_index) {
+				uint16_t* typedBitsIdx = reinterpret_cast< uint16_t* >(bitsIdx);
+
+				for (size_t i = 0; i < subIdxCount; ++i)
+					*typedBitsIdx++ = uint16_t(offsIdx + (it->has_index ? it->index.fetchUint(i, 0) : i));
+
+				bitsIdx = typedBitsIdx;
+			}
+			else {
+				uint32_t* typedBitsIdx = reinterpret_cast< uint32_t* >(bitsIdx);
+
+				for (size_t i = 0; i < subIdxCount; ++i)
+					*typedBitsIdx++ = uint32_t(offsIdx + (it->has_index ? it->index.fetchUint(i, 0) : i));
+
+				bitsIdx = typedBitsIdx;
+			}
+		}
+
+		offsIdx += subVertCount;
+	}
+
+	if (!direct_vtx)
+		glUnmapBufferOES(GL_ARRAY_BUFFER);
+
+	if (!direct_idx)
+		glUnmapBufferOES(GL_ELEMENT_ARRAY_BUFFER);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	if (!success)
+		return false;
+
+	num_faces = uint32_t(indexCount) / 3;
+
+	fprintf(stdout, "number of vertices: %u\nnumber of indices: %u\n",
+		uint32_t(vertexCount), uint32_t(indexCount));
+
+	return true;
+}
+
+} // namespace util
+
+namespace rend {
+
+using namespace simd;
+
+bool
+loadSkeletonAnimationGLB(
+	const char* const filename,
+	unsigned* count,
+	dense_matx4* bone_mat,
+	Bone* bone,
+	std::vector< std::vector< Track > >& animations,
+	std::vector< float >& durations)
+{
+	assert(filename);
+	assert(count);
+	assert(bone_mat);
+	assert(bone);
+
+	GlbFile glb;
+	SkinBones skin;
+
+	if (!glb.open(filename) || !getSkinBones(glb, skin))
+		return false;
+
+	const unsigned boneCount = unsigned(skin.node.size());
+
+	if (boneCount > *count) {
+		fprintf(stderr, "%s encountered too many bones\n", __FUNCTION__);
+		return false;
+	}
+
+	for (unsigned i = 0; i < boneCount; ++i) {
+		const JsonNode* const node = glb.at("nodes", skin.node[i]);
+		const JsonNode* const name = glb.get(node, "name");
+		float position[3];
+		float orientation[4];
+		float scale[3];
+
+		if (!getNodeTransform(glb, node, position, orientation, scale)) {
+			fprintf(stderr, "%s encountered malformed transform of node %u\n", __FUNCTION__, skin.node[i]);
+			return false;
+		}
+
+		// glTF quaternions are x, y, z, w of the same handedness as the Ogre ones
+		bone[i] = Bone();
+		bone[i].name = 0 != name && JsonNode::TYPE_STRING == name->type ? std::string(name->str, name->str_len) : std::string();
+		bone[i].position = vect3(position[0], position[1], position[2]);
+		bone[i].orientation = quat(orientation[0], orientation[1], orientation[2], orientation[3]);
+		bone[i].scale = vect3(scale[0], scale[1], scale[2]);
+		bone[i].parent_idx = skin.parent[i];
+	}
+
+	// channels target the local TRS of the nodes, i.e. no correction by the bind pose is due;
+	// step interpolation gets approximated by linear, cubic splines by their keys sans tangents
+	for (const JsonNode* a = glb.at("animations", 0); 0 != a; a = glb.next(a)) {
+		const JsonNode* const samplers = glb.get(a, "samplers");
+		std::vector< Track >& skeletal_animation = *animations.insert(animations.end(), std::vector< Track >());
+		std::vector< uint32_t > track_of(boneCount, uint32_t(-1));
+		float duration = 0.f;
+
+		for (const JsonNode* c = glb.at(glb.get(a, "channels"), 0); 0 != c; c = glb.next(c)) {
+			const JsonNode* const target = glb.get(c, "target");
+			const JsonNode* const path = glb.get(target, "path");
+			uint32_t node_idx;
+			uint32_t sampler_idx;
+
+			if (!getUint(glb.get(target, "node"), node_idx) || skin.bone_of.size() <= node_idx ||
+				uint32_t(-1) == skin.bone_of[node_idx] || isString(path, "weights")) {
+
+				continue;
+			}
+
+			const JsonNode* const sampler = glb.at(samplers, getUint(glb.get(c, "sampler"), sampler_idx) ? sampler_idx : uint32_t(-1));
+			uint32_t input_idx;
+			uint32_t output_idx;
+			Accessor input;
+			Accessor output;
+
+			if (0 == sampler ||
+				!getUint(glb.get(sampler, "input"), input_idx) || !glb.getAccessor(input_idx, input) ||
+				!getUint(glb.get(sampler, "output"), output_idx) || !glb.getAccessor(output_idx, output) ||
+				!input.is(COMPONENT_FLOAT, 1)) {
+
+				fprintf(stderr, "%s encountered malformed animation sampler\n", __FUNCTION__);
+				return false;
+			}
+
+			const bool cubic = isString(glb.get(sampler, "interpolation"), "CUBICSPLINE");
+			const size_t elem_step = cubic ? 3 : 1;
+			const size_t elem_offset = cubic ? 1 : 0;
+			const bool rotation = isString(path, "rotation");
+
+			if (output.count != input.count * elem_step ||
+				(rotation ? 4 : 3) != output.num_components ||
+				(!rotation && COMPONENT_FLOAT != output.component_type) ||
+				(rotation && COMPONENT_FLOAT != output.component_type && !output.normalized)) {
+
+				fprintf(stderr, "%s encountered malformed animation sampler output\n", __FUNCTION__);
+				return false;
+			}
+
+			const uint32_t bone_idx = skin.bone_of[node_idx];
+
+			if (uint32_t(-1) == track_of[bone_idx]) {
+				track_of[bone_idx] = uint32_t(skeletal_animation.size());
+				Track& track = *skeletal_animation.insert(skeletal_animation.end(), Track());
+				track.bone_idx = uint8_t(bone_idx);
+				track.position_last_key_idx = 0;
+				track.orientation_last_key_idx = 0;
+				track.scale_last_key_idx = 0;
+			}
+
+			Track& track = skeletal_animation[track_of[bone_idx]];
+
+			if (isString(path, "translation")) {
+				track.position_key.reserve(input.count);
+
+				for (uint32_t i = 0; i < input.count; ++i) {
+					BonePositionKey& key = *track.position_key.insert(track.position_key.end(), BonePositionKey());
+					const size_t j = i * elem_step + elem_offset;
+					key.time = input.fetch(i, 0);
+					key.value = vect3(output.fetch(j, 0), output.fetch(j, 1), output.fetch(j, 2));
+				}
+			}
+			else
+			if (rotation) {
+				track.orientation_key.reserve(input.count);
+
+				for (uint32_t i = 0; i < input.count; ++i) {
+					BoneOrientationKey& key = *track.orientation_key.insert(track.orientation_key.end(), BoneOrientationKey());
+					const size_t j = i * elem_step + elem_offset;
+					key.time = input.fetch(i, 0);
+					key.value = quat(output.fetch(j, 0), output.fetch(j, 1), output.fetch(j, 2), output.fetch(j, 3));
+				}
+			}
+			else
+			if (isString(path, "scale")) {
+				track.scale_key.reserve(input.count);
+
+				for (uint32_t i = 0; i < input.count; ++i) {
+					BoneScaleKey& key = *track.scale_key.insert(track.scale_key.end(), BoneScaleKey());
+					const size_t j = i * elem_step + elem_offset;
+					key.time = input.fetch(i, 0);
+					key.value = vect3(output.fetch(j, 0), output.fetch(j, 1), output.fetch(j, 2));
+				}
+			}
+			else
+				continue;
+
+			if (input.count)
+				duration = fmaxf(duration, input.fetch(input.count - 1, 0));
+		}
+
+		if (0.f == duration)
+			fprintf(stdout, "warning: animation %u has zero duration\n", unsigned(animations.size() - 1));
+
+		durations.push_back(duration);
+	}
+
+	// a static skin still gets an animation, of no tracks
+	if (animations.empty()) {
+		animations.push_back(std::vector< Track >());
+		durations.push_back(1.f);
+	}
+
+	for (unsigned i = 0; i < boneCount; ++i)
+		initBoneMatx(boneCount, bone_mat, bone, i);
+
+	// the bind transforms of the joints come from the inverse bind matrices, identities when absent;
+	// the bind pose need not be the rest pose, as skinning composes the bind transform with the current
+	const JsonNode* const ibm_idx = glb.get(glb.at("skins", 0), "inverseBindMatrices");
+	uint32_t accessor_idx;
+	Accessor ibm;
+
+	if (0 != ibm_idx && (!getUint(ibm_idx, accessor_idx) || !glb.getAccessor(accessor_idx, ibm) ||
+		!ibm.is(COMPONENT_FLOAT, 16) || skin.bone.size() != ibm.count)) {
+
+		fprintf(stderr, "%s encountered malformed inverse bind matrices\n", __FUNCTION__);
+		return false;
+	}
+
+	for (unsigned i = 0; i < boneCount; ++i) {
+		const uint32_t joint = skin.joint[i];
+
+		if (uint32_t(-1) == joint)
+			continue;
+
+		// column-major, column-vector convention, i.e. the columns are our rows
+		float m[16];
+
+		for (unsigned j = 0; j < 16; ++j)
+			m[j] = 0 != ibm_idx ? ibm.fetch(joint, j) : float(0 == j % 5);
+
+		const float affine_tolerance = 1e-5f;
+		bool affine =
+			affine_tolerance >= fabsf(m[3]) && affine_tolerance >= fabsf(m[7]) &&
+			affine_tolerance >= fabsf(m[11]) && affine_tolerance >= fabsf(m[15] - 1.f);
+
+		for (unsigned j = 0; j < 16 && affine; ++j)
+			affine = isfinite(m[j]);
+
+		const float det =
+			m[0] * (m[5] * m[10] - m[6] * m[9]) -
+			m[1] * (m[4] * m[10] - m[6] * m[8]) +
+			m[2] * (m[4] * m[9] - m[5] * m[8]);
+
+		if (!affine || !(1e-24f < fabsf(det))) {
+			fprintf(stderr, "%s encountered malformed or singular inverse bind matrix of joint %u\n", __FUNCTION__, joint);
+			return false;
+		}
+
+		bone[i].to_local.set(0, vect4(m[ 0], m[ 1], m[ 2], m[ 3]));
+		bone[i].to_local.set(1, vect4(m[ 4], m[ 5], m[ 6], m[ 7]));
+		bone[i].to_local.set(2, vect4(m[ 8], m[ 9], m[10], m[11]));
+		bone[i].to_local.set(3, vect4(m[12], m[13], m[14], m[15]));
+
+		// skinning of the rest pose off the bind pose
+		const matx4 b = matx4().mul(bone[i].to_local, bone[i].to_model);
+
+		bone_mat[i] = dense_matx4(
+			b[0][0], b[0][1], b[0][2], b[0][3],
+			b[1][0], b[1][1], b[1][2], b[1][3],
+			b[2][0], b[2][1], b[2][2], b[2][3],
+			b[3][0], b[3][1], b[3][2], b[3][3]);
+	}
+
+	*count = boneCount;
+	return true;
+}
+
+} // namespace rend
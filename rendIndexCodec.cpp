@@ -0,0 +1,378 @@
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <vector>
+
+#include "rendIndexCodec.hpp"
+
+namespace { // anonymous
+
+const uint8_t codec_version = 0xe1;
+
+// FIFO sizes; FIFO codes 0xf are reserved, so entries past the 15th are never referred to
+const unsigned edge_fifo_size = 16;
+const unsigned vert_fifo_size = 16;
+
+// vertex codes
+enum {
+	VCODE_NEXT = 0,		// the next never-seen vertex
+						// 1 - 14: vertex FIFO entry, most recent first
+	VCODE_EXPLICIT = 15	// zigzag varint delta from the last explicit vertex
+};
+
+// edge codes of a triangle with no edge hit: the common case of an old vertex followed by two
+// new ones in a byte, and the general case in two
+const unsigned ecode_none_next = 14;
+const unsigned ecode_none = 15;
+
+struct Edge
+{
+	uint32_t first;
+	uint32_t second;
+};
+
+// coder state, identical on both ends
+struct CodecState
+{
+	Edge edge[edge_fifo_size];
+	uint32_t vert[vert_fifo_size];
+	unsigned edge_head;
+	unsigned vert_head;
+	uint32_t next;
+	uint32_t last;
+
+	CodecState()
+	: edge_head(0)
+	, vert_head(0)
+	, next(0)
+	, last(0)
+	{
+		memset(edge, -1, sizeof(edge));
+		memset(vert, -1, sizeof(vert));
+	}
+
+	void pushEdge(
+		const uint32_t a,
+		const uint32_t b)
+	{
+		const Edge e = { a, b };
+		edge[edge_head++ & (edge_fifo_size - 1)] = e;
+	}
+
+	void pushVert(
+		const uint32_t v)
+	{
+		vert[vert_head++ & (vert_fifo_size - 1)] = v;
+	}
+
+	// edge FIFO entry, 0 being most recent
+	const Edge& getEdge(
+		const unsigned i) const
+	{
+		return edge[(edge_head - 1 - i) & (edge_fifo_size - 1)];
+	}
+
+	// vertex FIFO entry, 1 being most recent
+	uint32_t getVert(
+		const unsigned i) const
+	{
+		return vert[(vert_head - i) & (vert_fifo_size - 1)];
+	}
+};
+
+inline uint32_t
+zigzag(
+	const int32_t v)
+{
+	return uint32_t(v << 1) ^ uint32_t(v >> 31);
+}
+
+inline int32_t
+unzigzag(
+	const uint32_t v)
+{
+	return int32_t(v >> 1) ^ -int32_t(v & 1);
+}
+
+void
+putVarint(
+	std::vector< uint8_t >& out,
+	uint32_t v)
+{
+	while (v >= 0x80) {
+		out.push_back(uint8_t(v | 0x80));
+		v >>= 7;
+	}
+	out.push_back(uint8_t(v));
+}
+
+// code a vertex, updating the state; explicit vertices go to data
+unsigned
+encodeVert(
+	CodecState& state,
+	std::vector< uint8_t >& data,
+	const uint32_t v)
+{
+	if (v == state.next) {
+		state.next++;
+		state.pushVert(v);
+		return VCODE_NEXT;
+	}
+
+	for (unsigned i = 1; i < VCODE_EXPLICIT; ++i)
+		if (state.getVert(i) == v)
+			return i;
+
+	putVarint(data, zigzag(int32_t(v - state.last)));
+	state.last = v;
+	state.pushVert(v);
+	return VCODE_EXPLICIT;
+}
+
+// decoder-side data stream
+struct DataCursor
+{
+	const uint8_t* pos;
+	const uint8_t* end;
+
+	bool getVarint(
+		uint32_t& v)
+	{
+		v = 0;
+
+		for (unsigned shift = 0; shift < 35 && pos != end; shift += 7) {
+			const uint8_t b = *pos++;
+			v |= uint32_t(b & 0x7f) << shift;
+
+			if (0 == (b & 0x80))
+				return true;
+		}
+
+		return false;
+	}
+};
+
+// decode a vertex, updating the state
+inline bool
+decodeVert(
+	CodecState& state,
+	DataCursor& data,
+	const unsigned code,
+	uint32_t& v)
+{
+	if (VCODE_NEXT == code) {
+		v = state.next++;
+		state.pushVert(v);
+		return true;
+	}
+
+	if (VCODE_EXPLICIT != code) {
+		v = state.getVert(code);
+		return true;
+	}
+
+	uint32_t delta;
+
+	if (!data.getVarint(delta))
+		return false;
+
+	v = state.last + uint32_t(unzigzag(delta));
+	state.last = v;
+	state.pushVert(v);
+	return true;
+}
+
+template < typename INDEX_T >
+bool
+decodeTrilist(
+	INDEX_T* dst,
+	const size_t num_tris,
+	const uint8_t* codes,
+	const uint8_t* const codes_end,
+	DataCursor& data)
+{
+	CodecState state;
+	const uint32_t limit = uint32_t(INDEX_T(-1));
+
+	for (size_t i = 0; i < num_tris; ++i) {
+		if (codes == codes_end)
+			return false;
+
+		const unsigned code = *codes++;
+		const unsigned ecode = code >> 4;
+		uint32_t a, b, c;
+
+		if (ecode_none_next > ecode) {
+			const Edge& e = state.getEdge(ecode);
+			a = e.second;
+			b = e.first;
+
+			if (!decodeVert(state, data, code & 0xf, c))
+				return false;
+
+			state.pushEdge(b, c);
+			state.pushEdge(c, a);
+		}
+		else {
+			unsigned code_bc = VCODE_NEXT << 4 | VCODE_NEXT;
+
+			if (ecode_none == ecode) {
+				if (codes == codes_end)
+					return false;
+
+				code_bc = *codes++;
+			}
+
+			if (!decodeVert(state, data, code & 0xf, a) ||
+				!decodeVert(state, data, code_bc >> 4, b) ||
+				!decodeVert(state, data, code_bc & 0xf, c))
+				return false;
+
+			state.pushEdge(a, b);
+			state.pushEdge(b, c);
+			state.pushEdge(c, a);
+		}
+
+		if (a > limit || b > limit || c > limit)
+			return false;
+
+		dst[0] = INDEX_T(a);
+		dst[1] = INDEX_T(b);
+		dst[2] = INDEX_T(c);
+		dst += 3;
+	}
+
+	return codes == codes_end && data.pos == data.end;
+}
+
+} // namespace
+
+namespace rend
+{
+
+bool
+encodeIndexBuffer(
+	std::vector< uint8_t >& out,
+	const uint32_t* const index,
+	const size_t num_indices)
+{
+	if (num_indices % 3)
+		return false;
+
+	CodecState state;
+	std::vector< uint8_t > codes;
+	std::vector< uint8_t > data;
+
+	codes.reserve(num_indices / 3);
+
+	for (size_t i = 0; i < num_indices; i += 3) {
+		const uint32_t tri[] = { index[i + 0], index[i + 1], index[i + 2] };
+
+		// find a rotation of the triangle that shares an edge with a recent triangle, the latter
+		// having the edge in the opposite direction
+		unsigned hit_edge = ecode_none;
+		unsigned hit_rot = 0;
+
+		for (unsigned e = 0; e < ecode_none_next && ecode_none == hit_edge; ++e) {
+			const Edge& edge = state.getEdge(e);
+
+			for (unsigned r = 0; r < 3; ++r) {
+				if (tri[r] == edge.second && tri[(r + 1) % 3] == edge.first) {
+					hit_edge = e;
+					hit_rot = r;
+					break;
+				}
+			}
+		}
+
+		if (ecode_none != hit_edge) {
+			const uint32_t a = tri[hit_rot];
+			const uint32_t b = tri[(hit_rot + 1) % 3];
+			const uint32_t c = tri[(hit_rot + 2) % 3];
+
+			codes.push_back(uint8_t(hit_edge << 4 | encodeVert(state, data, c)));
+
+			state.pushEdge(b, c);
+			state.pushEdge(c, a);
+		}
+		else {
+			// prefer a rotation ending in two new vertices
+			unsigned rot = 0;
+
+			for (unsigned r = 0; r < 3; ++r) {
+				if (tri[(r + 1) % 3] == state.next + (tri[r] == state.next) &&
+					tri[(r + 2) % 3] == state.next + (tri[r] == state.next) + 1) {
+					rot = r;
+					break;
+				}
+			}
+
+			const uint32_t a = tri[rot];
+			const uint32_t b = tri[(rot + 1) % 3];
+			const uint32_t c = tri[(rot + 2) % 3];
+
+			const unsigned code_a = encodeVert(state, data, a);
+			const unsigned code_b = encodeVert(state, data, b);
+			const unsigned code_c = encodeVert(state, data, c);
+
+			if (VCODE_NEXT == code_b && VCODE_NEXT == code_c)
+				codes.push_back(uint8_t(ecode_none_next << 4 | code_a));
+			else {
+				codes.push_back(uint8_t(ecode_none << 4 | code_a));
+				codes.push_back(uint8_t(code_b << 4 | code_c));
+			}
+
+			state.pushEdge(a, b);
+			state.pushEdge(b, c);
+			state.pushEdge(c, a);
+		}
+	}
+
+	const uint32_t codes_size = uint32_t(codes.size());
+
+	out.push_back(codec_version);
+	out.insert(out.end(),
+		reinterpret_cast< const uint8_t* >(&codes_size),
+		reinterpret_cast< const uint8_t* >(&codes_size) + sizeof(codes_size));
+	out.insert(out.end(), codes.begin(), codes.end());
+	out.insert(out.end(), data.begin(), data.end());
+
+	return true;
+}
+
+bool
+decodeIndexBuffer(
+	void* const dst,
+	const size_t num_indices,
+	const size_t index_size,
+	const uint8_t* const src,
+	const size_t src_size)
+{
+	uint32_t codes_size;
+
+	if (num_indices % 3 ||
+		src_size < sizeof(codec_version) + sizeof(codes_size) ||
+		codec_version != src[0])
+		return false;
+
+	memcpy(&codes_size, src + sizeof(codec_version), sizeof(codes_size));
+
+	const uint8_t* const codes = src + sizeof(codec_version) + sizeof(codes_size);
+	const uint8_t* const end = src + src_size;
+
+	if (codes_size > size_t(end - codes))
+		return false;
+
+	DataCursor data = { codes + codes_size, end };
+
+	switch (index_size) {
+	case sizeof(uint16_t):
+		return decodeTrilist(reinterpret_cast< uint16_t* >(dst), num_indices / 3, codes, codes + codes_size, data);
+	case sizeof(uint32_t):
+		return decodeTrilist(reinterpret_cast< uint32_t* >(dst), num_indices / 3, codes, codes + codes_size, data);
+	}
+
+	return false;
+}
+
+} // namespace rend
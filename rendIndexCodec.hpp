@@ -0,0 +1,45 @@
+#ifndef rend_index_codec_H__
+#define rend_index_codec_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace rend
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// trilist index codec: each triangle becomes a code byte referring to a recently-seen edge and a
+// recently-seen vertex through small FIFOs, or to the next never-seen vertex; what the FIFOs miss
+// goes to a data stream as zigzag varint deltas. Triangles may come out rotated, winding intact.
+// Compression depends on the face order having vertex-cache locality, e.g. after clusterization.
+//
+// encoded layout:
+//
+//	uint8_t  version
+//	uint32_t size of code stream
+//	uint8_t  codes[]	one per triangle, plus one per triangle with no edge hit
+//	uint8_t  data[]		varints of explicit vertices
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// encode a trilist of 32-bit indices, appending to out; return false if num_indices is not a
+// multiple of three
+bool
+encodeIndexBuffer(
+	std::vector< uint8_t >& out,
+	const uint32_t* const index,
+	const size_t num_indices);
+
+// decode a trilist into a buffer of num_indices indices of index_size bytes (2 or 4), e.g. a
+// mapped element buffer; return false on malformed input or indices exceeding index_size
+bool
+decodeIndexBuffer(
+	void* const dst,
+	const size_t num_indices,
+	const size_t index_size,
+	const uint8_t* const src,
+	const size_t src_size);
+
+} // namespace rend
+
+#endif // rend_index_codec_H__
@@ -17,7 +17,11 @@
 
 #include "scoped.hpp"
 #include "stream.hpp"
+#include "util_file.hpp"
 #include "rendIndexedTrilist.hpp"
+#include "rendVertQuant.hpp"
+#include "rendVertGather.hpp"
+#include "rendIndexCodec.hpp"
 
 #ifndef MESH_INDEX_START
 #define MESH_INDEX_START 0
@@ -135,6 +139,75 @@ const T& max(
 	return a > b ? a : b;
 }
 
+// split a facelist of 32-bit indices into batches addressable by 16-bit indices, in face order;
+// produce the batch-relative indices and the source vertex of each batched vertex
+static bool
+splitFacelistBatches(
+	const uint32_t* const index,
+	const unsigned indices_per_face,
+	const unsigned num_faces,
+	const unsigned num_verts,
+	uint16_t* const batch_index,
+	std::vector< uint32_t >& batch_vertex,
+	TrilistBatches& batches)
+{
+	const uint32_t capacity = uint32_t(1) + uint16_t(-1);
+	std::vector< uint32_t > owner(num_verts, uint32_t(-1)); // batch of the latest use of a vertex
+	std::vector< uint16_t > local(num_verts); // index of a vertex in its latest batch
+	TrilistBatch batch = { 0, 0, 0, 0 };
+
+	for (unsigned i = 0; i < num_faces; ++i)
+	{
+		const uint32_t* const face = index + i * indices_per_face;
+		unsigned fresh = 0;
+
+		for (unsigned j = 0; j < indices_per_face; ++j)
+		{
+			if (num_verts <= face[j])
+			{
+				stream::cerr << __FUNCTION__ << " encountered out-of-bounds index\n";
+				return false;
+			}
+
+			if (owner[face[j]] != uint32_t(batches.size()))
+				++fresh;
+		}
+
+		if (batch.num_vertices + fresh > capacity)
+		{
+			batches.push_back(batch);
+
+			batch.first_face = i;
+			batch.num_faces = 0;
+			batch.first_vertex += batch.num_vertices;
+			batch.num_vertices = 0;
+		}
+
+		const uint32_t id = uint32_t(batches.size());
+
+		for (unsigned j = 0; j < indices_per_face; ++j)
+		{
+			const uint32_t v = face[j];
+
+			if (owner[v] != id)
+			{
+				owner[v] = id;
+				local[v] = uint16_t(batch.num_vertices++);
+				batch_vertex.push_back(v);
+			}
+
+			batch_index[i * indices_per_face + j] = local[v];
+		}
+
+		batch.num_faces++;
+	}
+
+	if (batch.num_faces)
+		batches.push_back(batch);
+
+	return true;
+}
+
 template <
 	unsigned NUM_FLOATS_T,		// floats per vertex
 	unsigned NUM_INDICES_T >	// indices per face
@@ -146,15 +219,20 @@ fill_indexed_facelist_from_file(
 	unsigned& num_faces,
 	GLenum& index_type,
 	float (&vmin)[3],
-	float (&vmax)[3])
+	float (&vmax)[3],
+	const TrilistFilter* const filter = 0,
+	const bool quantize = false,	// quantize positions to snorm16 x 4 in the isotropic domain of the AABB
+	TrilistBatches* const batches = 0)
 {
 	assert(filename);
+	assert(!filter || 3 == NUM_INDICES_T);
+	assert(!quantize || 3 == NUM_FLOATS_T);
 
-	scoped_ptr< FILE, scoped_functor > file(fopen(filename, "r"));
+	scoped_ptr< FILE, scoped_functor > file(open_file(filename));
 
 	if (0 == file())
 	{
-		stream::cerr << __FUNCTION__ << " failed at fopen '" << filename << "'\n";
+		stream::cerr << __FUNCTION__ << " failed at open_file '" << filename << "'\n";
 		return false;
 	}
 
@@ -257,7 +335,54 @@ fill_indexed_facelist_from_file(
 	stream::cout << "number of vertices: " << nv_total <<
 		"\nnumber of indices: " << nf_total * NUM_INDICES_T << '\n';
 
+	if (0 != filter && !filter->apply(filter->ctx,
+			reinterpret_cast< const float* >(vb_total), NUM_FLOATS_T, nv_total,
+			reinterpret_cast< uint32_t* >(ib_total), nf_total))
+	{
+		stream::cerr << __FUNCTION__ << " failed at filter\n";
+		free(vb_total);
+		free(ib_total);
+		return false;
+	}
+
 	size_t sizeof_index = sizeof(BigIndex);
+	std::vector< uint32_t > batch_vertex; // source vertex of each vertex of a split mesh
+
+	// split into batches of compact indices if needed and requested
+	if (0 != batches)
+	{
+		batches->clear();
+
+		if (uint64_t(1) + CompactIndex(-1) < nv_total)
+		{
+			CompactIndex* const ib =
+				reinterpret_cast< CompactIndex* >(malloc(sizeof(CompactIndex) * NUM_INDICES_T * nf_total));
+
+			if (0 == ib || !splitFacelistBatches(
+					reinterpret_cast< const BigIndex* >(ib_total), NUM_INDICES_T, nf_total, nv_total,
+					ib, batch_vertex, *batches))
+			{
+				free(ib);
+				free(vb_total);
+				free(ib_total);
+				return false;
+			}
+
+			free(ib_total);
+			ib_total = ib;
+
+			sizeof_index = sizeof(CompactIndex);
+			index_type = compact_index_type;
+
+			stream::cout << "number of batches: " << batches->size() <<
+				"\nnumber of batched vertices: " << batch_vertex.size() << '\n';
+		}
+		else
+		{
+			const TrilistBatch batch = { 0, nf_total, 0, nv_total };
+			batches->push_back(batch);
+		}
+	}
 
 	// compact index integral type if possible
 	if (sizeof_index > sizeof(CompactIndex) &&
@@ -287,7 +412,46 @@ fill_indexed_facelist_from_file(
 		index_type = compact_index_type;
 	}
 
-	const size_t sizeof_vb = sizeof(float) * NUM_FLOATS_T * nv_total;
+	size_t sizeof_vertex = sizeof(float) * NUM_FLOATS_T;
+
+	// quantize positions in place -- quantized vertices are no larger than the originals, so an
+	// ascending pass never overwrites a vertex before reading it
+	if (quantize)
+	{
+		const rend::QuantDomain domain(vmin, vmax, true);
+
+		for (unsigned i = 0; i < nv_total; ++i)
+		{
+			const float (&vi)[3] = reinterpret_cast< float (*)[3] >(vb_total)[i];
+			const float pos[3] = { vi[0], vi[1], vi[2] };
+
+			domain.quantize(pos, reinterpret_cast< int16_t (*)[4] >(vb_total)[i]);
+		}
+
+		sizeof_vertex = sizeof(int16_t[4]);
+	}
+
+	// gather the vertices of the batches, duplicates included
+	if (!batch_vertex.empty())
+	{
+		int8_t* const vb = reinterpret_cast< int8_t* >(malloc(sizeof_vertex * batch_vertex.size()));
+
+		if (0 == vb)
+		{
+			free(vb_total);
+			free(ib_total);
+			return false;
+		}
+
+		for (size_t i = 0; i < batch_vertex.size(); ++i)
+			memcpy(vb + sizeof_vertex * i, reinterpret_cast< const int8_t* >(vb_total) + sizeof_vertex * batch_vertex[i], sizeof_vertex);
+
+		free(vb_total);
+		vb_total = vb;
+		nv_total = unsigned(batch_vertex.size());
+	}
+
+	const size_t sizeof_vb = sizeof_vertex * nv_total;
 	const size_t sizeof_ib = sizeof_index * NUM_INDICES_T * nf_total;
 
 	glBindBuffer(GL_ARRAY_BUFFER, vbo_arr);
@@ -315,7 +479,9 @@ fill_indexed_trilist_from_file_P(
 	unsigned& num_faces,
 	GLenum& index_type,
 	float (&vmin)[3],
-	float (&vmax)[3])
+	float (&vmax)[3],
+	const TrilistFilter* const filter,
+	TrilistBatches* const batches)
 {
 	return fill_indexed_facelist_from_file< 3, 3 >(
 		filename,
@@ -324,7 +490,35 @@ fill_indexed_trilist_from_file_P(
 		num_faces,
 		index_type,
 		vmin,
-		vmax);
+		vmax,
+		filter,
+		false,
+		batches);
+}
+
+bool
+fill_indexed_trilist_from_file_P_snorm16(
+	const char* const filename,
+	const GLuint vbo_arr,
+	const GLuint vbo_idx,
+	unsigned& num_faces,
+	GLenum& index_type,
+	float (&vmin)[3],
+	float (&vmax)[3],
+	const TrilistFilter* const filter,
+	TrilistBatches* const batches)
+{
+	return fill_indexed_facelist_from_file< 3, 3 >(
+		filename,
+		vbo_arr,
+		vbo_idx,
+		num_faces,
+		index_type,
+		vmin,
+		vmax,
+		filter,
+		true,
+		batches);
 }
 
 bool
@@ -335,7 +529,9 @@ fill_indexed_trilist_from_file_PN(
 	unsigned& num_faces,
 	GLenum& index_type,
 	float (&vmin)[3],
-	float (&vmax)[3])
+	float (&vmax)[3],
+	const TrilistFilter* const filter,
+	TrilistBatches* const batches)
 {
 	return fill_indexed_facelist_from_file< 6, 3 >(
 		filename,
@@ -344,7 +540,10 @@ fill_indexed_trilist_from_file_PN(
 		num_faces,
 		index_type,
 		vmin,
-		vmax);
+		vmax,
+		filter,
+		false,
+		batches);
 }
 
 bool
@@ -355,7 +554,9 @@ fill_indexed_trilist_from_file_PN2(
 	unsigned& num_faces,
 	GLenum& index_type,
 	float (&vmin)[3],
-	float (&vmax)[3])
+	float (&vmax)[3],
+	const TrilistFilter* const filter,
+	TrilistBatches* const batches)
 {
 	return fill_indexed_facelist_from_file< 8, 3 >(
 		filename,
@@ -364,9 +565,61 @@ fill_indexed_trilist_from_file_PN2(
 		num_faces,
 		index_type,
 		vmin,
-		vmax);
+		vmax,
+		filter,
+		false,
+		batches);
 }
 
+// cursor over a span of a file mapping, e.g. the content of a chunk; all reads are bounds-checked
+// against the end of the span, and are alignment-agnostic
+struct ChunkCursor {
+	const uint8_t* pos;
+	const uint8_t* end;
+
+	ChunkCursor()
+	: pos(0)
+	, end(0)
+	{}
+
+	ChunkCursor(const uint8_t* const pos, const uint8_t* const end)
+	: pos(pos)
+	, end(end)
+	{}
+
+	bool empty() const
+	{
+		return pos == end;
+	}
+
+	size_t remaining() const
+	{
+		return size_t(end - pos);
+	}
+
+	template < typename T >
+	bool read(T& out)
+	{
+		if (remaining() < sizeof(out))
+			return false;
+
+		memcpy(&out, pos, sizeof(out));
+		pos += sizeof(out);
+		return true;
+	}
+
+	// advance past the specified span and return its start, or nil if out of bounds
+	const void* take(const size_t span)
+	{
+		if (remaining() < span)
+			return 0;
+
+		const void* const start = pos;
+		pos += span;
+		return start;
+	}
+};
+
 bool
 fill_indexed_trilist_from_file_ABE(
 	const char* const filename,
@@ -380,21 +633,23 @@ fill_indexed_trilist_from_file_ABE(
 {
 	assert(filename);
 
-	scoped_ptr< FILE, scoped_functor > file(fopen(filename, "rb"));
+	mapped_file mapping;
 
-	if (0 == file())
+	if (!mapping.open(filename))
 	{
-		stream::cerr << "error: failure at fopen '" << filename << "'\n";
+		stream::cerr << "error: failure at open '" << filename << "'\n";
 		return false;
 	}
 
+	ChunkCursor file(mapping.data(), mapping.data() + mapping.length());
+
 	uint32_t magic;
 	uint32_t version;
 
-	if (1 != fread(&magic, sizeof(magic), 1, file()) ||
-		1 != fread(&version, sizeof(version), 1, file()))
+	if (!file.read(magic) ||
+		!file.read(version))
 	{
-		stream::cerr << "error: failure at fread '" << filename << "'\n";
+		stream::cerr << "error: failure reading '" << filename << "'\n";
 		return false;
 	}
 
@@ -403,8 +658,9 @@ fill_indexed_trilist_from_file_ABE(
 
 	static const uint32_t sMagic = 0x6873656d;
 	static const uint32_t sVersion = 100;
+	static const uint32_t sVersionIndexCodec = 101; // index buffer by rend::encodeIndexBuffer
 
-	if (magic != sMagic || version != sVersion)
+	if (magic != sMagic || (version != sVersion && version != sVersionIndexCodec))
 	{
 		stream::cerr << "error: mesh of unknown magic/version\n";
 		return false;
@@ -413,10 +669,10 @@ fill_indexed_trilist_from_file_ABE(
 	uint8_t softwareSkinning;
 	uint16_t primitiveType;
 
-	if (1 != fread(&softwareSkinning, sizeof(softwareSkinning), 1, file()) ||
-		1 != fread(&primitiveType, sizeof(primitiveType), 1, file()))
+	if (!file.read(softwareSkinning) ||
+		!file.read(primitiveType))
 	{
-		stream::cerr << "error: failure at fread '" << filename << "'\n";
+		stream::cerr << "error: failure reading '" << filename << "'\n";
 		return false;
 	}
 
@@ -462,9 +718,9 @@ fill_indexed_trilist_from_file_ABE(
 
 	uint16_t num_attr;
 
-	if (1 != fread(&num_attr, sizeof(num_attr), 1, file()))
+	if (!file.read(num_attr))
 	{
-		stream::cerr << "error: failure at fread '" << filename << "'\n";
+		stream::cerr << "error: failure reading '" << filename << "'\n";
 		return false;
 	}
 
@@ -486,13 +742,13 @@ fill_indexed_trilist_from_file_ABE(
 		uint16_t offset;
 		uint16_t index;
 
-		if (1 != fread(&src_buffer, sizeof(src_buffer), 1, file()) ||
-			1 != fread(&type, sizeof(type), 1, file()) ||
-			1 != fread(&semantic, sizeof(semantic), 1, file()) ||
-			1 != fread(&offset, sizeof(offset), 1, file()) ||
-			1 != fread(&index, sizeof(index), 1, file()))
+		if (!file.read(src_buffer) ||
+			!file.read(type) ||
+			!file.read(semantic) ||
+			!file.read(offset) ||
+			!file.read(index))
 		{
-			stream::cerr << "error: failure at fread '" << filename << "'\n";
+			stream::cerr << "error: failure reading '" << filename << "'\n";
 			return false;
 		}
 
@@ -558,58 +814,57 @@ fill_indexed_trilist_from_file_ABE(
 	uint32_t num_vertices;
 	uint16_t num_buffers;
 
-	if (1 != fread(&num_vertices, sizeof(num_vertices), 1, file()) ||
-		1 != fread(&num_buffers, sizeof(num_buffers), 1, file()))
+	if (!file.read(num_vertices) ||
+		!file.read(num_buffers))
 	{
-		stream::cerr << "error: failure at fread '" << filename << "'\n";
+		stream::cerr << "error: failure reading '" << filename << "'\n";
 		return false;
 	}
 
 	size_t sizeof_vb = 0;
-	void* proto_vb = 0;
+	const void* vb = 0; // within the file mapping
 
 	for (unsigned i = 0; i < num_buffers; ++i)
 	{ 
 		uint16_t bind_index;
 		uint16_t vertex_size;
 
-		if (1 != fread(&bind_index, sizeof(bind_index), 1, file()) ||
-			1 != fread(&vertex_size, sizeof(vertex_size), 1, file()))
+		if (!file.read(bind_index) ||
+			!file.read(vertex_size))
 		{
-			stream::cerr << "error: failure at fread '" << filename << "'\n";
+			stream::cerr << "error: failure reading '" << filename << "'\n";
 			return false;
 		}
 
-		sizeof_vb = size_t(vertex_size) * num_vertices;
+		const size_t sizeof_buf = size_t(vertex_size) * num_vertices;
+		const void* const buf = file.take(sizeof_buf);
 
-		if (buffer_interest != i)
-		{
-			fseek(file(), sizeof_vb, SEEK_CUR);
-			continue;
-		}
-
-		scoped_ptr< void, generic_free > buf(malloc(sizeof_vb));
-
-		if (0 == buf() || 1 != fread(buf(), sizeof_vb, 1, file()))
+		if (0 == buf)
 		{
 			stream::cerr << "error: failure reading attribute buffer from file '" << filename << "'\n";
 			return false;
 		}
 
-		proto_vb = buf();
-		buf.reset();
+		if (buffer_interest == i)
+		{
+			sizeof_vb = sizeof_buf;
+			vb = buf;
+		}
 	}
 
-	scoped_ptr< void, generic_free > vb(proto_vb);
-	proto_vb = 0;
+	if (0 == vb)
+	{
+		stream::cerr << "error: mesh lacks the attribute buffer of interest\n";
+		return false;
+	}
 
 	uint16_t index_format;
 	uint32_t num_indices;
 
-	if (1 != fread(&index_format, sizeof(index_format), 1, file()) ||
-		1 != fread(&num_indices, sizeof(num_indices), 1, file()))
+	if (!file.read(index_format) ||
+		!file.read(num_indices))
 	{
-		stream::cerr << "error: failure at fread '" << filename << "'\n";
+		stream::cerr << "error: failure reading '" << filename << "'\n";
 		return false;
 	}
 
@@ -639,18 +894,27 @@ fill_indexed_trilist_from_file_ABE(
 	}
 
 	const size_t sizeof_ib = sizeof_index * num_indices;
-	scoped_ptr< void, generic_free > ib(malloc(sizeof_ib));
+	uint32_t sizeof_encoded_ib = 0;
 
-	if (0 == ib() || 1 != fread(ib(), sizeof_ib, 1, file()))
+	if (version == sVersionIndexCodec && !file.read(sizeof_encoded_ib))
+	{
+		stream::cerr << "error: failure reading '" << filename << "'\n";
+		return false;
+	}
+
+	const size_t sizeof_file_ib = version == sVersionIndexCodec ? size_t(sizeof_encoded_ib) : sizeof_ib;
+	const void* const ib = file.take(sizeof_file_ib); // within the file mapping
+
+	if (0 == ib)
 	{
 		stream::cerr << "error: failure reading index buffer from file '" << filename << "'\n";
 		return false;
 	}
 
-	if (1 != fread(&bmin, sizeof(bmin), 1, file()) ||
-		1 != fread(&bmax, sizeof(bmax), 1, file()))
+	if (!file.read(bmin) ||
+		!file.read(bmax))
 	{
-		stream::cerr << "error: failure at fread '" << filename << "'\n";
+		stream::cerr << "error: failure reading '" << filename << "'\n";
 		return false;
 	}
 
@@ -665,10 +929,10 @@ fill_indexed_trilist_from_file_ABE(
 	float center[3];
 	float radius;
 
-	if (1 != fread(&center, sizeof(center), 1, file()) ||
-		1 != fread(&radius, sizeof(radius), 1, file()))
+	if (!file.read(center) ||
+		!file.read(radius))
 	{
-		stream::cerr << "error: failure at fread '" << filename << "'\n";
+		stream::cerr << "error: failure reading '" << filename << "'\n";
 		return false;
 	}
 
@@ -676,10 +940,33 @@ fill_indexed_trilist_from_file_ABE(
 		"\nnumber of indices: " << num_indices << '\n';
 
 	glBindBuffer(GL_ARRAY_BUFFER, vbo_arr);
-	glBufferData(GL_ARRAY_BUFFER, sizeof_vb, vb(), GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, sizeof_vb, vb, GL_STATIC_DRAW);
 
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo_idx);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof_ib, ib(), GL_STATIC_DRAW);
+
+	if (version == sVersionIndexCodec)
+	{
+		// decode straight into the element buffer
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof_ib, 0, GL_STATIC_DRAW);
+		void* const bitsIdx = glMapBufferOES(GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY_OES);
+
+		const bool success = 0 != bitsIdx &&
+			rend::decodeIndexBuffer(bitsIdx, num_indices, sizeof_index, reinterpret_cast< const uint8_t* >(ib), sizeof_encoded_ib);
+
+		if (0 != bitsIdx)
+			glUnmapBufferOES(GL_ELEMENT_ARRAY_BUFFER);
+
+		if (!success)
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+			stream::cerr << "error: failure decoding index buffer from file '" << filename << "'\n";
+			return false;
+		}
+	}
+	else
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof_ib, ib, GL_STATIC_DRAW);
 
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
@@ -704,21 +991,31 @@ enum IndexBitness {
 	INDEX_BITNESS_32
 };
 
+struct BoneAssignment {
+	uint32_t vertexIndex;
+	uint16_t boneIndex;
+	float weight;
+};
+
 struct Submesh {
 	enum { buffer_capacity = 15 };
 
 	size_t vertexCount;
 	size_t indexCount;
-	void* vertices[buffer_capacity];
-	void* indices;
+	const void* vertices[buffer_capacity]; // within the file mapping
+	uint16_t vertexSize[buffer_capacity];
+	const void* indices; // within the file mapping
+	std::vector< BoneAssignment > boneAssignment;
 
 	Submesh()
 	: vertexCount(0)
 	, indexCount(0)
 	, indices(0)
 	{
-		for (size_t i = 0; i < buffer_capacity; ++i)
+		for (size_t i = 0; i < buffer_capacity; ++i) {
 			vertices[i] = 0;
+			vertexSize[i] = 0;
+		}
 	}
 };
 
@@ -971,67 +1268,52 @@ struct VertexDecl {
 	{}
 };
 
-static bool skipChunkOgre(
-	FILE* file,
-	uint32_t& chunk_size) // remaining size of parent chunk
-{
-	uint16_t skip_chunk_id;
+// chunk header: 16-bit id followed by 32-bit size, the latter inclusive of the header
+static const size_t sizeof_chunk_header = sizeof(uint16_t) + sizeof(uint32_t);
 
-	if (1 != fread(&skip_chunk_id, sizeof(skip_chunk_id), 1, file)) {
-		fprintf(stderr, "%s encountered non-skeleton link\n", __FUNCTION__);
-		return false;
-	}
+// parse the chunk header at the parent cursor, yield a cursor over the chunk content and
+// advance the parent cursor past the chunk
+static bool enterChunkOgre(
+	ChunkCursor& parent,
+	uint16_t& id,
+	ChunkCursor& chunk)
+{
+	uint32_t size;
 
-	uint32_t skip_chunk_size;
-	if (1 != fread(&skip_chunk_size, sizeof(skip_chunk_size), 1, file)) {
-		fprintf(stderr, "%s could not read chunk size\n", __FUNCTION__);
+	if (!parent.read(id) || !parent.read(size)) {
+		fprintf(stderr, "%s could not read chunk header\n", __FUNCTION__);
 		return false;
 	}
 
-	if (skip_chunk_size > chunk_size) {
+	if (size < sizeof_chunk_header || size - sizeof_chunk_header > parent.remaining()) {
 		fprintf(stderr, "%s chunk size mismatch\n", __FUNCTION__);
 		return false;
 	}
 
-	chunk_size -= skip_chunk_size;
+	chunk.pos = parent.pos;
+	chunk.end = parent.pos + (size - sizeof_chunk_header);
+	parent.pos = chunk.end;
 
-	return 0 == fseek(file, skip_chunk_size - (sizeof(skip_chunk_id) + sizeof(skip_chunk_size)), SEEK_CUR);
+	return true;
 }
 
 static bool loadVertexElemOgre(
-	FILE* file,
-	uint32_t& chunk_size, // remaining size of the chunk
+	ChunkCursor chunk, // content of GEOMETRY_VERTEX_ELEMENT
 	VertexElement& elem)
 {
-	uint16_t element_chunk_id;
-
-	if (1 != fread(&element_chunk_id, sizeof(element_chunk_id), 1, file) || 0x5110 != element_chunk_id) {
-		fprintf(stderr, "%s encountered non-element\n", __FUNCTION__);
-		return false;
-	}
-
-	uint32_t element_chunk_size;
-	if (1 != fread(&element_chunk_size, sizeof(element_chunk_size), 1, file)) {
-		fprintf(stderr, "%s could not read chunk size\n", __FUNCTION__);
-		return false;
-	}
-
-	if (element_chunk_size > chunk_size) {
-		fprintf(stderr, "%s chunk size mismatch\n", __FUNCTION__);
-		return false;
-	}
+	VertexElement incoming;
 
-	chunk_size -= element_chunk_size;
+	if (!chunk.read(incoming.source) ||
+		!chunk.read(incoming.type) ||
+		!chunk.read(incoming.semantic) ||
+		!chunk.read(incoming.offset) ||
+		!chunk.read(incoming.index)) {
 
-	VertexElement incoming;
-	if (1 != fread(&incoming, sizeof(incoming), 1, file)) {
 		fprintf(stderr, "%s could not read chunk content\n", __FUNCTION__);
 		return false;
 	}
 
-	const uint32_t chunk_dec = sizeof(element_chunk_id) + sizeof(element_chunk_size) + sizeof(incoming);
-
-	if (chunk_dec != element_chunk_size) {
+	if (!chunk.empty()) {
 		fprintf(stderr, "%s chunk size mismatch\n", __FUNCTION__);
 		return false;
 	}
@@ -1051,59 +1333,29 @@ static bool loadVertexElemOgre(
 }
 
 static bool loadVertexDeclOgre(
-	FILE* file,
-	uint32_t& chunk_size, // remaining size of the chunk
+	ChunkCursor chunk, // content of GEOMETRY_VERTEX_DECLARATION
 	VertexDecl& vertDecl)
 {
-	uint16_t declaration_chunk_id;
-
-	if (1 != fread(&declaration_chunk_id, sizeof(declaration_chunk_id), 1, file) || 0x5100 != declaration_chunk_id) {
-		fprintf(stderr, "%s encountered non-declaration\n", __FUNCTION__);
-		return false;
-	}
-
-	uint32_t declaration_chunk_size;
-	if (1 != fread(&declaration_chunk_size, sizeof(declaration_chunk_size), 1, file)) {
-		fprintf(stderr, "%s could not read chunk size\n", __FUNCTION__);
-		return false;
-	}
-
-	if (declaration_chunk_size > chunk_size) {
-		fprintf(stderr, "%s chunk size mismatch\n", __FUNCTION__);
-		return false;
-	}
-
-	chunk_size -= declaration_chunk_size;
-
-	const uint32_t chunk_dec = sizeof(declaration_chunk_id) + sizeof(declaration_chunk_size);
-
-	if (chunk_dec > declaration_chunk_size) {
-		fprintf(stderr, "%s chunk size mismatch\n", __FUNCTION__);
-		return false;
-	}
-
-	declaration_chunk_size -= chunk_dec;
 	size_t declCount = 0;
 
-	while (declaration_chunk_size) {
+	while (!chunk.empty()) {
 		uint16_t id;
-		if (1 != fread(&id, sizeof(id), 1, file)) {
-			fprintf(stderr, "%s could not read chunk id\n", __FUNCTION__);
+		ChunkCursor sub;
+
+		if (!enterChunkOgre(chunk, id, sub))
 			return false;
-		}
+
 		switch (id) {
 		case 0x5110: // GEOMETRY_VERTEX_ELEMENT
 			if (vertDecl.capacity == declCount) {
 				fprintf(stderr, "%s encountered too many vertex elements\n", __FUNCTION__);
 				return false;
 			}
-			if (!loadVertexElemOgre(file, declaration_chunk_size, vertDecl.elem[declCount++]))
+			if (!loadVertexElemOgre(sub, vertDecl.elem[declCount++]))
 				return false;
 			break;
 		default:
 			fprintf(stderr, "%s encountered unhandled chunk id 0x%04hx; skipping\n", __FUNCTION__, id);
-			if (!skipChunkOgre(file, declaration_chunk_size))
-				return false;
 			break;
 		}
 	}
@@ -1121,37 +1373,16 @@ static bool loadVertexDeclOgre(
 }
 
 static bool loadVertexBufferOgre(
-	FILE* file,
-	uint32_t& chunk_size, // remaining size of the chunk
+	ChunkCursor chunk, // content of GEOMETRY_VERTEX_BUFFER
 	Submesh& submesh)
 {
-	uint16_t buffer_chunk_id;
-
-	if (1 != fread(&buffer_chunk_id, sizeof(buffer_chunk_id), 1, file) || 0x5200 != buffer_chunk_id) {
-		fprintf(stderr, "%s encountered non-buffer\n", __FUNCTION__);
-		return false;
-	}
-
-	uint32_t buffer_chunk_size;
-	if (1 != fread(&buffer_chunk_size, sizeof(buffer_chunk_size), 1, file)) {
-		fprintf(stderr, "%s could not read chunk size\n", __FUNCTION__);
-		return false;
-	}
-
-	if (buffer_chunk_size > chunk_size) {
-		fprintf(stderr, "%s chunk size mismatch\n", __FUNCTION__);
-		return false;
-	}
-
-	chunk_size -= buffer_chunk_size;
-
 	uint16_t bindIndex;
-	if (1 != fread(&bindIndex, sizeof(bindIndex), 1, file)) {
+	if (!chunk.read(bindIndex)) {
 		fprintf(stderr, "%s could not read bind index\n", __FUNCTION__);
 		return false;
 	}
 
-	if (bindIndex > Submesh::buffer_capacity) {
+	if (bindIndex >= Submesh::buffer_capacity) {
 		fprintf(stderr, "%s encountered out-of-bounds bind index\n", __FUNCTION__);
 		return false;
 	}
@@ -1162,93 +1393,37 @@ static bool loadVertexBufferOgre(
 	}
 
 	uint16_t vertexSize;
-	if (1 != fread(&vertexSize, sizeof(vertexSize), 1, file)) {
+	if (!chunk.read(vertexSize)) {
 		fprintf(stderr, "%s could not read vertex size\n", __FUNCTION__);
 		return false;
 	}
 
-	const uint32_t chunk_dec = sizeof(buffer_chunk_id) + sizeof(buffer_chunk_size) + sizeof(bindIndex) + sizeof(vertexSize);
+	uint16_t id;
+	ChunkCursor data;
 
-	if (chunk_dec > buffer_chunk_size) {
-		fprintf(stderr, "%s chunk size mismatch\n", __FUNCTION__);
-		return false;
-	}
-
-	buffer_chunk_size -= chunk_dec;
-
-	uint16_t buffer_data_chunk_id;
-
-	if (1 != fread(&buffer_data_chunk_id, sizeof(buffer_data_chunk_id), 1, file) || 0x5210 != buffer_data_chunk_id) {
+	if (!enterChunkOgre(chunk, id, data) || 0x5210 != id || !chunk.empty()) {
 		fprintf(stderr, "%s encountered non-buffer-data\n", __FUNCTION__);
 		return false;
 	}
 
-	uint32_t buffer_data_chunk_size;
-	if (1 != fread(&buffer_data_chunk_size, sizeof(buffer_data_chunk_size), 1, file)) {
-		fprintf(stderr, "%s could not read buffer-data chunk size\n", __FUNCTION__);
-		return false;
-	}
-
-	if (buffer_data_chunk_size != buffer_chunk_size) {
-		fprintf(stderr, "%s buffer-data chunk size mismatch\n", __FUNCTION__);
-		return false;
-	}
-
-	const uint32_t buffer_data_chunk_dec = sizeof(buffer_data_chunk_id) + sizeof(buffer_data_chunk_size);
-
-	if (buffer_data_chunk_dec > buffer_data_chunk_size) {
-		fprintf(stderr, "%s buffer-data chunk size mismatch\n", __FUNCTION__);
-		return false;
-	}
-
-	buffer_data_chunk_size -= buffer_data_chunk_dec;
-
-	if (uint32_t(vertexSize) * submesh.vertexCount != buffer_data_chunk_size) {
+	if (uint64_t(vertexSize) * submesh.vertexCount != data.remaining()) {
 		fprintf(stderr, "%s encountered vertex size vs buffer-data chunk size mismatch\n", __FUNCTION__);
 		return false;
 	}
 
-	scoped_ptr< void, generic_free > vb(malloc(buffer_data_chunk_size));
-
-	if (1 != fread(vb(), buffer_data_chunk_size, 1, file)) {
-		fprintf(stderr, "%s could not buffer data\n", __FUNCTION__);
-		return false;
-	}
-
-	submesh.vertices[bindIndex] = vb();
-	vb.reset();
+	submesh.vertices[bindIndex] = data.pos;
+	submesh.vertexSize[bindIndex] = vertexSize;
 
 	return true;
 }
 
 static bool loadGeometryOgre(
-	FILE* file,
-	uint32_t& chunk_size, // remaining size of the chunk
+	ChunkCursor chunk, // content of GEOMETRY
 	Submesh& submesh,
 	VertexDecl& vertDecl)
 {
-	uint16_t geometry_chunk_id;
-
-	if (1 != fread(&geometry_chunk_id, sizeof(geometry_chunk_id), 1, file) || 0x5000 != geometry_chunk_id) {
-		fprintf(stderr, "%s encountered non-geometry\n", __FUNCTION__);
-		return false;
-	}
-
-	uint32_t geometry_chunk_size;
-	if (1 != fread(&geometry_chunk_size, sizeof(geometry_chunk_size), 1, file)) {
-		fprintf(stderr, "%s could not read chunk size\n", __FUNCTION__);
-		return false;
-	}
-
-	if (geometry_chunk_size > chunk_size) {
-		fprintf(stderr, "%s chunk size mismatch\n", __FUNCTION__);
-		return false;
-	}
-
-	chunk_size -= geometry_chunk_size;
-
 	uint32_t vertexCount;
-	if (1 != fread(&vertexCount, sizeof(vertexCount), 1, file)) {
+	if (!chunk.read(vertexCount)) {
 		fprintf(stderr, "%s could not read vertex count\n", __FUNCTION__);
 		return false;
 	}
@@ -1256,86 +1431,69 @@ static bool loadGeometryOgre(
 	fprintf(stderr, "\tvertex count: %u\n", vertexCount);
 	submesh.vertexCount = vertexCount;
 
-	const uint32_t chunk_dec = sizeof(geometry_chunk_id) + sizeof(geometry_chunk_size) + sizeof(vertexCount);
-
-	if (chunk_dec > geometry_chunk_size) {
-		fprintf(stderr, "%s chunk size mismatch\n", __FUNCTION__);
-		return false;
-	}
-
-	geometry_chunk_size -= chunk_dec;
-
-	while (geometry_chunk_size) {
+	while (!chunk.empty()) {
 		uint16_t id;
-		if (1 != fread(&id, sizeof(id), 1, file)) {
-			fprintf(stderr, "%s could not read chunk id\n", __FUNCTION__);
+		ChunkCursor sub;
+
+		if (!enterChunkOgre(chunk, id, sub))
 			return false;
-		}
+
 		switch (id) {
 		case 0x5100: // GEOMETRY_VERTEX_DECLARATION
-			if (!loadVertexDeclOgre(file, geometry_chunk_size, vertDecl))
+			if (!loadVertexDeclOgre(sub, vertDecl))
 				return false;
 			break;
 		case 0x5200: // GEOMETRY_VERTEX_BUFFER
-		default:
-			if (!loadVertexBufferOgre(file, geometry_chunk_size, submesh))
+			if (!loadVertexBufferOgre(sub, submesh))
 				return false;
 			break;
+		default:
+			fprintf(stderr, "%s encountered unhandled chunk id 0x%04hx; skipping\n", __FUNCTION__, id);
+			break;
 		}
 	}
 
 	return true;
 }
 
-static bool loadSubmeshOgre(
-	FILE* file,
-	uint32_t& chunk_size, // remaining size of the chunk
-	VertexSharing& vertSharing,
-	IndexBitness& indexBitness,
-	Submesh& submesh,
-	VertexDecl& vertDecl)
+static bool loadBoneAssignmentOgre(
+	ChunkCursor chunk, // content of SUBMESH_BONE_ASSIGNMENT
+	Submesh& submesh)
 {
-	uint16_t submesh_chunk_id;
+	BoneAssignment assignment;
 
-	if (1 != fread(&submesh_chunk_id, sizeof(submesh_chunk_id), 1, file) || 0x4000 != submesh_chunk_id) {
-		fprintf(stderr, "%s encountered non-submesh\n", __FUNCTION__);
-		return false;
-	}
+	if (!chunk.read(assignment.vertexIndex) ||
+		!chunk.read(assignment.boneIndex) ||
+		!chunk.read(assignment.weight) ||
+		!chunk.empty()) {
 
-	uint32_t submesh_chunk_size;
-	if (1 != fread(&submesh_chunk_size, sizeof(submesh_chunk_size), 1, file)) {
-		fprintf(stderr, "%s could not read chunk size\n", __FUNCTION__);
-		return false;
-	}
-
-	if (submesh_chunk_size > chunk_size) {
-		fprintf(stderr, "%s chunk size mismatch\n", __FUNCTION__);
+		fprintf(stderr, "%s could not read bone assignment\n", __FUNCTION__);
 		return false;
 	}
 
-	chunk_size -= submesh_chunk_size;
+	submesh.boneAssignment.push_back(assignment);
+	return true;
+}
 
-	size_t name_len = 0;
-	char name[1024];
-	while (name_len < sizeof(name) / sizeof(name[0])) {
-		if (1 != fread(name + name_len, sizeof(name[0]), 1, file)) {
-			fprintf(stderr, "%s could not read name\n", __FUNCTION__);
-			return false;
-		}
-		if (name[name_len] == 0xa) {
-			name[name_len] = '\0';
-			break;
-		}
-		++name_len;
-	}
+static bool loadSubmeshOgre(
+	ChunkCursor chunk, // content of SUBMESH
+	VertexSharing& vertSharing,
+	IndexBitness& indexBitness,
+	Submesh& submesh,
+	VertexDecl& vertDecl)
+{
+	const void* const eol = memchr(chunk.pos, 0xa, chunk.remaining());
 
-	if (name_len == sizeof(name) / sizeof(name[0])) {
-		fprintf(stderr, "%s encountered too long name\n", __FUNCTION__);
+	if (0 == eol) {
+		fprintf(stderr, "%s could not read name\n", __FUNCTION__);
 		return false;
 	}
 
+	const size_t name_len = reinterpret_cast< const uint8_t* >(eol) - chunk.pos;
+	const char* const name = reinterpret_cast< const char* >(chunk.take(name_len + 1));
+
 	uint8_t sharedVert;
-	if (1 != fread(&sharedVert, sizeof(sharedVert), 1, file)) {
+	if (!chunk.read(sharedVert)) {
 		fprintf(stderr, "%s could not read shared-vertices flag\n", __FUNCTION__);
 		return false;
 	}
@@ -1356,19 +1514,19 @@ static bool loadSubmeshOgre(
 	}
 
 	uint32_t indexCount;
-	if (1 != fread(&indexCount, sizeof(indexCount), 1, file)) {
+	if (!chunk.read(indexCount)) {
 		fprintf(stderr, "%s could not read index count\n", __FUNCTION__);
 		return false;
 	}
 
 	uint8_t index32bit;
-	if (1 != fread(&index32bit, sizeof(index32bit), 1, file)) {
+	if (!chunk.read(index32bit)) {
 		fprintf(stderr, "%s could not read index bitness flag\n", __FUNCTION__);
 		return false;
 	}
 
-	fprintf(stderr, "%s\n\tshared vert: %hhu\n\tindex count: %u\n\tindex 32-bit: %hhu\n",
-		name, sharedVert, indexCount, index32bit);
+	fprintf(stderr, "%.*s\n\tshared vert: %hhu\n\tindex count: %u\n\tindex 32-bit: %hhu\n",
+		int(name_len), name, sharedVert, indexCount, index32bit);
 
 	const IndexBitness bitness = index32bit ? INDEX_BITNESS_32 : INDEX_BITNESS_16;
 
@@ -1386,101 +1544,65 @@ static bool loadSubmeshOgre(
 	}
 
 	const size_t sizeof_index = indexBitness == INDEX_BITNESS_32 ? sizeof(uint32_t) : sizeof(uint16_t);
-	const size_t sizeof_ib = sizeof_index * indexCount;
-	scoped_ptr< void, generic_free > ib(malloc(sizeof_ib));
+	const void* const indices = chunk.take(sizeof_index * indexCount);
 
-	if (1 != fread(ib(), sizeof_ib, 1, file)) {
+	if (0 == indices) {
 		fprintf(stderr, "%s could not read index array\n", __FUNCTION__);
 		return false;
 	}
 
-	const uint32_t chunk_dec = sizeof(submesh_chunk_id) + sizeof(submesh_chunk_size) + name_len + 1 + sizeof(sharedVert) +
-		sizeof(indexCount) + sizeof(index32bit) + sizeof_ib;
-
-	if (chunk_dec > submesh_chunk_size) {
-		fprintf(stderr, "%s chunk size mismatch\n", __FUNCTION__);
-		return false;
-	}
-
-	submesh_chunk_size -= chunk_dec;
-
-	while (submesh_chunk_size) {
+	while (!chunk.empty()) {
 		uint16_t id;
-		if (1 != fread(&id, sizeof(id), 1, file)) {
-			fprintf(stderr, "%s could not read chunk id\n", __FUNCTION__);
+		ChunkCursor sub;
+
+		if (!enterChunkOgre(chunk, id, sub))
 			return false;
-		}
+
 		switch (id) {
 		case 0x4010: // SUBMESH_OPERATION
-			if (!skipChunkOgre(file, submesh_chunk_size))
-				return false;
 			break;
 		case 0x4100: // SUBMESH_BONE_ASSIGNMENT
-			if (!skipChunkOgre(file, submesh_chunk_size))
+			if (!loadBoneAssignmentOgre(sub, submesh))
 				return false;
 			break;
 		case 0x5000: // GEOMETRY
-			if (!loadGeometryOgre(file, submesh_chunk_size, submesh, vertDecl))
+			if (!loadGeometryOgre(sub, submesh, vertDecl))
 				return false;
 			break;
 		default:
 			fprintf(stderr, "%s encountered unhandled chunk id 0x%04hx; skipping\n", __FUNCTION__, id);
-			if (!skipChunkOgre(file, submesh_chunk_size))
-				return false;
 			break;
 		}
 	}
 
 	submesh.indexCount = indexCount;
-	submesh.indices = ib();
-	ib.reset();
+	submesh.indices = indices;
 
 	return true;
 }
 
 static bool loadMeshBoundsOgre(
-	FILE* file,
-	uint32_t& chunk_size, // remaining size of parent chunk
+	ChunkCursor chunk, // content of MESH_BOUNDS
 	float (&bmin)[3],
 	float (&bmax)[3])
 {
-	uint16_t bounds_chunk_id;
-
-	if (1 != fread(&bounds_chunk_id, sizeof(bounds_chunk_id), 1, file) || 0x9000 != bounds_chunk_id) {
-		fprintf(stderr, "%s encountered non-bounds\n", __FUNCTION__);
-		return false;
-	}
-
-	uint32_t bounds_chunk_size;
-	if (1 != fread(&bounds_chunk_size, sizeof(bounds_chunk_size), 1, file)) {
-		fprintf(stderr, "%s could not read chunk size\n", __FUNCTION__);
-		return false;
-	}
-
-	if (bounds_chunk_size > chunk_size) {
-		fprintf(stderr, "%s chunk size mismatch\n", __FUNCTION__);
-		return false;
-	}
-
-	chunk_size -= bounds_chunk_size;
-
-	if (1 != fread(bmin, sizeof(bmin), 1, file)) {
+	if (!chunk.read(bmin)) {
 		fprintf(stderr, "%s could not read min bounds\n", __FUNCTION__);
 		return false;
 	}
 
-	if (1 != fread(bmax, sizeof(bmax), 1, file)) {
+	if (!chunk.read(bmax)) {
 		fprintf(stderr, "%s could not read max bounds\n", __FUNCTION__);
 		return false;
 	}
 
 	float radius; // discarded
-	if (1 != fread(&radius, sizeof(radius), 1, file)) {
+	if (!chunk.read(radius)) {
 		fprintf(stderr, "%s could not read radius\n", __FUNCTION__);
 		return false;
 	}
 
-	return bounds_chunk_size == sizeof(bounds_chunk_id) + sizeof(bounds_chunk_size) + sizeof(bmin) + sizeof(bmax) + sizeof(radius);
+	return chunk.empty();
 }
 
 static inline bool isfinite(const float c) {
@@ -1489,6 +1611,117 @@ static inline bool isfinite(const float c) {
 	return exp_mask != (ic & exp_mask);
 }
 
+// up to four bone influences of a vertex
+struct BoneInfluence {
+	enum { capacity = 4 };
+
+	unsigned index[capacity];
+	float weight[capacity];
+
+	BoneInfluence()
+	{
+		for (unsigned i = 0; i < capacity; ++i) {
+			index[i] = 0;
+			weight[i] = 0.f;
+		}
+	}
+
+	// keep the heaviest influences
+	void add(const unsigned idx, const float w)
+	{
+		unsigned lightest = 0;
+
+		for (unsigned i = 1; i < capacity; ++i)
+			if (weight[i] < weight[lightest])
+				lightest = i;
+
+		if (w > weight[lightest]) {
+			index[lightest] = idx;
+			weight[lightest] = w;
+		}
+	}
+
+	// pack into the bon[4] layout of the skinning shaders: normalized weights of the first three
+	// influences in xyz, the fourth weight being implied by unit sum, and the four 6-bit bone
+	// indices in w as i0 + i1 * 64 + i2 * 4096 + i3 * 262144; no influences means root of weight 1
+	void pack(float (&bon)[4]) const
+	{
+		const float sum = weight[0] + weight[1] + weight[2] + weight[3];
+
+		if (0.f >= sum) {
+			bon[0] = 1.f;
+			bon[1] = 0.f;
+			bon[2] = 0.f;
+			bon[3] = 0.f;
+			return;
+		}
+
+		const float rcp_sum = 1.f / sum;
+
+		bon[0] = weight[0] * rcp_sum;
+		bon[1] = weight[1] * rcp_sum;
+		bon[2] = weight[2] * rcp_sum;
+		bon[3] = float(index[0] + (index[1] << 6) + (index[2] << 12) + (index[3] << 18));
+	}
+};
+
+struct PackedBone {
+	float bon[4];
+};
+
+// max bone index representable in the bon[4] layout
+static const unsigned bone_index_limit = 64;
+
+// fetch the bone influences of a vertex from its VES_BLEND_WEIGHTS/VES_BLEND_INDICES elements;
+// a nil weights element means a single influence of weight 1
+static bool fetchBlendElemOgre(
+	const void* const weights,
+	const uint16_t weights_type,
+	const void* const indices,
+	const uint16_t indices_type,
+	BoneInfluence& influence)
+{
+	unsigned count = 1;
+	float w[BoneInfluence::capacity] = { 1.f, 0.f, 0.f, 0.f };
+
+	if (0 != weights) {
+		count = weights_type - VertexElement::VET_FLOAT1 + 1;
+		memcpy(w, weights, sizeof(w[0]) * count);
+	}
+
+	unsigned idx[BoneInfluence::capacity] = { 0 };
+
+	if (VertexElement::VET_UBYTE4 == indices_type) {
+		uint8_t src[BoneInfluence::capacity];
+		memcpy(src, indices, sizeof(src));
+
+		for (unsigned i = 0; i < count; ++i)
+			idx[i] = src[i];
+	}
+	else {
+		const unsigned src_count = indices_type - VertexElement::VET_USHORT1 + 1;
+		uint16_t src[BoneInfluence::capacity] = { 0 };
+		memcpy(src, indices, sizeof(src[0]) * src_count);
+
+		for (unsigned i = 0; i < count; ++i)
+			idx[i] = src[i];
+	}
+
+	for (unsigned i = 0; i < count; ++i) {
+		if (0.f == w[i])
+			continue;
+
+		if (bone_index_limit <= idx[i]) {
+			fprintf(stderr, "%s encountered out-of-bounds bone index %u\n", __FUNCTION__, idx[i]);
+			return false;
+		}
+
+		influence.add(idx[i], w[i]);
+	}
+
+	return true;
+}
+
 bool
 fill_indexed_trilist_from_file_Ogre(
 	const char* const filename,
@@ -1501,27 +1734,36 @@ fill_indexed_trilist_from_file_Ogre(
 	float (&bmax)[3])
 {
 	assert(filename);
-	scoped_ptr< FILE, scoped_functor > file(fopen(filename, "rb"));
+	mapped_file mapping;
 
-	if (0 == file()) {
-		stream::cerr << "error: failure at fopen '" << filename << "'\n";
+	if (!mapping.open(filename, false)) {
+		stream::cerr << "error: failure at mmap '" << filename << "'\n";
 		return false;
 	}
 
+	ChunkCursor file(mapping.data(), mapping.data() + mapping.length());
 	uint16_t mesh_chunk_id;
-	if (1 != fread(&mesh_chunk_id, sizeof(mesh_chunk_id), 1, file()) || 0x3000 != mesh_chunk_id) {
-		fprintf(stderr, "%s encountered non-mesh\n", __FUNCTION__);
-		return false;
+
+	// tolerate a serializer header: id followed by a newline-terminated version string, sans size
+	if (ChunkCursor(file).read(mesh_chunk_id) && 0x1000 == mesh_chunk_id) {
+		const void* const eol = memchr(file.pos, 0xa, file.remaining());
+
+		if (0 == eol) {
+			fprintf(stderr, "%s could not read header\n", __FUNCTION__);
+			return false;
+		}
+
+		file.pos = reinterpret_cast< const uint8_t* >(eol) + 1;
 	}
 
-	uint32_t mesh_chunk_size;
-	if (1 != fread(&mesh_chunk_size, sizeof(mesh_chunk_size), 1, file())) {
-		fprintf(stderr, "%s could not read chunk size\n", __FUNCTION__);
+	ChunkCursor mesh;
+	if (!enterChunkOgre(file, mesh_chunk_id, mesh) || 0x3000 != mesh_chunk_id) {
+		fprintf(stderr, "%s encountered non-mesh\n", __FUNCTION__);
 		return false;
 	}
 
 	uint8_t skelAnimated = 0;
-	if (1 != fread(&skelAnimated, sizeof(skelAnimated), 1, file())) {
+	if (!mesh.read(skelAnimated)) {
 		fprintf(stderr, "%s could not read animated flag\n", __FUNCTION__);
 		return false;
 	}
@@ -1531,8 +1773,6 @@ fill_indexed_trilist_from_file_Ogre(
 		return false;
 	}
 
-	mesh_chunk_size -= sizeof(mesh_chunk_id) + sizeof(mesh_chunk_size) + sizeof(skelAnimated);
-
 	uint64_t vertexCount = 0;
 	uint64_t indexCount = 0;
 	VertexSharing vertSharing = VERTEX_SHARING_UNKNOWN;
@@ -1543,38 +1783,41 @@ fill_indexed_trilist_from_file_Ogre(
 	std::vector< Submesh > submesh;
 	VertexDecl vertDecl;
 
-	while (mesh_chunk_size) {
+	// single pass over the chunks; vertex and index data stay in the mapping
+	while (!mesh.empty()) {
 		uint16_t id;
-		if (1 != fread(&id, sizeof(id), 1, file())) {
-			fprintf(stderr, "%s could not read chunk id\n", __FUNCTION__);
-			return false;
-		}
+		ChunkCursor sub;
 
-		Submesh smesh;
+		if (!enterChunkOgre(mesh, id, sub))
+			return false;
 
 		switch (id) {
 		case 0x4000: // SUBMESH
-			if (!loadSubmeshOgre(file(), mesh_chunk_size, vertSharing, indexBitness, smesh, vertDecl))
+			submesh.push_back(Submesh());
+
+			if (!loadSubmeshOgre(sub, vertSharing, indexBitness, submesh.back(), vertDecl))
 				return false;
-			vertexCount += smesh.vertexCount;
-			indexCount += smesh.indexCount;
-			submesh.push_back(smesh);
+
+			vertexCount += submesh.back().vertexCount;
+			indexCount += submesh.back().indexCount;
 			break;
 
 		case 0x9000: // MESH_BOUNDS
-			if (!loadMeshBoundsOgre(file(), mesh_chunk_size, bmin, bmax))
+			if (!loadMeshBoundsOgre(sub, bmin, bmax))
 				return false;
 			break;
 
 		default:
 			fprintf(stderr, "%s encountered unhandled chunk id 0x%04hx; skipping\n", __FUNCTION__, id);
-
-			if (!skipChunkOgre(file(), mesh_chunk_size))
-				return false;
 			break;
 		}
 	}
 
+	if (submesh.empty() || VERTEX_SHARING_TRUE == vertSharing) {
+		fprintf(stderr, "%s encountered no submeshes of own geometry\n", __FUNCTION__);
+		return false;
+	}
+
 	if (!isfinite(bmin[0]) || !isfinite(bmin[1]) || !isfinite(bmin[2]) ||
 		!isfinite(bmax[0]) || !isfinite(bmax[1]) || !isfinite(bmax[2])) {
 
@@ -1610,42 +1853,56 @@ fill_indexed_trilist_from_file_Ogre(
 		SEMANTIC_COUNT
 	};
 
+	// expected source types; the bone attrib gets composed from the blend elements
+	static const uint16_t src_semantics_type[SEMANTIC_COUNT] = {
+		VertexElement::VET_FLOAT3,
+		VertexElement::VET_FLOAT4,
+		VertexElement::VET_FLOAT3,
+		VertexElement::VET_FLOAT2
+	};
+
 	uintptr_t src_semantics_size[SEMANTIC_COUNT] = { 0 };
 	uintptr_t src_semantics_offset[SEMANTIC_COUNT];
 	uint16_t src_semantics_buffer[SEMANTIC_COUNT];
-	uint16_t src_buffer_stride[Submesh::buffer_capacity] = { 0 };
-	size_t sizeof_vertex = sizeof(float[4]); // TODO compensate for missing bone attrib
+	const VertexElement* blend_weights = 0;
+	const VertexElement* blend_indices = 0;
+	size_t sizeof_vertex = sizeof(float[4]); // bone attrib
 
 	for (size_t i = 0; i < vertDecl.count; ++i) {
-		assert(sizeof(src_buffer_stride) / sizeof(src_buffer_stride[0]) > vertDecl.elem[i].source);
+		assert(Submesh::buffer_capacity > vertDecl.elem[i].source);
 		const size_t sizeof_type = VertexElement::size_from_type(VertexElement::Type(vertDecl.elem[i].type));
-		src_buffer_stride[vertDecl.elem[i].source] += sizeof_type;
+		size_t semantic = SEMANTIC_COUNT;
 
 		switch (vertDecl.elem[i].semantic) {
 		case VertexElement::VES_POSITION:
-			src_semantics_size  [SEMANTIC_POS] = sizeof_type;
-			src_semantics_offset[SEMANTIC_POS] = vertDecl.elem[i].offset;
-			src_semantics_buffer[SEMANTIC_POS] = vertDecl.elem[i].source;
-			sizeof_vertex += sizeof_type;
+			semantic = SEMANTIC_POS;
 			break;
 		case VertexElement::VES_BLEND_WEIGHTS:
+			if (VertexElement::VET_FLOAT1 > vertDecl.elem[i].type || VertexElement::VET_FLOAT4 < vertDecl.elem[i].type) {
+				fprintf(stderr, "unsupported blend-weights type '%s'; bailing out\n",
+					VertexElement::string_from_type(VertexElement::Type(vertDecl.elem[i].type)));
+				return false;
+			}
+			blend_weights = vertDecl.elem + i;
+			break;
 		case VertexElement::VES_BLEND_INDICES:
+			if (VertexElement::VET_UBYTE4 != vertDecl.elem[i].type &&
+				(VertexElement::VET_USHORT1 > vertDecl.elem[i].type || VertexElement::VET_USHORT4 < vertDecl.elem[i].type)) {
+				fprintf(stderr, "unsupported blend-indices type '%s'; bailing out\n",
+					VertexElement::string_from_type(VertexElement::Type(vertDecl.elem[i].type)));
+				return false;
+			}
+			blend_indices = vertDecl.elem + i;
 			break;
 		case VertexElement::VES_NORMAL:
-			src_semantics_size  [SEMANTIC_NRM] = sizeof_type;
-			src_semantics_offset[SEMANTIC_NRM] = vertDecl.elem[i].offset;
-			src_semantics_buffer[SEMANTIC_NRM] = vertDecl.elem[i].source;
-			sizeof_vertex += sizeof_type;
+			semantic = SEMANTIC_NRM;
 			break;
 		case VertexElement::VES_DIFFUSE:
 		case VertexElement::VES_SPECULAR:
 			break;
 		case VertexElement::VES_TEXTURE_COORDINATES:
 			if (0 != vertDecl.elem[i].index) break;
-			src_semantics_size  [SEMANTIC_TXC] = sizeof_type;
-			src_semantics_offset[SEMANTIC_TXC] = vertDecl.elem[i].offset;
-			src_semantics_buffer[SEMANTIC_TXC] = vertDecl.elem[i].source;
-			sizeof_vertex += sizeof_type;
+			semantic = SEMANTIC_TXC;
 			break;
 		case VertexElement::VES_BITANGENT:
 		case VertexElement::VES_TANGENT:
@@ -1655,12 +1912,77 @@ fill_indexed_trilist_from_file_Ogre(
 				VertexElement::string_from_semantic(VertexElement::Semantic(vertDecl.elem[i].semantic)));
 			break;
 		}
+
+		if (SEMANTIC_COUNT == semantic)
+			continue;
+
+		if (src_semantics_type[semantic] != vertDecl.elem[i].type) {
+			fprintf(stderr, "unsupported type '%s' of vertex attrib semantic '%s'; bailing out\n",
+				VertexElement::string_from_type(VertexElement::Type(vertDecl.elem[i].type)),
+				VertexElement::string_from_semantic(VertexElement::Semantic(vertDecl.elem[i].semantic)));
+			return false;
+		}
+
+		src_semantics_size  [semantic] = sizeof_type;
+		src_semantics_offset[semantic] = vertDecl.elem[i].offset;
+		src_semantics_buffer[semantic] = vertDecl.elem[i].source;
+		sizeof_vertex += sizeof_type;
 	}
 
-	assert(0 != src_semantics_size[SEMANTIC_POS]);
-	assert(0 == src_semantics_size[SEMANTIC_BON]); // TODO missing bone attrib
-	assert(0 != src_semantics_size[SEMANTIC_NRM]);
-	assert(0 != src_semantics_size[SEMANTIC_TXC]);
+	if (0 == src_semantics_size[SEMANTIC_POS] ||
+		0 == src_semantics_size[SEMANTIC_NRM] ||
+		0 == src_semantics_size[SEMANTIC_TXC]) {
+
+		fprintf(stderr, "%s encountered mesh missing position, normal or tcoord\n", __FUNCTION__);
+		return false;
+	}
+
+	if (0 != blend_weights && 0 == blend_indices) {
+		fprintf(stderr, "%s encountered blend weights sans blend indices\n", __FUNCTION__);
+		return false;
+	}
+
+	// validate the source buffers and bone assignments ahead of mapping the output
+	for (std::vector< Submesh >::const_iterator it = submesh.begin(); it != submesh.end(); ++it) {
+		const size_t sources[] = {
+			src_semantics_buffer[SEMANTIC_POS],
+			src_semantics_buffer[SEMANTIC_NRM],
+			src_semantics_buffer[SEMANTIC_TXC]
+		};
+		const size_t semantics[] = {
+			SEMANTIC_POS,
+			SEMANTIC_NRM,
+			SEMANTIC_TXC
+		};
+
+		for (size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); ++i) {
+			if (0 == it->vertices[sources[i]] ||
+				it->vertexSize[sources[i]] < src_semantics_offset[semantics[i]] + src_semantics_size[semantics[i]]) {
+
+				fprintf(stderr, "%s encountered missing or undersized vertex buffer\n", __FUNCTION__);
+				return false;
+			}
+		}
+
+		const VertexElement* const blend[] = { blend_weights, blend_indices };
+
+		for (size_t i = 0; i < sizeof(blend) / sizeof(blend[0]); ++i) {
+			if (0 != blend[i] && (0 == it->vertices[blend[i]->source] ||
+				it->vertexSize[blend[i]->source] < blend[i]->offset +
+					VertexElement::size_from_type(VertexElement::Type(blend[i]->type)))) {
+
+				fprintf(stderr, "%s encountered missing or undersized blend buffer\n", __FUNCTION__);
+				return false;
+			}
+		}
+
+		for (std::vector< BoneAssignment >::const_iterator jt = it->boneAssignment.begin(); jt != it->boneAssignment.end(); ++jt) {
+			if (it->vertexCount <= jt->vertexIndex || bone_index_limit <= jt->boneIndex) {
+				fprintf(stderr, "%s encountered out-of-bounds bone assignment\n", __FUNCTION__);
+				return false;
+			}
+		}
+	}
 
 	const GLsizeiptr sizeArr = GLsizeiptr(vertexCount) * sizeof_vertex;
 	const GLsizeiptr sizeIdx = GLsizeiptr(indexCount) * sizeof_index;
@@ -1676,65 +1998,106 @@ fill_indexed_trilist_from_file_Ogre(
 	void* bitsArr = glMapBufferOES(GL_ARRAY_BUFFER,         GL_WRITE_ONLY_OES);
 	void* bitsIdx = glMapBufferOES(GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY_OES);
 	size_t offsIdx = 0;
+	bool success = 0 != bitsArr && 0 != bitsIdx;
 
-	// gather the output buffers from the source buffers
- 	for (std::vector< Submesh >::iterator it = submesh.begin(); it != submesh.end(); ++it) {
+	if (!success)
+		fprintf(stderr, "%s failed to map the output buffers\n", __FUNCTION__);
+
+	// gather the output buffers straight from the file mapping
+	for (std::vector< Submesh >::const_iterator it = submesh.begin(); success && it != submesh.end(); ++it) {
 		// fill in the vertices
 		const size_t subVertCount = it->vertexCount;
 		int8_t* typedBitsArr = reinterpret_cast< int8_t* >(bitsArr);
 
-		for (size_t i = 0; i < subVertCount; ++i) {
-			{
-				const size_t source = src_semantics_buffer[SEMANTIC_POS];
-				memcpy(typedBitsArr + semantics_offset[SEMANTIC_POS],
-					reinterpret_cast< int8_t* >(it->vertices[source]) + i * src_buffer_stride[source] + src_semantics_offset[SEMANTIC_POS], src_semantics_size[SEMANTIC_POS]);
-			}
-			{
-				const size_t source = src_semantics_buffer[SEMANTIC_NRM];
-				memcpy(typedBitsArr + semantics_offset[SEMANTIC_NRM],
-					reinterpret_cast< int8_t* >(it->vertices[source]) + i * src_buffer_stride[source] + src_semantics_offset[SEMANTIC_NRM], src_semantics_size[SEMANTIC_NRM]);
-			}
-			{
-				const size_t source = src_semantics_buffer[SEMANTIC_TXC];
-				memcpy(typedBitsArr + semantics_offset[SEMANTIC_TXC],
-					reinterpret_cast< int8_t* >(it->vertices[source]) + i * src_buffer_stride[source] + src_semantics_offset[SEMANTIC_TXC], src_semantics_size[SEMANTIC_TXC]);
-			}
-			{
-				// patch in a default bone attrib (root of weight 1.0)
-				const float root[4] = { 1.f, 0.f, 0.f, 0.f };
-				memcpy(typedBitsArr + semantics_offset[SEMANTIC_BON], root, sizeof(root));
+		// bone influences, by blend elements or by bone assignments
+		std::vector< BoneInfluence > influence(subVertCount);
+
+		if (0 != blend_indices) {
+			const uint16_t wsrc = 0 != blend_weights ? blend_weights->source : 0;
+			const uint16_t isrc = blend_indices->source;
+
+			for (size_t i = 0; success && i < subVertCount; ++i) {
+				const void* const weights = 0 != blend_weights ?
+					reinterpret_cast< const int8_t* >(it->vertices[wsrc]) + i * it->vertexSize[wsrc] + blend_weights->offset : 0;
+				const void* const indices =
+					reinterpret_cast< const int8_t* >(it->vertices[isrc]) + i * it->vertexSize[isrc] + blend_indices->offset;
+
+				success = fetchBlendElemOgre(
+					weights, 0 != blend_weights ? blend_weights->type : 0,
+					indices, blend_indices->type,
+					influence[i]);
 			}
-			typedBitsArr += sizeof_vertex;
+		}
+		else {
+			for (std::vector< BoneAssignment >::const_iterator jt = it->boneAssignment.begin(); jt != it->boneAssignment.end(); ++jt)
+				influence[jt->vertexIndex].add(jt->boneIndex, jt->weight);
 		}
 
-		bitsArr = typedBitsArr;
+		std::vector< PackedBone > bone(subVertCount);
+
+		for (size_t i = 0; i < subVertCount; ++i)
+			influence[i].pack(bone[i].bon);
+
+		const size_t semantics[] = {
+			SEMANTIC_POS,
+			SEMANTIC_NRM,
+			SEMANTIC_TXC
+		};
+		const rend::GatherFormat format[] = {
+			rend::GATHER_FLOAT3,
+			rend::GATHER_FLOAT3,
+			rend::GATHER_FLOAT2
+		};
+
+		rend::GatherLayout layout(sizeof_vertex);
+
+		for (size_t j = 0; j < sizeof(semantics) / sizeof(semantics[0]); ++j) {
+			const size_t source = src_semantics_buffer[semantics[j]];
+			layout.add(
+				reinterpret_cast< const int8_t* >(it->vertices[source]) + src_semantics_offset[semantics[j]],
+				it->vertexSize[source],
+				semantics_offset[semantics[j]],
+				format[j]);
+		}
+
+		if (subVertCount)
+			layout.add(bone.front().bon, sizeof(PackedBone), semantics_offset[SEMANTIC_BON], rend::GATHER_FLOAT4);
+
+		if (success && !rend::gatherVertices(layout, typedBitsArr, subVertCount)) {
+			fprintf(stderr, "%s encountered unsupported output layout\n", __FUNCTION__);
+			success = false;
+		}
 
-		for (size_t i = 0; i < Submesh::buffer_capacity; ++i)
-			if (0 != it->vertices[i])
-				free(it->vertices[i]);
+		typedBitsArr += sizeof_vertex * subVertCount;
+		bitsArr = typedBitsArr;
 
 		// fill in the indices
 		const size_t subIdxCount = it->indexCount;
-		void* const indices = it->indices;
+		const void* const indices = it->indices;
 
 		if (INDEX_BITNESS_16 == indexBitness) {
 			uint16_t* typedBitsIdx = reinterpret_cast< uint16_t* >(bitsIdx);
 
-			for (size_t i = 0; i < subIdxCount; ++i)
-				*typedBitsIdx++ = uint16_t(offsIdx + reinterpret_cast< const uint16_t* >(indices)[i]);
+			for (size_t i = 0; i < subIdxCount; ++i) {
+				uint16_t index;
+				memcpy(&index, reinterpret_cast< const uint16_t* >(indices) + i, sizeof(index));
+				*typedBitsIdx++ = uint16_t(offsIdx + index);
+			}
 
 			bitsIdx = typedBitsIdx;
 		}
 		else {
 			uint32_t* typedBitsIdx = reinterpret_cast< uint32_t* >(bitsIdx);
 
-			for (size_t i = 0; i < subIdxCount; ++i)
-				*typedBitsIdx++ = uint32_t(offsIdx + reinterpret_cast< const uint32_t* >(indices)[i]);
+			for (size_t i = 0; i < subIdxCount; ++i) {
+				uint32_t index;
+				memcpy(&index, reinterpret_cast< const uint32_t* >(indices) + i, sizeof(index));
+				*typedBitsIdx++ = uint32_t(offsIdx + index);
+			}
 
 			bitsIdx = typedBitsIdx;
 		}
 		offsIdx += subVertCount;
-		free(it->indices);
 	}
 
 	glUnmapBufferOES(GL_ARRAY_BUFFER);
@@ -1743,6 +2106,9 @@ fill_indexed_trilist_from_file_Ogre(
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
+	if (!success)
+		return false;
+
 	num_faces = uint32_t(indexCount) / 3;
 
 	fprintf(stdout, "number of vertices: %u\nnumber of indices: %u\n",
@@ -6,9 +6,41 @@
 #else
 	#include <GLES2/gl2.h>
 #endif
+#include <stdint.h>
+#include <vector>
 
 namespace util {
 
+// optional processing of a trilist between loading and upload: vertices are float (before any
+// quantization), indices are 32-bit and may be permuted, e.g. faces reordered, in place
+struct TrilistFilter
+{
+	bool (* apply)(
+		void* const ctx,
+		const float* const vertex,
+		const unsigned floats_per_vertex,
+		const unsigned num_verts,
+		uint32_t* const index,
+		const unsigned num_faces);
+
+	void* ctx;
+};
+
+// sub-batch of a trilist with 16-bit indices relative to a vertex range of its own; faces keep
+// their order and numbering across batches, vertices shared by batches get duplicated
+struct TrilistBatch
+{
+	uint32_t first_face;
+	uint32_t num_faces;
+	uint32_t first_vertex;
+	uint32_t num_vertices;
+};
+
+typedef std::vector< TrilistBatch > TrilistBatches;
+
+// text-mesh loaders; meshes of more vertices than 16-bit indices can address get 32-bit indices,
+// unless batches are given -- then such meshes get split into batches of 16-bit indices; batches
+// receive the draw list, a single batch if no split was needed
 bool
 fill_indexed_trilist_from_file_P(
 	const char* const filename,
@@ -17,7 +49,22 @@ fill_indexed_trilist_from_file_P(
 	unsigned& num_faces,
 	GLenum& index_type,
 	float (&bmin)[3],
-	float (&bmax)[3]);
+	float (&bmax)[3],
+	const TrilistFilter* const filter = 0,
+	TrilistBatches* const batches = 0);
+
+// positions quantized to snorm16 x 4 (w = 1) in the domain rend::QuantDomain(bmin, bmax, true)
+bool
+fill_indexed_trilist_from_file_P_snorm16(
+	const char* const filename,
+	const GLuint vbo_arr,
+	const GLuint vbo_idx,
+	unsigned& num_faces,
+	GLenum& index_type,
+	float (&bmin)[3],
+	float (&bmax)[3],
+	const TrilistFilter* const filter = 0,
+	TrilistBatches* const batches = 0);
 
 bool
 fill_indexed_trilist_from_file_PN(
@@ -27,7 +74,9 @@ fill_indexed_trilist_from_file_PN(
 	unsigned& num_faces,
 	GLenum& index_type,
 	float (&bmin)[3],
-	float (&bmax)[3]);
+	float (&bmax)[3],
+	const TrilistFilter* const filter = 0,
+	TrilistBatches* const batches = 0);
 
 bool
 fill_indexed_trilist_from_file_PN2(
@@ -37,7 +86,9 @@ fill_indexed_trilist_from_file_PN2(
 	unsigned& num_faces,
 	GLenum& index_type,
 	float (&bmin)[3],
-	float (&bmax)[3]);
+	float (&bmax)[3],
+	const TrilistFilter* const filter = 0,
+	TrilistBatches* const batches = 0);
 
 bool
 fill_indexed_trilist_from_file_ABE(
@@ -61,6 +112,45 @@ fill_indexed_trilist_from_file_Ogre(
 	float (&bmin)[3],
 	float (&bmax)[3]);
 
+// binary glTF 2.0 (.glb) loader: the meshes of the nodes skinned by the first skin (or of all mesh
+// nodes, absent skins) go to a single trilist, node transforms not applied; POSITION, NORMAL and
+// TEXCOORD_0 (float) go to the pos, nrm and txc offsets of semantics_offset, and JOINTS_0/WEIGHTS_0
+// get packed into bon, joints in the bone order of rend::loadSkeletonAnimationGLB; an offset of -1
+// skips the attribute; a single primitive matching the output layout gets its vertices and/or
+// indices uploaded straight from the file mapping
+bool
+fill_indexed_trilist_from_file_GLB(
+	const char* const filename,
+	const GLuint vbo_arr,
+	const GLuint vbo_idx,
+	const uintptr_t (&semantics_offset)[4],
+	unsigned& num_faces,
+	GLenum& index_type,
+	float (&bmin)[3],
+	float (&bmax)[3]);
+
+// binary little-endian PLY loader for large scans: the file gets streamed in blocks straight into
+// the mapped buffers, never held in memory whole; vertex properties x, y, z, nx, ny, nz and u, v
+// (or s, t), of any scalar type, go to the pos, nrm and txc offsets of semantics_offset within
+// vertices of the specified size, an offset of -1 skipping the attribute (bon is not produced);
+// positions come as float x 3, or with quantize as snorm16 x 4 (w = 1) in the domain
+// rend::QuantDomain(bmin, bmax, true) -- that takes an extra pass over the vertices; normals come
+// as float x 3, tcoords as float x 2; faces must be triangles, their indices get narrowed to 16
+// bits when the vertex count permits; files of no faces, e.g. point scans, produce no faces
+bool
+fill_indexed_trilist_from_file_PLY(
+	const char* const filename,
+	const GLuint vbo_arr,
+	const GLuint vbo_idx,
+	const uintptr_t (&semantics_offset)[4],
+	const uintptr_t sizeof_vertex,
+	const bool quantize,
+	unsigned& num_verts,
+	unsigned& num_faces,
+	GLenum& index_type,
+	float (&bmin)[3],
+	float (&bmax)[3]);
+
 } // namespace util
 
 #endif // rend_indexed_trilist_H__
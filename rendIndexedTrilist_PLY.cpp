@@ -0,0 +1,792 @@
+#if defined(PLATFORM_GL)
+	#include <GL/gl.h>
+	#include "gles_gl_mapping.hpp"
+#else
+	#include <GLES2/gl2.h>
+	#include <GLES2/gl2ext.h>
+	#include "gles_ext.h"
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "stream.hpp"
+#include "timer.h"
+#include "rendIndexedTrilist.hpp"
+#include "rendVertQuant.hpp"
+
+namespace { // anonymous
+
+// file blocks get streamed at this granularity
+const size_t block_size = 1 << 22;
+
+// the header has to fit in this
+const size_t max_header_size = 1 << 16;
+
+// vertices converted per stage, i.e. per copy to the mapped buffer
+const size_t stage_verts = 256;
+const size_t max_vertex_size = 256;
+
+enum PlyType {
+	PLY_INT8,
+	PLY_UINT8,
+	PLY_INT16,
+	PLY_UINT16,
+	PLY_INT32,
+	PLY_UINT32,
+	PLY_FLOAT32,
+	PLY_FLOAT64,
+
+	PLY_TYPE_COUNT,
+	PLY_TYPE_FORCE_UINT = -1U
+};
+
+const struct {
+	const char* name;
+	const char* alias;
+	size_t size;
+} ply_type[] = {
+	{ "char",   "int8",    1 },
+	{ "uchar",  "uint8",   1 },
+	{ "short",  "int16",   2 },
+	{ "ushort", "uint16",  2 },
+	{ "int",    "int32",   4 },
+	{ "uint",   "uint32",  4 },
+	{ "float",  "float32", 4 },
+	{ "double", "float64", 8 }
+};
+
+PlyType
+getPlyType(
+	const char* const name)
+{
+	for (unsigned i = 0; i < PLY_TYPE_COUNT; ++i)
+		if (0 == strcmp(name, ply_type[i].name) || 0 == strcmp(name, ply_type[i].alias))
+			return PlyType(i);
+
+	return PLY_TYPE_COUNT;
+}
+
+template < typename T >
+inline T
+load(
+	const uint8_t* const src)
+{
+	T t;
+	memcpy(&t, src, sizeof(t));
+	return t;
+}
+
+inline double
+getScalar(
+	const uint8_t* const src,
+	const PlyType type)
+{
+	switch (type) {
+	case PLY_INT8:
+		return load< int8_t >(src);
+	case PLY_UINT8:
+		return load< uint8_t >(src);
+	case PLY_INT16:
+		return load< int16_t >(src);
+	case PLY_UINT16:
+		return load< uint16_t >(src);
+	case PLY_INT32:
+		return load< int32_t >(src);
+	case PLY_UINT32:
+		return load< uint32_t >(src);
+	case PLY_FLOAT32:
+		return load< float >(src);
+	case PLY_FLOAT64:
+		return load< double >(src);
+	default:
+		break;
+	}
+
+	assert(false);
+	return 0.0;
+}
+
+// integral scalar, negatives wrapping around to out-of-bounds
+inline uint32_t
+getIndex(
+	const uint8_t* const src,
+	const PlyType type)
+{
+	switch (type) {
+	case PLY_INT8:
+		return uint32_t(int32_t(load< int8_t >(src)));
+	case PLY_UINT8:
+		return load< uint8_t >(src);
+	case PLY_INT16:
+		return uint32_t(int32_t(load< int16_t >(src)));
+	case PLY_UINT16:
+		return load< uint16_t >(src);
+	case PLY_INT32:
+	case PLY_UINT32:
+		return load< uint32_t >(src);
+	default:
+		break;
+	}
+
+	return uint32_t(-1);
+}
+
+struct PlyProperty
+{
+	char name[32];
+	PlyType type;
+	PlyType count_type;	// of list properties; PLY_TYPE_COUNT for scalars
+};
+
+struct PlyElement
+{
+	char name[32];
+	uint64_t count;
+	std::vector< PlyProperty > prop;
+
+	// record size if fixed, i.e. with no list properties, else zero
+	size_t getSize() const
+	{
+		size_t size = 0;
+
+		for (std::vector< PlyProperty >::const_iterator it = prop.begin(); it != prop.end(); ++it) {
+			if (PLY_TYPE_COUNT != it->count_type)
+				return 0;
+
+			size += ply_type[it->type].size;
+		}
+
+		return size;
+	}
+
+	// offset and type of a scalar property, searched by any of the specified names
+	bool findScalar(
+		const char* const name0,
+		const char* const name1,
+		size_t& offset,
+		PlyType& type) const
+	{
+		offset = 0;
+
+		for (std::vector< PlyProperty >::const_iterator it = prop.begin(); it != prop.end(); ++it) {
+			if (PLY_TYPE_COUNT == it->count_type &&
+				(0 == strcmp(it->name, name0) || (name1 && 0 == strcmp(it->name, name1)))) {
+
+				type = it->type;
+				return true;
+			}
+
+			offset += ply_type[it->type].size;
+		}
+
+		return false;
+	}
+};
+
+// sequential reader of large blocks; records may straddle blocks
+class BlockReader
+{
+	int fd;
+	std::vector< uint8_t > block;
+	size_t pos;
+	size_t end;
+	uint64_t total;
+
+	BlockReader(const BlockReader&);
+	BlockReader& operator =(const BlockReader&);
+
+public:
+	BlockReader(
+		const int fd)
+	: fd(fd)
+	, block(block_size)
+	, pos(0)
+	, end(0)
+	, total(0)
+	{}
+
+	// restart at the specified file offset
+	void seek(
+		const uint64_t offset)
+	{
+		lseek(fd, off_t(offset), SEEK_SET);
+		pos = 0;
+		end = 0;
+	}
+
+	// make sure of at least span bytes past the cursor
+	bool fill(
+		const size_t span)
+	{
+		assert(span <= block.size());
+
+		if (end - pos >= span)
+			return true;
+
+		memmove(&block.front(), &block.front() + pos, end - pos);
+		end -= pos;
+		pos = 0;
+
+		while (end < span) {
+			const ssize_t res = read(fd, &block.front() + end, block.size() - end);
+
+			if (0 >= res)
+				return false;
+
+			end += size_t(res);
+			total += uint64_t(res);
+		}
+
+		return true;
+	}
+
+	const uint8_t* take(
+		const size_t span)
+	{
+		if (!fill(span))
+			return 0;
+
+		const uint8_t* const start = &block.front() + pos;
+		pos += span;
+		return start;
+	}
+
+	// bytes past the cursor
+	size_t available() const
+	{
+		return end - pos;
+	}
+
+	const uint8_t* peek() const
+	{
+		return &block.front() + pos;
+	}
+
+	uint64_t getTotalRead() const
+	{
+		return total;
+	}
+};
+
+// skip the records of an element, of fixed size or not
+bool
+skipElement(
+	BlockReader& reader,
+	const PlyElement& elem)
+{
+	const size_t size = elem.getSize();
+
+	for (uint64_t i = 0; i < elem.count; ++i) {
+		if (size) {
+			if (0 == reader.take(size))
+				return false;
+
+			continue;
+		}
+
+		for (std::vector< PlyProperty >::const_iterator it = elem.prop.begin(); it != elem.prop.end(); ++it) {
+			size_t span = ply_type[it->type].size;
+
+			if (PLY_TYPE_COUNT != it->count_type) {
+				const uint8_t* const count = reader.take(ply_type[it->count_type].size);
+
+				if (0 == count)
+					return false;
+
+				span *= getIndex(count, it->count_type);
+			}
+
+			// spans can exceed a block
+			while (span) {
+				const size_t part = span < block_size ? span : block_size;
+
+				if (0 == reader.take(part))
+					return false;
+
+				span -= part;
+			}
+		}
+	}
+
+	return true;
+}
+
+// parse the header; return its size, or zero on failure
+size_t
+parseHeader(
+	BlockReader& reader,
+	std::vector< PlyElement >& element)
+{
+	// a short file fails the fill but keeps what it read
+	reader.fill(max_header_size);
+
+	const size_t span = reader.available() < max_header_size ? reader.available() : max_header_size;
+	const char* const text = reinterpret_cast< const char* >(reader.peek());
+	const char* const text_end = text + span;
+
+	static const char sEnd[] = "end_header\n";
+	const char* header_end = 0;
+
+	for (const char* p = text; p + sizeof(sEnd) - 1 <= text_end && 0 == header_end; ++p)
+		if ('e' == *p && 0 == memcmp(p, sEnd, sizeof(sEnd) - 1) && (p == text || '\n' == p[-1]))
+			header_end = p + sizeof(sEnd) - 1;
+
+	if (0 == header_end || 4 > span || 0 != memcmp(text, "ply\n", 4)) {
+		stream::cerr << __FUNCTION__ << " encountered a missing or oversized PLY header\n";
+		return 0;
+	}
+
+	bool format = false;
+
+	for (const char* line = text; line < header_end; ) {
+		const char* const eol = reinterpret_cast< const char* >(memchr(line, '\n', header_end - line));
+		char buf[256];
+		const size_t len = size_t(eol - line) < sizeof(buf) - 1 ? size_t(eol - line) : sizeof(buf) - 1;
+
+		memcpy(buf, line, len);
+		buf[len] = '\0';
+		line = eol + 1;
+
+		char word[3][32];
+		unsigned long long count;
+
+		if (1 == sscanf(buf, "format %31s", word[0])) {
+			if (strcmp(word[0], "binary_little_endian")) {
+				stream::cerr << __FUNCTION__ << " supports binary_little_endian PLY only\n";
+				return 0;
+			}
+
+			format = true;
+		}
+		else
+		if (2 == sscanf(buf, "element %31s %llu", word[0], &count)) {
+			element.push_back(PlyElement());
+			strcpy(element.back().name, word[0]);
+			element.back().count = count;
+		}
+		else
+		if (3 == sscanf(buf, "property list %31s %31s %31s", word[0], word[1], word[2])) {
+
+			PlyProperty prop;
+			strcpy(prop.name, word[2]);
+			prop.count_type = getPlyType(word[0]);
+			prop.type = getPlyType(word[1]);
+
+			if (element.empty() || PLY_TYPE_COUNT == prop.count_type || PLY_TYPE_COUNT == prop.type) {
+				stream::cerr << __FUNCTION__ << " encountered invalid property '" << buf << "'\n";
+				return 0;
+			}
+
+			element.back().prop.push_back(prop);
+		}
+		else
+		if (2 == sscanf(buf, "property %31s %31s", word[0], word[1])) {
+			PlyProperty prop;
+			strcpy(prop.name, word[1]);
+			prop.count_type = PLY_TYPE_COUNT;
+			prop.type = getPlyType(word[0]);
+
+			if (element.empty() || PLY_TYPE_COUNT == prop.type) {
+				stream::cerr << __FUNCTION__ << " encountered invalid property '" << buf << "'\n";
+				return 0;
+			}
+
+			element.back().prop.push_back(prop);
+		}
+	}
+
+	if (!format) {
+		stream::cerr << __FUNCTION__ << " encountered a PLY header of no format\n";
+		return 0;
+	}
+
+	const size_t size = size_t(header_end - text);
+	reader.take(size);
+
+	return size;
+}
+
+// attribute fetch of a vertex record
+struct VertexFetch
+{
+	enum {
+		ATTR_X, ATTR_Y, ATTR_Z,
+		ATTR_NX, ATTR_NY, ATTR_NZ,
+		ATTR_U, ATTR_V,
+
+		ATTR_COUNT
+	};
+
+	size_t offset[ATTR_COUNT];
+	PlyType type[ATTR_COUNT];
+	bool pos_float3;	// x, y, z are consecutive floats
+
+	bool init(
+		const PlyElement& vertex,
+		const bool nrm,
+		const bool txc)
+	{
+		static const char* const name[ATTR_COUNT][2] = {
+			{ "x", 0 }, { "y", 0 }, { "z", 0 },
+			{ "nx", 0 }, { "ny", 0 }, { "nz", 0 },
+			{ "u", "s" }, { "v", "t" }
+		};
+
+		for (unsigned i = 0; i < ATTR_COUNT; ++i) {
+			const bool needed = i < ATTR_NX || (i < ATTR_U ? nrm : txc);
+
+			if (!vertex.findScalar(name[i][0], name[i][1], offset[i], type[i]) && needed) {
+				stream::cerr << "PLY vertices lack property '" << name[i][0] << "'\n";
+				return false;
+			}
+		}
+
+		pos_float3 =
+			PLY_FLOAT32 == type[ATTR_X] && PLY_FLOAT32 == type[ATTR_Y] && PLY_FLOAT32 == type[ATTR_Z] &&
+			offset[ATTR_Y] == offset[ATTR_X] + sizeof(float) &&
+			offset[ATTR_Z] == offset[ATTR_Y] + sizeof(float);
+
+		return true;
+	}
+
+	void getPos(
+		const uint8_t* const record,
+		float (& pos)[3]) const
+	{
+		if (pos_float3) {
+			memcpy(pos, record + offset[ATTR_X], sizeof(pos));
+			return;
+		}
+
+		pos[0] = float(getScalar(record + offset[ATTR_X], type[ATTR_X]));
+		pos[1] = float(getScalar(record + offset[ATTR_Y], type[ATTR_Y]));
+		pos[2] = float(getScalar(record + offset[ATTR_Z], type[ATTR_Z]));
+	}
+
+	void get(
+		const uint8_t* const record,
+		const unsigned first,
+		const unsigned count,
+		float* const out) const
+	{
+		for (unsigned i = 0; i < count; ++i)
+			out[i] = float(getScalar(record + offset[first + i], type[first + i]));
+	}
+};
+
+} // namespace
+
+namespace util {
+
+bool
+fill_indexed_trilist_from_file_PLY(
+	const char* const filename,
+	const GLuint vbo_arr,
+	const GLuint vbo_idx,
+	const uintptr_t (&semantics_offset)[4],
+	const uintptr_t sizeof_vertex,
+	const bool quantize,
+	unsigned& num_verts,
+	unsigned& num_faces,
+	GLenum& index_type,
+	float (&bmin)[3],
+	float (&bmax)[3])
+{
+	assert(filename);
+
+	const uint64_t t0 = timer_ns();
+	const int fd = open(filename, O_RDONLY);
+
+	if (-1 == fd) {
+		stream::cerr << __FUNCTION__ << " failed at open '" << filename << "'\n";
+		return false;
+	}
+
+	struct CloseFd {
+		int fd;
+		~CloseFd() { close(fd); }
+	} close_fd = { fd };
+
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	struct stat sb;
+	const uint64_t file_size = 0 == fstat(fd, &sb) ? uint64_t(sb.st_size) : 0;
+
+	const uintptr_t offset_pos = semantics_offset[0];
+	const uintptr_t offset_nrm = semantics_offset[2];
+	const uintptr_t offset_txc = semantics_offset[3];
+	const uintptr_t none = uintptr_t(-1);
+	const size_t sizeof_pos = quantize ? sizeof(int16_t[4]) : sizeof(float[3]);
+
+	if (max_vertex_size < sizeof_vertex ||
+		none == offset_pos || sizeof_vertex < offset_pos + sizeof_pos ||
+		(none != offset_nrm && sizeof_vertex < offset_nrm + sizeof(float[3])) ||
+		(none != offset_txc && sizeof_vertex < offset_txc + sizeof(float[2]))) {
+
+		stream::cerr << __FUNCTION__ << " encountered an invalid vertex layout\n";
+		return false;
+	}
+
+	std::vector< PlyElement > element;
+	BlockReader reader(fd);
+	const size_t header_size = parseHeader(reader, element);
+
+	if (0 == header_size)
+		return false;
+
+	// locate the vertex and face elements
+	const PlyElement* vertex = 0;
+	const PlyElement* face = 0;
+
+	for (std::vector< PlyElement >::const_iterator it = element.begin(); it != element.end(); ++it) {
+		if (0 == strcmp(it->name, "vertex"))
+			vertex = &*it;
+		else
+		if (0 == strcmp(it->name, "face"))
+			face = &*it;
+	}
+
+	if (0 == vertex || 0 == vertex->getSize() || 0 == vertex->count || uint32_t(-1) < vertex->count) {
+		stream::cerr << __FUNCTION__ << " encountered missing or unsupported PLY vertices\n";
+		return false;
+	}
+
+	// faces: triangles of a list of vertex indices, possibly among other, scalar, properties
+	size_t face_size = 0;
+	size_t face_list_offset = 0;
+	PlyType face_count_type = PLY_TYPE_COUNT;
+	PlyType face_index_type = PLY_TYPE_COUNT;
+
+	if (0 != face) {
+		for (std::vector< PlyProperty >::const_iterator it = face->prop.begin(); it != face->prop.end(); ++it) {
+			if (PLY_TYPE_COUNT == it->count_type) {
+				face_size += ply_type[it->type].size;
+				continue;
+			}
+
+			if (PLY_TYPE_COUNT != face_count_type ||
+				(strcmp(it->name, "vertex_indices") && strcmp(it->name, "vertex_index")) ||
+				PLY_FLOAT32 <= it->type) {
+
+				stream::cerr << __FUNCTION__ << " encountered unsupported PLY faces\n";
+				return false;
+			}
+
+			face_list_offset = face_size;
+			face_count_type = it->count_type;
+			face_index_type = it->type;
+			face_size += ply_type[it->count_type].size + 3 * ply_type[it->type].size;
+		}
+
+		if (PLY_TYPE_COUNT == face_count_type || uint32_t(-1) / 3 < face->count) {
+			stream::cerr << __FUNCTION__ << " encountered unsupported PLY faces\n";
+			return false;
+		}
+	}
+
+	VertexFetch fetch;
+
+	if (!fetch.init(*vertex, none != offset_nrm, none != offset_txc))
+		return false;
+
+	const size_t vertex_size = vertex->getSize();
+
+	num_verts = unsigned(vertex->count);
+	num_faces = face ? unsigned(face->count) : 0;
+
+	/////////////////////////////////////////////////////////////////
+	// quantization needs the bounds upfront -- a pass over the vertices
+
+	bmin[0] = bmin[1] = bmin[2] = std::numeric_limits< float >::infinity();
+	bmax[0] = bmax[1] = bmax[2] = -std::numeric_limits< float >::infinity();
+
+	if (quantize) {
+		for (std::vector< PlyElement >::const_iterator it = element.begin(); &*it != vertex; ++it)
+			if (!skipElement(reader, *it)) {
+				stream::cerr << __FUNCTION__ << " encountered truncated PLY element '" << it->name << "'\n";
+				return false;
+			}
+
+		const size_t batch = block_size / vertex_size;
+
+		for (uint64_t i = 0; i < vertex->count; i += batch) {
+			const size_t count = size_t(vertex->count - i < batch ? vertex->count - i : batch);
+			const uint8_t* const record = reader.take(vertex_size * count);
+
+			if (0 == record) {
+				stream::cerr << __FUNCTION__ << " encountered truncated PLY vertices\n";
+				return false;
+			}
+
+			for (size_t j = 0; j < count; ++j) {
+				float pos[3];
+				fetch.getPos(record + j * vertex_size, pos);
+
+				for (unsigned k = 0; k < 3; ++k) {
+					bmin[k] = fminf(bmin[k], pos[k]);
+					bmax[k] = fmaxf(bmax[k], pos[k]);
+				}
+			}
+		}
+
+		reader.seek(header_size);
+	}
+
+	const rend::QuantDomain domain(bmin, bmax, true);
+
+	/////////////////////////////////////////////////////////////////
+	// map the output buffers and stream the elements into them
+
+	const size_t sizeof_index = uint64_t(1) + uint16_t(-1) < num_verts ? sizeof(uint32_t) : sizeof(uint16_t);
+	index_type = sizeof(uint32_t) == sizeof_index ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+
+	glBindBuffer(GL_ARRAY_BUFFER, vbo_arr);
+	glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(sizeof_vertex) * num_verts, 0, GL_STATIC_DRAW);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo_idx);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, GLsizeiptr(sizeof_index) * 3 * num_faces, 0, GL_STATIC_DRAW);
+
+	uint8_t* const bitsArr = reinterpret_cast< uint8_t* >(glMapBufferOES(GL_ARRAY_BUFFER, GL_WRITE_ONLY_OES));
+	uint8_t* const bitsIdx = num_faces ? reinterpret_cast< uint8_t* >(glMapBufferOES(GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY_OES)) : 0;
+	bool success = 0 != bitsArr && (0 != bitsIdx || 0 == num_faces);
+
+	if (!success)
+		stream::cerr << __FUNCTION__ << " failed to map the output buffers\n";
+
+	for (std::vector< PlyElement >::const_iterator it = element.begin(); success && it != element.end(); ++it) {
+		if (&*it == vertex) {
+			// vertices get composed in a stage and copied out whole, for the sake of write-combined mappings
+			uint8_t stage[stage_verts * max_vertex_size];
+			memset(stage, 0, sizeof(stage));
+
+			for (uint64_t i = 0; success && i < vertex->count; i += stage_verts) {
+				const size_t count = size_t(vertex->count - i < stage_verts ? vertex->count - i : stage_verts);
+				const uint8_t* const record = reader.take(vertex_size * count);
+
+				if (0 == record) {
+					stream::cerr << __FUNCTION__ << " encountered truncated PLY vertices\n";
+					success = false;
+					break;
+				}
+
+				for (size_t j = 0; j < count; ++j) {
+					const uint8_t* const src = record + j * vertex_size;
+					uint8_t* const dst = stage + j * sizeof_vertex;
+					float pos[3];
+
+					fetch.getPos(src, pos);
+
+					if (quantize) {
+						int16_t q[4];
+						domain.quantize(pos, q);
+						memcpy(dst + offset_pos, q, sizeof(q));
+					}
+					else {
+						memcpy(dst + offset_pos, pos, sizeof(pos));
+
+						for (unsigned k = 0; k < 3; ++k) {
+							bmin[k] = fminf(bmin[k], pos[k]);
+							bmax[k] = fmaxf(bmax[k], pos[k]);
+						}
+					}
+
+					if (none != offset_nrm) {
+						float nrm[3];
+						fetch.get(src, VertexFetch::ATTR_NX, 3, nrm);
+						memcpy(dst + offset_nrm, nrm, sizeof(nrm));
+					}
+
+					if (none != offset_txc) {
+						float txc[2];
+						fetch.get(src, VertexFetch::ATTR_U, 2, txc);
+						memcpy(dst + offset_txc, txc, sizeof(txc));
+					}
+				}
+
+				memcpy(bitsArr + sizeof_vertex * i, stage, sizeof_vertex * count);
+			}
+		}
+		else
+		if (&*it == face) {
+			// faces get narrowed on the fly; an index buffer is written in order, no staging needed
+			const size_t sizeof_index_src = ply_type[face_index_type].size;
+			const size_t batch = block_size / face_size;
+
+			for (uint64_t i = 0; success && i < face->count; i += batch) {
+				const size_t count = size_t(face->count - i < batch ? face->count - i : batch);
+				const uint8_t* const record = reader.take(face_size * count);
+
+				if (0 == record) {
+					stream::cerr << __FUNCTION__ << " encountered truncated PLY faces\n";
+					success = false;
+					break;
+				}
+
+				for (size_t j = 0; j < count; ++j) {
+					const uint8_t* const list = record + j * face_size + face_list_offset;
+					const uint8_t* const index = list + ply_type[face_count_type].size;
+					const uint32_t tri[] = {
+						getIndex(index + 0 * sizeof_index_src, face_index_type),
+						getIndex(index + 1 * sizeof_index_src, face_index_type),
+						getIndex(index + 2 * sizeof_index_src, face_index_type)
+					};
+
+					if (3 != getIndex(list, face_count_type) ||
+						num_verts <= tri[0] || num_verts <= tri[1] || num_verts <= tri[2]) {
+
+						stream::cerr << __FUNCTION__ << " encountered a non-triangle face or an out-of-bounds index\n";
+						success = false;
+						break;
+					}
+
+					const size_t k = size_t(i + j) * 3;
+
+					if (sizeof(uint16_t) == sizeof_index) {
+						const uint16_t narrow[] = { uint16_t(tri[0]), uint16_t(tri[1]), uint16_t(tri[2]) };
+						memcpy(bitsIdx + k * sizeof(uint16_t), narrow, sizeof(narrow));
+					}
+					else
+						memcpy(bitsIdx + k * sizeof(uint32_t), tri, sizeof(tri));
+				}
+			}
+		}
+		else
+		if (!skipElement(reader, *it)) {
+			stream::cerr << __FUNCTION__ << " encountered truncated PLY element '" << it->name << "'\n";
+			success = false;
+		}
+	}
+
+	if (0 != bitsArr)
+		glUnmapBufferOES(GL_ARRAY_BUFFER);
+
+	if (0 != bitsIdx)
+		glUnmapBufferOES(GL_ELEMENT_ARRAY_BUFFER);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	if (!success)
+		return false;
+
+	const double dt = double(timer_ns() - t0) * 1e-9;
+	const double mbytes = double(file_size) / (1 << 20);
+
+	stream::cout << "number of vertices: " << num_verts <<
+		"\nnumber of indices: " << num_faces * 3 <<
+		"\nPLY throughput: " << mbytes << " MB in " << dt << " s, " << mbytes / dt <<
+		" MB/s (" << double(reader.getTotalRead()) / (1 << 20) << " MB read)\n";
+
+	return true;
+}
+
+} // namespace util
@@ -0,0 +1,487 @@
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include "stream.hpp"
+#include "rendLod.hpp"
+
+namespace { // anonymous
+
+// squared cosine of the largest face turn a collapse may cause
+const double flip_cos2 = .25 * .25;
+
+// symmetric 4x4 error quadric, along with its accumulated weight
+struct Quadric
+{
+	double a00, a01, a02, a11, a12, a22;
+	double b0, b1, b2;
+	double c;
+	double w;
+
+	void add(const Quadric& q) {
+		a00 += q.a00; a01 += q.a01; a02 += q.a02;
+		a11 += q.a11; a12 += q.a12; a22 += q.a22;
+		b0 += q.b0; b1 += q.b1; b2 += q.b2;
+		c += q.c;
+		w += q.w;
+	}
+
+	// quadric of the plane n * p + d = 0, n being unit, of the specified weight
+	void set_plane(
+		const double (& n)[3],
+		const double d,
+		const double weight)
+	{
+		a00 = weight * n[0] * n[0]; a01 = weight * n[0] * n[1]; a02 = weight * n[0] * n[2];
+		a11 = weight * n[1] * n[1]; a12 = weight * n[1] * n[2]; a22 = weight * n[2] * n[2];
+		b0 = weight * n[0] * d; b1 = weight * n[1] * d; b2 = weight * n[2] * d;
+		c = weight * d * d;
+		w = weight;
+	}
+
+	double eval(const float* const p) const {
+		const double x = p[0], y = p[1], z = p[2];
+
+		return
+			x * (a00 * x + 2.0 * (a01 * y + a02 * z + b0)) +
+			y * (a11 * y + 2.0 * (a12 * z + b1)) +
+			z * (a22 * z + 2.0 * b2) + c;
+	}
+};
+
+// face-normal (unnormalized) of the specified vertex positions
+inline void
+cross_edges(
+	const float* const p0,
+	const float* const p1,
+	const float* const p2,
+	double (& n)[3])
+{
+	const double e0[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+	const double e1[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+
+	n[0] = e0[1] * e1[2] - e0[2] * e1[1];
+	n[1] = e0[2] * e1[0] - e0[0] * e1[2];
+	n[2] = e0[0] * e1[1] - e0[1] * e1[0];
+}
+
+struct Collapse
+{
+	uint32_t src;
+	uint32_t dst;
+	double cost;
+
+	bool operator <(const Collapse& other) const {
+		return cost < other.cost;
+	}
+};
+
+class VertexLess
+{
+	const float* vertex;
+	unsigned floats_per_vertex;
+
+public:
+	VertexLess(
+		const float* const vertex,
+		const unsigned floats_per_vertex)
+	: vertex(vertex)
+	, floats_per_vertex(floats_per_vertex)
+	{}
+
+	bool operator ()(const uint32_t a, const uint32_t b) const {
+		const float* const va = vertex + size_t(a) * floats_per_vertex;
+		const float* const vb = vertex + size_t(b) * floats_per_vertex;
+
+		for (unsigned i = 0; i < floats_per_vertex; ++i)
+			if (va[i] != vb[i])
+				return va[i] < vb[i];
+
+		return a < b;
+	}
+};
+
+// simplifier state, carried over from one level to the next
+class Simplifier
+{
+	const float* vertex;
+	unsigned floats_per_vertex;
+
+	std::vector< uint32_t > face;		// current trilist, over welded vertices
+	std::vector< Quadric > quadric;		// per welded vertex
+	double max_error;					// squared, weight-normalized
+
+	const float* pos(const uint32_t v) const {
+		return vertex + size_t(v) * floats_per_vertex;
+	}
+
+	bool pass(const size_t target_faces);
+
+public:
+	Simplifier(
+		const float* const vertex,
+		const unsigned floats_per_vertex,
+		const unsigned num_verts,
+		const uint32_t* const index,
+		const unsigned num_faces);
+
+	// collapse until the face count reaches the target, or no collapse is left
+	void simplify(const size_t target_faces) {
+		while (face.size() / 3 > target_faces && pass(target_faces)) {}
+	}
+
+	const std::vector< uint32_t >& get_faces() const {
+		return face;
+	}
+
+	float get_error() const {
+		return float(sqrt(max_error));
+	}
+};
+
+Simplifier::Simplifier(
+	const float* const vertex,
+	const unsigned floats_per_vertex,
+	const unsigned num_verts,
+	const uint32_t* const index,
+	const unsigned num_faces)
+: vertex(vertex)
+, floats_per_vertex(floats_per_vertex)
+, face(index, index + size_t(num_faces) * 3)
+, quadric(num_verts)
+, max_error(0.0)
+{
+	// weld identical vertices onto the first of their kind
+	std::vector< uint32_t > sorted(num_verts);
+	std::vector< uint32_t > weld(num_verts);
+
+	for (unsigned i = 0; i < num_verts; ++i)
+		sorted[i] = i;
+
+	const VertexLess less(vertex, floats_per_vertex);
+	std::sort(sorted.begin(), sorted.end(), less);
+
+	for (unsigned i = 0; i < num_verts; ++i)
+		weld[sorted[i]] = sorted[i];
+
+	// identical vertices are consecutive in ascending index order
+	for (unsigned i = 1; i < num_verts; ++i)
+		if (!memcmp(pos(sorted[i - 1]), pos(sorted[i]), sizeof(float) * floats_per_vertex))
+			weld[sorted[i]] = weld[sorted[i - 1]];
+
+	for (size_t i = 0; i < face.size(); ++i)
+		face[i] = weld[face[i]];
+
+	memset(&quadric.front(), 0, sizeof(Quadric) * quadric.size());
+
+	// area-weighted plane quadrics of the faces
+	for (size_t i = 0; i < face.size(); i += 3) {
+		double n[3];
+		cross_edges(pos(face[i + 0]), pos(face[i + 1]), pos(face[i + 2]), n);
+
+		const double len = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+		if (0.0 == len)
+			continue;
+
+		n[0] /= len;
+		n[1] /= len;
+		n[2] /= len;
+
+		const float* const p = pos(face[i]);
+		const double d = -(n[0] * p[0] + n[1] * p[1] + n[2] * p[2]);
+
+		Quadric q;
+		q.set_plane(n, d, len * .5);
+
+		for (unsigned j = 0; j < 3; ++j)
+			quadric[face[i + j]].add(q);
+	}
+}
+
+bool
+Simplifier::pass(
+	const size_t target_faces)
+{
+	const size_t num_verts = quadric.size();
+	const size_t num_faces = face.size() / 3;
+
+	// undirected edges, keyed as lo << 32 | hi; an edge used by other than two faces is a border
+	std::vector< uint64_t > edge(face.size());
+
+	for (size_t i = 0; i < num_faces; ++i)
+		for (unsigned j = 0; j < 3; ++j) {
+			const uint64_t a = face[i * 3 + j];
+			const uint64_t b = face[i * 3 + (j + 1) % 3];
+			edge[i * 3 + j] = a < b ? a << 32 | b : b << 32 | a;
+		}
+
+	std::sort(edge.begin(), edge.end());
+
+	// border vertices stay put, so borders and seams stay intact
+	std::vector< uint8_t > locked(num_verts, 0);
+	std::vector< Collapse > collapse;
+
+	for (size_t i = 0; i < edge.size(); ) {
+		size_t j = i + 1;
+
+		while (j < edge.size() && edge[j] == edge[i])
+			++j;
+
+		const uint32_t a = uint32_t(edge[i] >> 32);
+		const uint32_t b = uint32_t(edge[i]);
+
+		if (2 != j - i)
+			locked[a] = locked[b] = 1;
+		else {
+			Quadric q = quadric[a];
+			q.add(quadric[b]);
+
+			const double rcp_w = 0.0 < q.w ? 1.0 / q.w : 0.0;
+			const Collapse ab = { a, b, q.eval(pos(b)) * rcp_w };
+			const Collapse ba = { b, a, q.eval(pos(a)) * rcp_w };
+			collapse.push_back(ab.cost < ba.cost ? ab : ba);
+		}
+
+		i = j;
+	}
+
+	// vertex-to-face adjacency
+	std::vector< uint32_t > adj_start(num_verts + 1, 0);
+	std::vector< uint32_t > adj(face.size());
+
+	for (size_t i = 0; i < face.size(); ++i)
+		++adj_start[face[i] + 1];
+
+	for (size_t i = 0; i < num_verts; ++i)
+		adj_start[i + 1] += adj_start[i];
+
+	{
+		std::vector< uint32_t > adj_fill(adj_start.begin(), adj_start.end() - 1);
+
+		for (size_t i = 0; i < face.size(); ++i)
+			adj[adj_fill[face[i]]++] = uint32_t(i / 3);
+	}
+
+	std::sort(collapse.begin(), collapse.end());
+
+	// collapse cheapest-first, at most one collapse per neighbourhood per pass
+	std::vector< uint32_t > remap(num_verts);
+	std::vector< uint8_t > touched(num_verts, 0);
+	std::vector< uint32_t > ring;
+
+	for (size_t i = 0; i < num_verts; ++i)
+		remap[i] = uint32_t(i);
+
+	size_t faces_left = num_faces;
+	bool progress = false;
+
+	for (size_t i = 0; i < collapse.size() && faces_left > target_faces; ++i) {
+		const uint32_t src = collapse[i].src;
+		const uint32_t dst = collapse[i].dst;
+
+		if (locked[src] || touched[src] || touched[dst])
+			continue;
+
+		// link condition: an interior edge has exactly two common neighbours
+		ring.clear();
+
+		for (uint32_t k = adj_start[src]; k < adj_start[src + 1]; ++k)
+			for (unsigned j = 0; j < 3; ++j)
+				ring.push_back(face[adj[k] * 3 + j]);
+
+		std::sort(ring.begin(), ring.end());
+		ring.erase(std::unique(ring.begin(), ring.end()), ring.end());
+
+		unsigned common = 0;
+
+		for (uint32_t k = adj_start[dst]; k < adj_start[dst + 1]; ++k)
+			for (unsigned j = 0; j < 3; ++j) {
+				const uint32_t v = face[adj[k] * 3 + j];
+
+				if (v != src && v != dst && std::binary_search(ring.begin(), ring.end(), v)) {
+					++common;
+					ring.erase(std::lower_bound(ring.begin(), ring.end(), v));
+				}
+			}
+
+		if (2 != common)
+			continue;
+
+		// no face around src may flip when src moves onto dst
+		bool flip = false;
+
+		for (uint32_t k = adj_start[src]; k < adj_start[src + 1] && !flip; ++k) {
+			const uint32_t* const f = &face[adj[k] * 3];
+
+			if (f[0] == dst || f[1] == dst || f[2] == dst)
+				continue;
+
+			double n0[3], n1[3];
+			cross_edges(pos(f[0]), pos(f[1]), pos(f[2]), n0);
+			cross_edges(
+				pos(f[0] == src ? dst : f[0]),
+				pos(f[1] == src ? dst : f[1]),
+				pos(f[2] == src ? dst : f[2]), n1);
+
+			// reject turns past ~75 degrees as well, which slivers tend to do
+			const double dp = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2];
+			const double len2 =
+				(n0[0] * n0[0] + n0[1] * n0[1] + n0[2] * n0[2]) *
+				(n1[0] * n1[0] + n1[1] * n1[1] + n1[2] * n1[2]);
+
+			flip = 0.0 >= dp || dp * dp < flip_cos2 * len2;
+		}
+
+		if (flip)
+			continue;
+
+		remap[src] = dst;
+		quadric[dst].add(quadric[src]);
+		max_error = std::max(max_error, collapse[i].cost);
+		progress = true;
+
+		// lock the neighbourhoods of both ends for the rest of the pass
+		for (uint32_t k = adj_start[src]; k < adj_start[src + 1]; ++k)
+			for (unsigned j = 0; j < 3; ++j)
+				touched[face[adj[k] * 3 + j]] = 1;
+
+		for (uint32_t k = adj_start[dst]; k < adj_start[dst + 1]; ++k)
+			for (unsigned j = 0; j < 3; ++j)
+				touched[face[adj[k] * 3 + j]] = 1;
+
+		faces_left -= 2;
+	}
+
+	if (!progress)
+		return false;
+
+	// apply the collapses, dropping the degenerate faces
+	size_t out = 0;
+
+	for (size_t i = 0; i < face.size(); i += 3) {
+		const uint32_t a = remap[face[i + 0]];
+		const uint32_t b = remap[face[i + 1]];
+		const uint32_t c = remap[face[i + 2]];
+
+		if (a == b || b == c || c == a)
+			continue;
+
+		face[out + 0] = a;
+		face[out + 1] = b;
+		face[out + 2] = c;
+		out += 3;
+	}
+
+	face.resize(out);
+	return true;
+}
+
+} // namespace
+
+namespace rend
+{
+
+bool
+buildLodChain(
+	LodChain& chain,
+	const float* const vertex,
+	const unsigned floats_per_vertex,
+	const unsigned num_verts,
+	const uint32_t* const index,
+	const unsigned num_faces)
+{
+	assert(vertex);
+	assert(index);
+	assert(3 <= floats_per_vertex);
+	assert(0.f < chain.ratio && 1.f > chain.ratio);
+
+	for (size_t i = 0; i < size_t(num_faces) * 3; ++i)
+		if (index[i] >= num_verts) {
+			stream::cerr << __FUNCTION__ << " encountered out-of-range index\n";
+			return false;
+		}
+
+	const unsigned num_levels = std::min(chain.num_levels, unsigned(LodChain::max_levels));
+	Simplifier simplifier(vertex, floats_per_vertex, num_verts, index, num_faces);
+
+	size_t num_faces_prev = num_faces;
+	float target = float(num_faces);
+	chain.num_levels = 0;
+
+	for (unsigned i = 0; i < num_levels; ++i) {
+		target *= chain.ratio;
+		simplifier.simplify(size_t(target));
+
+		const std::vector< uint32_t >& faces = simplifier.get_faces();
+
+		// stop once the mesh no longer simplifies meaningfully
+		if (faces.empty() || faces.size() / 3 > num_faces_prev * (1.f + chain.ratio) * .5f)
+			break;
+
+		chain.level[i].index = faces;
+		chain.level[i].error = simplifier.get_error();
+		chain.num_levels = i + 1;
+		num_faces_prev = faces.size() / 3;
+
+		stream::cout << "lod " << i + 1 << ": number of faces: " << num_faces_prev <<
+			", error: " << chain.level[i].error << '\n';
+	}
+
+	return true;
+}
+
+bool
+buildLodChainFilter(
+	void* const ctx,
+	const float* const vertex,
+	const unsigned floats_per_vertex,
+	const unsigned num_verts,
+	uint32_t* const index,
+	const unsigned num_faces)
+{
+	assert(ctx);
+
+	return buildLodChain(
+		*reinterpret_cast< LodChain* >(ctx),
+		vertex,
+		floats_per_vertex,
+		num_verts,
+		index,
+		num_faces);
+}
+
+unsigned
+selectLod(
+	const LodChain& chain,
+	const float (& mvp)[16],
+	const float (& centre)[3],
+	const float radius,
+	const unsigned viewport_height,
+	const float max_pixel_error)
+{
+	const float (& m)[4][4] = reinterpret_cast< const float (&)[4][4] >(mvp);
+
+	// clip w at the point of the sphere nearest to the viewer, and pixels per object-space unit there
+	const float w_scale = sqrtf(m[0][3] * m[0][3] + m[1][3] * m[1][3] + m[2][3] * m[2][3]);
+	const float w_near =
+		centre[0] * m[0][3] + centre[1] * m[1][3] + centre[2] * m[2][3] + m[3][3] - radius * w_scale;
+
+	if (0.f >= w_near)
+		return 0;
+
+	const float y_scale = sqrtf(m[0][1] * m[0][1] + m[1][1] * m[1][1] + m[2][1] * m[2][1]);
+	const float pixels_per_unit = .5f * viewport_height * y_scale / w_near;
+
+	unsigned lod = 0;
+
+	while (lod < chain.num_levels && chain.level[lod].error * pixels_per_unit <= max_pixel_error)
+		++lod;
+
+	return lod;
+}
+
+} // namespace rend
@@ -0,0 +1,74 @@
+#ifndef rend_lod_H__
+#define rend_lod_H__
+
+#include <stdint.h>
+#include <vector>
+
+namespace rend
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// load-time LOD chain generation by quadric-error edge collapse: each level is an index list of
+// fewer faces over the original vertex buffer (collapses are half-edge, i.e. onto existing
+// vertices), along with its geometric error in object-space units; at draw time a level gets
+// selected by projecting that error through the mvp at the bounding sphere of the mesh
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct LodLevel
+{
+	std::vector< uint32_t > index;	// 32-bit trilist
+	float error;					// object-space deviation from the full-detail mesh
+};
+
+struct LodChain
+{
+	enum { max_levels = 4 };
+
+	unsigned num_levels;			// requested levels past the full-detail one
+	float ratio;					// target face ratio between consecutive levels
+	LodLevel level[max_levels];		// produced levels; num_levels gets updated to their count
+
+	LodChain(
+		const unsigned num_levels = 3,
+		const float ratio = .5f)
+	: num_levels(num_levels)
+	, ratio(ratio)
+	{}
+};
+
+// build the LOD levels of a trilist of 32-bit indices; vertices count as identical if all their
+// floats are identical, vertex positions being the first three floats; borders and seams are kept
+bool
+buildLodChain(
+	LodChain& chain,
+	const float* const vertex,
+	const unsigned floats_per_vertex,
+	const unsigned num_verts,
+	const uint32_t* const index,
+	const unsigned num_faces);
+
+// util::TrilistFilter-compatible LOD chain builder; ctx is a LodChain; leaves the trilist intact
+bool
+buildLodChainFilter(
+	void* const ctx,
+	const float* const vertex,
+	const unsigned floats_per_vertex,
+	const unsigned num_verts,
+	uint32_t* const index,
+	const unsigned num_faces);
+
+// select a LOD for a mesh of the specified object-space bounding sphere under the specified mvp
+// (16 floats, row-vector convention) and viewport height: the coarsest level whose projected
+// error stays within the specified pixels; return 0 for full detail, or 1 + index of LodLevel
+unsigned
+selectLod(
+	const LodChain& chain,
+	const float (& mvp)[16],
+	const float (& centre)[3],
+	const float radius,
+	const unsigned viewport_height,
+	const float max_pixel_error = 1.f);
+
+} // namespace rend
+
+#endif // rend_lod_H__
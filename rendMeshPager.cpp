@@ -0,0 +1,545 @@
+#if defined(PLATFORM_GL)
+	#include <GL/gl.h>
+	#include "gles_gl_mapping.hpp"
+#else
+	#include <GLES2/gl2.h>
+	#include <GLES2/gl2ext.h>
+	#include "gles_ext.h"
+#endif
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+#include "stream.hpp"
+#include "util_file.hpp"
+#include "rendMeshPager.hpp"
+
+namespace { // anonymous
+
+// importance of a visible chunk enclosing the eye
+const float importance_inside = 1e30f;
+
+// a slot of no chunk
+const uint32_t chunk_none = uint32_t(-1);
+
+size_t
+getChunkSize(
+	const uint32_t num_verts,
+	const uint32_t num_faces)
+{
+	return sizeof(int16_t[4]) * num_verts + sizeof(uint16_t[3]) * num_faces;
+}
+
+// read the full span or fail
+bool
+readFull(
+	const int fd,
+	void* const dst,
+	const size_t size,
+	const uint64_t offset)
+{
+	size_t done = 0;
+
+	while (done < size) {
+		const ssize_t res = pread(fd, reinterpret_cast< uint8_t* >(dst) + done, size - done, off_t(offset + done));
+
+		if (0 >= res)
+			return false;
+
+		done += size_t(res);
+	}
+
+	return true;
+}
+
+inline float
+dot3(
+	const float* const a,
+	const float* const b)
+{
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+struct ByImportance
+{
+	const float* importance;
+
+	bool operator()(
+		const uint32_t a,
+		const uint32_t b) const
+	{
+		return importance[a] > importance[b];
+	}
+};
+
+} // namespace
+
+namespace rend
+{
+
+MeshPager::MeshPager()
+: fd(-1)
+, fd_base(0)
+, frame(0)
+, num_staging(0)
+, reader_running(false)
+, reader_quit(false)
+{
+	memset(&header, 0, sizeof(header));
+	proxy_vbo[0] = proxy_vbo[1] = 0;
+
+	pthread_mutex_init(&mutex, 0);
+	pthread_cond_init(&cond, 0);
+}
+
+MeshPager::~MeshPager()
+{
+	stopReader();
+
+	if (-1 != fd)
+		::close(fd);
+
+	pthread_cond_destroy(&cond);
+	pthread_mutex_destroy(&mutex);
+}
+
+void
+MeshPager::stopReader()
+{
+	if (!reader_running)
+		return;
+
+	pthread_mutex_lock(&mutex);
+	reader_quit = true;
+	pthread_cond_signal(&cond);
+	pthread_mutex_unlock(&mutex);
+
+	pthread_join(reader, 0);
+	reader_running = false;
+}
+
+void*
+MeshPager::readerMain(
+	void* arg)
+{
+	reinterpret_cast< MeshPager* >(arg)->readerLoop();
+	return 0;
+}
+
+void
+MeshPager::readerLoop()
+{
+	pthread_mutex_lock(&mutex);
+
+	while (!reader_quit) {
+		Staging* stage = 0;
+
+		for (unsigned i = 0; i < num_staging && 0 == stage; ++i)
+			if (Staging::STATE_REQUESTED == staging[i].state)
+				stage = staging + i;
+
+		if (0 == stage) {
+			pthread_cond_wait(&cond, &mutex);
+			continue;
+		}
+
+		// requested stagings are the reader's; read without the lock
+		const PagedChunk& c = chunk[stage->chunk];
+		pthread_mutex_unlock(&mutex);
+
+		const bool success = readFull(fd, &stage->data.front(), getChunkSize(c.num_verts, c.num_faces), fd_base + c.offset);
+
+		pthread_mutex_lock(&mutex);
+		stage->state = success ? Staging::STATE_READY : Staging::STATE_FAILED;
+	}
+
+	pthread_mutex_unlock(&mutex);
+}
+
+bool
+MeshPager::open(
+	const char* const filename,
+	const unsigned pool_chunks,
+	const unsigned uploads_per_frame)
+{
+	assert(filename);
+	assert(-1 == fd);
+
+	// a packed mesh reads from the asset pack, at the offset of its entry
+	fd = util::open_file_fd(filename, fd_base);
+
+	if (-1 == fd) {
+		stream::cerr << __FUNCTION__ << " failed at open '" << filename << "'\n";
+		return false;
+	}
+
+	if (!readFull(fd, &header, sizeof(header), fd_base) ||
+		PagedMeshHeader::magic != header.file_magic ||
+		PagedMeshHeader::version != header.file_version ||
+		0 == header.num_chunks ||
+		0 == pool_chunks ||
+		uint32_t(1) + uint16_t(-1) < header.max_chunk_verts ||
+		uint32_t(1) + uint16_t(-1) < header.proxy_verts) {
+
+		stream::cerr << __FUNCTION__ << " encountered an invalid paged mesh '" << filename << "'\n";
+		return false;
+	}
+
+	chunk.resize(header.num_chunks);
+
+	if (!readFull(fd, &chunk.front(), sizeof(PagedChunk) * header.num_chunks, fd_base + sizeof(header))) {
+		stream::cerr << __FUNCTION__ << " failed reading chunk table of '" << filename << "'\n";
+		return false;
+	}
+
+	for (uint32_t i = 0; i < header.num_chunks; ++i)
+		if (chunk[i].num_verts > header.max_chunk_verts ||
+			chunk[i].num_faces > header.max_chunk_faces ||
+			uint64_t(chunk[i].proxy_first_face) + chunk[i].proxy_num_faces > header.proxy_faces) {
+
+			stream::cerr << __FUNCTION__ << " encountered an invalid chunk in '" << filename << "'\n";
+			return false;
+		}
+
+	importance.assign(header.num_chunks, 0.f);
+	resident.assign(header.num_chunks, 0);
+	last_seen.assign(header.num_chunks, 0);
+	order.reserve(header.num_chunks);
+	frame = 0;
+
+	// the proxy is resident throughout
+	glGenBuffers(2, proxy_vbo);
+
+	if (header.proxy_faces) {
+		std::vector< uint8_t > proxy(getChunkSize(header.proxy_verts, header.proxy_faces));
+
+		if (!readFull(fd, &proxy.front(), proxy.size(), fd_base + header.proxy_offset)) {
+			stream::cerr << __FUNCTION__ << " failed reading proxy of '" << filename << "'\n";
+			return false;
+		}
+
+		const size_t sizeof_vb = sizeof(int16_t[4]) * header.proxy_verts;
+
+		glBindBuffer(GL_ARRAY_BUFFER, proxy_vbo[0]);
+		glBufferData(GL_ARRAY_BUFFER, sizeof_vb, &proxy.front(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, proxy_vbo[1]);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, proxy.size() - sizeof_vb, &proxy.front() + sizeof_vb, GL_STATIC_DRAW);
+	}
+
+	// the pool gets allocated upfront, at the size of the largest chunk
+	slot.resize(pool_chunks);
+
+	for (unsigned i = 0; i < pool_chunks; ++i) {
+		glGenBuffers(2, slot[i].vbo);
+		slot[i].chunk = chunk_none;
+
+		glBindBuffer(GL_ARRAY_BUFFER, slot[i].vbo[0]);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(int16_t[4]) * header.max_chunk_verts, 0, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, slot[i].vbo[1]);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint16_t[3]) * header.max_chunk_faces, 0, GL_DYNAMIC_DRAW);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	num_staging = std::max(1U, std::min(uploads_per_frame, unsigned(max_staging)));
+
+	for (unsigned i = 0; i < num_staging; ++i) {
+		staging[i].data.resize(getChunkSize(header.max_chunk_verts, header.max_chunk_faces));
+		staging[i].state = Staging::STATE_FREE;
+	}
+
+	// should the reader fail to spawn, update reads in line
+	reader_quit = false;
+	reader_running = 0 == pthread_create(&reader, 0, readerMain, this);
+
+	stream::cout << "paged mesh chunks: " << header.num_chunks <<
+		"\npaged mesh pool: " << pool_chunks << " chunks of " <<
+		getChunkSize(header.max_chunk_verts, header.max_chunk_faces) << " bytes\n";
+
+	return true;
+}
+
+void
+MeshPager::close()
+{
+	stopReader();
+
+	for (size_t i = 0; i < slot.size(); ++i)
+		glDeleteBuffers(2, slot[i].vbo);
+
+	if (proxy_vbo[0])
+		glDeleteBuffers(2, proxy_vbo);
+
+	proxy_vbo[0] = proxy_vbo[1] = 0;
+
+	std::vector< Slot >().swap(slot);
+	std::vector< PagedChunk >().swap(chunk);
+	std::vector< float >().swap(importance);
+	std::vector< uint32_t >().swap(resident);
+	std::vector< uint32_t >().swap(last_seen);
+	std::vector< uint32_t >().swap(order);
+
+	for (unsigned i = 0; i < num_staging; ++i)
+		std::vector< uint8_t >().swap(staging[i].data);
+
+	num_staging = 0;
+
+	if (-1 != fd)
+		::close(fd);
+
+	fd = -1;
+	fd_base = 0;
+	memset(&header, 0, sizeof(header));
+}
+
+bool
+MeshPager::uploadChunk(
+	const Staging& stage)
+{
+	const uint32_t c = stage.chunk;
+
+	if (resident[c])
+		return true;
+
+	// victim: a free slot, or else the least important chunk, least recently seen among equals
+	unsigned victim = 0;
+
+	for (unsigned i = 0; i < slot.size(); ++i) {
+		if (chunk_none == slot[i].chunk) {
+			victim = i;
+			break;
+		}
+
+		const uint32_t a = slot[i].chunk;
+		const uint32_t b = slot[victim].chunk;
+
+		if (importance[a] < importance[b] ||
+			(importance[a] == importance[b] && last_seen[a] < last_seen[b]))
+			victim = i;
+	}
+
+	if (chunk_none != slot[victim].chunk) {
+		const uint32_t v = slot[victim].chunk;
+
+		// chunks that went out of sight since their request do not evict anything
+		if (importance[v] > importance[c] ||
+			(importance[v] == importance[c] && last_seen[v] >= last_seen[c]))
+			return false;
+
+		resident[v] = 0;
+	}
+
+	const size_t sizeof_vb = sizeof(int16_t[4]) * chunk[c].num_verts;
+	const size_t sizeof_ib = sizeof(uint16_t[3]) * chunk[c].num_faces;
+
+	glBindBuffer(GL_ARRAY_BUFFER, slot[victim].vbo[0]);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof_vb, &stage.data.front());
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, slot[victim].vbo[1]);
+	glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, sizeof_ib, &stage.data.front() + sizeof_vb);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	slot[victim].chunk = c;
+	resident[c] = victim + 1;
+
+	return true;
+}
+
+void
+MeshPager::update(
+	const float (& mvp)[16],
+	const unsigned viewport_height)
+{
+	if (chunk.empty())
+		return;
+
+	++frame;
+
+	/////////////////////////////////////////////////////////////////
+	// upload what the reader has read since the last update
+
+	for (unsigned i = 0; i < num_staging; ++i) {
+		pthread_mutex_lock(&mutex);
+		const Staging::State state = staging[i].state;
+		pthread_mutex_unlock(&mutex);
+
+		if (Staging::STATE_READY == state)
+			uploadChunk(staging[i]);
+		else
+		if (Staging::STATE_FAILED == state)
+			stream::cerr << __FUNCTION__ << " failed reading chunk " << staging[i].chunk << '\n';
+		else
+			continue;
+
+		pthread_mutex_lock(&mutex);
+		staging[i].state = Staging::STATE_FREE;
+		pthread_mutex_unlock(&mutex);
+	}
+
+	/////////////////////////////////////////////////////////////////
+	// prioritize: frustum-cull the chunk spheres, rank the rest by projected radius in pixels
+
+	const float (& m)[4][4] = reinterpret_cast< const float (&)[4][4] >(mvp);
+	float plane[6][4];
+
+	for (unsigned i = 0; i < 3; ++i)
+		for (unsigned j = 0; j < 4; ++j) {
+			plane[i * 2 + 0][j] = m[j][3] + m[j][i];
+			plane[i * 2 + 1][j] = m[j][3] - m[j][i];
+		}
+
+	for (unsigned i = 0; i < 6; ++i) {
+		const float len = sqrtf(dot3(plane[i], plane[i]));
+
+		if (0.f < len)
+			for (unsigned j = 0; j < 4; ++j)
+				plane[i][j] /= len;
+	}
+
+	const float w_col[3] = { m[0][3], m[1][3], m[2][3] };
+	const float y_col[3] = { m[0][1], m[1][1], m[2][1] };
+	const float w_scale = sqrtf(dot3(w_col, w_col));
+	const float pixels_scale = .5f * viewport_height * sqrtf(dot3(y_col, y_col));
+
+	for (uint32_t i = 0; i < chunk.size(); ++i) {
+		const PagedChunk& c = chunk[i];
+		bool visible = true;
+
+		for (unsigned j = 0; j < 6 && visible; ++j)
+			visible = dot3(plane[j], c.centre) + plane[j][3] >= -c.radius;
+
+		if (!visible) {
+			importance[i] = 0.f;
+			continue;
+		}
+
+		const float w_near = dot3(w_col, c.centre) + m[3][3] - c.radius * w_scale;
+
+		importance[i] = 0.f < w_near ? pixels_scale * c.radius / w_near : importance_inside;
+		last_seen[i] = frame;
+	}
+
+	/////////////////////////////////////////////////////////////////
+	// request the most important visible chunks that are neither resident nor in flight
+
+	pthread_mutex_lock(&mutex);
+
+	order.clear();
+
+	for (uint32_t i = 0; i < chunk.size(); ++i)
+		if (0.f < importance[i] && 0 == resident[i])
+			order.push_back(i);
+
+	for (unsigned i = 0; i < num_staging; ++i)
+		if (Staging::STATE_FREE != staging[i].state)
+			order.erase(std::remove(order.begin(), order.end(), staging[i].chunk), order.end());
+
+	unsigned num_free = 0;
+
+	for (unsigned i = 0; i < num_staging; ++i)
+		num_free += Staging::STATE_FREE == staging[i].state;
+
+	const ByImportance by_importance = { &importance.front() };
+	const size_t num_requests = std::min(size_t(num_free), order.size());
+	std::partial_sort(order.begin(), order.begin() + num_requests, order.end(), by_importance);
+
+	// requests that would not evict anything are not worth the reading
+	float least_resident = importance_inside;
+	unsigned num_empty = 0;
+
+	for (size_t i = 0; i < slot.size(); ++i)
+		if (chunk_none == slot[i].chunk)
+			++num_empty;
+		else
+			least_resident = std::min(least_resident, importance[slot[i].chunk]);
+
+	for (size_t i = 0, j = 0; i < num_requests; ++i) {
+		if (0 == num_empty && importance[order[i]] <= least_resident)
+			break;
+
+		if (num_empty)
+			--num_empty;
+
+		while (Staging::STATE_FREE != staging[j].state)
+			++j;
+
+		staging[j].chunk = order[i];
+		staging[j].state = Staging::STATE_REQUESTED;
+	}
+
+	pthread_cond_signal(&cond);
+	pthread_mutex_unlock(&mutex);
+
+	if (reader_running)
+		return;
+
+	// no reader -- read in line
+	for (unsigned i = 0; i < num_staging; ++i) {
+		if (Staging::STATE_REQUESTED != staging[i].state)
+			continue;
+
+		const PagedChunk& c = chunk[staging[i].chunk];
+		staging[i].state = readFull(fd, &staging[i].data.front(), getChunkSize(c.num_verts, c.num_faces), fd_base + c.offset) ?
+			Staging::STATE_READY : Staging::STATE_FAILED;
+	}
+}
+
+unsigned
+MeshPager::getDraws(
+	PagedDraw* const out) const
+{
+	assert(out || chunk.empty());
+
+	unsigned num_draws = 0;
+
+	for (uint32_t i = 0; i < chunk.size(); ++i) {
+		if (0.f == importance[i])
+			continue;
+
+		if (resident[i]) {
+			const Slot& s = slot[resident[i] - 1];
+			const PagedDraw draw = { s.vbo[0], s.vbo[1], 0, chunk[i].num_faces };
+			out[num_draws++] = draw;
+			continue;
+		}
+
+		if (0 == chunk[i].proxy_num_faces)
+			continue;
+
+		// adjacent proxy ranges merge
+		if (num_draws &&
+			out[num_draws - 1].vbo_vtx == proxy_vbo[0] &&
+			out[num_draws - 1].first_face + out[num_draws - 1].num_faces == chunk[i].proxy_first_face) {
+
+			out[num_draws - 1].num_faces += chunk[i].proxy_num_faces;
+			continue;
+		}
+
+		const PagedDraw draw = { proxy_vbo[0], proxy_vbo[1], chunk[i].proxy_first_face, chunk[i].proxy_num_faces };
+		out[num_draws++] = draw;
+	}
+
+	return num_draws;
+}
+
+unsigned
+MeshPager::getNumResident() const
+{
+	unsigned count = 0;
+
+	for (size_t i = 0; i < slot.size(); ++i)
+		count += chunk_none != slot[i].chunk;
+
+	return count;
+}
+
+} // namespace rend
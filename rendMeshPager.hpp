@@ -0,0 +1,162 @@
+#ifndef rend_mesh_pager_H__
+#define rend_mesh_pager_H__
+
+#include <stdint.h>
+#include <pthread.h>
+#include <vector>
+
+namespace rend
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// out-of-core mesh paging: a paged mesh is pre-split into spatial chunks of 16-bit indices, plus a
+// coarse proxy of the entire mesh; at draw time chunks get prioritized by visibility and projected
+// size, and streamed in by a reader thread through a fixed pool of GL buffers, evicting the least
+// important ones; chunks not resident get drawn by their share of the always-resident proxy.
+// Memory stays bounded by the pool, and upload work per frame by the number of staging buffers.
+//
+// paged-file layout (all positions snorm16 x 4 in the isotropic quantization domain of the mesh):
+//
+//	PagedMeshHeader
+//	PagedChunk      chunk[num_chunks]
+//	chunk data      per chunk: int16_t vertex[num_verts][4], uint16_t index[num_faces][3], 4-aligned
+//	proxy data      int16_t vertex[proxy_verts][4], uint16_t index[proxy_faces][3]
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct PagedMeshHeader
+{
+	enum {
+		magic = 0x6761706d, // 'mpag'
+		version = 100
+	};
+
+	uint32_t file_magic;
+	uint32_t file_version;
+	float vmin[3];				// bounding box of the entire mesh, i.e. the quantization domain
+	float vmax[3];
+	uint32_t num_chunks;
+	uint32_t max_chunk_verts;	// size of the largest chunk, for sizing of the buffer pool
+	uint32_t max_chunk_faces;
+	uint32_t proxy_verts;
+	uint32_t proxy_faces;
+	uint32_t pad;
+	uint64_t proxy_offset;		// file offset of the proxy data
+};
+
+struct PagedChunk
+{
+	float centre[3];			// object-space bounding sphere
+	float radius;
+	uint64_t offset;			// file offset of the chunk data
+	uint32_t num_verts;
+	uint32_t num_faces;
+	uint32_t proxy_first_face;	// faces of the proxy that stand in for the chunk
+	uint32_t proxy_num_faces;
+};
+
+// a draw call of the pager: the buffers to bind and the face range of the element buffer
+struct PagedDraw
+{
+	unsigned vbo_vtx;
+	unsigned vbo_idx;
+	uint32_t first_face;
+	uint32_t num_faces;
+};
+
+class MeshPager
+{
+	enum {
+		max_staging = 4
+	};
+
+	// pool slot, i.e. a pair of GL buffers holding one chunk
+	struct Slot
+	{
+		unsigned vbo[2];
+		uint32_t chunk;
+	};
+
+	// staging buffer of the reader thread
+	struct Staging
+	{
+		enum State {
+			STATE_FREE,
+			STATE_REQUESTED,	// owned by the reader
+			STATE_READY,		// read, awaiting upload
+			STATE_FAILED,
+
+			STATE_FORCE_UINT = -1U
+		};
+
+		std::vector< uint8_t > data;
+		uint32_t chunk;
+		State state;
+	};
+
+	int fd;
+	uint64_t fd_base;	// offset of the mesh in the file, as per the asset pack
+	PagedMeshHeader header;
+	std::vector< PagedChunk > chunk;
+	std::vector< float > importance;	// per chunk, of the latest update; zero for culled chunks
+	std::vector< uint32_t > resident;	// per chunk, 1 + slot index, or 0
+	std::vector< uint32_t > last_seen;	// per chunk, frame of latest visibility
+	std::vector< uint32_t > order;		// chunks by descending importance, scratch
+	std::vector< Slot > slot;
+	unsigned proxy_vbo[2];
+	uint32_t frame;
+
+	Staging staging[max_staging];
+	unsigned num_staging;
+	pthread_t reader;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	bool reader_running;
+	bool reader_quit;
+
+	MeshPager(const MeshPager&);
+	MeshPager& operator =(const MeshPager&);
+
+	static void* readerMain(void* arg);
+	void readerLoop();
+	void stopReader();
+
+	bool uploadChunk(const Staging& stage);
+
+public:
+	MeshPager();
+	~MeshPager();
+
+	// open a paged mesh, with a pool of the specified number of chunks and up to the specified
+	// number of chunk uploads per frame; requires a current GL context
+	bool open(
+		const char* const filename,
+		const unsigned pool_chunks,
+		const unsigned uploads_per_frame = 2);
+
+	// release the mesh and its GL buffers; requires a current GL context
+	void close();
+
+	const PagedMeshHeader& getHeader() const {
+		return header;
+	}
+
+	// prioritize chunks for the specified mvp (16 floats, row-vector convention, object space)
+	// and viewport height, upload chunks read since the last update, and request the reading of
+	// the most important chunks not yet resident
+	void update(
+		const float (& mvp)[16],
+		const unsigned viewport_height);
+
+	// produce the draw calls for the visible chunks as of the latest update, resident chunks from
+	// the pool and the rest from the proxy; out has room for num_chunks draws; return number of
+	// draws
+	unsigned getDraws(
+		PagedDraw* const out) const;
+
+	// number of resident chunks
+	unsigned getNumResident() const;
+};
+
+} // namespace rend
+
+#endif // rend_mesh_pager_H__
@@ -5,6 +5,7 @@
 
 #include "scoped.hpp"
 #include "stream.hpp"
+#include "util_file.hpp"
 #include "vectsimd.hpp"
 #include "rendSkeleton.hpp"
 
@@ -327,7 +328,7 @@ loadSkeletonAnimationABE(
 	assert(bone_mat);
 	assert(bone);
 
-	scoped_ptr< FILE, scoped_functor > file(fopen(filename, "rb"));
+	scoped_ptr< FILE, scoped_functor > file(util::open_file(filename));
 
 	if (0 == file()) {
 		stream::cerr << __FUNCTION__ << " failed to open " << filename << '\n';
@@ -973,10 +974,10 @@ loadSkeletonAnimationOgre(
 	assert(bone_mat);
 	assert(bone);
 
-	scoped_ptr< FILE, scoped_functor > file(fopen(filename, "rb"));
+	scoped_ptr< FILE, scoped_functor > file(util::open_file(filename));
 
 	if (0 == file()) {
-		fprintf(stderr, "%s failed at fopen\n", __FUNCTION__);
+		fprintf(stderr, "%s failed at open_file\n", __FUNCTION__);
 		return false;
 	}
 
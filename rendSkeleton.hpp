@@ -321,6 +321,18 @@ loadSkeletonAnimationOgre(
 	std::vector< std::vector< Track > >& animations,
 	std::vector< float >& durations);
 
+
+// binary glTF 2.0 (.glb) skeleton: the joints of the first skin, parents first, in their rest
+// pose; animation channels targeting the joints become tracks, of duration the latest key
+bool
+loadSkeletonAnimationGLB(
+	const char* const filename,
+	unsigned* count,
+	dense_matx4* bone_mat,
+	Bone* bone,
+	std::vector< std::vector< Track > >& animations,
+	std::vector< float >& durations);
+
 } // namespace rend
 
 #endif // rend_skeleton_H__
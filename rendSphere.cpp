@@ -0,0 +1,603 @@
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <cmath>
+#include <map>
+#include <vector>
+#include <algorithm>
+
+#include "stream.hpp"
+#include "rendSphere.hpp"
+
+namespace { // anonymous
+
+const float pi = 3.14159265358979f;
+
+// polar sphere of 4 << lod rows of faces and 8 << lod columns, laid out as by the original polar
+// generators: per-column north-pole vertices, interior rows with a seam column, per-column
+// south-pole vertices
+void createPolar(
+	const unsigned lod,
+	const float tile_u,
+	const float tile_v,
+	std::vector< rend::SphereVertex >& vertex,
+	std::vector< uint32_t >& index)
+{
+	const unsigned rows = (4 << lod) + 1;
+	const unsigned cols = (8 << lod) + 1;
+
+	// trig of every column and row, once
+	std::vector< float > azim(cols);
+	std::vector< float > decl(rows);
+
+	for (unsigned j = 0; j < cols; ++j)
+		azim[j] = j * 2.f * pi / (cols - 1);
+
+	for (unsigned i = 0; i < rows; ++i)
+		decl[i] = .5f * pi - i * pi / (rows - 1);
+
+	std::vector< float > sin_azim(cols), cos_azim(cols);
+	std::vector< float > sin_decl(rows), cos_decl(rows);
+
+	rend::sincos(&azim.front(), &sin_azim.front(), &cos_azim.front(), cols);
+	rend::sincos(&decl.front(), &sin_decl.front(), &cos_decl.front(), rows);
+
+	vertex.resize((rows - 2) * cols + 2 * (cols - 1));
+	size_t ai = 0;
+
+	// north pole
+	for (unsigned j = 0; j < cols - 1; ++j, ++ai) {
+		rend::SphereVertex& v = vertex[ai];
+		v.pos[0] = 0.f;
+		v.pos[1] = 0.f;
+		v.pos[2] = 1.f;
+		v.tan[0] = -sin_azim[j];
+		v.tan[1] = cos_azim[j];
+		v.tan[2] = 0.f;
+		v.txc[0] = tile_u * (j + .5f) / (cols - 1);
+		v.txc[1] = tile_v;
+	}
+
+	// interior
+	for (unsigned i = 1; i < rows - 1; ++i)
+		for (unsigned j = 0; j < cols; ++j, ++ai) {
+			rend::SphereVertex& v = vertex[ai];
+			v.pos[0] = cos_decl[i] * cos_azim[j];
+			v.pos[1] = cos_decl[i] * sin_azim[j];
+			v.pos[2] = sin_decl[i];
+			v.tan[0] = -sin_azim[j];
+			v.tan[1] = cos_azim[j];
+			v.tan[2] = 0.f;
+			v.txc[0] = tile_u * j / (cols - 1);
+			v.txc[1] = tile_v * (rows - 1 - i) / (rows - 1);
+		}
+
+	// south pole
+	for (unsigned j = 0; j < cols - 1; ++j, ++ai) {
+		rend::SphereVertex& v = vertex[ai];
+		v.pos[0] = 0.f;
+		v.pos[1] = 0.f;
+		v.pos[2] = -1.f;
+		v.tan[0] = -sin_azim[j];
+		v.tan[1] = cos_azim[j];
+		v.tan[2] = 0.f;
+		v.txc[0] = tile_u * (j + .5f) / (cols - 1);
+		v.txc[1] = 0.f;
+	}
+
+	assert(ai == vertex.size());
+	index.clear();
+	index.reserve(((rows - 3) * 2 + 2) * (cols - 1) * 3);
+
+	// north pole
+	for (unsigned j = 0; j < cols - 1; ++j) {
+		index.push_back(j);
+		index.push_back(j + cols - 1);
+		index.push_back(j + cols);
+	}
+
+	// interior
+	for (unsigned i = 1; i < rows - 2; ++i)
+		for (unsigned j = 0; j < cols - 1; ++j) {
+			index.push_back(j + i * cols);
+			index.push_back(j + i * cols - 1);
+			index.push_back(j + (i + 1) * cols);
+
+			index.push_back(j + (i + 1) * cols - 1);
+			index.push_back(j + (i + 1) * cols);
+			index.push_back(j + i * cols - 1);
+		}
+
+	// south pole
+	for (unsigned j = 0; j < cols - 1; ++j) {
+		index.push_back(j + (rows - 2) * cols);
+		index.push_back(j + (rows - 2) * cols - 1);
+		index.push_back(j + (rows - 2) * cols + cols - 1);
+	}
+}
+
+// cube sphere of (2 << lod)^2 quads per side; lattice points of the cube surface get mapped onto
+// the sphere by x' = x * sqrt(1 - y^2 / 2 - z^2 / 2 + y^2 * z^2 / 3) et al., which keeps the
+// sphere-side cells close to uniform
+void createCube(
+	const unsigned lod,
+	std::vector< float >& pos,
+	std::vector< uint32_t >& index)
+{
+	const unsigned n = 2 << lod;
+	const unsigned m = n + 1;
+
+	// per side: origin and u, v steps in the lattice, u x v pointing outwards
+	static const int side[6][3][3] = {
+		{ { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } }, // +x
+		{ { 0, 0, 0 }, { 0, 0, 1 }, { 0, 1, 0 } }, // -x
+		{ { 0, 1, 0 }, { 0, 0, 1 }, { 1, 0, 0 } }, // +y
+		{ { 0, 0, 0 }, { 1, 0, 0 }, { 0, 0, 1 } }, // -y
+		{ { 0, 0, 1 }, { 1, 0, 0 }, { 0, 1, 0 } }, // +z
+		{ { 0, 0, 0 }, { 0, 1, 0 }, { 1, 0, 0 } }  // -z
+	};
+
+	// lattice points shared by adjacent sides get welded
+	std::vector< uint32_t > lattice(m * m * m, uint32_t(-1));
+	std::vector< uint32_t > grid(m * m);
+
+	pos.clear();
+	index.clear();
+
+	for (unsigned s = 0; s < 6; ++s) {
+		for (unsigned iv = 0; iv < m; ++iv)
+			for (unsigned iu = 0; iu < m; ++iu) {
+				unsigned p[3];
+
+				for (unsigned a = 0; a < 3; ++a)
+					p[a] = side[s][0][a] * n + side[s][1][a] * iu + side[s][2][a] * iv;
+
+				uint32_t& idx = lattice[(p[0] * m + p[1]) * m + p[2]];
+
+				if (uint32_t(-1) == idx) {
+					idx = uint32_t(pos.size() / 3);
+
+					const float x = 2.f * p[0] / n - 1.f;
+					const float y = 2.f * p[1] / n - 1.f;
+					const float z = 2.f * p[2] / n - 1.f;
+
+					pos.push_back(x * sqrtf(1.f - y * y * .5f - z * z * .5f + y * y * z * z * (1.f / 3.f)));
+					pos.push_back(y * sqrtf(1.f - z * z * .5f - x * x * .5f + z * z * x * x * (1.f / 3.f)));
+					pos.push_back(z * sqrtf(1.f - x * x * .5f - y * y * .5f + x * x * y * y * (1.f / 3.f)));
+				}
+
+				grid[iv * m + iu] = idx;
+			}
+
+		for (unsigned iv = 0; iv < n; ++iv)
+			for (unsigned iu = 0; iu < n; ++iu) {
+				const uint32_t a = grid[iv * m + iu];
+				const uint32_t b = grid[iv * m + iu + 1];
+				const uint32_t c = grid[(iv + 1) * m + iu + 1];
+				const uint32_t d = grid[(iv + 1) * m + iu];
+
+				index.push_back(a);
+				index.push_back(b);
+				index.push_back(c);
+
+				index.push_back(a);
+				index.push_back(c);
+				index.push_back(d);
+			}
+	}
+}
+
+// icosphere of the specified number of subdivisions of an icosahedron
+void createIco(
+	const unsigned lod,
+	std::vector< float >& pos,
+	std::vector< uint32_t >& index)
+{
+	const float t = (1.f + sqrtf(5.f)) * .5f;
+	const float base_pos[12][3] = {
+		{ -1.f,  t,   0.f }, {  1.f,  t,   0.f }, { -1.f, -t,   0.f }, {  1.f, -t,   0.f },
+		{  0.f, -1.f, t   }, {  0.f,  1.f, t   }, {  0.f, -1.f, -t  }, {  0.f,  1.f, -t  },
+		{  t,   0.f, -1.f }, {  t,   0.f,  1.f }, { -t,   0.f, -1.f }, { -t,   0.f,  1.f }
+	};
+	static const uint32_t base_index[20][3] = {
+		{ 0, 11, 5 }, { 0, 5, 1 }, { 0, 1, 7 }, { 0, 7, 10 }, { 0, 10, 11 },
+		{ 1, 5, 9 }, { 5, 11, 4 }, { 11, 10, 2 }, { 10, 7, 6 }, { 7, 1, 8 },
+		{ 3, 9, 4 }, { 3, 4, 2 }, { 3, 2, 6 }, { 3, 6, 8 }, { 3, 8, 9 },
+		{ 4, 9, 5 }, { 2, 4, 11 }, { 6, 2, 10 }, { 8, 6, 7 }, { 9, 8, 1 }
+	};
+
+	const float rcp_len = 1.f / sqrtf(1.f + t * t);
+	pos.clear();
+
+	for (unsigned i = 0; i < 12; ++i)
+		for (unsigned a = 0; a < 3; ++a)
+			pos.push_back(base_pos[i][a] * rcp_len);
+
+	index.assign(&base_index[0][0], &base_index[0][0] + sizeof(base_index) / sizeof(base_index[0][0]));
+
+	for (unsigned l = 0; l < lod; ++l) {
+		std::map< uint64_t, uint32_t > midpoint;
+		std::vector< uint32_t > next;
+		next.reserve(index.size() * 4);
+
+		for (size_t i = 0; i < index.size(); i += 3) {
+			uint32_t mid[3];
+
+			for (unsigned e = 0; e < 3; ++e) {
+				const uint32_t a = index[i + e];
+				const uint32_t b = index[i + (e + 1) % 3];
+				const uint64_t key = a < b ? uint64_t(a) << 32 | b : uint64_t(b) << 32 | a;
+				const std::map< uint64_t, uint32_t >::const_iterator it = midpoint.find(key);
+
+				if (midpoint.end() != it) {
+					mid[e] = it->second;
+					continue;
+				}
+
+				const float p[3] = {
+					pos[a * 3 + 0] + pos[b * 3 + 0],
+					pos[a * 3 + 1] + pos[b * 3 + 1],
+					pos[a * 3 + 2] + pos[b * 3 + 2]
+				};
+				const float rcp = 1.f / sqrtf(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+
+				mid[e] = uint32_t(pos.size() / 3);
+				midpoint[key] = mid[e];
+
+				pos.push_back(p[0] * rcp);
+				pos.push_back(p[1] * rcp);
+				pos.push_back(p[2] * rcp);
+			}
+
+			const uint32_t sub[4][3] = {
+				{ index[i + 0], mid[0], mid[2] },
+				{ index[i + 1], mid[1], mid[0] },
+				{ index[i + 2], mid[2], mid[1] },
+				{ mid[0], mid[1], mid[2] }
+			};
+
+			next.insert(next.end(), &sub[0][0], &sub[0][0] + 12);
+		}
+
+		index.swap(next);
+	}
+}
+
+// polar tcoords and tangents for a sphere of arbitrary topology: faces straddling the u seam get
+// their low-u vertices duplicated at u + 1, and every face at a pole gets its own pole vertex, at
+// the mean u of the other two
+void mapPolar(
+	const std::vector< float >& pos,
+	std::vector< uint32_t >& index,
+	const float tile_u,
+	const float tile_v,
+	std::vector< rend::SphereVertex >& vertex)
+{
+	const size_t n = pos.size() / 3;
+	std::vector< float > x(n), y(n), z(n), r(n), u(n), v(n);
+
+	for (size_t i = 0; i < n; ++i) {
+		x[i] = pos[i * 3 + 0];
+		y[i] = pos[i * 3 + 1];
+		z[i] = pos[i * 3 + 2];
+		r[i] = sqrtf(x[i] * x[i] + y[i] * y[i]);
+	}
+
+	rend::atan2(&y.front(), &x.front(), &u.front(), n);
+	rend::atan2(&z.front(), &r.front(), &v.front(), n);
+
+	const float pole_eps = 1e-6f;
+	vertex.resize(n);
+
+	for (size_t i = 0; i < n; ++i) {
+		u[i] = u[i] * (.5f / pi);
+		u[i] = 0.f > u[i] ? u[i] + 1.f : u[i];
+		v[i] = v[i] * (1.f / pi) + .5f;
+
+		const float rcp_r = pole_eps < r[i] ? 1.f / r[i] : 0.f;
+
+		rend::SphereVertex& vtx = vertex[i];
+		vtx.pos[0] = x[i];
+		vtx.pos[1] = y[i];
+		vtx.pos[2] = z[i];
+		vtx.tan[0] = -y[i] * rcp_r;
+		vtx.tan[1] = x[i] * rcp_r;
+		vtx.tan[2] = 0.f;
+		vtx.txc[0] = tile_u * u[i];
+		vtx.txc[1] = tile_v * v[i];
+	}
+
+	std::vector< uint32_t > wrapped(n, uint32_t(-1));
+
+	for (size_t i = 0; i < index.size(); i += 3) {
+		float umin = 1.f;
+		float umax = 0.f;
+
+		for (unsigned c = 0; c < 3; ++c) {
+			const uint32_t idx = index[i + c];
+
+			if (pole_eps < r[idx]) {
+				umin = std::min(umin, u[idx]);
+				umax = std::max(umax, u[idx]);
+			}
+		}
+
+		const bool wrap = umax - umin > .5f;
+		float face_u[3];
+		float usum = 0.f;
+		unsigned ucount = 0;
+
+		for (unsigned c = 0; c < 3; ++c) {
+			const uint32_t idx = index[i + c];
+			face_u[c] = u[idx];
+
+			if (pole_eps >= r[idx])
+				continue;
+
+			if (wrap && .5f > u[idx]) {
+				if (uint32_t(-1) == wrapped[idx]) {
+					rend::SphereVertex dup = vertex[idx];
+					dup.txc[0] = tile_u * (u[idx] + 1.f);
+
+					wrapped[idx] = uint32_t(vertex.size());
+					vertex.push_back(dup);
+				}
+
+				index[i + c] = wrapped[idx];
+				face_u[c] += 1.f;
+			}
+
+			usum += face_u[c];
+			++ucount;
+		}
+
+		for (unsigned c = 0; c < 3; ++c) {
+			const uint32_t idx = index[i + c];
+
+			if (idx >= n || pole_eps < r[idx])
+				continue;
+
+			const float pole_u = ucount ? usum / ucount : 0.f;
+			const float pole_azim = pole_u * 2.f * pi;
+			float sin_azim, cos_azim;
+			rend::sincos(&pole_azim, &sin_azim, &cos_azim, 1);
+
+			rend::SphereVertex dup = vertex[idx];
+			dup.tan[0] = -sin_azim;
+			dup.tan[1] = cos_azim;
+			dup.txc[0] = tile_u * pole_u;
+
+			index[i + c] = uint32_t(vertex.size());
+			vertex.push_back(dup);
+		}
+	}
+}
+
+} // namespace
+
+namespace rend
+{
+
+void
+sincos(
+	const float* const angle,
+	float* const sin_out,
+	float* const cos_out,
+	const size_t n)
+{
+	// Cody-Waite reduction to [-pi/4, pi/4] by the nearest quadrant
+	const float two_over_pi = .636619772f;
+	const float pio2_hi = 1.5703125f;
+	const float pio2_mid = 4.83751296997e-4f;
+	const float pio2_lo = 7.54978995489e-8f;
+
+	for (size_t i = 0; i < n; ++i) {
+		const float a = angle[i];
+		const float j = floorf(a * two_over_pi + .5f);
+		const int q = int(j);
+		const float x = ((a - j * pio2_hi) - j * pio2_mid) - j * pio2_lo;
+		const float x2 = x * x;
+
+		const float s = x + x * x2 * (-1.6666654611e-1f + x2 * (8.3321608736e-3f + x2 * -1.9515295891e-4f));
+		const float c = 1.f - .5f * x2 + x2 * x2 * (4.166664568e-2f + x2 * (-1.388731625e-3f + x2 * 2.443315711e-5f));
+
+		// sin(x + q pi/2), cos(x + q pi/2)
+		const float ss = q & 1 ? c : s;
+		const float cc = q & 1 ? s : c;
+
+		sin_out[i] = q & 2 ? -ss : ss;
+		cos_out[i] = ((q + 1) & 2) ? -cc : cc;
+	}
+}
+
+void
+atan2(
+	const float* const y,
+	const float* const x,
+	float* const out,
+	const size_t n)
+{
+	for (size_t i = 0; i < n; ++i) {
+		const float ax = fabsf(x[i]);
+		const float ay = fabsf(y[i]);
+		const float mx = std::max(ax, ay);
+		const float mn = std::min(ax, ay);
+		const float t = 0.f < mx ? mn / mx : 0.f;
+		const float t2 = t * t;
+
+		// atan on [0, 1]
+		float r = t * (.99997726f + t2 * (-.33262347f + t2 * (.19354346f + t2 * (-.11643287f + t2 * (.05265332f + t2 * -.01172120f)))));
+
+		r = ay > ax ? .5f * pi - r : r;
+		r = 0.f > x[i] ? pi - r : r;
+		out[i] = copysignf(r, y[i]);
+	}
+}
+
+void
+optimizeVertexCache(
+	uint16_t* const index,
+	const size_t num_faces,
+	const size_t num_verts,
+	const unsigned cache_size)
+{
+	// vertex-to-face adjacency
+	std::vector< uint32_t > live(num_verts, 0);
+
+	for (size_t i = 0; i < num_faces * 3; ++i)
+		++live[index[i]];
+
+	std::vector< uint32_t > offset(num_verts + 1, 0);
+
+	for (size_t i = 0; i < num_verts; ++i)
+		offset[i + 1] = offset[i] + live[i];
+
+	std::vector< uint32_t > adj(num_faces * 3);
+	std::vector< uint32_t > fill(offset.begin(), offset.end() - 1);
+
+	for (size_t i = 0; i < num_faces * 3; ++i)
+		adj[fill[index[i]]++] = uint32_t(i / 3);
+
+	std::vector< uint32_t > cache_time(num_verts, 0);
+	std::vector< bool > emitted(num_faces, false);
+	std::vector< uint32_t > dead_end;
+	std::vector< uint32_t > candidate;
+	std::vector< uint16_t > out;
+	dead_end.reserve(num_faces * 3);
+	out.reserve(num_faces * 3);
+
+	uint32_t time = cache_size + 1;
+	size_t cursor = 0;
+	size_t fanning = num_faces ? index[0] : size_t(-1);
+
+	while (size_t(-1) != fanning) {
+		candidate.clear();
+
+		// emit the remaining faces of the fanning vertex
+		for (uint32_t k = offset[fanning]; k < offset[fanning + 1]; ++k) {
+			const uint32_t f = adj[k];
+
+			if (emitted[f])
+				continue;
+
+			for (unsigned c = 0; c < 3; ++c) {
+				const uint16_t v = index[f * 3 + c];
+
+				out.push_back(v);
+				dead_end.push_back(v);
+				candidate.push_back(v);
+				--live[v];
+
+				if (time - cache_time[v] > cache_size)
+					cache_time[v] = time++;
+			}
+
+			emitted[f] = true;
+		}
+
+		// next fanning vertex: the oldest candidate still in the cache after emitting its faces
+		fanning = size_t(-1);
+		int best = -1;
+
+		for (std::vector< uint32_t >::const_iterator it = candidate.begin(); it != candidate.end(); ++it) {
+			if (0 == live[*it])
+				continue;
+
+			int priority = 0;
+
+			if (time - cache_time[*it] + 2 * live[*it] <= cache_size)
+				priority = int(time - cache_time[*it]);
+
+			if (priority > best) {
+				best = priority;
+				fanning = *it;
+			}
+		}
+
+		// else the most recent dead-end vertex of live faces, else the next one in order
+		while (size_t(-1) == fanning && !dead_end.empty()) {
+			const uint32_t v = dead_end.back();
+			dead_end.pop_back();
+
+			if (live[v])
+				fanning = v;
+		}
+
+		for (; size_t(-1) == fanning && cursor < num_verts; ++cursor)
+			if (live[cursor])
+				fanning = cursor;
+	}
+
+	assert(out.size() == num_faces * 3);
+
+	if (num_faces)
+		memcpy(index, &out.front(), sizeof(index[0]) * out.size());
+}
+
+bool
+createSphere(
+	const SphereTopology topology,
+	const unsigned lod,
+	const float tile_u,
+	const float tile_v,
+	std::vector< SphereVertex >& vertex,
+	std::vector< uint16_t >& index)
+{
+	std::vector< uint32_t > index32;
+
+	switch (topology) {
+	case SPHERE_POLAR:
+		if (lod > 4)
+			break;
+
+		createPolar(lod, tile_u, tile_v, vertex, index32);
+		break;
+
+	case SPHERE_CUBE:
+	case SPHERE_ICO:
+		if (lod > 6)
+			break;
+
+		{
+			std::vector< float > pos;
+
+			if (SPHERE_CUBE == topology)
+				createCube(lod, pos, index32);
+			else
+				createIco(lod, pos, index32);
+
+			mapPolar(pos, index32, tile_u, tile_v, vertex);
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	if (index32.empty() || vertex.size() > 65536) {
+		stream::cerr << __FUNCTION__ << " encountered unsupported topology or LOD\n";
+		return false;
+	}
+
+	index.assign(index32.begin(), index32.end());
+	optimizeVertexCache(&index.front(), index.size() / 3, vertex.size());
+
+	// vertices by first use
+	std::vector< uint32_t > remap(vertex.size(), uint32_t(-1));
+	std::vector< SphereVertex > ordered;
+	ordered.reserve(vertex.size());
+
+	for (std::vector< uint16_t >::iterator it = index.begin(); it != index.end(); ++it) {
+		if (uint32_t(-1) == remap[*it]) {
+			remap[*it] = uint32_t(ordered.size());
+			ordered.push_back(vertex[*it]);
+		}
+
+		*it = uint16_t(remap[*it]);
+	}
+
+	vertex.swap(ordered);
+	return true;
+}
+
+} // namespace rend
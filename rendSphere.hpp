@@ -0,0 +1,79 @@
+#ifndef rend_sphere_H__
+#define rend_sphere_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace rend
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// procedural unit spheres of polar (UV), cube-sphere or icosphere topology: the latter two spread
+// their vertices evenly, so they match the silhouette of a polar sphere at a fraction of its
+// vertices, sans the sliver triangles at the poles. All topologies get polar tcoords, i.e. u along
+// the azimuth and v along the declination, and tangents along u; vertices at the u seam and at the
+// poles get duplicated as needed. Faces come ordered for the post-transform vertex cache, vertices
+// by first use.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+enum SphereTopology {
+	SPHERE_POLAR,
+	SPHERE_CUBE,
+	SPHERE_ICO,
+
+	SPHERE_TOPOLOGY_COUNT,
+	SPHERE_TOPOLOGY_FORCE_UINT = -1U
+};
+
+// vertex of a unit sphere; the normal equals the position
+struct SphereVertex
+{
+	float pos[3];
+	float tan[3];
+	float txc[2];
+};
+
+// produce a unit sphere of the specified topology and LOD, a trilist of CCW faces facing outwards;
+// LOD 0 is the coarsest -- an octagonal-equator polar sphere, a cube of 2x2 quads per side, or an
+// icosahedron -- every next LOD doubles the edge resolution; tcoords span [0, tile_u] x [0, tile_v],
+// v growing north; return false if the result exceeds 16-bit indexing
+bool
+createSphere(
+	const SphereTopology topology,
+	const unsigned lod,
+	const float tile_u,
+	const float tile_v,
+	std::vector< SphereVertex >& vertex,
+	std::vector< uint16_t >& index);
+
+// batch sine and cosine of n angles in radians; a polynomial approximation of abs error under 1e-6
+// in [-8pi, 8pi], branchless for vectorization
+void
+sincos(
+	const float* const angle,
+	float* const sin_out,
+	float* const cos_out,
+	const size_t n);
+
+// batch atan2 of n pairs; a polynomial approximation of abs error under 1e-5, branchless for
+// vectorization; atan2(+-0, x) = +-0 for x >= 0
+void
+atan2(
+	const float* const y,
+	const float* const x,
+	float* const out,
+	const size_t n);
+
+// reorder the faces of a trilist for a post-transform vertex cache of the specified size, by
+// Sander et al., "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw", 2007
+void
+optimizeVertexCache(
+	uint16_t* const index,
+	const size_t num_faces,
+	const size_t num_verts,
+	const unsigned cache_size = 16);
+
+} // namespace rend
+
+#endif // rend_sphere_H__
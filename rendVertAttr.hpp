@@ -13,6 +13,34 @@
 namespace rend
 {
 
+// format of a single vertex attribute, in terms of glVertexAttribPointer args; a nil size stands
+// for the natural size of the semantics
+struct AttrFormat
+{
+	GLint size;
+	GLenum type;
+	GLboolean normalized;
+
+	AttrFormat(
+		const GLint size = 0,
+		const GLenum type = GL_FLOAT,
+		const GLboolean normalized = GL_FALSE)
+	: size(size)
+	, type(type)
+	, normalized(normalized)
+	{}
+};
+
+// per-semantic attribute formats of a vertex type; default is all-float attributes
+struct VertexFormat
+{
+	AttrFormat pos;
+	AttrFormat nrm;
+	AttrFormat tan;
+	AttrFormat bon;
+	AttrFormat txc;
+};
+
 struct ActiveAttrSemantics
 {
 	GLint active_attr[32];
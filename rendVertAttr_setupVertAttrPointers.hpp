@@ -25,11 +25,14 @@
 #define VERTEX_ATTR_POS_DIM 3
 #endif
 
+// attribute formats come from the optional per-semantic format descriptor; semantics of nil size
+// take their natural size, e.g. quantized or packed vertex types need a descriptor to that effect
 template < class VERTEX_T >
 static bool
 setupVertexAttrPointers(
 	const rend::ActiveAttrSemantics& active_attr_semantics,
-	const uintptr_t va = 0)
+	const uintptr_t va = 0,
+	const rend::VertexFormat& format = rend::VertexFormat())
 {
 #if (SETUP_VERTEX_ATTR_POINTERS_MASK & SETUP_VERTEX_ATTR_POINTERS_MASK_vertex) || \
 	(SETUP_VERTEX_ATTR_POINTERS_MASK & SETUP_VERTEX_ATTR_POINTERS_MASK_vert2d)
@@ -37,7 +40,8 @@ setupVertexAttrPointers(
 	if (active_attr_semantics.semantics_vertex != -1) {
 		const uintptr_t offs = offsetof(VERTEX_T, pos);
 
-		glVertexAttribPointer(active_attr_semantics.getVertexAttr(), VERTEX_ATTR_POS_DIM, GL_FLOAT, GL_FALSE, sizeof(VERTEX_T),
+		glVertexAttribPointer(active_attr_semantics.getVertexAttr(), format.pos.size ? format.pos.size : VERTEX_ATTR_POS_DIM,
+			format.pos.type, format.pos.normalized, sizeof(VERTEX_T),
 			(GLvoid*)(offs + va));
 
 		DEBUG_GL_ERR()
@@ -53,7 +57,8 @@ setupVertexAttrPointers(
 	if (active_attr_semantics.semantics_normal != -1) {
 		const uintptr_t offs = offsetof(VERTEX_T, nrm);
 
-		glVertexAttribPointer(active_attr_semantics.getNormalAttr(), 3, GL_FLOAT, GL_FALSE, sizeof(VERTEX_T),
+		glVertexAttribPointer(active_attr_semantics.getNormalAttr(), format.nrm.size ? format.nrm.size : 3,
+			format.nrm.type, format.nrm.normalized, sizeof(VERTEX_T),
 			(GLvoid*)(offs + va));
 
 		DEBUG_GL_ERR()
@@ -69,7 +74,8 @@ setupVertexAttrPointers(
 	if (active_attr_semantics.semantics_tangent != -1) {
 		const uintptr_t offs = offsetof(VERTEX_T, tan);
 
-		glVertexAttribPointer(active_attr_semantics.getTangentAttr(), 3, GL_FLOAT, GL_FALSE, sizeof(VERTEX_T),
+		glVertexAttribPointer(active_attr_semantics.getTangentAttr(), format.tan.size ? format.tan.size : 3,
+			format.tan.type, format.tan.normalized, sizeof(VERTEX_T),
 			(GLvoid*)(offs + va));
 
 		DEBUG_GL_ERR()
@@ -85,7 +91,8 @@ setupVertexAttrPointers(
 	if (active_attr_semantics.semantics_blendw != -1) {
 		const uintptr_t offs = offsetof(VERTEX_T, bon);
 
-		glVertexAttribPointer(active_attr_semantics.getBlendWAttr(), 4, GL_FLOAT, GL_FALSE, sizeof(VERTEX_T),
+		glVertexAttribPointer(active_attr_semantics.getBlendWAttr(), format.bon.size ? format.bon.size : 4,
+			format.bon.type, format.bon.normalized, sizeof(VERTEX_T),
 			(GLvoid*)(offs + va));
 
 		DEBUG_GL_ERR()
@@ -101,7 +108,8 @@ setupVertexAttrPointers(
 	if (active_attr_semantics.semantics_tcoord != -1) {
 		const uintptr_t offs = offsetof(VERTEX_T, txc);
 
-		glVertexAttribPointer(active_attr_semantics.getTCoordAttr(), 2, GL_FLOAT, GL_FALSE, sizeof(VERTEX_T),
+		glVertexAttribPointer(active_attr_semantics.getTCoordAttr(), format.txc.size ? format.txc.size : 2,
+			format.txc.type, format.txc.normalized, sizeof(VERTEX_T),
 			(GLvoid*)(offs + va));
 
 		DEBUG_GL_ERR()
@@ -113,7 +121,8 @@ setupVertexAttrPointers(
 	if (active_attr_semantics.semantics_tcoord != -1) {
 		const uintptr_t offs = offsetof(VERTEX_T, pos);
 
-		glVertexAttribPointer(active_attr_semantics.getTCoordAttr(), 2, GL_FLOAT, GL_FALSE, sizeof(VERTEX_T),
+		glVertexAttribPointer(active_attr_semantics.getTCoordAttr(), 2,
+			format.pos.type, format.pos.normalized, sizeof(VERTEX_T),
 			(GLvoid*)(offs + va));
 
 		DEBUG_GL_ERR()
@@ -0,0 +1,275 @@
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "rendVertGather.hpp"
+
+namespace { // anonymous
+
+// vertices per cache-resident block; a block of max-stride vertices takes 16KB
+const size_t block_verts = 64;
+
+// vertex count from which an automatic thread count goes parallel
+const size_t parallel_threshold = 1 << 16;
+
+const unsigned max_threads = 8;
+
+typedef float v4f __attribute__ ((vector_size(4 * sizeof(float))));
+typedef float v2f __attribute__ ((vector_size(2 * sizeof(float))));
+
+// fixed-size element copies; memcpy of a constant size compiles to plain (unaligned) moves
+template < typename T >
+inline void
+copy(
+	uint8_t* const dst,
+	const uint8_t* const src)
+{
+	T t;
+	memcpy(&t, src, sizeof(t));
+	memcpy(dst, &t, sizeof(t));
+}
+
+template < size_t SIZE_T >
+inline void
+copyElem(
+	uint8_t* const dst,
+	const uint8_t* const src);
+
+template <>
+inline void
+copyElem< sizeof(uint32_t) >(
+	uint8_t* const dst,
+	const uint8_t* const src)
+{
+	copy< uint32_t >(dst, src);
+}
+
+template <>
+inline void
+copyElem< sizeof(v2f) >(
+	uint8_t* const dst,
+	const uint8_t* const src)
+{
+	copy< v2f >(dst, src);
+}
+
+template <>
+inline void
+copyElem< sizeof(float[3]) >(
+	uint8_t* const dst,
+	const uint8_t* const src)
+{
+	copy< v2f >(dst, src);
+	copy< float >(dst + sizeof(v2f), src + sizeof(v2f));
+}
+
+template <>
+inline void
+copyElem< sizeof(v4f) >(
+	uint8_t* const dst,
+	const uint8_t* const src)
+{
+	copy< v4f >(dst, src);
+}
+
+// copy count elements of SIZE_T bytes, four at a time; the copy can be wider than the element,
+// i.e. WIDE_T bytes, as long as source and destination tolerate that
+template < size_t SIZE_T, size_t WIDE_T >
+void
+gatherKernel(
+	uint8_t* dst,
+	const size_t dst_stride,
+	const uint8_t* src,
+	const size_t src_stride,
+	const size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		copyElem< WIDE_T >(dst + dst_stride * 0, src + src_stride * 0);
+		copyElem< WIDE_T >(dst + dst_stride * 1, src + src_stride * 1);
+		copyElem< WIDE_T >(dst + dst_stride * 2, src + src_stride * 2);
+		copyElem< WIDE_T >(dst + dst_stride * 3, src + src_stride * 3);
+		dst += dst_stride * 4;
+		src += src_stride * 4;
+	}
+
+	for (; i < count; ++i) {
+		copyElem< SIZE_T >(dst, src);
+		dst += dst_stride;
+		src += src_stride;
+	}
+}
+
+typedef void (* GatherKernel)(
+	uint8_t*,
+	const size_t,
+	const uint8_t*,
+	const size_t,
+	const size_t);
+
+const size_t format_size[] = {
+	sizeof(float[2]),
+	sizeof(float[3]),
+	sizeof(float[4]),
+	sizeof(uint8_t[4])
+};
+
+// exact kernels write just the attribute
+const GatherKernel kernel_exact[] = {
+	gatherKernel< sizeof(float[2]), sizeof(float[2]) >,
+	gatherKernel< sizeof(float[3]), sizeof(float[3]) >,
+	gatherKernel< sizeof(float[4]), sizeof(float[4]) >,
+	gatherKernel< sizeof(uint8_t[4]), sizeof(uint8_t[4]) >
+};
+
+// wide kernels read and write a full vector, i.e. past the attribute; with streams written in
+// ascending destination offset the excess lands on not-yet-written bytes of the same vertex
+const GatherKernel kernel_wide[] = {
+	gatherKernel< sizeof(float[2]), sizeof(float[2]) >,
+	gatherKernel< sizeof(float[3]), sizeof(v4f) >,
+	gatherKernel< sizeof(float[4]), sizeof(float[4]) >,
+	gatherKernel< sizeof(uint8_t[4]), sizeof(uint8_t[4]) >
+};
+
+struct GatherJob
+{
+	const rend::GatherLayout* layout;	// streams in ascending destination offset
+	uint8_t* dst;
+	size_t first;						// first vertex of the job
+	size_t count;						// vertices of the job
+	size_t num_verts;					// vertices of the entire gather
+};
+
+void
+gatherRange(
+	const GatherJob& job)
+{
+	const rend::GatherLayout& layout = *job.layout;
+	const size_t dst_stride = layout.dst_stride;
+	uint8_t stage[block_verts * rend::GatherLayout::max_dst_stride];
+
+	for (size_t first = job.first; first < job.first + job.count; first += block_verts) {
+		const size_t count = first + block_verts < job.first + job.count ? block_verts : job.first + job.count - first;
+		// the global last vertex does not get over-read
+		const size_t count_wide = first + count < job.num_verts ? count : count - 1;
+
+		for (unsigned i = 0; i < layout.num_streams; ++i) {
+			const rend::GatherStream& s = layout.stream[i];
+			const uint8_t* const src = reinterpret_cast< const uint8_t* >(s.src) + s.src_stride * first;
+			uint8_t* const dst = stage + s.dst_offset;
+			const bool wide = s.dst_offset + sizeof(v4f) <= dst_stride;
+
+			if (wide) {
+				kernel_wide[s.format](dst, dst_stride, src, s.src_stride, count_wide);
+				kernel_exact[s.format](
+					dst + dst_stride * count_wide, dst_stride,
+					src + s.src_stride * count_wide, s.src_stride, count - count_wide);
+			}
+			else
+				kernel_exact[s.format](dst, dst_stride, src, s.src_stride, count);
+		}
+
+		memcpy(job.dst + dst_stride * first, stage, dst_stride * count);
+	}
+}
+
+void*
+gatherWorker(
+	void* arg)
+{
+	gatherRange(*reinterpret_cast< const GatherJob* >(arg));
+	return 0;
+}
+
+} // namespace
+
+namespace rend
+{
+
+size_t
+getGatherFormatSize(
+	const GatherFormat format)
+{
+	assert(GATHER_FORMAT_COUNT > format);
+	return format_size[format];
+}
+
+bool
+gatherVertices(
+	const GatherLayout& layout,
+	void* const dst,
+	const size_t num_verts,
+	const unsigned num_threads)
+{
+	if (GatherLayout::max_dst_stride < layout.dst_stride || GatherLayout::capacity < layout.num_streams)
+		return false;
+
+	// sort the streams by destination offset, as the wide kernels require
+	GatherLayout sorted(layout.dst_stride);
+
+	for (unsigned i = 0; i < layout.num_streams; ++i) {
+		const GatherStream& s = layout.stream[i];
+
+		if (GATHER_FORMAT_COUNT <= s.format || layout.dst_stride < s.dst_offset + format_size[s.format])
+			return false;
+
+		unsigned j = sorted.num_streams++;
+
+		for (; j > 0 && sorted.stream[j - 1].dst_offset > s.dst_offset; --j)
+			sorted.stream[j] = sorted.stream[j - 1];
+
+		sorted.stream[j] = s;
+	}
+
+	unsigned threads = num_threads;
+
+	if (0 == threads) {
+		const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = parallel_threshold <= num_verts && 1 < cpus ? unsigned(cpus) : 1;
+	}
+
+	if (max_threads < threads)
+		threads = max_threads;
+
+	// split into whole blocks per thread
+	const size_t num_blocks = (num_verts + block_verts - 1) / block_verts;
+
+	if (num_blocks < threads)
+		threads = num_blocks ? unsigned(num_blocks) : 1;
+
+	const size_t blocks_per_thread = (num_blocks + threads - 1) / threads;
+
+	GatherJob job[max_threads];
+	pthread_t worker[max_threads];
+	bool spawned[max_threads] = { false };
+
+	for (unsigned i = 0; i < threads; ++i) {
+		const size_t first = blocks_per_thread * block_verts * i;
+		const size_t last = first + blocks_per_thread * block_verts;
+
+		job[i].layout = &sorted;
+		job[i].dst = reinterpret_cast< uint8_t* >(dst);
+		job[i].first = first < num_verts ? first : num_verts;
+		job[i].count = (last < num_verts ? last : num_verts) - job[i].first;
+		job[i].num_verts = num_verts;
+	}
+
+	// thread 0 is the caller; should a worker fail to spawn, the caller picks up its job
+	for (unsigned i = 1; i < threads; ++i)
+		spawned[i] = 0 == pthread_create(worker + i, 0, gatherWorker, job + i);
+
+	for (unsigned i = 0; i < threads; ++i)
+		if (!spawned[i])
+			gatherRange(job[i]);
+
+	for (unsigned i = 1; i < threads; ++i)
+		if (spawned[i])
+			pthread_join(worker[i], 0);
+
+	return true;
+}
+
+} // namespace rend
@@ -0,0 +1,84 @@
+#ifndef rend_vert_gather_H__
+#define rend_vert_gather_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace rend
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// gather of vertex attributes from multiple strided sources into a single interleaved destination,
+// e.g. a mapped VBO: a layout descriptor lists the source streams along with their format and
+// destination offset; each format has its own fixed-size copy kernel. Vertices are assembled in
+// cache-resident blocks and written out sequentially, so a write-combined destination only sees
+// contiguous writes; large buffers get split across threads.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+enum GatherFormat {
+	GATHER_FLOAT2,
+	GATHER_FLOAT3,
+	GATHER_FLOAT4,
+	GATHER_UBYTE4,
+
+	GATHER_FORMAT_COUNT,
+	GATHER_FORMAT_FORCE_UINT = -1U
+};
+
+struct GatherStream
+{
+	const void* src;		// source of the first vertex
+	size_t src_stride;		// bytes between consecutive source vertices
+	size_t dst_offset;		// offset of the attribute in the destination vertex
+	GatherFormat format;
+};
+
+struct GatherLayout
+{
+	enum { capacity = 8 };
+	enum { max_dst_stride = 256 };
+
+	size_t dst_stride;		// destination vertex size; at most max_dst_stride
+	unsigned num_streams;
+	GatherStream stream[capacity];
+
+	GatherLayout(
+		const size_t dst_stride)
+	: dst_stride(dst_stride)
+	, num_streams(0)
+	{}
+
+	// append a stream; return false if out of capacity
+	bool add(
+		const void* const src,
+		const size_t src_stride,
+		const size_t dst_offset,
+		const GatherFormat format)
+	{
+		if (capacity == num_streams)
+			return false;
+
+		const GatherStream s = { src, src_stride, dst_offset, format };
+		stream[num_streams++] = s;
+		return true;
+	}
+};
+
+// size of an attribute of the specified format
+size_t
+getGatherFormatSize(
+	const GatherFormat format);
+
+// gather the specified number of vertices into dst per the layout, across the specified number of
+// threads; zero threads means one per online CPU for large counts, and a single thread otherwise;
+// destination bytes not covered by a stream are left undefined; return false on invalid layout
+bool
+gatherVertices(
+	const GatherLayout& layout,
+	void* const dst,
+	const size_t num_verts,
+	const unsigned num_threads = 0);
+
+} // namespace rend
+
+#endif // rend_vert_gather_H__
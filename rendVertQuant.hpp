@@ -0,0 +1,195 @@
+#ifndef rend_vert_quant_H__
+#define rend_vert_quant_H__
+
+#include <stdint.h>
+#include <string.h>
+#include <cmath>
+
+namespace rend
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// load-time quantization of vertex attributes:
+//
+//	position        -> snorm16 x 3 (+1 pad) within the quantization domain of the mesh
+//	normal, tangent -> octahedral snorm16 x 2, or snorm 10_10_10_2
+//	tcoord          -> half-float x 2
+//
+// positions are dequantized by folding the domain transform into the model matrix; octahedral
+// normals and tangents need decoding in the vertex shader; the rest is done by the attrib fetch.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline float
+clamp_snorm(
+	const float x)
+{
+	return x < -1.f ? -1.f : (x > 1.f ? 1.f : x);
+}
+
+
+inline int16_t
+quant_snorm16(
+	const float x)
+{
+	return int16_t(lrintf(clamp_snorm(x) * 32767.f));
+}
+
+
+inline int16_t
+quant_snormN(
+	const float x,
+	const unsigned bits)
+{
+	const float scale = float((1 << (bits - 1)) - 1);
+	return int16_t(lrintf(clamp_snorm(x) * scale));
+}
+
+
+// half-float from float, round to nearest even; handles denormals, infinities and nans
+inline uint16_t
+quant_half(
+	const float x)
+{
+	uint32_t f;
+	memcpy(&f, &x, sizeof(f));
+
+	const uint32_t sign = f >> 16 & 0x8000;
+	const uint32_t absf = f & 0x7fffffff;
+
+	if (absf >= 0x7f800000) // inf or nan
+		return uint16_t(sign | 0x7c00 | (absf > 0x7f800000 ? 0x200 : 0));
+
+	if (absf >= 0x477ff000) // overflow after rounding
+		return uint16_t(sign | 0x7c00);
+
+	if (absf < 0x38800000) { // half denormal or zero
+		if (absf < 0x33000000)
+			return uint16_t(sign);
+
+		const uint32_t mant = (absf & 0x007fffff) | 0x00800000;
+		const unsigned shift = 126 - (absf >> 23);
+		const uint32_t half = mant >> shift;
+		const uint32_t rest = mant & ((1u << shift) - 1);
+		const uint32_t tie = 1u << (shift - 1);
+
+		return uint16_t(sign | (half + (rest > tie || (rest == tie && (half & 1)))));
+	}
+
+	const uint32_t rebias = absf - 0x38000000;
+	const uint32_t half = rebias >> 13;
+	const uint32_t rest = rebias & 0x1fff;
+
+	return uint16_t(sign | (half + (rest > 0x1000 || (rest == 0x1000 && (half & 1)))));
+}
+
+
+// octahedral encoding of a unit vector into snorm16 x 2; decode as:
+//
+//	vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+//	if (v.z < 0.0) v.xy = (1.0 - abs(v.yx)) * sign_not_zero(v.xy);
+//	v = normalize(v);
+//
+inline void
+quant_octahedral_snorm16(
+	const float (& v)[3],
+	int16_t (& out)[2])
+{
+	const float rcp_l1 = 1.f / (fabsf(v[0]) + fabsf(v[1]) + fabsf(v[2]));
+	float u = v[0] * rcp_l1;
+	float w = v[1] * rcp_l1;
+
+	if (v[2] < 0.f) {
+		const float fu = (1.f - fabsf(w)) * (u < 0.f ? -1.f : 1.f);
+		const float fw = (1.f - fabsf(u)) * (w < 0.f ? -1.f : 1.f);
+		u = fu;
+		w = fw;
+	}
+
+	out[0] = quant_snorm16(u);
+	out[1] = quant_snorm16(w);
+}
+
+
+// snorm 10_10_10_2 packing of a 3-vector and a 2-bit w, as GL_INT_2_10_10_10_REV (GLES3) expects it
+inline uint32_t
+quant_snorm_2_10_10_10_rev(
+	const float (& v)[3],
+	const float w = 0.f)
+{
+	const uint32_t x = uint32_t(quant_snormN(v[0], 10)) & 0x3ff;
+	const uint32_t y = uint32_t(quant_snormN(v[1], 10)) & 0x3ff;
+	const uint32_t z = uint32_t(quant_snormN(v[2], 10)) & 0x3ff;
+	const uint32_t a = uint32_t(quant_snormN(w, 2)) & 0x3;
+
+	return x | y << 10 | z << 20 | a << 30;
+}
+
+
+// position quantization domain: a box given by its centre and half-extents; positions map to the
+// snorm range [-1, 1] and dequantize as centre + extent * q; an isotropic domain is the bounding
+// cube of the box, which keeps object-space directions intact through the dequantization
+struct QuantDomain
+{
+	float centre[3];
+	float extent[3];
+
+	QuantDomain() {
+		centre[0] = centre[1] = centre[2] = 0.f;
+		extent[0] = extent[1] = extent[2] = 1.f;
+	}
+
+	QuantDomain(
+		const float (& bmin)[3],
+		const float (& bmax)[3],
+		const bool isotropic = false)
+	{
+		for (unsigned i = 0; i < 3; ++i) {
+			centre[i] = (bmin[i] + bmax[i]) * .5f;
+			extent[i] = (bmax[i] - bmin[i]) * .5f;
+		}
+
+		if (isotropic)
+			extent[0] = extent[1] = extent[2] = fmaxf(fmaxf(extent[0], extent[1]), extent[2]);
+
+		// avoid degenerate axes
+		for (unsigned i = 0; i < 3; ++i)
+			if (0.f == extent[i])
+				extent[i] = 1.f;
+	}
+
+	void quantize(
+		const float (& p)[3],
+		int16_t (& out)[4]) const
+	{
+		out[0] = quant_snorm16((p[0] - centre[0]) / extent[0]);
+		out[1] = quant_snorm16((p[1] - centre[1]) / extent[1]);
+		out[2] = quant_snorm16((p[2] - centre[2]) / extent[2]);
+		out[3] = 32767;
+	}
+
+	// dequantization matrix in the row-vector convention of simd::matx4, i.e. p' = p * m
+	void get_dequant_matx(
+		float (& m)[4][4]) const
+	{
+		m[0][0] = extent[0];	m[0][1] = 0.f;			m[0][2] = 0.f;			m[0][3] = 0.f;
+		m[1][0] = 0.f;			m[1][1] = extent[1];	m[1][2] = 0.f;			m[1][3] = 0.f;
+		m[2][0] = 0.f;			m[2][1] = 0.f;			m[2][2] = extent[2];	m[2][3] = 0.f;
+		m[3][0] = centre[0];	m[3][1] = centre[1];	m[3][2] = centre[2];	m[3][3] = 1.f;
+	}
+
+	// fold the dequantization into a row-vector-convention matrix, i.e. m = dequant * m
+	void fold_dequant(
+		float (& m)[4][4]) const
+	{
+		for (unsigned j = 0; j < 4; ++j)
+			m[3][j] += centre[0] * m[0][j] + centre[1] * m[1][j] + centre[2] * m[2][j];
+
+		for (unsigned i = 0; i < 3; ++i)
+			for (unsigned j = 0; j < 4; ++j)
+				m[i][j] *= extent[i];
+	}
+};
+
+} // namespace rend
+
+#endif // rend_vert_quant_H__
@@ -0,0 +1,781 @@
+////////////////////////////////////////////////////////////////////////////////
+// batch texture converter: converts PNG or .raw images to GPU-ready .raw or KTX
+// textures, optionally along with their full mip chains, one image per thread
+// across all online CPUs, the block rows of ETC2/EAC textures further split among
+// the threads left idle; conversions whose input content and parameters hash
+// the same as at their last run get skipped
+//
+// build as: $ g++ -O3 -pthread tex_convert.cpp util_mip.cpp util_pix.cpp util_etc.cpp util_file.cpp util_lz.cpp util_pack.cpp util_preload.cpp -lpng16
+//
+// manifest lines, '#' starting a comment:
+//   <input.png|input.raw> <output.ktx|output.raw> <format> [none|box|kaiser [linear|srgb|normal]]
+// formats: rgb888, rgba8888, rgb565, rg88, etc2 (ETC2 RGB8), eac (EAC RG11), height (the r channel
+// as an 8-bit height map, for normal maps derived at load); .raw outputs take rgb888 and height only;
+// inputs decode to RGB, so rgba8888 outputs come fully opaque; mips default to box, in linear mode, or
+// normal mode for rg88 and eac; height maps take no mips
+//
+// directory mode: every PNG in the input directory goes to a KTX of the same name in the output
+// directory -- as rg88 with normal-mode mips if its name contains 'normal', as rgba8888 with sRGB
+// mips otherwise; PNGs whose names contain 'height' go to .raw height maps instead
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <png.h>
+
+#include "util_file.hpp"
+#include "util_mip.hpp"
+#include "util_pix.hpp"
+#include "util_etc.hpp"
+
+static const uint8_t ktx_identifier[12] = {
+	0xab, 'K', 'T', 'X', ' ', '1', '1', 0xbb, '\r', '\n', 0x1a, '\n'
+};
+
+enum Format {
+	FORMAT_RGB888,
+	FORMAT_RGBA8888,
+	FORMAT_RGB565,
+	FORMAT_RG88,
+	FORMAT_ETC2,
+	FORMAT_EAC,
+	FORMAT_HEIGHT,
+
+	FORMAT_COUNT,
+	FORMAT_FORCE_UINT = -1U
+};
+
+struct FormatDesc {
+	const char* name;
+	util::PixFormat pix_format;
+	bool compressed;
+	util::EtcFormat etc_format;
+	uint32_t glType;
+	uint32_t glTypeSize;
+	uint32_t glFormat;
+	uint32_t glInternalFormat;
+	uint32_t glBaseInternalFormat;
+};
+
+static const FormatDesc format_desc[FORMAT_COUNT] = {
+	{ "rgb888",   util::PIX_FORMAT_RGB888,   false, util::ETC_FORMAT_FORCE_UINT, 0x1401, 1, 0x1907, 0x8051, 0x1907 },
+	{ "rgba8888", util::PIX_FORMAT_RGBA8888, false, util::ETC_FORMAT_FORCE_UINT, 0x1401, 1, 0x1908, 0x8058, 0x1908 },
+	{ "rgb565",   util::PIX_FORMAT_RGB565,   false, util::ETC_FORMAT_FORCE_UINT, 0x8363, 2, 0x1907, 0x8d62, 0x1907 },
+	{ "rg88",     util::PIX_FORMAT_RG88,     false, util::ETC_FORMAT_FORCE_UINT, 0x1401, 1, 0x8227, 0x822b, 0x8227 },
+	{ "etc2",     util::PIX_FORMAT_RGB888,   true,  util::ETC_FORMAT_RGB8,       0,      1, 0,      0x9274, 0x1907 },
+	{ "eac",      util::PIX_FORMAT_RGB888,   true,  util::ETC_FORMAT_RG11,       0,      1, 0,      0x9272, 0x8227 },
+	{ "height",   util::PIX_FORMAT_RGB888,   false, util::ETC_FORMAT_FORCE_UINT, 0,      0, 0,      0,      0      }
+};
+
+// bumped whenever the output of a conversion changes for the same input, invalidating all hashes
+static const uint64_t converter_version = 1;
+
+enum Status {
+	STATUS_PENDING,
+	STATUS_CONVERTED,
+	STATUS_SKIPPED,
+	STATUS_FAILED,
+
+	STATUS_COUNT,
+	STATUS_FORCE_UINT = -1U
+};
+
+struct Job {
+	std::string input;
+	std::string output;
+	Format format;
+	bool mips;
+	util::MipFilter mip_filter;
+	util::MipMode mip_mode;
+
+	uint64_t hash;
+	Status status;
+};
+
+struct HashEntry {
+	std::string output;
+	uint64_t hash;
+};
+
+struct Batch {
+	std::vector< Job > job;
+	std::vector< HashEntry > last_hash; // as of the last run, sorted by output
+	bool force;
+	unsigned num_threads;
+	unsigned next_job; // atomic
+	unsigned num_active; // atomic; jobs in conversion
+};
+
+struct EtcLevel {
+	unsigned w;
+	unsigned h;
+	const uint8_t* src;
+	uint8_t* dst;
+	unsigned first_row; // in the count of block rows across all levels
+};
+
+// block rows of all levels of a compressed texture, claimed by any number of threads
+struct EtcWork {
+	util::EtcFormat format;
+	std::vector< EtcLevel > level;
+	unsigned num_rows;
+	unsigned next_row; // atomic
+};
+
+// FNV-1a
+static uint64_t hash_bytes(
+	const uint8_t* const data,
+	const size_t size,
+	uint64_t hash = 0xcbf29ce484222325ULL)
+{
+	for (size_t i = 0; i < size; ++i)
+		hash = (hash ^ data[i]) * 0x100000001b3ULL;
+
+	return hash;
+}
+
+static bool has_suffix(
+	const std::string& str,
+	const char* const suffix)
+{
+	const size_t len = strlen(suffix);
+	return str.size() > len && 0 == str.compare(str.size() - len, len, suffix);
+}
+
+static bool operator <(
+	const HashEntry& a,
+	const HashEntry& b)
+{
+	return a.output < b.output;
+}
+
+static bool find_last_hash(
+	const std::vector< HashEntry >& last_hash,
+	const std::string& output,
+	uint64_t& hash)
+{
+	HashEntry key;
+	key.output = output;
+
+	const std::vector< HashEntry >::const_iterator it = std::lower_bound(last_hash.begin(), last_hash.end(), key);
+
+	if (it == last_hash.end() || it->output != output)
+		return false;
+
+	hash = it->hash;
+	return true;
+}
+
+// decode level 0 from a PNG or a .raw, bottom row first as per .raw
+static bool decodeImage(
+	const Job& job,
+	const util::mapped_file& file,
+	unsigned& w,
+	unsigned& h,
+	std::vector< uint8_t >& image)
+{
+	if (has_suffix(job.input, ".png")) {
+		png_image png;
+		memset(&png, 0, sizeof(png));
+		png.version = PNG_IMAGE_VERSION;
+
+		if (!png_image_begin_read_from_memory(&png, file.data(), file.length())) {
+			fprintf(stderr, "error: '%s': %s\n", job.input.c_str(), png.message);
+			return false;
+		}
+
+		png.format = PNG_FORMAT_RGB;
+		w = png.width;
+		h = png.height;
+		image.resize(size_t(w) * h * 3);
+
+		// negative stride: bottom row first
+		if (!png_image_finish_read(&png, 0, &image[0], -int(w * 3), 0)) {
+			fprintf(stderr, "error: '%s': %s\n", job.input.c_str(), png.message);
+			return false;
+		}
+
+		return true;
+	}
+
+	uint32_t dim[2];
+
+	if (file.length() < sizeof(dim)) {
+		fprintf(stderr, "error: '%s' is not a .raw image\n", job.input.c_str());
+		return false;
+	}
+
+	memcpy(dim, file.data(), sizeof(dim));
+	const size_t size = size_t(dim[0]) * dim[1] * 3;
+
+	// tolerate a trailing mip chain; level 0 is all that matters
+	if (0 == size || file.length() - sizeof(dim) < size) {
+		fprintf(stderr, "error: '%s' is not a .raw image\n", job.input.c_str());
+		return false;
+	}
+
+	w = dim[0];
+	h = dim[1];
+	image.assign(file.data() + sizeof(dim), file.data() + sizeof(dim) + size);
+
+	return true;
+}
+
+static void* etcWorker(void* arg)
+{
+	EtcWork& work = *reinterpret_cast< EtcWork* >(arg);
+
+	// claim a few block rows at a time, from any level
+	const unsigned batch = 4;
+
+	for (;;) {
+		const unsigned row = __atomic_fetch_add(&work.next_row, batch, __ATOMIC_RELAXED);
+
+		if (row >= work.num_rows)
+			break;
+
+		for (size_t i = 0; i < work.level.size(); ++i) {
+			const EtcLevel& level = work.level[i];
+			const unsigned level_rows = (level.h + 3) / 4;
+			const unsigned first = level.first_row;
+
+			if (row + batch <= first || row >= first + level_rows)
+				continue;
+
+			const unsigned start = row > first ? row - first : 0;
+			const unsigned end = row + batch - first < level_rows ? row + batch - first : level_rows;
+
+			util::etc_encode(work.format, level.src, level.w, level.h, start, end - start, level.dst);
+		}
+	}
+
+	return 0;
+}
+
+// compress the block rows of all levels on the calling thread and the specified number of helpers
+static void etcEncodeLevels(
+	EtcWork& work,
+	const unsigned num_helpers)
+{
+	std::vector< pthread_t > helper(num_helpers);
+	size_t num_spawned = 0;
+
+	for (; num_spawned < helper.size(); ++num_spawned)
+		if (0 != pthread_create(&helper[num_spawned], 0, etcWorker, &work))
+			break;
+
+	etcWorker(&work);
+
+	for (size_t i = 0; i < num_spawned; ++i)
+		pthread_join(helper[i], 0);
+}
+
+// produce the content of the output file of a job, from level 0 and the mip tail of the image;
+// compressed levels get their block rows split among the calling thread and the specified helpers
+static void encodeTexture(
+	const Job& job,
+	const unsigned w,
+	const unsigned h,
+	const unsigned num_levels,
+	const uint8_t* const image,
+	const uint8_t* const mip_tail,
+	const unsigned num_helpers,
+	std::vector< uint8_t >& out)
+{
+	const FormatDesc& desc = format_desc[job.format];
+
+	if (has_suffix(job.output, ".raw")) {
+		const uint32_t dim[2] = { w, h };
+
+		out.insert(out.end(), reinterpret_cast< const uint8_t* >(dim), reinterpret_cast< const uint8_t* >(dim + 2));
+
+		if (FORMAT_HEIGHT == job.format) {
+			for (size_t i = 0; i < size_t(w) * h; ++i)
+				out.push_back(image[i * 3]);
+
+			return;
+		}
+
+		out.insert(out.end(), image, image + size_t(w) * h * 3);
+		out.insert(out.end(), mip_tail, mip_tail + util::mip_chain_size(w, h, 1, num_levels - 1));
+		return;
+	}
+
+	const uint32_t header[13] = {
+		0x04030201,	// endianness
+		desc.glType,
+		desc.glTypeSize,
+		desc.glFormat,
+		desc.glInternalFormat,
+		desc.glBaseInternalFormat,
+		w,
+		h,
+		0,			// pixelDepth
+		0,			// numberOfArrayElements
+		1,			// numberOfFaces
+		num_levels,
+		0			// bytesOfKeyValueData
+	};
+
+	out.insert(out.end(), ktx_identifier, ktx_identifier + sizeof(ktx_identifier));
+	out.insert(out.end(), reinterpret_cast< const uint8_t* >(header), reinterpret_cast< const uint8_t* >(header + 13));
+
+	std::vector< uint8_t > converted;
+	std::vector< size_t > etc_offset;
+	const uint8_t* src = image;
+
+	for (unsigned i = 0; i < num_levels; ++i) {
+		const unsigned level_w = util::mip_level_dim(w, i);
+		const unsigned level_h = util::mip_level_dim(h, i);
+		const size_t row_size = level_w * util::pix_format_size(desc.pix_format);
+
+		// KTX rows of uncompressed levels are padded to 4 bytes
+		const size_t padded_row = (row_size + 3) & ~size_t(3);
+		const uint32_t level_size = uint32_t(desc.compressed
+			? util::etc_image_size(desc.etc_format, level_w, level_h)
+			: padded_row * level_h);
+
+		out.insert(out.end(), reinterpret_cast< const uint8_t* >(&level_size), reinterpret_cast< const uint8_t* >(&level_size + 1));
+
+		const size_t level_offset = out.size();
+		out.resize(level_offset + level_size, 0);
+
+		if (desc.compressed)
+			etc_offset.push_back(level_offset);
+		else {
+			converted.resize(row_size * level_h);
+			util::convert_rgb888(desc.pix_format, src, level_w, level_h, &converted[0]);
+
+			for (unsigned y = 0; y < level_h; ++y)
+				memcpy(&out[level_offset + y * padded_row], &converted[y * row_size], row_size);
+		}
+
+		// level sizes are multiples of 4 already, so no mip padding
+		src = i ? src + size_t(level_w) * level_h * 3 : mip_tail;
+	}
+
+	if (!desc.compressed)
+		return;
+
+	// compress once all levels have their place in the output
+	EtcWork work;
+	work.format = desc.etc_format;
+	work.level.resize(num_levels);
+	work.num_rows = 0;
+	work.next_row = 0;
+	src = image;
+
+	for (unsigned i = 0; i < num_levels; ++i) {
+		EtcLevel& level = work.level[i];
+		level.w = util::mip_level_dim(w, i);
+		level.h = util::mip_level_dim(h, i);
+		level.src = src;
+		level.dst = &out[etc_offset[i]];
+		level.first_row = work.num_rows;
+
+		work.num_rows += (level.h + 3) / 4;
+		src = i ? src + size_t(level.w) * level.h * 3 : mip_tail;
+	}
+
+	etcEncodeLevels(work, num_helpers);
+}
+
+static bool writeFile(
+	const std::string& filename,
+	const std::vector< uint8_t >& content)
+{
+	// write aside and rename, so no reader ever sees a partial file
+	const std::string tmp = filename + ".tmp";
+	FILE* const file = fopen(tmp.c_str(), "wb");
+
+	if (0 == file) {
+		fprintf(stderr, "error: cannot open '%s'\n", tmp.c_str());
+		return false;
+	}
+
+	const bool success = 1 == fwrite(&content[0], content.size(), 1, file);
+
+	if (0 != fclose(file) || !success || 0 != rename(tmp.c_str(), filename.c_str())) {
+		fprintf(stderr, "error: failure writing '%s'\n", filename.c_str());
+		remove(tmp.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+static Status convert(
+	Job& job,
+	const Batch& batch)
+{
+	util::mapped_file file;
+
+	if (!file.open(job.input.c_str())) {
+		fprintf(stderr, "error: cannot read '%s'\n", job.input.c_str());
+		return STATUS_FAILED;
+	}
+
+	const uint32_t params[] = {
+		job.format,
+		job.mips,
+		job.mip_filter,
+		job.mip_mode
+	};
+
+	job.hash = hash_bytes(file.data(), file.length());
+	job.hash = hash_bytes(reinterpret_cast< const uint8_t* >(params), sizeof(params), job.hash);
+	job.hash = hash_bytes(reinterpret_cast< const uint8_t* >(&converter_version), sizeof(converter_version), job.hash);
+
+	uint64_t last_hash;
+
+	if (!batch.force && find_last_hash(batch.last_hash, job.output, last_hash) && last_hash == job.hash &&
+		0 == access(job.output.c_str(), F_OK)) {
+
+		return STATUS_SKIPPED;
+	}
+
+	unsigned w;
+	unsigned h;
+	std::vector< uint8_t > image;
+
+	if (!decodeImage(job, file, w, h, image))
+		return STATUS_FAILED;
+
+	file.close();
+
+	const unsigned num_levels = job.mips ? util::mip_level_count(w, h) : 1;
+	std::vector< uint8_t > mip_tail(util::mip_chain_size(w, h, 1, num_levels - 1));
+
+	if (1 < num_levels)
+		util::build_mip_chain(&image[0], w, h, job.mip_filter, job.mip_mode, &mip_tail[0]);
+
+	// jobs still in conversion share the threads of the batch for their block compression
+	const unsigned num_active = __atomic_load_n(&batch.num_active, __ATOMIC_RELAXED);
+	const unsigned num_helpers = batch.num_threads / (num_active ? num_active : 1) - 1;
+
+	std::vector< uint8_t > out;
+	encodeTexture(job, w, h, num_levels, &image[0], mip_tail.empty() ? 0 : &mip_tail[0], num_helpers, out);
+
+	if (!writeFile(job.output, out))
+		return STATUS_FAILED;
+
+	fprintf(stdout, "%s -> %s: %u x %u %s, %u levels, %u bytes\n", job.input.c_str(), job.output.c_str(),
+		w, h, format_desc[job.format].name, num_levels, unsigned(out.size()));
+
+	return STATUS_CONVERTED;
+}
+
+static void* worker(void* arg)
+{
+	Batch& batch = *reinterpret_cast< Batch* >(arg);
+
+	for (;;) {
+		const unsigned i = __atomic_fetch_add(&batch.next_job, 1, __ATOMIC_RELAXED);
+
+		if (i >= batch.job.size())
+			break;
+
+		__atomic_fetch_add(&batch.num_active, 1, __ATOMIC_RELAXED);
+		batch.job[i].status = convert(batch.job[i], batch);
+		__atomic_fetch_sub(&batch.num_active, 1, __ATOMIC_RELAXED);
+	}
+
+	return 0;
+}
+
+static bool parseFormat(
+	const char* const name,
+	Format& format)
+{
+	for (unsigned i = 0; i < FORMAT_COUNT; ++i)
+		if (0 == strcmp(name, format_desc[i].name)) {
+			format = Format(i);
+			return true;
+		}
+
+	return false;
+}
+
+static bool readManifest(
+	const char* const filename,
+	std::vector< Job >& jobs)
+{
+	FILE* const file = fopen(filename, "r");
+
+	if (0 == file) {
+		fprintf(stderr, "error: cannot open manifest '%s'\n", filename);
+		return false;
+	}
+
+	const char* const filter_name[] = { "box", "kaiser" };
+	const char* const mode_name[] = { "linear", "srgb", "normal" };
+
+	char line[1024];
+	unsigned line_number = 0;
+	bool success = true;
+
+	while (success && 0 != fgets(line, sizeof(line), file)) {
+		line_number += 1;
+
+		if (char* const comment = strchr(line, '#'))
+			*comment = '\0';
+
+		char input[512];
+		char output[512];
+		char format[32];
+		char filter[32] = "box";
+		char mode[32] = "";
+
+		const int num_fields = sscanf(line, "%511s %511s %31s %31s %31s", input, output, format, filter, mode);
+
+		if (0 >= num_fields)
+			continue;
+
+		Job job;
+		job.input = input;
+		job.output = output;
+		job.mips = 0 != strcmp(filter, "none");
+		job.mip_filter = util::MIP_FILTER_BOX;
+		job.mip_mode = util::MIP_MODE_LINEAR;
+		job.hash = 0;
+		job.status = STATUS_PENDING;
+
+		success = 3 <= num_fields && parseFormat(format, job.format);
+
+		if (success)
+			success = has_suffix(job.output, ".ktx")
+				? FORMAT_HEIGHT != job.format
+				: has_suffix(job.output, ".raw") && (FORMAT_RGB888 == job.format || FORMAT_HEIGHT == job.format);
+
+		if (success && FORMAT_HEIGHT == job.format)
+			job.mips = false;
+
+		if (success && (FORMAT_RG88 == job.format || FORMAT_EAC == job.format))
+			job.mip_mode = util::MIP_MODE_NORMAL;
+
+		if (success && job.mips) {
+			unsigned i = 0;
+
+			while (i < sizeof(filter_name) / sizeof(filter_name[0]) && strcmp(filter, filter_name[i]))
+				++i;
+
+			success = i < sizeof(filter_name) / sizeof(filter_name[0]);
+			job.mip_filter = util::MipFilter(i);
+		}
+
+		if (success && '\0' != mode[0]) {
+			unsigned i = 0;
+
+			while (i < sizeof(mode_name) / sizeof(mode_name[0]) && strcmp(mode, mode_name[i]))
+				++i;
+
+			success = i < sizeof(mode_name) / sizeof(mode_name[0]);
+			job.mip_mode = util::MipMode(i);
+		}
+
+		if (success)
+			jobs.push_back(job);
+		else
+			fprintf(stderr, "error: malformed manifest line %u\n", line_number);
+	}
+
+	fclose(file);
+	return success;
+}
+
+static bool readDirectory(
+	const char* const input_dir,
+	const char* const output_dir,
+	std::vector< Job >& jobs)
+{
+	DIR* const dir = opendir(input_dir);
+
+	if (0 == dir) {
+		fprintf(stderr, "error: cannot open directory '%s'\n", input_dir);
+		return false;
+	}
+
+	std::vector< std::string > names;
+
+	while (const dirent* const entry = readdir(dir))
+		if (has_suffix(entry->d_name, ".png"))
+			names.push_back(entry->d_name);
+
+	closedir(dir);
+	std::sort(names.begin(), names.end());
+
+	for (size_t i = 0; i < names.size(); ++i) {
+		const bool normal = std::string::npos != names[i].find("normal");
+		const bool height = std::string::npos != names[i].find("height");
+
+		Job job;
+		job.input = std::string(input_dir) + '/' + names[i];
+		job.output = std::string(output_dir) + '/' + names[i].substr(0, names[i].size() - 4) + (height ? ".raw" : ".ktx");
+		job.format = height ? FORMAT_HEIGHT : normal ? FORMAT_RG88 : FORMAT_RGBA8888;
+		job.mips = !height;
+		job.mip_filter = util::MIP_FILTER_BOX;
+		job.mip_mode = normal ? util::MIP_MODE_NORMAL : util::MIP_MODE_SRGB;
+		job.hash = 0;
+		job.status = STATUS_PENDING;
+
+		jobs.push_back(job);
+	}
+
+	return true;
+}
+
+// hash file lines: <hash in hex> <output>
+static void readHashes(
+	const std::string& filename,
+	std::vector< HashEntry >& hashes)
+{
+	FILE* const file = fopen(filename.c_str(), "r");
+
+	if (0 == file)
+		return;
+
+	char line[1024];
+
+	while (0 != fgets(line, sizeof(line), file)) {
+		unsigned long long hash;
+		char output[512];
+
+		if (2 != sscanf(line, "%llx %511s", &hash, output))
+			continue;
+
+		HashEntry entry;
+		entry.output = output;
+		entry.hash = hash;
+		hashes.push_back(entry);
+	}
+
+	fclose(file);
+	std::sort(hashes.begin(), hashes.end());
+}
+
+static bool writeHashes(
+	const std::string& filename,
+	const std::vector< HashEntry >& hashes)
+{
+	std::string content;
+
+	for (size_t i = 0; i < hashes.size(); ++i) {
+		char hash[32];
+		snprintf(hash, sizeof(hash), "%016llx ", static_cast< unsigned long long >(hashes[i].hash));
+
+		content += hash;
+		content += hashes[i].output;
+		content += '\n';
+	}
+
+	return writeFile(filename, std::vector< uint8_t >(content.begin(), content.end()));
+}
+
+int main(
+	int argc,
+	char** argv)
+{
+	Batch batch;
+	batch.force = false;
+	batch.next_job = 0;
+	batch.num_active = 0;
+
+	long num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	bool valid_options = true;
+	int i = 1;
+
+	for (; i < argc && '-' == argv[i][0] && valid_options; ++i) {
+		if (0 == strcmp(argv[i], "-f"))
+			batch.force = true;
+		else
+		if (0 == strcmp(argv[i], "-j") && i + 1 < argc && 1 == sscanf(argv[i + 1], "%ld", &num_threads))
+			++i;
+		else
+			valid_options = false;
+	}
+
+	if (!valid_options || (i + 1 != argc && i + 2 != argc)) {
+		fprintf(stderr, "usage: %s [-f] [-j num_threads] <manifest|input_dir> [output_dir]\n"
+			"\t-f: convert all, regardless of hashes\n", argv[0]);
+		return -1;
+	}
+
+	const char* const source = argv[i];
+	const char* const output_dir = i + 2 == argc ? argv[i + 1] : ".";
+	DIR* const dir = opendir(source);
+	std::string hash_filename;
+
+	if (0 != dir) {
+		closedir(dir);
+
+		if (!readDirectory(source, output_dir, batch.job))
+			return -1;
+
+		hash_filename = std::string(output_dir) + "/tex_convert.hash";
+	}
+	else {
+		if (!readManifest(source, batch.job))
+			return -1;
+
+		hash_filename = std::string(source) + ".hash";
+	}
+
+	readHashes(hash_filename, batch.last_hash);
+
+	std::vector< pthread_t > thread(1 < num_threads ? num_threads : 1);
+	batch.num_threads = unsigned(thread.size());
+
+	for (size_t j = 1; j < thread.size(); ++j)
+		if (0 != pthread_create(&thread[j], 0, worker, &batch)) {
+			fprintf(stderr, "error: failure at pthread_create\n");
+			return -1;
+		}
+
+	worker(&batch);
+
+	for (size_t j = 1; j < thread.size(); ++j)
+		pthread_join(thread[j], 0);
+
+	// hashes of this run supersede those of the last; the rest carry over
+	std::vector< HashEntry > hashes;
+	unsigned num_status[STATUS_COUNT] = { 0 };
+
+	for (size_t j = 0; j < batch.job.size(); ++j) {
+		const Job& job = batch.job[j];
+		num_status[job.status] += 1;
+
+		if (STATUS_FAILED == job.status)
+			continue;
+
+		HashEntry entry;
+		entry.output = job.output;
+		entry.hash = job.hash;
+		hashes.push_back(entry);
+	}
+
+	std::sort(hashes.begin(), hashes.end());
+
+	for (size_t j = 0; j < batch.last_hash.size(); ++j) {
+		uint64_t hash;
+
+		if (!find_last_hash(hashes, batch.last_hash[j].output, hash))
+			hashes.push_back(batch.last_hash[j]);
+	}
+
+	std::sort(hashes.begin(), hashes.end());
+
+	if (!writeHashes(hash_filename, hashes))
+		return -1;
+
+	fprintf(stdout, "%u converted, %u skipped, %u failed on %u threads\n",
+		num_status[STATUS_CONVERTED], num_status[STATUS_SKIPPED], num_status[STATUS_FAILED], unsigned(thread.size()));
+
+	return num_status[STATUS_FAILED] ? -1 : 0;
+}
@@ -0,0 +1,527 @@
+#include <assert.h>
+#include <string.h>
+
+#include "util_etc.hpp"
+
+namespace util {
+
+namespace { // anonymous
+
+// ETC1 intensity modifiers, per table: the small and the large magnitude
+const int etc1_modifier[8][2] = {
+	{  2,   8 },
+	{  5,  17 },
+	{  9,  29 },
+	{ 13,  42 },
+	{ 18,  60 },
+	{ 24,  80 },
+	{ 33, 106 },
+	{ 47, 183 }
+};
+
+// EAC modifiers, per table, indexed by the 3-bit texel selector
+const int eac_modifier[16][8] = {
+	{ -3, -6,  -9, -15, 2, 5, 8, 14 },
+	{ -3, -7, -10, -13, 2, 6, 9, 12 },
+	{ -2, -5,  -8, -13, 1, 4, 7, 12 },
+	{ -2, -4,  -6, -13, 1, 3, 5, 12 },
+	{ -3, -6,  -8, -12, 2, 5, 7, 11 },
+	{ -3, -7,  -9, -11, 2, 6, 8, 10 },
+	{ -4, -7,  -8, -11, 3, 6, 7, 10 },
+	{ -3, -5,  -8, -11, 2, 4, 7, 10 },
+	{ -2, -6,  -8, -10, 1, 5, 7,  9 },
+	{ -2, -5,  -8, -10, 1, 4, 7,  9 },
+	{ -2, -4,  -8, -10, 1, 3, 7,  9 },
+	{ -2, -5,  -7, -10, 1, 4, 6,  9 },
+	{ -3, -4,  -7, -10, 2, 3, 6,  9 },
+	{ -1, -2,  -3, -10, 0, 1, 2,  9 },
+	{ -4, -6,  -8,  -9, 3, 5, 7,  8 },
+	{ -3, -5,  -7,  -9, 2, 4, 6,  8 }
+};
+
+inline int clamp(
+	const int x,
+	const int lo,
+	const int hi)
+{
+	return x < lo ? lo : (x > hi ? hi : x);
+}
+
+// ETC1 modifier of a 2-bit texel selector: +small, +large, -small, -large
+inline int etc1Modifier(
+	const unsigned table,
+	const unsigned selector)
+{
+	const int mag = etc1_modifier[table][selector & 1];
+	return selector & 2 ? -mag : mag;
+}
+
+// expand a 4- or 5-bit color component to 8 bits
+inline int expand4(const int c) { return c << 4 | c; }
+inline int expand5(const int c) { return c << 3 | c >> 2; }
+
+void storeBigEndian(
+	const uint64_t bits,
+	uint8_t* const dst)
+{
+	for (unsigned i = 0; i < 8; ++i)
+		dst[i] = uint8_t(bits >> (56 - i * 8));
+}
+
+uint64_t loadBigEndian(
+	const uint8_t* const src)
+{
+	uint64_t bits = 0;
+
+	for (unsigned i = 0; i < 8; ++i)
+		bits = bits << 8 | src[i];
+
+	return bits;
+}
+
+// texels of a block, row-major, edge-replicated past the image
+void fetchBlock(
+	const uint8_t* const src,
+	const unsigned w,
+	const unsigned h,
+	const unsigned bx,
+	const unsigned by,
+	uint8_t (&texel)[16][3])
+{
+	for (unsigned y = 0; y < 4; ++y)
+		for (unsigned x = 0; x < 4; ++x) {
+			const unsigned sx = bx * 4 + x < w ? bx * 4 + x : w - 1;
+			const unsigned sy = by * 4 + y < h ? by * 4 + y : h - 1;
+
+			memcpy(texel[y * 4 + x], src + (size_t(sy) * w + sx) * 3, 3);
+		}
+}
+
+// half of an ETC1 block: 8 texels, as indices into the block, row-major
+struct Subblock {
+	unsigned texel[8];
+};
+
+void getSubblocks(
+	const unsigned flip,
+	Subblock (&sub)[2])
+{
+	unsigned count[2] = { 0, 0 };
+
+	for (unsigned y = 0; y < 4; ++y)
+		for (unsigned x = 0; x < 4; ++x) {
+			const unsigned s = flip ? y >> 1 : x >> 1;
+			sub[s].texel[count[s]++] = y * 4 + x;
+		}
+}
+
+// best-fit of a subblock to a base color: the table of least error, and the texel selectors thereof
+struct SubblockFit {
+	unsigned err;
+	unsigned table;
+	unsigned selector[8];
+};
+
+void fitSubblock(
+	const uint8_t (&texel)[16][3],
+	const Subblock& sub,
+	const int (&base)[3],
+	SubblockFit& fit)
+{
+	fit.err = -1U;
+
+	for (unsigned t = 0; t < 8; ++t) {
+		unsigned err = 0;
+		unsigned selector[8];
+
+		for (unsigned i = 0; i < 8; ++i) {
+			const uint8_t* const c = texel[sub.texel[i]];
+			unsigned best = -1U;
+
+			for (unsigned s = 0; s < 4; ++s) {
+				const int mod = etc1Modifier(t, s);
+				const int dr = clamp(base[0] + mod, 0, 255) - c[0];
+				const int dg = clamp(base[1] + mod, 0, 255) - c[1];
+				const int db = clamp(base[2] + mod, 0, 255) - c[2];
+				const unsigned e = unsigned(dr * dr + dg * dg + db * db);
+
+				if (e < best) {
+					best = e;
+					selector[i] = s;
+				}
+			}
+
+			err += best;
+
+			if (err >= fit.err)
+				break;
+		}
+
+		if (err < fit.err) {
+			fit.err = err;
+			fit.table = t;
+			memcpy(fit.selector, selector, sizeof(selector));
+		}
+	}
+}
+
+// candidate quantized base colors of a subblock: each component of the average, rounded either way
+const unsigned num_candidates = 8;
+
+void getCandidates(
+	const uint8_t (&texel)[16][3],
+	const Subblock& sub,
+	const unsigned bits,
+	int (&quant)[num_candidates][3])
+{
+	const int max_q = (1 << bits) - 1;
+	int sum[3] = { 0, 0, 0 };
+
+	for (unsigned i = 0; i < 8; ++i)
+		for (unsigned j = 0; j < 3; ++j)
+			sum[j] += texel[sub.texel[i]][j];
+
+	for (unsigned k = 0; k < num_candidates; ++k)
+		for (unsigned j = 0; j < 3; ++j) {
+			// average * max_q / 255, floored, then bumped up per the bit of the candidate
+			const int lo = sum[j] * max_q / (8 * 255);
+			quant[k][j] = clamp(lo + int(k >> j & 1), 0, max_q);
+		}
+}
+
+struct EtcBlock {
+	unsigned err;
+	uint64_t bits;
+};
+
+void packEtc1(
+	const unsigned flip,
+	const bool diff,
+	const int (&q0)[3],
+	const int (&q1)[3], // for diff: the delta from q0
+	const Subblock (&sub)[2],
+	const SubblockFit& fit0,
+	const SubblockFit& fit1,
+	EtcBlock& block)
+{
+	uint64_t bits = 0;
+
+	if (diff) {
+		for (unsigned j = 0; j < 3; ++j)
+			bits |= uint64_t(q0[j] << 3 | (q1[j] & 7)) << (56 - j * 8);
+	}
+	else {
+		for (unsigned j = 0; j < 3; ++j)
+			bits |= uint64_t(q0[j] << 4 | q1[j]) << (56 - j * 8);
+	}
+
+	bits |= uint64_t(fit0.table) << 37;
+	bits |= uint64_t(fit1.table) << 34;
+	bits |= uint64_t(diff) << 33;
+	bits |= uint64_t(flip) << 32;
+
+	const SubblockFit* const fit[] = { &fit0, &fit1 };
+
+	for (unsigned s = 0; s < 2; ++s)
+		for (unsigned i = 0; i < 8; ++i) {
+			// selectors go in column-major texel order, MSBs in the upper half-word
+			const unsigned p = sub[s].texel[i];
+			const unsigned j = (p & 3) * 4 + (p >> 2);
+			const unsigned sel = fit[s]->selector[i];
+
+			bits |= uint64_t(sel >> 1) << (16 + j);
+			bits |= uint64_t(sel & 1) << j;
+		}
+
+	block.err = fit0.err + fit1.err;
+	block.bits = bits;
+}
+
+void encodeBlockRGB8(
+	const uint8_t (&texel)[16][3],
+	uint8_t* const dst)
+{
+	EtcBlock best = { -1U, 0 };
+
+	for (unsigned flip = 0; flip < 2; ++flip) {
+		Subblock sub[2];
+		getSubblocks(flip, sub);
+
+		// individual mode: two 4-bit base colors
+		int q4[2][num_candidates][3];
+		SubblockFit fit4[2];
+		unsigned pick4[2];
+
+		for (unsigned s = 0; s < 2; ++s) {
+			getCandidates(texel, sub[s], 4, q4[s]);
+			fit4[s].err = -1U;
+
+			for (unsigned k = 0; k < num_candidates; ++k) {
+				const int base[3] = { expand4(q4[s][k][0]), expand4(q4[s][k][1]), expand4(q4[s][k][2]) };
+				SubblockFit fit;
+				fitSubblock(texel, sub[s], base, fit);
+
+				if (fit.err < fit4[s].err) {
+					fit4[s] = fit;
+					pick4[s] = k;
+				}
+			}
+		}
+
+		EtcBlock block;
+		packEtc1(flip, false, q4[0][pick4[0]], q4[1][pick4[1]], sub, fit4[0], fit4[1], block);
+
+		if (block.err < best.err)
+			best = block;
+
+		// differential mode: a 5-bit base color and a 3-bit signed delta to the second one
+		int q5[2][num_candidates][3];
+		SubblockFit fit5[2][num_candidates];
+
+		for (unsigned s = 0; s < 2; ++s) {
+			getCandidates(texel, sub[s], 5, q5[s]);
+
+			for (unsigned k = 0; k < num_candidates; ++k) {
+				const int base[3] = { expand5(q5[s][k][0]), expand5(q5[s][k][1]), expand5(q5[s][k][2]) };
+				fitSubblock(texel, sub[s], base, fit5[s][k]);
+			}
+		}
+
+		for (unsigned k0 = 0; k0 < num_candidates; ++k0)
+			for (unsigned k1 = 0; k1 < num_candidates; ++k1) {
+				int delta[3];
+				bool valid = true;
+
+				for (unsigned j = 0; j < 3; ++j) {
+					delta[j] = q5[1][k1][j] - q5[0][k0][j];
+					valid = valid && -4 <= delta[j] && delta[j] <= 3;
+				}
+
+				if (!valid || fit5[0][k0].err + fit5[1][k1].err >= best.err)
+					continue;
+
+				packEtc1(flip, true, q5[0][k0], delta, sub, fit5[0][k0], fit5[1][k1], best);
+			}
+	}
+
+	storeBigEndian(best.bits, dst);
+}
+
+void decodeBlockRGB8(
+	const uint8_t* const src,
+	uint8_t (&texel)[16][3])
+{
+	const uint64_t bits = loadBigEndian(src);
+	const bool diff = 0 != (bits >> 33 & 1);
+	const unsigned flip = unsigned(bits >> 32 & 1);
+	const unsigned table[2] = { unsigned(bits >> 37 & 7), unsigned(bits >> 34 & 7) };
+	int base[2][3];
+
+	for (unsigned j = 0; j < 3; ++j) {
+		if (diff) {
+			const int c0 = int(bits >> (59 - j * 8) & 31);
+			const int d = int(bits >> (56 - j * 8) & 7);
+			const int c1 = c0 + (d & 4 ? d - 8 : d);
+
+			// encoder output only: the second base color never overflows into the ETC2 modes
+			assert(0 <= c1 && c1 < 32);
+			base[0][j] = expand5(c0);
+			base[1][j] = expand5(c1);
+		}
+		else {
+			base[0][j] = expand4(int(bits >> (60 - j * 8) & 15));
+			base[1][j] = expand4(int(bits >> (56 - j * 8) & 15));
+		}
+	}
+
+	for (unsigned y = 0; y < 4; ++y)
+		for (unsigned x = 0; x < 4; ++x) {
+			const unsigned j = x * 4 + y;
+			const unsigned s = flip ? y >> 1 : x >> 1;
+			const unsigned sel = unsigned(bits >> (16 + j) & 1) << 1 | unsigned(bits >> j & 1);
+			const int mod = etc1Modifier(table[s], sel);
+
+			for (unsigned c = 0; c < 3; ++c)
+				texel[y * 4 + x][c] = uint8_t(clamp(base[s][c] + mod, 0, 255));
+		}
+}
+
+// EAC value of a texel, 11-bit
+inline int eacValue(
+	const int base,
+	const int mul,
+	const unsigned table,
+	const unsigned selector)
+{
+	return clamp(base * 8 + 4 + eac_modifier[table][selector] * mul * 8, 0, 2047);
+}
+
+// EAC single-channel block from the specified channel of the texels
+void encodeBlockEAC(
+	const uint8_t (&texel)[16][3],
+	const unsigned channel,
+	uint8_t* const dst)
+{
+	// targets in 11 bits
+	int target[16];
+	int lo = 2047;
+	int hi = 0;
+
+	for (unsigned i = 0; i < 16; ++i) {
+		const int v = texel[i][channel];
+		target[i] = v << 3 | v >> 5;
+		lo = target[i] < lo ? target[i] : lo;
+		hi = target[i] > hi ? target[i] : hi;
+	}
+
+	unsigned best_err = -1U;
+	uint64_t best_bits = 0;
+
+	for (unsigned t = 0; t < 16; ++t) {
+		const int mod_lo = eac_modifier[t][3];
+		const int mod_hi = eac_modifier[t][7];
+		const int span = (mod_hi - mod_lo) * 8;
+		const int mul_guess = (hi - lo + span / 2) / span;
+
+		for (int mul = mul_guess - 1; mul <= mul_guess + 1; ++mul) {
+			if (mul < 1 || mul > 15)
+				continue;
+
+			// center the span of the modifiers on the span of the targets
+			const int base_guess = ((lo + hi) / 2 - 4 - (mod_lo + mod_hi) * mul * 4) / 8;
+
+			for (int base = base_guess - 1; base <= base_guess + 1; ++base) {
+				if (base < 0 || base > 255)
+					continue;
+
+				unsigned err = 0;
+				uint64_t selectors = 0;
+
+				for (unsigned x = 0; x < 4 && err < best_err; ++x)
+					for (unsigned y = 0; y < 4; ++y) {
+						const int tv = target[y * 4 + x];
+						unsigned best = -1U;
+						unsigned best_sel = 0;
+
+						for (unsigned s = 0; s < 8; ++s) {
+							const int d = eacValue(base, mul, t, s) - tv;
+							const unsigned e = unsigned(d * d);
+
+							if (e < best) {
+								best = e;
+								best_sel = s;
+							}
+						}
+
+						err += best;
+						selectors = selectors << 3 | best_sel;
+					}
+
+				if (err < best_err) {
+					best_err = err;
+					best_bits = uint64_t(base) << 56 | uint64_t(mul) << 52 | uint64_t(t) << 48 | selectors;
+				}
+			}
+		}
+	}
+
+	storeBigEndian(best_bits, dst);
+}
+
+void decodeBlockEAC(
+	const uint8_t* const src,
+	const unsigned channel,
+	uint8_t (&texel)[16][3])
+{
+	const uint64_t bits = loadBigEndian(src);
+	const int base = int(bits >> 56);
+	const int mul = int(bits >> 52 & 15);
+	const unsigned table = unsigned(bits >> 48 & 15);
+
+	for (unsigned x = 0; x < 4; ++x)
+		for (unsigned y = 0; y < 4; ++y) {
+			const unsigned sel = unsigned(bits >> (45 - (x * 4 + y) * 3) & 7);
+			const int v = mul ? eacValue(base, mul, table, sel) : clamp(base * 8 + 4 + eac_modifier[table][sel], 0, 2047);
+
+			texel[y * 4 + x][channel] = uint8_t((v * 255 + 1023) / 2047);
+		}
+}
+
+size_t blockSize(
+	const EtcFormat format)
+{
+	return ETC_FORMAT_RG11 == format ? 16 : 8;
+}
+
+} // namespace
+
+size_t etc_image_size(
+	const EtcFormat format,
+	const unsigned w,
+	const unsigned h)
+{
+	return size_t((w + 3) / 4) * ((h + 3) / 4) * blockSize(format);
+}
+
+void etc_encode(
+	const EtcFormat format,
+	const uint8_t* const src,
+	const unsigned w,
+	const unsigned h,
+	const unsigned first_block_row,
+	const unsigned num_block_rows,
+	uint8_t* const dst)
+{
+	assert(0 != src && 0 != dst);
+	assert(first_block_row + num_block_rows <= (h + 3) / 4);
+
+	const unsigned blocks_w = (w + 3) / 4;
+	const size_t block_size = blockSize(format);
+
+	for (unsigned by = first_block_row; by < first_block_row + num_block_rows; ++by)
+		for (unsigned bx = 0; bx < blocks_w; ++bx) {
+			uint8_t texel[16][3];
+			fetchBlock(src, w, h, bx, by, texel);
+
+			uint8_t* const block = dst + (size_t(by) * blocks_w + bx) * block_size;
+
+			if (ETC_FORMAT_RG11 == format) {
+				encodeBlockEAC(texel, 0, block);
+				encodeBlockEAC(texel, 1, block + 8);
+			}
+			else
+				encodeBlockRGB8(texel, block);
+		}
+}
+
+void etc_decode(
+	const EtcFormat format,
+	const uint8_t* const src,
+	const unsigned w,
+	const unsigned h,
+	uint8_t* const dst)
+{
+	assert(0 != src && 0 != dst);
+
+	const unsigned blocks_w = (w + 3) / 4;
+	const size_t block_size = blockSize(format);
+
+	for (unsigned by = 0; by < (h + 3) / 4; ++by)
+		for (unsigned bx = 0; bx < blocks_w; ++bx) {
+			const uint8_t* const block = src + (size_t(by) * blocks_w + bx) * block_size;
+			uint8_t texel[16][3] = {};
+
+			if (ETC_FORMAT_RG11 == format) {
+				decodeBlockEAC(block, 0, texel);
+				decodeBlockEAC(block + 8, 1, texel);
+			}
+			else
+				decodeBlockRGB8(block, texel);
+
+			for (unsigned y = 0; y < 4 && by * 4 + y < h; ++y)
+				for (unsigned x = 0; x < 4 && bx * 4 + x < w; ++x)
+					memcpy(dst + (size_t(by * 4 + y) * w + bx * 4 + x) * 3, texel[y * 4 + x], 3);
+		}
+}
+
+} // namespace util
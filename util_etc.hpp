@@ -0,0 +1,51 @@
+#ifndef util_etc_H__
+#define util_etc_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace util {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// ETC2 RGB8 and EAC RG11 block compression of tightly packed RGB888 images, 4x4 texels per block;
+// RG11 takes the r and g channels only, e.g. the x and y of a tangent-space normal map. RGB8 blocks
+// get encoded in the individual and differential modes ETC2 inherits from ETC1, which any ETC2
+// decoder accepts. Blocks past the edges of the image replicate the edge texels.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+enum EtcFormat {
+	ETC_FORMAT_RGB8,	// GL_COMPRESSED_RGB8_ETC2, 8 bytes per block
+	ETC_FORMAT_RG11,	// GL_COMPRESSED_RG11_EAC, 16 bytes per block
+
+	ETC_FORMAT_COUNT,
+	ETC_FORMAT_FORCE_UINT = -1U
+};
+
+// byte size of an image of the specified dimensions in the specified format
+size_t etc_image_size(
+	const EtcFormat format,
+	const unsigned w,
+	const unsigned h);
+
+// compress the specified span of block rows of an image; dst is the start of the entire compressed
+// image, so disjoint spans can be compressed concurrently
+void etc_encode(
+	const EtcFormat format,
+	const uint8_t* const src,
+	const unsigned w,
+	const unsigned h,
+	const unsigned first_block_row,
+	const unsigned num_block_rows,
+	uint8_t* const dst);
+
+// decompress an image produced by etc_encode back to RGB888; RG11 yields zero for the b channel
+void etc_decode(
+	const EtcFormat format,
+	const uint8_t* const src,
+	const unsigned w,
+	const unsigned h,
+	uint8_t* const dst);
+
+} // namespace util
+
+#endif // util_etc_H__
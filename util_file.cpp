@@ -1,11 +1,20 @@
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <vector>
 
 #include "scoped.hpp"
 #include "util_file.hpp"
+#include "util_lz.hpp"
+#include "util_pack.hpp"
+#include "util_preload.hpp"
 
 namespace util {
 
@@ -34,6 +43,14 @@ bool get_file_size(
 	size_t& size)
 {
 	assert(0 != filename);
+
+	const PackEntry* const packed = shared_asset_pack().find(filename);
+
+	if (0 != packed) {
+		size = size_t(packed->size);
+		return true;
+	}
+
 	struct stat filestat;
 
 	if (-1 == stat(filename, &filestat)) {
@@ -58,36 +75,321 @@ char* get_buffer_from_file(
 	assert(0 != filename);
 	assert(0 == (roundToIntegralMultiple & roundToIntegralMultiple - 1));
 
-	if (!get_file_size(filename, size)) {
-		fprintf(stderr, "%s cannot get size of file '%s'\n", __FUNCTION__, filename);
-		return 0;
+	const size_t roundTo = roundToIntegralMultiple - 1;
+
+	// preloaded files come in a buffer of their own
+	scoped_ptr< char, generic_free > source(
+		reinterpret_cast< char* >(shared_file_preload().take(filename, size, roundTo)));
+
+	if (0 == source()) {
+		if (!get_file_size(filename, size)) {
+			fprintf(stderr, "%s cannot get size of file '%s'\n", __FUNCTION__, filename);
+			return 0;
+		}
+
+		scoped_ptr< char, generic_free > buffer(
+			reinterpret_cast< char* >(malloc((size + roundTo) & ~roundTo)));
+		source.swap(buffer);
+
+		if (0 == source()) {
+			fprintf(stderr, "%s cannot allocate memory for file '%s'\n", __FUNCTION__, filename);
+			return 0;
+		}
+
+		const asset_pack& pack = shared_asset_pack();
+		const PackEntry* const packed = pack.find(filename);
+
+		if (0 != packed)
+			memcpy(source(), pack.data(*packed), size);
+		else {
+			const scoped_ptr< FILE, scoped_functor > file(fopen(filename, "rb"));
+
+			if (0 == file()) {
+				fprintf(stderr, "%s cannot open file '%s'\n", __FUNCTION__, filename);
+				return 0;
+			}
+
+			if (1 != fread(source(), size, 1, file())) {
+				fprintf(stderr, "%s cannot read from file '%s'\n", __FUNCTION__, filename);
+				return 0;
+			}
+		}
+	}
+
+	// block containers get decompressed in place of their content
+	size_t raw_size;
+
+	if (is_lz_container(reinterpret_cast< const uint8_t* >(source()), size, &raw_size)) {
+		scoped_ptr< char, generic_free > raw(
+			reinterpret_cast< char* >(malloc((raw_size + roundTo) & ~roundTo)));
+
+		if (0 == raw()) {
+			fprintf(stderr, "%s cannot allocate memory for file '%s'\n", __FUNCTION__, filename);
+			return 0;
+		}
+
+		if (!lz_decompress(reinterpret_cast< const uint8_t* >(source()), size, reinterpret_cast< uint8_t* >(raw()), raw_size)) {
+			fprintf(stderr, "%s encountered a malformed container '%s'\n", __FUNCTION__, filename);
+			return 0;
+		}
+
+		source.swap(raw);
+		size = raw_size;
+	}
+
+	char* const ret = source();
+	source.reset();
+
+	return ret;
+}
+
+bool mapped_file::open(
+	const char* const filename,
+	const bool sequential,
+	const size_t guardband)
+{
+	assert(0 != filename);
+	close();
+
+	// packed files come straight out of the mapping of the pack, where the zero padding up to the
+	// next entry covers the guardband same as the tail of a page would
+	const asset_pack& pack = shared_asset_pack();
+	const PackEntry* const packed = pack.find(filename);
+
+	if (0 != packed) {
+		const size_t entry_size = size_t(packed->size);
+		const size_t padding = (pack_alignment - entry_size % pack_alignment) % pack_alignment;
+
+		if (padding >= guardband) {
+			addr = const_cast< uint8_t* >(pack.data(*packed));
+			size = entry_size;
+			heap = false;
+			borrowed = true;
+			return inflate(filename, guardband);
+		}
+
+		uint8_t* const copy = reinterpret_cast< uint8_t* >(malloc(entry_size + guardband + 1));
+
+		if (0 == copy) {
+			fprintf(stderr, "%s cannot allocate memory for file '%s'\n", __FUNCTION__, filename);
+			return false;
+		}
+
+		memcpy(copy, pack.data(*packed), entry_size);
+		memset(copy + entry_size, 0, guardband + 1);
+
+		addr = copy;
+		size = entry_size;
+		heap = true;
+		return inflate(filename, guardband);
 	}
 
-	const scoped_ptr< FILE, scoped_functor > file(fopen(filename, "rb"));
+	const int fd = ::open(filename, O_RDONLY);
 
-	if (0 == file()) {
+	if (-1 == fd) {
 		fprintf(stderr, "%s cannot open file '%s'\n", __FUNCTION__, filename);
-		return 0;
+		return false;
 	}
 
-	const size_t roundTo = roundToIntegralMultiple - 1;
-	scoped_ptr< char, generic_free > source(
-		reinterpret_cast< char* >(malloc((size + roundTo) & ~roundTo)));
+	struct stat filestat;
 
-	if (0 == source()) {
+	if (-1 == fstat(fd, &filestat) || !S_ISREG(filestat.st_mode)) {
+		fprintf(stderr, "%s encountered a non-regular file '%s'\n", __FUNCTION__, filename);
+		::close(fd);
+		return false;
+	}
+
+	const size_t file_size = size_t(filestat.st_size);
+	const size_t page_size = size_t(sysconf(_SC_PAGESIZE));
+	const size_t tail_slack = (page_size - file_size % page_size) % page_size;
+
+	// map unless the file is empty or the tail of its last page cannot cover the guardband
+	if (0 != file_size && tail_slack >= guardband) {
+		void* const mapping = mmap(0, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+		if (MAP_FAILED != mapping) {
+			if (sequential)
+				madvise(mapping, file_size, MADV_SEQUENTIAL);
+
+			madvise(mapping, file_size, MADV_WILLNEED);
+			::close(fd);
+
+			addr = mapping;
+			size = file_size;
+			heap = false;
+			return inflate(filename, guardband);
+		}
+	}
+
+	// fall back to a heap copy; zero the guardband same as a mapping would
+	scoped_ptr< uint8_t, generic_free > copy(
+		reinterpret_cast< uint8_t* >(malloc(file_size + guardband + 1)));
+
+	if (0 == copy()) {
 		fprintf(stderr, "%s cannot allocate memory for file '%s'\n", __FUNCTION__, filename);
-		return 0;
+		::close(fd);
+		return false;
 	}
 
-	if (1 != fread(source(), size, 1, file())) {
+	size_t done = 0;
+
+	while (done < file_size) {
+		const ssize_t res = read(fd, copy() + done, file_size - done);
+
+		if (0 < res) {
+			done += size_t(res);
+			continue;
+		}
+
+		if (-1 == res && EINTR == errno)
+			continue;
+
 		fprintf(stderr, "%s cannot read from file '%s'\n", __FUNCTION__, filename);
+		::close(fd);
+		return false;
+	}
+
+	::close(fd);
+	memset(copy() + file_size, 0, guardband + 1);
+
+	addr = copy();
+	size = file_size;
+	heap = true;
+	copy.reset();
+
+	return inflate(filename, guardband);
+}
+
+bool mapped_file::inflate(
+	const char* const filename,
+	const size_t guardband)
+{
+	size_t raw_size;
+
+	if (!is_lz_container(data(), size, &raw_size))
+		return true;
+
+	scoped_ptr< uint8_t, generic_free > raw(
+		reinterpret_cast< uint8_t* >(malloc(raw_size + guardband + 1)));
+
+	if (0 == raw()) {
+		fprintf(stderr, "%s cannot allocate memory for file '%s'\n", __FUNCTION__, filename);
+		close();
+		return false;
+	}
+
+	if (!lz_decompress(data(), size, raw(), raw_size)) {
+		fprintf(stderr, "%s encountered a malformed container '%s'\n", __FUNCTION__, filename);
+		close();
+		return false;
+	}
+
+	memset(raw() + raw_size, 0, guardband + 1);
+	close();
+
+	addr = raw();
+	size = raw_size;
+	heap = true;
+	raw.reset();
+
+	return true;
+}
+
+void mapped_file::close()
+{
+	if (0 == addr)
+		return;
+
+	if (heap)
+		free(addr);
+	else
+	if (!borrowed)
+		munmap(addr, size);
+
+	addr = 0;
+	size = 0;
+	heap = false;
+	borrowed = false;
+}
+
+// stream over a copy of the content, in a buffer of the stream's own
+static FILE* open_stream(
+	const uint8_t* const data,
+	const size_t size)
+{
+	// a stream of its own buffer terminates the content, at the cost of a byte of room
+	FILE* const file = fmemopen(0, size + 1, "w+b");
+
+	if (0 == file)
+		return 0;
+
+	if (0 != size && 1 != fwrite(data, size, 1, file)) {
+		fclose(file);
 		return 0;
 	}
 
-	char* const ret = source();
-	source.reset();
+	rewind(file);
+	return file;
+}
 
-	return ret;
+FILE* open_file(
+	const char* const filename)
+{
+	assert(0 != filename);
+
+	const asset_pack& pack = shared_asset_pack();
+	const PackEntry* const packed = pack.find(filename);
+
+	if (0 == packed) {
+		size_t size;
+		const scoped_ptr< uint8_t, generic_free > preloaded(shared_file_preload().take(filename, size));
+
+		if (0 != preloaded())
+			return open_stream(preloaded(), size);
+
+		return fopen(filename, "rb");
+	}
+
+	const uint8_t* const data = pack.data(*packed);
+	const size_t entry_size = size_t(packed->size);
+
+	if (0 == (packed->flags & PACK_FLAG_LZ))
+		return fmemopen(const_cast< uint8_t* >(data), entry_size, "rb");
+
+	// compressed entries come decompressed, into the buffer of a stream of their own
+	size_t raw_size;
+
+	if (!is_lz_container(data, entry_size, &raw_size) || 0 == raw_size) {
+		fprintf(stderr, "%s encountered a malformed container '%s'\n", __FUNCTION__, filename);
+		return 0;
+	}
+
+	std::vector< uint8_t > raw(raw_size);
+
+	if (!lz_decompress(data, entry_size, &raw[0], raw_size)) {
+		fprintf(stderr, "%s encountered a malformed container '%s'\n", __FUNCTION__, filename);
+		return 0;
+	}
+
+	return open_stream(&raw[0], raw_size);
+}
+
+int open_file_fd(
+	const char* const filename,
+	uint64_t& base)
+{
+	assert(0 != filename);
+
+	const asset_pack& pack = shared_asset_pack();
+	const PackEntry* const packed = pack.find(filename);
+
+	if (0 != packed && 0 == (packed->flags & PACK_FLAG_LZ)) {
+		base = packed->offset;
+		return dup(pack.get_fd());
+	}
+
+	base = 0;
+	return ::open(filename, O_RDONLY);
 }
 
 } // namespace util
@@ -1,17 +1,96 @@
 #ifndef util_file_H__
 #define util_file_H__
 
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "scoped.hpp"
+
 namespace util {
 
 bool get_file_size(
 	const char* const filename,
 	size_t& size);
 
+// read the entire content of a file to a buffer of the heap, rounded up in size to the specified power
+// of two; a file in the block container of util_lz comes decompressed
 char* get_buffer_from_file(
 	const char* const filename,
 	size_t& size,
 	const size_t roundToIntegralMultiple = 1);
 
+// open a file for stream reads; a file of the asset pack reads from the mapping of the pack, or from
+// a decompressed copy if stored compressed
+FILE* open_file(
+	const char* const filename);
+
+// open a file for positioned reads, returning the offset of its content in the file descriptor; a file
+// of the asset pack comes as a descriptor of the pack, unless stored compressed; return -1 upon failure
+int open_file_fd(
+	const char* const filename,
+	uint64_t& base);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// mapped_file provides read-only access to the entire content of a file, by a private mapping where
+// possible, or by a heap copy otherwise. The caller may request a guardband -- a number of readable
+// bytes past the end of the content, e.g. for word-sized over-reads of 3-byte pixels; a mapping
+// satisfies that from the zero-filled tail of its last page, or the heap copy takes over. A file in
+// the block container of util_lz gets decompressed to the heap across threads -- fewer bytes come off
+// the storage, at the cost of a copy. A file of the asset pack gets used in place, out of the mapping
+// of the pack.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class mapped_file : non_copyable
+{
+	void* addr;
+	size_t size;
+	bool heap;
+	bool borrowed; // part of the mapping of the asset pack
+
+	// replace the content of a block container by its decompression; return false upon failure
+	bool inflate(
+		const char* const filename,
+		const size_t guardband);
+
+public:
+	mapped_file()
+	: addr(0)
+	, size(0)
+	, heap(false)
+	, borrowed(false)
+	{}
+
+	~mapped_file()
+	{
+		close();
+	}
+
+	// access the file, advising the kernel of sequential or random access, and prefetching either way;
+	// return false if the file cannot be accessed
+	bool open(
+		const char* const filename,
+		const bool sequential = true,
+		const size_t guardband = 0);
+
+	void close();
+
+	const uint8_t* data() const
+	{
+		return reinterpret_cast< const uint8_t* >(addr);
+	}
+
+	size_t length() const
+	{
+		return size;
+	}
+
+	// whether the content is mapped, as opposed to copied to the heap
+	bool is_mapped() const
+	{
+		return 0 != addr && !heap;
+	}
+};
+
 } // namespace util
 
 #endif // util_file_H__
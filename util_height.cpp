@@ -0,0 +1,240 @@
+#include <assert.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <vector>
+
+#if __SSE__ == 1
+	#include <xmmintrin.h>
+#elif __ARM_NEON__ == 1 || __ARM_NEON == 1
+	#include <arm_neon.h>
+#endif
+
+#include "util_height.hpp"
+
+namespace util {
+
+namespace { // anonymous
+
+// texel count from which an automatic thread count goes parallel
+const size_t parallel_threshold = 1 << 18;
+
+const unsigned max_threads = 8;
+
+typedef float v4f __attribute__ ((vector_size(4 * sizeof(float))));
+
+inline v4f load(
+	const float* const src)
+{
+	v4f v;
+	memcpy(&v, src, sizeof(v));
+	return v;
+}
+
+inline v4f splat(
+	const float a)
+{
+	const v4f v = { a, a, a, a };
+	return v;
+}
+
+inline v4f rsqrt(
+	const v4f a)
+{
+#if __SSE__ == 1
+	return v4f(_mm_div_ps(_mm_set1_ps(1.f), _mm_sqrt_ps(__m128(a))));
+
+#elif __ARM_NEON__ == 1 || __ARM_NEON == 1
+	// estimate, refined by two Newton-Raphson steps
+	const float32x4_t x = float32x4_t(a);
+	float32x4_t r = vrsqrteq_f32(x);
+	r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(x, r), r));
+	r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(x, r), r));
+	return v4f(r);
+
+#else
+	const v4f r = { 1.f / sqrtf(a[0]), 1.f / sqrtf(a[1]), 1.f / sqrtf(a[2]), 1.f / sqrtf(a[3]) };
+	return r;
+
+#endif
+}
+
+inline uint8_t quantize(
+	const float n)
+{
+	const float q = n * 127.5f + 128.f;
+	return uint8_t(q < 255.f ? q : 255.f);
+}
+
+// a height row as floats, along with one texel of padding at either end, per the wrap mode
+void fetchRow(
+	const uint8_t* const src,
+	const unsigned w,
+	const unsigned h,
+	const int y,
+	const HeightWrap wrap,
+	float* const row)
+{
+	const unsigned wrapped_y = HEIGHT_WRAP_REPEAT == wrap
+		? unsigned((y % int(h) + int(h)) % int(h))
+		: unsigned(y < 0 ? 0 : y >= int(h) ? int(h) - 1 : y);
+
+	const uint8_t* const src_row = src + size_t(wrapped_y) * w;
+
+	for (unsigned x = 0; x < w; ++x)
+		row[x + 1] = float(src_row[x]);
+
+	row[0] = HEIGHT_WRAP_REPEAT == wrap ? row[w] : row[1];
+	row[w + 1] = HEIGHT_WRAP_REPEAT == wrap ? row[1] : row[w];
+}
+
+struct HeightJob {
+	const uint8_t* src;
+	unsigned w;
+	unsigned h;
+	HeightDesc desc;
+	uint8_t* dst;
+	unsigned first_row;
+	unsigned num_rows;
+};
+
+void normalRange(
+	const HeightJob& job)
+{
+	const unsigned w = job.w;
+	const size_t padded = size_t(w) + 2;
+
+	// filter weights of the outer and the center row/column, normalized to a unit gradient for a unit
+	// slope, and scaled from 8-bit heights by the strength
+	const float norm = HEIGHT_FILTER_SOBEL == job.desc.filter ? 1.f / 8.f : 1.f / 32.f;
+	const float scale = job.desc.strength * norm / 255.f;
+	const float a = (HEIGHT_FILTER_SOBEL == job.desc.filter ? 1.f : 3.f) * scale;
+	const float b = (HEIGHT_FILTER_SOBEL == job.desc.filter ? 2.f : 10.f) * scale;
+
+	// rolling window of three padded rows
+	std::vector< float > window(padded * 3);
+	float* r0 = &window[0];
+	float* r1 = &window[padded];
+	float* r2 = &window[padded * 2];
+
+	fetchRow(job.src, w, job.h, int(job.first_row) - 1, job.desc.wrap, r0);
+	fetchRow(job.src, w, job.h, int(job.first_row), job.desc.wrap, r1);
+
+	const v4f va = splat(a);
+	const v4f vb = splat(b);
+
+	for (unsigned y = job.first_row; y < job.first_row + job.num_rows; ++y) {
+		fetchRow(job.src, w, job.h, int(y) + 1, job.desc.wrap, r2);
+
+		uint8_t* out = job.dst + size_t(y) * w * 3;
+		unsigned x = 0;
+
+		// four texels at a time: the normal is (-dh/dx, -dh/dy, 1), normalized
+		for (; x + 4 <= w; x += 4, out += 12) {
+			const v4f l0 = load(r0 + x);
+			const v4f m0 = load(r0 + x + 1);
+			const v4f h0 = load(r0 + x + 2);
+			const v4f l1 = load(r1 + x);
+			const v4f h1 = load(r1 + x + 2);
+			const v4f l2 = load(r2 + x);
+			const v4f m2 = load(r2 + x + 1);
+			const v4f h2 = load(r2 + x + 2);
+
+			const v4f gx = va * (h0 - l0) + vb * (h1 - l1) + va * (h2 - l2);
+			const v4f gy = va * (l2 - l0) + vb * (m2 - m0) + va * (h2 - h0);
+			const v4f inv = rsqrt(gx * gx + gy * gy + splat(1.f));
+
+			const v4f nx = -gx * inv;
+			const v4f ny = -gy * inv;
+
+			for (unsigned i = 0; i < 4; ++i) {
+				out[i * 3 + 0] = quantize(nx[i]);
+				out[i * 3 + 1] = quantize(ny[i]);
+				out[i * 3 + 2] = quantize(inv[i]);
+			}
+		}
+
+		for (; x < w; ++x, out += 3) {
+			const float gx = a * (r0[x + 2] - r0[x]) + b * (r1[x + 2] - r1[x]) + a * (r2[x + 2] - r2[x]);
+			const float gy = a * (r2[x] - r0[x]) + b * (r2[x + 1] - r0[x + 1]) + a * (r2[x + 2] - r0[x + 2]);
+			const float inv = 1.f / sqrtf(gx * gx + gy * gy + 1.f);
+
+			out[0] = quantize(-gx * inv);
+			out[1] = quantize(-gy * inv);
+			out[2] = quantize(inv);
+		}
+
+		float* const recycled = r0;
+		r0 = r1;
+		r1 = r2;
+		r2 = recycled;
+	}
+}
+
+void* normalWorker(
+	void* arg)
+{
+	normalRange(*reinterpret_cast< const HeightJob* >(arg));
+	return 0;
+}
+
+} // namespace
+
+void normal_from_height(
+	const uint8_t* const src,
+	const unsigned w,
+	const unsigned h,
+	const HeightDesc& desc,
+	uint8_t* const dst,
+	const unsigned num_threads)
+{
+	assert(0 != src && 0 != dst);
+	assert(0 != w && 0 != h);
+
+	unsigned threads = num_threads;
+
+	if (0 == threads) {
+		const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = parallel_threshold <= size_t(w) * h && 1 < cpus ? unsigned(cpus) : 1;
+	}
+
+	if (max_threads < threads)
+		threads = max_threads;
+
+	if (h < threads)
+		threads = h;
+
+	const unsigned rows_per_thread = (h + threads - 1) / threads;
+
+	HeightJob job[max_threads];
+	pthread_t worker[max_threads];
+	bool spawned[max_threads] = { false };
+
+	for (unsigned i = 0; i < threads; ++i) {
+		const unsigned first = rows_per_thread * i;
+		const unsigned last = first + rows_per_thread;
+
+		job[i].src = src;
+		job[i].w = w;
+		job[i].h = h;
+		job[i].desc = desc;
+		job[i].dst = dst;
+		job[i].first_row = first < h ? first : h;
+		job[i].num_rows = (last < h ? last : h) - job[i].first_row;
+	}
+
+	// thread 0 is the caller; should a worker fail to spawn, the caller picks up its job
+	for (unsigned i = 1; i < threads; ++i)
+		spawned[i] = 0 == pthread_create(worker + i, 0, normalWorker, job + i);
+
+	for (unsigned i = 0; i < threads; ++i)
+		if (!spawned[i])
+			normalRange(job[i]);
+
+	for (unsigned i = 1; i < threads; ++i)
+		if (spawned[i])
+			pthread_join(worker[i], 0);
+}
+
+} // namespace util
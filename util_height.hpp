@@ -0,0 +1,50 @@
+#ifndef util_height_H__
+#define util_height_H__
+
+#include <stdint.h>
+
+namespace util {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// derivation of tangent-space normal maps from 8-bit height maps, for shipping a third of the bytes
+// of a normal map: the height gradient comes from a 3x3 Sobel or Scharr filter, four texels at a time
+// in SIMD, and large maps get split across threads. Rows are taken bottom-up, as in .raw, so that the
+// gradient along y follows the t texture coordinate.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+enum HeightFilter {
+	HEIGHT_FILTER_SOBEL,	// 1-2-1 smoothing across the derivative
+	HEIGHT_FILTER_SCHARR,	// 3-10-3 smoothing across the derivative; more rotation-invariant
+
+	HEIGHT_FILTER_COUNT,
+	HEIGHT_FILTER_FORCE_UINT = -1U
+};
+
+enum HeightWrap {
+	HEIGHT_WRAP_REPEAT,		// heights wrap around the edges, as for tiling textures
+	HEIGHT_WRAP_CLAMP,		// heights past the edges repeat the edge texels
+
+	HEIGHT_WRAP_COUNT,
+	HEIGHT_WRAP_FORCE_UINT = -1U
+};
+
+struct HeightDesc {
+	float strength;			// gradient scale: full-range height difference per texel at strength 1
+	HeightFilter filter;
+	HeightWrap wrap;
+};
+
+// produce a tightly packed RGB888 normal map from a height map of the same dimensions, across the
+// specified number of threads; zero threads means one per online CPU for large maps, and a single
+// thread otherwise
+void normal_from_height(
+	const uint8_t* const src,
+	const unsigned w,
+	const unsigned h,
+	const HeightDesc& desc,
+	uint8_t* const dst,
+	const unsigned num_threads = 0);
+
+} // namespace util
+
+#endif // util_height_H__
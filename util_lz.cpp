@@ -0,0 +1,457 @@
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "util_lz.hpp"
+
+namespace { // anonymous
+
+const char magic[4] = { 'L', 'Z', 'B', '1' };
+
+// top bit of a block-table entry: the block is stored as is
+const uint32_t block_stored = 1U << 31;
+
+// codec parameters as of the LZ4 block format: matches of at least 4 bytes within a 64KB window, the
+// last 5 bytes always literals, and no match starting within the last 12 bytes
+const size_t min_match = 4;
+const size_t max_offset = 65535;
+const size_t last_literals = 5;
+const size_t match_find_limit = 12;
+const unsigned hash_log = 12;
+
+const unsigned max_threads = 8;
+
+inline uint32_t get32(
+	const uint8_t* const p)
+{
+	return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+
+inline void put32(
+	uint8_t* const p,
+	const uint32_t v)
+{
+	p[0] = uint8_t(v);
+	p[1] = uint8_t(v >> 8);
+	p[2] = uint8_t(v >> 16);
+	p[3] = uint8_t(v >> 24);
+}
+
+// unaligned native-order read, for match finding only
+inline uint32_t read32(
+	const uint8_t* const p)
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+inline unsigned hash4(
+	const uint32_t v)
+{
+	return (v * 2654435761U) >> (32 - hash_log);
+}
+
+// bytes to encode the remainder of a length past its 4-bit token field
+inline size_t length_size(
+	const size_t len)
+{
+	return 15 > len ? 0 : (len - 15) / 255 + 1;
+}
+
+inline uint8_t* put_length(
+	uint8_t* op,
+	size_t len)
+{
+	for (; 255 <= len; len -= 255)
+		*op++ = 255;
+
+	*op++ = uint8_t(len);
+	return op;
+}
+
+inline bool get_length(
+	const uint8_t*& ip,
+	const uint8_t* const iend,
+	size_t& len)
+{
+	unsigned b;
+
+	do {
+		if (iend == ip)
+			return false;
+
+		b = *ip++;
+		len += b;
+	}
+	while (255 == b);
+
+	return true;
+}
+
+// emit a sequence of literals followed by a match, or by nothing for the last sequence; return null if
+// past the capacity of the destination
+uint8_t* put_sequence(
+	uint8_t* op,
+	uint8_t* const oend,
+	const uint8_t* const lit,
+	const size_t num_lit,
+	const size_t offset,
+	const size_t match_len)
+{
+	const size_t ml = 0 != match_len ? match_len - min_match : 0;
+	const size_t seq_size = 1 + length_size(num_lit) + num_lit + (0 != match_len ? 2 + length_size(ml) : 0);
+
+	if (size_t(oend - op) < seq_size)
+		return 0;
+
+	uint8_t* const token = op++;
+	*token = uint8_t((15 > num_lit ? num_lit : 15) << 4);
+
+	if (15 <= num_lit)
+		op = put_length(op, num_lit - 15);
+
+	memcpy(op, lit, num_lit);
+	op += num_lit;
+
+	if (0 == match_len)
+		return op;
+
+	*op++ = uint8_t(offset);
+	*op++ = uint8_t(offset >> 8);
+	*token |= uint8_t(15 > ml ? ml : 15);
+
+	if (15 <= ml)
+		op = put_length(op, ml - 15);
+
+	return op;
+}
+
+// greedy single-pass compression of a block; return the compressed size, or zero if that would not fit
+// the specified capacity
+size_t compress_block(
+	const uint8_t* const src,
+	const size_t size,
+	uint8_t* const dst,
+	const size_t capacity)
+{
+	uint32_t table[1 << hash_log];
+	memset(table, 0, sizeof(table));
+
+	uint8_t* op = dst;
+	uint8_t* const oend = dst + capacity;
+	size_t anchor = 0;
+	size_t ip = 0;
+
+	while (ip + match_find_limit < size) {
+		const uint32_t seq = read32(src + ip);
+		const unsigned h = hash4(seq);
+		const size_t ref = table[h];
+		table[h] = uint32_t(ip);
+
+		if (ref >= ip || ip - ref > max_offset || read32(src + ref) != seq) {
+			// skip ahead faster the longer no match turns up, as over incompressible data
+			ip += 1 + ((ip - anchor) >> 6);
+			continue;
+		}
+
+		size_t len = min_match;
+		const size_t len_limit = size - last_literals - ip;
+
+		while (len < len_limit && src[ref + len] == src[ip + len])
+			++len;
+
+		op = put_sequence(op, oend, src + anchor, ip - anchor, ip - ref, len);
+
+		if (0 == op)
+			return 0;
+
+		ip += len;
+		anchor = ip;
+	}
+
+	op = put_sequence(op, oend, src + anchor, size - anchor, 0, 0);
+
+	return 0 != op ? size_t(op - dst) : 0;
+}
+
+bool decompress_block(
+	const uint8_t* const src,
+	const size_t size,
+	uint8_t* const dst,
+	const size_t dst_size)
+{
+	const uint8_t* ip = src;
+	const uint8_t* const iend = src + size;
+	uint8_t* op = dst;
+	uint8_t* const oend = dst + dst_size;
+
+	for (;;) {
+		if (iend == ip)
+			return false;
+
+		const unsigned token = *ip++;
+		size_t num_lit = token >> 4;
+
+		if (15 == num_lit && !get_length(ip, iend, num_lit))
+			return false;
+
+		if (size_t(iend - ip) < num_lit || size_t(oend - op) < num_lit)
+			return false;
+
+		memcpy(op, ip, num_lit);
+		ip += num_lit;
+		op += num_lit;
+
+		// the last sequence ends on its literals
+		if (iend == ip)
+			return oend == op;
+
+		if (2 > iend - ip)
+			return false;
+
+		const size_t offset = size_t(ip[0]) | size_t(ip[1]) << 8;
+		ip += 2;
+
+		size_t len = token & 15;
+
+		if (15 == len && !get_length(ip, iend, len))
+			return false;
+
+		len += min_match;
+
+		if (0 == offset || size_t(op - dst) < offset || size_t(oend - op) < len)
+			return false;
+
+		const uint8_t* ref = op - offset;
+
+		// overlapping matches repeat their pattern, so they copy byte by byte
+		if (offset >= len) {
+			memcpy(op, ref, len);
+			op += len;
+		}
+		else {
+			for (size_t i = 0; i < len; ++i)
+				*op++ = *ref++;
+		}
+	}
+}
+
+struct Layout
+{
+	size_t block_size;
+	size_t size;
+	size_t num_blocks;
+	const uint8_t* table;
+};
+
+bool parse_header(
+	const uint8_t* const src,
+	const size_t src_size,
+	Layout& layout)
+{
+	if (util::lz_header_size > src_size || 0 != memcmp(src, magic, sizeof(magic)))
+		return false;
+
+	const uint64_t size = uint64_t(get32(src + 8)) | uint64_t(get32(src + 12)) << 32;
+	const size_t block_size = get32(src + 4);
+
+	if (0 == block_size || util::lz_max_block_size < block_size || size_t(-1) < size)
+		return false;
+
+	const uint64_t num_blocks = (size + block_size - 1) / block_size;
+
+	if ((src_size - util::lz_header_size) / sizeof(uint32_t) < num_blocks)
+		return false;
+
+	layout.block_size = block_size;
+	layout.size = size_t(size);
+	layout.num_blocks = size_t(num_blocks);
+	layout.table = src + util::lz_header_size;
+	return true;
+}
+
+struct DecompressJob
+{
+	const Layout* layout;
+	const uint8_t* src;
+	const size_t* offset;	// of the compressed blocks, plus the end of the last
+	uint8_t* dst;
+	size_t first;
+	size_t count;
+	bool success;
+};
+
+void decompress_range(
+	DecompressJob& job)
+{
+	const Layout& layout = *job.layout;
+	job.success = true;
+
+	for (size_t i = job.first; i < job.first + job.count && job.success; ++i) {
+		const uint8_t* const src = job.src + job.offset[i];
+		const size_t src_size = job.offset[i + 1] - job.offset[i];
+		uint8_t* const dst = job.dst + i * layout.block_size;
+		const size_t dst_size = layout.num_blocks - 1 != i ? layout.block_size : layout.size - i * layout.block_size;
+
+		if (get32(layout.table + i * sizeof(uint32_t)) & block_stored) {
+			job.success = src_size == dst_size;
+
+			if (job.success)
+				memcpy(dst, src, dst_size);
+
+			continue;
+		}
+
+		job.success = decompress_block(src, src_size, dst, dst_size);
+	}
+}
+
+void* decompress_worker(
+	void* arg)
+{
+	decompress_range(*reinterpret_cast< DecompressJob* >(arg));
+	return 0;
+}
+
+} // namespace
+
+namespace util {
+
+bool is_lz_container(
+	const uint8_t* const src,
+	const size_t src_size,
+	size_t* const size)
+{
+	Layout layout;
+
+	if (0 == src || !parse_header(src, src_size, layout))
+		return false;
+
+	if (0 != size)
+		*size = layout.size;
+
+	return true;
+}
+
+bool lz_compress(
+	const uint8_t* const src,
+	const size_t src_size,
+	std::vector< uint8_t >& dst,
+	const size_t block_size)
+{
+	assert(0 != src || 0 == src_size);
+
+	if (0 == block_size || size_t(lz_max_block_size) < block_size)
+		return false;
+
+	const size_t num_blocks = (src_size + block_size - 1) / block_size;
+
+	dst.resize(lz_header_size + num_blocks * sizeof(uint32_t));
+	memcpy(&dst[0], magic, sizeof(magic));
+	put32(&dst[4], uint32_t(block_size));
+	put32(&dst[8], uint32_t(uint64_t(src_size)));
+	put32(&dst[12], uint32_t(uint64_t(src_size) >> 32));
+
+	std::vector< uint8_t > block(block_size);
+
+	for (size_t i = 0; i < num_blocks; ++i) {
+		const uint8_t* const block_src = src + i * block_size;
+		const size_t size = num_blocks - 1 != i ? block_size : src_size - i * block_size;
+
+		// compressed blocks must come out smaller than stored ones
+		size_t compressed_size = compress_block(block_src, size, &block[0], size - 1);
+		uint32_t entry = uint32_t(compressed_size);
+
+		if (0 == compressed_size) {
+			memcpy(&block[0], block_src, size);
+			compressed_size = size;
+			entry = uint32_t(size) | block_stored;
+		}
+
+		put32(&dst[lz_header_size + i * sizeof(uint32_t)], entry);
+		dst.insert(dst.end(), block.begin(), block.begin() + compressed_size);
+	}
+
+	return true;
+}
+
+bool lz_decompress(
+	const uint8_t* const src,
+	const size_t src_size,
+	uint8_t* const dst,
+	const size_t dst_size,
+	const unsigned num_threads)
+{
+	Layout layout;
+
+	if (0 == src || !parse_header(src, src_size, layout) || layout.size != dst_size)
+		return false;
+
+	// locate the blocks, validating their extents
+	std::vector< size_t > offset(layout.num_blocks + 1);
+	offset[0] = lz_header_size + layout.num_blocks * sizeof(uint32_t);
+
+	for (size_t i = 0; i < layout.num_blocks; ++i) {
+		const size_t block_size = get32(layout.table + i * sizeof(uint32_t)) & ~block_stored;
+
+		if (src_size - offset[i] < block_size)
+			return false;
+
+		offset[i + 1] = offset[i] + block_size;
+	}
+
+	unsigned threads = num_threads;
+
+	if (0 == threads) {
+		const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = 1 < layout.num_blocks && 1 < cpus ? unsigned(cpus) : 1;
+	}
+
+	if (max_threads < threads)
+		threads = max_threads;
+
+	if (layout.num_blocks < threads)
+		threads = layout.num_blocks ? unsigned(layout.num_blocks) : 1;
+
+	const size_t blocks_per_thread = (layout.num_blocks + threads - 1) / threads;
+
+	DecompressJob job[max_threads];
+	pthread_t worker[max_threads];
+	bool spawned[max_threads] = { false };
+
+	for (unsigned i = 0; i < threads; ++i) {
+		const size_t first = blocks_per_thread * i;
+		const size_t last = first + blocks_per_thread;
+
+		job[i].layout = &layout;
+		job[i].src = src;
+		job[i].offset = &offset[0];
+		job[i].dst = dst;
+		job[i].first = first < layout.num_blocks ? first : layout.num_blocks;
+		job[i].count = (last < layout.num_blocks ? last : layout.num_blocks) - job[i].first;
+		job[i].success = false;
+	}
+
+	// thread 0 is the caller; should a worker fail to spawn, the caller picks up its job
+	for (unsigned i = 1; i < threads; ++i)
+		spawned[i] = 0 == pthread_create(worker + i, 0, decompress_worker, job + i);
+
+	for (unsigned i = 0; i < threads; ++i)
+		if (!spawned[i])
+			decompress_range(job[i]);
+
+	bool success = true;
+
+	for (unsigned i = 0; i < threads; ++i) {
+		if (spawned[i])
+			pthread_join(worker[i], 0);
+
+		success = success && job[i].success;
+	}
+
+	return success;
+}
+
+} // namespace util
@@ -0,0 +1,57 @@
+#ifndef util_lz_H__
+#define util_lz_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace util {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// block container of LZ4-class compression: a header carrying the decompressed size and the block
+// size, a table of the compressed sizes of the blocks, and the blocks themselves, each compressed on
+// its own, or stored as is where that does not pay off. Blocks decompress independently, so threads
+// can split them among themselves, each writing straight into its part of the destination, be that
+// a heap buffer, a mapped GL buffer or a texture staging buffer.
+//
+// byte layout, all little-endian:
+//   char     magic[4];          // "LZB1"
+//   uint32_t block_size;        // decompressed size of all blocks but the last
+//   uint64_t size;              // decompressed size of the content
+//   uint32_t block[num_blocks]; // compressed size of each block; the top bit marks a stored block
+//   blocks follow in order
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+enum {
+	lz_header_size = 16,
+	lz_default_block_size = 1 << 18,
+	lz_max_block_size = 1 << 24
+};
+
+// whether a buffer holds a block container; optionally return the decompressed size
+bool is_lz_container(
+	const uint8_t* const src,
+	const size_t src_size,
+	size_t* const size = 0);
+
+// compress a buffer into a block container of the specified block size; return false upon
+// a block size out of range
+bool lz_compress(
+	const uint8_t* const src,
+	const size_t src_size,
+	std::vector< uint8_t >& dst,
+	const size_t block_size = lz_default_block_size);
+
+// decompress a block container into a destination of exactly the decompressed size, across the
+// specified number of threads; zero threads means one per online CPU for containers of several
+// blocks, and a single thread otherwise; return false upon a malformed container
+bool lz_decompress(
+	const uint8_t* const src,
+	const size_t src_size,
+	uint8_t* const dst,
+	const size_t dst_size,
+	const unsigned num_threads = 0);
+
+} // namespace util
+
+#endif // util_lz_H__
@@ -0,0 +1,326 @@
+#include <assert.h>
+#include <math.h>
+#include <vector>
+
+#include "util_mip.hpp"
+
+namespace util {
+
+namespace { // anonymous
+
+// half-width of the Kaiser-windowed sinc, in destination texels, and the shape of the window
+const float kaiser_width = 3.f;
+const float kaiser_alpha = 4.f;
+
+// zeroth-order modified Bessel function of the first kind, by its power series
+float bessel0(
+	const float x)
+{
+	const float xh = x * .5f;
+	float sum = 1.f;
+	float term = 1.f;
+
+	for (unsigned k = 1; k < 32; ++k) {
+		term *= xh * xh / float(k * k);
+		sum += term;
+
+		if (term < sum * 1e-8f)
+			break;
+	}
+
+	return sum;
+}
+
+float kaiserSinc(
+	const float x)
+{
+	const float t = x / kaiser_width;
+
+	if (t * t >= 1.f)
+		return 0.f;
+
+	const float px = float(M_PI) * x;
+	const float sinc = fabsf(px) < 1e-6f ? 1.f : sinf(px) / px;
+
+	return sinc * bessel0(kaiser_alpha * sqrtf(1.f - t * t)) / bessel0(kaiser_alpha);
+}
+
+// taps of a 1D resampling from one dimension to another: a fixed count of source coordinates per
+// destination coordinate, already wrapped around, and their normalized weights
+struct Taps {
+	unsigned count;
+	std::vector< unsigned > index;
+	std::vector< float > weight;
+};
+
+void computeTaps(
+	const unsigned src_dim,
+	const unsigned dst_dim,
+	const MipFilter filter,
+	Taps& taps)
+{
+	assert(src_dim >= dst_dim && 0 != dst_dim);
+
+	const float ratio = float(src_dim) / float(dst_dim);
+	const float radius = MIP_FILTER_BOX == filter ? ratio * .5f : ratio * kaiser_width;
+	const unsigned span = unsigned(ceilf(radius * 2.f)) + 2;
+
+	std::vector< int > start(dst_dim);
+	std::vector< unsigned > lo(dst_dim);
+	std::vector< float > weight(size_t(dst_dim) * span);
+	taps.count = 1;
+
+	// weigh a generous span of source coordinates, then trim it to the coordinates of non-zero weight
+	for (unsigned d = 0; d < dst_dim; ++d) {
+		const float center = (float(d) + .5f) * ratio;
+		float* const w = &weight[size_t(d) * span];
+		unsigned hi = 0;
+		float sum = 0.f;
+
+		start[d] = int(floorf(center - radius)) - 1;
+		lo[d] = span;
+
+		for (unsigned t = 0; t < span; ++t) {
+			const float i = float(start[d] + int(t));
+
+			if (MIP_FILTER_BOX == filter) {
+				const float cover = fminf(i + 1.f, center + radius) - fmaxf(i, center - radius);
+				w[t] = fmaxf(cover, 0.f);
+			}
+			else
+				w[t] = kaiserSinc((i + .5f - center) / ratio);
+
+			if (0.f != w[t]) {
+				lo[d] = lo[d] < t ? lo[d] : t;
+				hi = t;
+			}
+
+			sum += w[t];
+		}
+
+		assert(lo[d] <= hi && 0.f != sum);
+
+		for (unsigned t = lo[d]; t <= hi; ++t)
+			w[t] /= sum;
+
+		taps.count = taps.count > hi - lo[d] + 1 ? taps.count : hi - lo[d] + 1;
+	}
+
+	taps.index.resize(size_t(dst_dim) * taps.count);
+	taps.weight.resize(size_t(dst_dim) * taps.count);
+
+	for (unsigned d = 0; d < dst_dim; ++d) {
+		const float* const w = &weight[size_t(d) * span];
+
+		for (unsigned t = 0; t < taps.count; ++t) {
+			const int i = (start[d] + int(lo[d] + t)) % int(src_dim);
+
+			taps.index[size_t(d) * taps.count + t] = unsigned(i < 0 ? i + int(src_dim) : i);
+			taps.weight[size_t(d) * taps.count + t] = lo[d] + t < span ? w[lo[d] + t] : 0.f;
+		}
+	}
+}
+
+// accumulate a weighted source row into a destination row; contiguous and branchless for vectorization
+void accumulateRow(
+	float* const __restrict dst,
+	const float* const __restrict src,
+	const float weight,
+	const size_t n)
+{
+	for (size_t i = 0; i < n; ++i)
+		dst[i] += weight * src[i];
+}
+
+float srgbToLinear(
+	const float c)
+{
+	return c <= .04045f ? c * (1.f / 12.92f) : powf((c + .055f) * (1.f / 1.055f), 2.4f);
+}
+
+float linearToSrgb(
+	const float l)
+{
+	return l <= .0031308f ? l * 12.92f : 1.055f * powf(l, 1.f / 2.4f) - .055f;
+}
+
+// entries of the linear-to-sRGB table, indexed by the square root of the linear value for precision
+// in the darks
+const unsigned srgb_table_size = 4096;
+
+void decode(
+	const uint8_t* const src,
+	const size_t n,
+	const MipMode mode,
+	float* const dst)
+{
+	float lut[256];
+
+	for (unsigned i = 0; i < 256; ++i)
+		switch (mode) {
+		case MIP_MODE_SRGB:
+			lut[i] = srgbToLinear(float(i) * (1.f / 255.f));
+			break;
+		case MIP_MODE_NORMAL:
+			lut[i] = float(i) * (2.f / 255.f) - 1.f;
+			break;
+		default:
+			lut[i] = float(i) * (1.f / 255.f);
+			break;
+		}
+
+	for (size_t i = 0; i < n; ++i)
+		dst[i] = lut[src[i]];
+}
+
+// quantize a level; normals get renormalized in place, so the next level gets filtered from unit vectors
+void encode(
+	float* const src,
+	const size_t num_pix,
+	const MipMode mode,
+	uint8_t* const dst)
+{
+	switch (mode) {
+	case MIP_MODE_SRGB: {
+			std::vector< uint8_t > lut(srgb_table_size);
+
+			for (unsigned i = 0; i < srgb_table_size; ++i) {
+				const float s = float(i) / float(srgb_table_size - 1);
+				lut[i] = uint8_t(linearToSrgb(s * s) * 255.f + .5f);
+			}
+
+			for (size_t i = 0; i < num_pix * 3; ++i) {
+				const float l = fminf(fmaxf(src[i], 0.f), 1.f);
+				dst[i] = lut[unsigned(sqrtf(l) * float(srgb_table_size - 1) + .5f)];
+			}
+		}
+		break;
+
+	case MIP_MODE_NORMAL:
+		for (size_t i = 0; i < num_pix; ++i) {
+			float* const n = src + i * 3;
+			const float len2 = n[0] * n[0] + n[1] * n[1] + n[2] * n[2];
+			const float rlen = len2 > 1e-12f ? 1.f / sqrtf(len2) : 0.f;
+
+			for (unsigned j = 0; j < 3; ++j) {
+				n[j] *= rlen;
+				dst[i * 3 + j] = uint8_t(fminf(fmaxf(n[j] * 127.5f + 128.f, 0.f), 255.f));
+			}
+		}
+		break;
+
+	default:
+		for (size_t i = 0; i < num_pix * 3; ++i)
+			dst[i] = uint8_t(fminf(fmaxf(src[i], 0.f), 1.f) * 255.f + .5f);
+		break;
+	}
+}
+
+} // namespace
+
+unsigned mip_level_count(
+	const unsigned w,
+	const unsigned h)
+{
+	unsigned count = 1;
+
+	for (unsigned dim = w > h ? w : h; dim > 1; dim >>= 1)
+		++count;
+
+	return count;
+}
+
+size_t mip_chain_size(
+	const unsigned w,
+	const unsigned h,
+	const unsigned first_level,
+	const unsigned num_levels)
+{
+	size_t size = 0;
+
+	for (unsigned i = first_level; i < first_level + num_levels; ++i)
+		size += size_t(mip_level_dim(w, i)) * mip_level_dim(h, i) * 3;
+
+	return size;
+}
+
+void build_mip_chain(
+	const uint8_t* const src,
+	const unsigned w,
+	const unsigned h,
+	const MipFilter filter,
+	const MipMode mode,
+	uint8_t* const dst)
+{
+	assert(0 != src && 0 != dst);
+	assert(0 != w && 0 != h);
+
+	const unsigned num_levels = mip_level_count(w, h);
+
+	std::vector< float > plane(size_t(w) * h * 3);
+	std::vector< float > vert;
+	std::vector< float > next;
+	Taps taps_x;
+	Taps taps_y;
+
+	decode(src, plane.size(), mode, &plane[0]);
+
+	uint8_t* out = dst;
+	unsigned sw = w;
+	unsigned sh = h;
+
+	for (unsigned level = 1; level < num_levels; ++level) {
+		const unsigned dw = mip_level_dim(w, level);
+		const unsigned dh = mip_level_dim(h, level);
+		const size_t src_row = size_t(sw) * 3;
+
+		computeTaps(sw, dw, filter, taps_x);
+		computeTaps(sh, dh, filter, taps_y);
+
+		// vertical pass first: whole rows at a time
+		vert.assign(size_t(dh) * src_row, 0.f);
+
+		for (unsigned y = 0; y < dh; ++y)
+			for (unsigned t = 0; t < taps_y.count; ++t) {
+				const size_t tap = size_t(y) * taps_y.count + t;
+
+				if (0.f != taps_y.weight[tap])
+					accumulateRow(&vert[y * src_row], &plane[taps_y.index[tap] * src_row], taps_y.weight[tap], src_row);
+			}
+
+		// horizontal pass on the already-reduced rows
+		next.resize(size_t(dw) * dh * 3);
+
+		for (unsigned y = 0; y < dh; ++y) {
+			const float* const row = &vert[y * src_row];
+			float* const dst_row = &next[size_t(y) * dw * 3];
+
+			for (unsigned x = 0; x < dw; ++x) {
+				const unsigned* const index = &taps_x.index[size_t(x) * taps_x.count];
+				const float* const weight = &taps_x.weight[size_t(x) * taps_x.count];
+				float acc[3] = { 0.f, 0.f, 0.f };
+
+				for (unsigned t = 0; t < taps_x.count; ++t) {
+					const float* const texel = row + index[t] * 3;
+
+					acc[0] += weight[t] * texel[0];
+					acc[1] += weight[t] * texel[1];
+					acc[2] += weight[t] * texel[2];
+				}
+
+				dst_row[x * 3 + 0] = acc[0];
+				dst_row[x * 3 + 1] = acc[1];
+				dst_row[x * 3 + 2] = acc[2];
+			}
+		}
+
+		encode(&next[0], size_t(dw) * dh, mode, out);
+		out += size_t(dw) * dh * 3;
+
+		plane.swap(next);
+		sw = dw;
+		sh = dh;
+	}
+}
+
+} // namespace util
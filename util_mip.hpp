@@ -0,0 +1,65 @@
+#ifndef util_mip_H__
+#define util_mip_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace util {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// CPU mip chain generation for tightly packed RGB888 images of arbitrary dimensions. Level sizes
+// follow GL: each next level halves the previous, rounding down but not below 1, down to 1x1. Each
+// level is produced from the previous one in float precision, by separable filtering with wrap-around
+// addressing, to match the repeat sampling of the textures.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+enum MipFilter {
+	MIP_FILTER_BOX,		// exact area coverage; sharp-edged, cheap
+	MIP_FILTER_KAISER,	// Kaiser-windowed sinc; crisper, may ring slightly
+
+	MIP_FILTER_COUNT,
+	MIP_FILTER_FORCE_UINT = -1U
+};
+
+enum MipMode {
+	MIP_MODE_LINEAR,	// channels filtered as stored
+	MIP_MODE_SRGB,		// channels filtered in linear space, i.e. gamma-correct
+	MIP_MODE_NORMAL,	// channels taken as a unit vector in [-1, 1]; filtered and renormalized
+
+	MIP_MODE_COUNT,
+	MIP_MODE_FORCE_UINT = -1U
+};
+
+// dimension of the specified level of a chain of the specified base dimension
+inline unsigned mip_level_dim(
+	const unsigned dim,
+	const unsigned level)
+{
+	return dim >> level ? dim >> level : 1;
+}
+
+// number of levels in a full chain of the specified base dimensions
+unsigned mip_level_count(
+	const unsigned w,
+	const unsigned h);
+
+// byte size of the specified span of levels of an RGB888 chain of the specified base dimensions
+size_t mip_chain_size(
+	const unsigned w,
+	const unsigned h,
+	const unsigned first_level,
+	const unsigned num_levels);
+
+// produce levels 1 through N - 1 of the full RGB888 chain of the specified level 0; the produced
+// levels get stored back to back at dst, whose size must be at least mip_chain_size(w, h, 1, N - 1)
+void build_mip_chain(
+	const uint8_t* const src,
+	const unsigned w,
+	const unsigned h,
+	const MipFilter filter,
+	const MipMode mode,
+	uint8_t* const dst);
+
+} // namespace util
+
+#endif // util_mip_H__
@@ -4,8 +4,18 @@
 	#include <GLES2/gl2.h>
 #endif
 
+#if PLATFORM_GLES
+	#include "gles_ext.h"
+#endif
+
+#include <sys/types.h>
+#include <sys/stat.h>
 #include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
 #include <cstring>
 #include <string>
 
@@ -29,6 +39,275 @@ public:
 	}
 };
 
+#if PLATFORM_GL_KHR_parallel_shader_compile
+bool g_parallel_probed;
+bool g_parallel_enabled;
+
+// let the driver compile and link on threads of its own; return whether it does
+bool probeParallelCompile()
+{
+	if (g_parallel_probed)
+		return g_parallel_enabled;
+
+	g_parallel_probed = true;
+
+	if (!util::hasGLExtension("GL_KHR_parallel_shader_compile") || 0 == glMaxShaderCompilerThreadsKHR)
+		return false;
+
+	// as many threads as the implementation sees fit
+	glMaxShaderCompilerThreadsKHR(0xffffffff);
+	g_parallel_enabled = true;
+
+	return true;
+}
+
+#endif
+// submit a compile, leaving its status to checkProgram
+bool compileShader(
+	const GLuint shader_name)
+{
+	glCompileShader(shader_name);
+
+	if (util::reportGLError()) {
+		stream::cerr << "cannot compile shader from source (binary only?)\n";
+		return false;
+	}
+
+	return true;
+}
+
+void reportShaderLog(
+	const GLuint shader_name)
+{
+	GLint len;
+	glGetShaderiv(shader_name, GL_INFO_LOG_LENGTH, &len);
+	const scoped_ptr< GLchar, generic_free > log(
+		reinterpret_cast< GLchar* >(malloc(sizeof(GLchar) * len)));
+	glGetShaderInfoLog(shader_name, len, NULL, log());
+	stream::cerr << "shader compile log:\n";
+	stream::cerr.write(log(), len - 1);
+	stream::cerr << '\n';
+}
+
+#if PLATFORM_GL_OES_get_program_binary
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// program binary cache: linked programs go to $XDG_CACHE_HOME/hello-chromeos-gles2, one file per
+// program, named by a hash of the driver identity and the sources of the shaders; the file carries
+// a second, independent hash of the same, so a collision of names does not pass for a hit
+
+struct ProgramCache
+{
+	bool probed;
+	bool enabled;
+	std::string dir;	// of the cache files, slash-terminated
+	std::string driver;	// GL_RENDERER and GL_VERSION
+};
+
+ProgramCache g_program_cache;
+
+struct ProgramBinaryHeader
+{
+	char magic[4];		// "PBC1"
+	uint32_t format;	// binary format, as per glGetProgramBinaryOES
+	uint32_t size;		// of the binary that follows
+	uint32_t reserved;
+	uint64_t check;		// second hash of the key
+};
+
+// keys of the programs submitted on a miss, for checkProgram to store their binaries by
+enum { max_pending_programs = 16 };
+
+GLuint g_pending_prog[max_pending_programs];
+std::string g_pending_key[max_pending_programs];
+
+bool makeDir(
+	const std::string& path)
+{
+	return 0 == mkdir(path.c_str(), 0755) || EEXIST == errno;
+}
+
+bool probeProgramCache()
+{
+	ProgramCache& cache = g_program_cache;
+
+	if (cache.probed)
+		return cache.enabled;
+
+	cache.probed = true;
+
+	GLint num_formats = 0;
+
+	if (util::hasGLExtension("GL_OES_get_program_binary"))
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &num_formats);
+
+	if (0 >= num_formats || 0 == glGetProgramBinaryOES || 0 == glProgramBinaryOES)
+		return false;
+
+	// relative paths in XDG_CACHE_HOME are invalid as per the XDG spec
+	const char* const xdg_cache = getenv("XDG_CACHE_HOME");
+	const char* const home = getenv("HOME");
+
+	if (0 != xdg_cache && '/' == xdg_cache[0])
+		cache.dir = xdg_cache;
+	else
+	if (0 != home && '/' == home[0])
+		cache.dir = std::string(home) + "/.cache";
+	else
+		return false;
+
+	cache.dir += "/hello-chromeos-gles2";
+
+	if (!makeDir(cache.dir.substr(0, cache.dir.rfind('/'))) || !makeDir(cache.dir)) {
+		stream::cerr << __FUNCTION__ << " cannot create program cache '" << cache.dir.c_str() << "'\n";
+		return false;
+	}
+
+	const char* const renderer = reinterpret_cast< const char* >(glGetString(GL_RENDERER));
+	const char* const version = reinterpret_cast< const char* >(glGetString(GL_VERSION));
+
+	if (0 == renderer || 0 == version)
+		return false;
+
+	cache.dir += '/';
+	cache.driver = std::string(renderer) + '\n' + version;
+	cache.enabled = true;
+
+	return true;
+}
+
+// FNV-1a, and a multiplicative hash of different mixing for the check
+uint64_t hashName(
+	const std::string& key)
+{
+	uint64_t h = 0xcbf29ce484222325ull;
+
+	for (size_t i = 0; i < key.length(); ++i)
+		h = (h ^ uint8_t(key[i])) * 0x100000001b3ull;
+
+	return h;
+}
+
+uint64_t hashCheck(
+	const std::string& key)
+{
+	uint64_t h = key.length();
+
+	for (size_t i = 0; i < key.length(); ++i)
+		h = (h + uint8_t(key[i])) * 0x9e3779b97f4a7c15ull ^ h >> 29;
+
+	return h;
+}
+
+bool appendShaderSource(
+	const GLuint shader_name,
+	std::string& key)
+{
+	GLint type = 0;
+	GLint len = 0;
+	glGetShaderiv(shader_name, GL_SHADER_TYPE, &type);
+	glGetShaderiv(shader_name, GL_SHADER_SOURCE_LENGTH, &len);
+
+	if (0 >= len)
+		return false;
+
+	const size_t pos = key.length();
+	key.resize(pos + len);
+	glGetShaderSource(shader_name, len, NULL, &key[pos]);
+
+	// the source comes nul-terminated; the nul separates it from the next
+	key[key.length() - 1] = char(type == GL_VERTEX_SHADER ? 'v' : 'f');
+	return true;
+}
+
+std::string programCachePath(
+	const std::string& key)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long) hashName(key));
+
+	return g_program_cache.dir + name;
+}
+
+bool loadProgramBinary(
+	const GLuint prog,
+	const std::string& key)
+{
+	FILE* const file = fopen(programCachePath(key).c_str(), "rb");
+
+	if (0 == file)
+		return false;
+
+	ProgramBinaryHeader header;
+	bool success = 1 == fread(&header, sizeof(header), 1, file) &&
+		0 == memcmp(header.magic, "PBC1", sizeof(header.magic)) &&
+		hashCheck(key) == header.check &&
+		0 != header.size;
+
+	const scoped_ptr< uint8_t, generic_free > binary(
+		reinterpret_cast< uint8_t* >(success ? malloc(header.size) : 0));
+
+	success = success && 0 != binary() && 1 == fread(binary(), header.size, 1, file);
+	fclose(file);
+
+	if (!success)
+		return false;
+
+	// drivers reject binaries of other builds of theirs, at which point the program is not linked
+	glProgramBinaryOES(prog, header.format, binary(), GLint(header.size));
+
+	while (GL_NO_ERROR != glGetError()) {}
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv(prog, GL_LINK_STATUS, &linked);
+
+	return GL_TRUE == linked;
+}
+
+void storeProgramBinary(
+	const GLuint prog,
+	const std::string& key)
+{
+	GLint len = 0;
+	glGetProgramiv(prog, GL_PROGRAM_BINARY_LENGTH_OES, &len);
+
+	if (0 >= len)
+		return;
+
+	const scoped_ptr< uint8_t, generic_free > binary(
+		reinterpret_cast< uint8_t* >(malloc(len)));
+
+	if (0 == binary())
+		return;
+
+	GLsizei size = 0;
+	GLenum format = 0;
+	glGetProgramBinaryOES(prog, len, &size, &format, binary());
+
+	if (util::reportGLError() || 0 >= size)
+		return;
+
+	const ProgramBinaryHeader header = { { 'P', 'B', 'C', '1' }, uint32_t(format), uint32_t(size), 0, hashCheck(key) };
+
+	// go through a temp file of this process, so that concurrent instances do not see partial files
+	const std::string path = programCachePath(key);
+	char suffix[32];
+	snprintf(suffix, sizeof(suffix), ".%d", int(getpid()));
+	const std::string temp = path + suffix;
+
+	FILE* const file = fopen(temp.c_str(), "wb");
+
+	if (0 == file)
+		return;
+
+	const bool success =
+		1 == fwrite(&header, sizeof(header), 1, file) &&
+		1 == fwrite(binary(), size, 1, file);
+
+	if (0 != fclose(file) || !success || 0 != rename(temp.c_str(), path.c_str()))
+		remove(temp.c_str());
+}
+
+#endif // PLATFORM_GL_OES_get_program_binary
 bool setupShaderFromString(
 	const GLuint shader_name,
 	const char* const source,
@@ -98,29 +377,18 @@ bool setupShaderFromString(
 	}
 
 	glShaderSource(shader_name, src_count, src, srclen);
-	glCompileShader(shader_name);
 
-	if (util::reportGLError()) {
-		stream::cerr << "cannot compile shader from source (binary only?)\n";
-		return false;
-	}
+#if PLATFORM_GL_OES_get_program_binary
+	// with a program cache the compile waits for a miss at submitProgram
+	if (probeProgramCache())
+		return true;
 
-	GLint success = GL_FALSE;
-	glGetShaderiv(shader_name, GL_COMPILE_STATUS, &success);
-
-	if (GL_TRUE != success) {
-		GLint len;
-		glGetShaderiv(shader_name, GL_INFO_LOG_LENGTH, &len);
-		const scoped_ptr< GLchar, generic_free > log(
-			reinterpret_cast< GLchar* >(malloc(sizeof(GLchar) * len)));
-		glGetShaderInfoLog(shader_name, len, NULL, log());
-		stream::cerr << "shader compile log:\n";
-		stream::cerr.write(log(), len - 1);
-		stream::cerr << '\n';
-		return false;
-	}
+#endif
+#if PLATFORM_GL_KHR_parallel_shader_compile
+	probeParallelCompile();
 
-	return true;
+#endif
+	return compileShader(shader_name);
 }
 
 } // namespace
@@ -131,15 +399,14 @@ bool util::setupShader(
 {
 	assert(0 != filename);
 
-	size_t length;
-	const scoped_ptr< char, generic_free > source(get_buffer_from_file(filename, length));
+	mapped_file source;
 
-	if (0 == source()) {
+	if (!source.open(filename) || 0 == source.length()) {
 		stream::cerr << __FUNCTION__ << " failed to read shader file '" << filename << "'\n";
 		return false;
 	}
 
-	return setupShaderFromString(shader_name, source(), length);
+	return setupShaderFromString(shader_name, reinterpret_cast< const char* >(source.data()), source.length());
 }
 
 bool util::setupShaderWithPatch(
@@ -151,15 +418,14 @@ bool util::setupShaderWithPatch(
 	assert(0 != filename);
 	assert(0 != patch);
 
-	size_t length;
-	const scoped_ptr< char, generic_free > source(get_buffer_from_file(filename, length));
+	mapped_file source;
 
-	if (0 == source()) {
+	if (!source.open(filename) || 0 == source.length()) {
 		stream::cerr << __FUNCTION__ << " failed to read shader file '" << filename << "'\n";
 		return false;
 	}
 
-	std::string src_final(source(), length);
+	std::string src_final(reinterpret_cast< const char* >(source.data()), source.length());
 	size_t npatched = 0;
 
 	for (size_t i = 0; i < patch_count; ++i) {
@@ -189,7 +455,7 @@ bool util::setupShaderWithPatch(
 	return setupShaderFromString(shader_name, src_final.c_str(), src_final.length());
 }
 
-bool util::setupProgram(
+bool util::submitProgram(
 	const GLuint prog,
 	const GLuint shader_vert,
 	const GLuint shader_frag)
@@ -206,14 +472,91 @@ bool util::setupProgram(
 		return false;
 	}
 
+#if PLATFORM_GL_KHR_parallel_shader_compile
+	probeParallelCompile();
+
+#endif
+#if PLATFORM_GL_OES_get_program_binary
+	// a binary of the same sources off the same driver spares the compile and link
+	if (probeProgramCache()) {
+		std::string key = g_program_cache.driver;
+		key += '\0';
+
+		const bool keyed =
+			appendShaderSource(shader_vert, key) &&
+			appendShaderSource(shader_frag, key);
+
+		if (keyed && loadProgramBinary(prog, key))
+			return true;
+
+		if (!compileShader(shader_vert) ||
+			!compileShader(shader_frag))
+			return false;
+
+		// past the pending capacity programs just do not get cached
+		for (unsigned i = 0; i < max_pending_programs && keyed; ++i)
+			if (0 == g_pending_prog[i]) {
+				g_pending_prog[i] = prog;
+				g_pending_key[i].swap(key);
+				break;
+			}
+	}
+
+#endif
 	glAttachShader(prog, shader_vert);
 	glAttachShader(prog, shader_frag);
 	glLinkProgram(prog);
 
+	return true;
+}
+
+bool util::isProgramComplete(
+	const GLuint prog)
+{
+#if PLATFORM_GL_KHR_parallel_shader_compile
+	if (probeParallelCompile()) {
+		GLint complete = GL_TRUE;
+		glGetProgramiv(prog, GL_COMPLETION_STATUS_KHR, &complete);
+
+		return GL_FALSE != complete;
+	}
+
+#endif
+	return true;
+}
+
+bool util::checkProgram(
+	const GLuint prog)
+{
 	GLint success = GL_FALSE;
 	glGetProgramiv(prog, GL_LINK_STATUS, &success);
 
+#if PLATFORM_GL_OES_get_program_binary
+	std::string key;
+
+	for (unsigned i = 0; i < max_pending_programs; ++i)
+		if (prog == g_pending_prog[i]) {
+			g_pending_prog[i] = 0;
+			g_pending_key[i].swap(key);
+			g_pending_key[i].clear();
+			break;
+		}
+
+#endif
 	if (GL_TRUE != success) {
+		// the compile status went unchecked so far; report the shaders that failed
+		GLuint shader[2];
+		GLsizei count = 0;
+		glGetAttachedShaders(prog, sizeof(shader) / sizeof(shader[0]), &count, shader);
+
+		for (GLsizei i = 0; i < count; ++i) {
+			GLint compiled = GL_FALSE;
+			glGetShaderiv(shader[i], GL_COMPILE_STATUS, &compiled);
+
+			if (GL_TRUE != compiled)
+				reportShaderLog(shader[i]);
+		}
+
 		GLint len;
 		glGetProgramiv(prog, GL_INFO_LOG_LENGTH, &len);
 		const scoped_ptr< GLchar, generic_free > log(
@@ -225,6 +568,38 @@ bool util::setupProgram(
 		return false;
 	}
 
+#if PLATFORM_GL_OES_get_program_binary
+	if (!key.empty())
+		storeProgramBinary(prog, key);
+
+#endif
 	return true;
 }
 
+bool util::setupProgram(
+	const GLuint prog,
+	const GLuint shader_vert,
+	const GLuint shader_frag)
+{
+	return submitProgram(prog, shader_vert, shader_frag) && checkProgram(prog);
+}
+
+bool util::hasGLExtension(
+	const char* const name)
+{
+	assert(0 != name);
+
+	const char* const exten = reinterpret_cast< const char* >(glGetString(GL_EXTENSIONS));
+
+	if (0 == exten)
+		return false;
+
+	// extension names are space-separated; match whole names only
+	const size_t len = strlen(name);
+
+	for (const char* pos = strstr(exten, name); 0 != pos; pos = strstr(pos + len, name))
+		if ((pos == exten || ' ' == pos[-1]) && (' ' == pos[len] || '\0' == pos[len]))
+			return true;
+
+	return false;
+}
@@ -21,6 +21,8 @@ struct compile_assert< true > {
 	}
 };
 
+// source a shader from a file and submit its compile; where programs get cached the compile is left
+// to submitProgram
 bool setupShader(
 	const GLuint shader_name,
 	const char* const filename);
@@ -31,11 +33,32 @@ bool setupShaderWithPatch(
 	const size_t patch_count,
 	const std::string* const patch);
 
+// submit the link of a program of two shaders, or load it from the program cache, keyed by the
+// sources of the shaders and the driver identity; the shaders get compiled on a miss only. Compile
+// and link status is left to checkProgram, so that the driver can work on the program meanwhile
+bool submitProgram(
+	const GLuint prog,
+	const GLuint shader_vert,
+	const GLuint shader_frag);
+
+// whether a submitted program is done compiling and linking, without waiting on it; true without
+// KHR_parallel_shader_compile, where checkProgram is all there is
+bool isProgramComplete(
+	const GLuint prog);
+
+// wait for a submitted program and return whether it linked, reporting the logs of whatever failed
+bool checkProgram(
+	const GLuint prog);
+
+// submitProgram and checkProgram in one
 bool setupProgram(
 	const GLuint prog,
 	const GLuint shader_vert,
 	const GLuint shader_frag);
 
+bool hasGLExtension(
+	const char* const name);
+
 bool reportGLError(FILE* file = stderr);
 bool reportEGLError(FILE* file = stderr);
 
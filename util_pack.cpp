@@ -0,0 +1,156 @@
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "util_pack.hpp"
+
+namespace util {
+
+static const char pack_magic[4] = { 'A', 'P', 'K', '1' };
+
+asset_pack::asset_pack()
+: addr(0)
+, size(0)
+, fd(-1)
+, entry(0)
+, names(0)
+, num_entries(0)
+{}
+
+asset_pack::~asset_pack()
+{
+	close();
+}
+
+bool asset_pack::open(
+	const char* const filename)
+{
+	assert(0 != filename);
+	close();
+
+	fd = ::open(filename, O_RDONLY);
+
+	if (-1 == fd) {
+		fprintf(stderr, "%s cannot open pack '%s'\n", __FUNCTION__, filename);
+		return false;
+	}
+
+	struct stat filestat;
+
+	if (-1 == fstat(fd, &filestat) || !S_ISREG(filestat.st_mode) || pack_header_size > filestat.st_size) {
+		fprintf(stderr, "%s encountered an invalid pack '%s'\n", __FUNCTION__, filename);
+		close();
+		return false;
+	}
+
+	const size_t file_size = size_t(filestat.st_size);
+	void* const mapping = mmap(0, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	if (MAP_FAILED == mapping) {
+		fprintf(stderr, "%s cannot map pack '%s'\n", __FUNCTION__, filename);
+		close();
+		return false;
+	}
+
+	// the pack is the working set -- have it all read ahead
+	madvise(mapping, file_size, MADV_SEQUENTIAL);
+	madvise(mapping, file_size, MADV_WILLNEED);
+
+	addr = reinterpret_cast< const uint8_t* >(mapping);
+	size = file_size;
+
+	uint32_t header[4];
+	memcpy(header, addr, sizeof(header));
+
+	const uint64_t dir_size = uint64_t(header[1]) * sizeof(PackEntry) + header[2];
+
+	if (0 != memcmp(addr, pack_magic, sizeof(pack_magic)) ||
+		size - pack_header_size < dir_size ||
+		(0 != header[2] && 0 != addr[pack_header_size + uint64_t(header[1]) * sizeof(PackEntry) + header[2] - 1])) {
+
+		fprintf(stderr, "%s encountered an invalid pack '%s'\n", __FUNCTION__, filename);
+		close();
+		return false;
+	}
+
+	num_entries = header[1];
+	entry = reinterpret_cast< const PackEntry* >(addr + pack_header_size);
+	names = reinterpret_cast< const char* >(entry + num_entries);
+
+	// validate the directory once, so that lookups need not
+	for (uint32_t i = 0; i < num_entries; ++i) {
+		const PackEntry& e = entry[i];
+
+		if (e.name >= header[2] ||
+			0 != e.offset % pack_alignment ||
+			e.offset > size || e.size > size - e.offset ||
+			(0 != i && 0 <= strcmp(names + entry[i - 1].name, names + e.name))) {
+
+			fprintf(stderr, "%s encountered an invalid entry in pack '%s'\n", __FUNCTION__, filename);
+			close();
+			return false;
+		}
+	}
+
+	fprintf(stdout, "asset pack '%s': %u entries, %u bytes\n", filename, num_entries, unsigned(size));
+	return true;
+}
+
+void asset_pack::close()
+{
+	if (0 != addr)
+		munmap(const_cast< uint8_t* >(addr), size);
+
+	if (-1 != fd)
+		::close(fd);
+
+	addr = 0;
+	size = 0;
+	fd = -1;
+	entry = 0;
+	names = 0;
+	num_entries = 0;
+}
+
+const PackEntry* asset_pack::find(
+	const char* name) const
+{
+	assert(0 != name);
+
+	if (0 == addr)
+		return 0;
+
+	while ('.' == name[0] && '/' == name[1])
+		name += 2;
+
+	uint32_t first = 0;
+	uint32_t last = num_entries;
+
+	while (first < last) {
+		const uint32_t mid = first + (last - first) / 2;
+		const int order = strcmp(names + entry[mid].name, name);
+
+		if (0 == order)
+			return entry + mid;
+
+		if (0 > order)
+			first = mid + 1;
+		else
+			last = mid;
+	}
+
+	return 0;
+}
+
+asset_pack& shared_asset_pack()
+{
+	static asset_pack pack;
+	return pack;
+}
+
+} // namespace util
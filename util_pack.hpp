@@ -0,0 +1,94 @@
+#ifndef util_pack_H__
+#define util_pack_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "scoped.hpp"
+
+namespace util {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// asset pack: a single file carrying the files of an app, found by name through a sorted directory.
+// Entries start at multiples of 4KB and get zero-padded up to the next, so each entry is a page-aligned
+// part of the one mapping of the pack, and the OS can prefetch the working set in one sequential read.
+// mapped_file, get_buffer_from_file, open_file and open_file_fd resolve names through the process-wide
+// pack first, and fall back to loose files for names not in the pack.
+//
+// byte layout, all little-endian:
+//   char      magic[4];              // "APK1"
+//   uint32_t  num_entries;
+//   uint32_t  names_size;
+//   uint32_t  reserved;
+//   PackEntry entry[num_entries];    // sorted by name, as per strcmp
+//   char      names[names_size];     // nul-terminated
+//   content of the entries, in no particular order
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+enum {
+	pack_alignment = 4096,
+	pack_header_size = 16
+};
+
+enum PackFlag {
+	PACK_FLAG_LZ = 1, // content in the block container of util_lz
+
+	PACK_FLAG_FORCE_UINT = -1U
+};
+
+struct PackEntry
+{
+	uint64_t offset;	// of the content in the pack; a multiple of pack_alignment
+	uint64_t size;		// of the content, short of the padding
+	uint32_t name;		// offset of the name in the names
+	uint32_t flags;		// combination of PackFlag
+};
+
+class asset_pack : non_copyable
+{
+	const uint8_t* addr;
+	size_t size;
+	int fd;
+	const PackEntry* entry;
+	const char* names;
+	uint32_t num_entries;
+
+public:
+	asset_pack();
+	~asset_pack();
+
+	// map a pack, advising the kernel of sequential access to all of it; return false if the pack is
+	// missing or malformed
+	bool open(
+		const char* const filename);
+
+	void close();
+
+	bool is_open() const
+	{
+		return 0 != addr;
+	}
+
+	// look up an entry by name, leading "./" notwithstanding; return null if the name is not in the pack
+	const PackEntry* find(
+		const char* const name) const;
+
+	// content of an entry, as mapped
+	const uint8_t* data(
+		const PackEntry& e) const
+	{
+		return addr + e.offset;
+	}
+
+	// descriptor of the pack, for positioned reads of uncompressed entries
+	int get_fd() const
+	{
+		return fd;
+	}
+};
+
+// process-wide pack the loaders resolve names through; closed unless opened by the app
+asset_pack& shared_asset_pack();
+
+} // namespace util
+
+#endif // util_pack_H__
@@ -0,0 +1,231 @@
+#include <assert.h>
+#include <string.h>
+
+#if __SSSE3__ == 1
+	#include <tmmintrin.h>
+#elif __ARM_NEON__ == 1 || __ARM_NEON == 1
+	#include <arm_neon.h>
+#endif
+
+#include "util_pix.hpp"
+
+namespace util {
+
+namespace { // anonymous
+
+// 4x4 Bayer matrix, scaled to thresholds in units of 1/255 of a quantum: (index + .5) * 256 / 16
+const uint16_t dither_threshold[4][4] = {
+	{   8, 136,  40, 168 },
+	{ 200,  72, 232, 104 },
+	{  56, 184,  24, 152 },
+	{ 248, 120, 216,  88 }
+};
+
+// x / 255 for x < 65535
+inline unsigned div255(
+	const unsigned x)
+{
+	return (x + 1 + (x >> 8)) >> 8;
+}
+
+void convertToRGBA8888(
+	const uint8_t* src,
+	const size_t num_pix,
+	uint8_t* dst)
+{
+	size_t i = 0;
+
+#if __SSSE3__ == 1
+	const __m128i shuf = _mm_setr_epi8(0, 1, 2, -128, 3, 4, 5, -128, 6, 7, 8, -128, 9, 10, 11, -128);
+	const __m128i alpha = _mm_set1_epi32(0xff000000);
+
+	for (; i + 16 <= num_pix; i += 16, src += 48, dst += 64) {
+		const __m128i a0 = _mm_loadu_si128(reinterpret_cast< const __m128i* >(src +  0));
+		const __m128i a1 = _mm_loadu_si128(reinterpret_cast< const __m128i* >(src + 16));
+		const __m128i a2 = _mm_loadu_si128(reinterpret_cast< const __m128i* >(src + 32));
+
+		_mm_storeu_si128(reinterpret_cast< __m128i* >(dst +  0), _mm_or_si128(_mm_shuffle_epi8(a0, shuf), alpha));
+		_mm_storeu_si128(reinterpret_cast< __m128i* >(dst + 16), _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(a1, a0, 12), shuf), alpha));
+		_mm_storeu_si128(reinterpret_cast< __m128i* >(dst + 32), _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(a2, a1, 8), shuf), alpha));
+		_mm_storeu_si128(reinterpret_cast< __m128i* >(dst + 48), _mm_or_si128(_mm_shuffle_epi8(_mm_srli_si128(a2, 4), shuf), alpha));
+	}
+
+#elif __ARM_NEON__ == 1 || __ARM_NEON == 1
+	for (; i + 16 <= num_pix; i += 16, src += 48, dst += 64) {
+		const uint8x16x3_t a = vld3q_u8(src);
+		uint8x16x4_t b;
+
+		b.val[0] = a.val[0];
+		b.val[1] = a.val[1];
+		b.val[2] = a.val[2];
+		b.val[3] = vdupq_n_u8(255);
+
+		vst4q_u8(dst, b);
+	}
+
+#endif
+	for (; i < num_pix; ++i, src += 3, dst += 4) {
+		dst[0] = src[0];
+		dst[1] = src[1];
+		dst[2] = src[2];
+		dst[3] = 255;
+	}
+}
+
+void convertToRG88(
+	const uint8_t* src,
+	const size_t num_pix,
+	uint8_t* dst)
+{
+	size_t i = 0;
+
+#if __SSSE3__ == 1
+	const __m128i shuf0_a0 = _mm_setr_epi8(0, 1, 3, 4, 6, 7, 9, 10, 12, 13, 15, -128, -128, -128, -128, -128);
+	const __m128i shuf0_a1 = _mm_setr_epi8(-128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, 0, 2, 3, 5, 6);
+	const __m128i shuf1_a1 = _mm_setr_epi8(8, 9, 11, 12, 14, 15, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128);
+	const __m128i shuf1_a2 = _mm_setr_epi8(-128, -128, -128, -128, -128, -128, 1, 2, 4, 5, 7, 8, 10, 11, 13, 14);
+
+	for (; i + 16 <= num_pix; i += 16, src += 48, dst += 32) {
+		const __m128i a0 = _mm_loadu_si128(reinterpret_cast< const __m128i* >(src +  0));
+		const __m128i a1 = _mm_loadu_si128(reinterpret_cast< const __m128i* >(src + 16));
+		const __m128i a2 = _mm_loadu_si128(reinterpret_cast< const __m128i* >(src + 32));
+
+		_mm_storeu_si128(reinterpret_cast< __m128i* >(dst +  0), _mm_or_si128(_mm_shuffle_epi8(a0, shuf0_a0), _mm_shuffle_epi8(a1, shuf0_a1)));
+		_mm_storeu_si128(reinterpret_cast< __m128i* >(dst + 16), _mm_or_si128(_mm_shuffle_epi8(a1, shuf1_a1), _mm_shuffle_epi8(a2, shuf1_a2)));
+	}
+
+#elif __ARM_NEON__ == 1 || __ARM_NEON == 1
+	for (; i + 16 <= num_pix; i += 16, src += 48, dst += 32) {
+		const uint8x16x3_t a = vld3q_u8(src);
+		uint8x16x2_t b;
+
+		b.val[0] = a.val[0];
+		b.val[1] = a.val[1];
+
+		vst2q_u8(dst, b);
+	}
+
+#endif
+	for (; i < num_pix; ++i, src += 3, dst += 2) {
+		dst[0] = src[0];
+		dst[1] = src[1];
+	}
+}
+
+void convertToRGB565(
+	const uint8_t* src,
+	const unsigned w,
+	const unsigned h,
+	uint16_t* dst)
+{
+	for (unsigned y = 0; y < h; ++y) {
+		const uint16_t* const t = dither_threshold[y & 3];
+		unsigned x = 0;
+
+#if __SSSE3__ == 1
+		const __m128i shuf_r_lo = _mm_setr_epi8(0, -128, 3, -128, 6, -128, 9, -128, 12, -128, 15, -128, -128, -128, -128, -128);
+		const __m128i shuf_r_hi = _mm_setr_epi8(-128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, 2, -128, 5, -128);
+		const __m128i shuf_g_lo = _mm_setr_epi8(1, -128, 4, -128, 7, -128, 10, -128, 13, -128, -128, -128, -128, -128, -128, -128);
+		const __m128i shuf_g_hi = _mm_setr_epi8(-128, -128, -128, -128, -128, -128, -128, -128, -128, -128, 0, -128, 3, -128, 6, -128);
+		const __m128i shuf_b_lo = _mm_setr_epi8(2, -128, 5, -128, 8, -128, 11, -128, 14, -128, -128, -128, -128, -128, -128, -128);
+		const __m128i shuf_b_hi = _mm_setr_epi8(-128, -128, -128, -128, -128, -128, -128, -128, -128, -128, 1, -128, 4, -128, 7, -128);
+		const __m128i thresh = _mm_setr_epi16(t[0], t[1], t[2], t[3], t[0], t[1], t[2], t[3]);
+		const __m128i one = _mm_set1_epi16(1);
+
+		// 8 pixels of 24 bytes at a time, in 16-bit lanes
+		for (; x + 8 <= w; x += 8, src += 24, dst += 8) {
+			const __m128i lo = _mm_loadu_si128(reinterpret_cast< const __m128i* >(src));
+			const __m128i hi = _mm_loadl_epi64(reinterpret_cast< const __m128i* >(src + 16));
+
+			__m128i r = _mm_or_si128(_mm_shuffle_epi8(lo, shuf_r_lo), _mm_shuffle_epi8(hi, shuf_r_hi));
+			__m128i g = _mm_or_si128(_mm_shuffle_epi8(lo, shuf_g_lo), _mm_shuffle_epi8(hi, shuf_g_hi));
+			__m128i b = _mm_or_si128(_mm_shuffle_epi8(lo, shuf_b_lo), _mm_shuffle_epi8(hi, shuf_b_hi));
+
+			r = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(31)), thresh);
+			g = _mm_add_epi16(_mm_mullo_epi16(g, _mm_set1_epi16(63)), thresh);
+			b = _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(31)), thresh);
+
+			r = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(r, one), _mm_srli_epi16(r, 8)), 8);
+			g = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(g, one), _mm_srli_epi16(g, 8)), 8);
+			b = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(b, one), _mm_srli_epi16(b, 8)), 8);
+
+			const __m128i out = _mm_or_si128(_mm_or_si128(_mm_slli_epi16(r, 11), _mm_slli_epi16(g, 5)), b);
+			_mm_storeu_si128(reinterpret_cast< __m128i* >(dst), out);
+		}
+
+#elif __ARM_NEON__ == 1 || __ARM_NEON == 1
+		const uint16_t thresh_row[8] = { t[0], t[1], t[2], t[3], t[0], t[1], t[2], t[3] };
+		const uint16x8_t thresh = vld1q_u16(thresh_row);
+		const uint16x8_t one = vdupq_n_u16(1);
+
+		// 8 pixels of 24 bytes at a time, in 16-bit lanes
+		for (; x + 8 <= w; x += 8, src += 24, dst += 8) {
+			const uint8x8x3_t a = vld3_u8(src);
+
+			uint16x8_t r = vmlal_u8(thresh, a.val[0], vdup_n_u8(31));
+			uint16x8_t g = vmlal_u8(thresh, a.val[1], vdup_n_u8(63));
+			uint16x8_t b = vmlal_u8(thresh, a.val[2], vdup_n_u8(31));
+
+			r = vshrq_n_u16(vaddq_u16(vaddq_u16(r, one), vshrq_n_u16(r, 8)), 8);
+			g = vshrq_n_u16(vaddq_u16(vaddq_u16(g, one), vshrq_n_u16(g, 8)), 8);
+			b = vshrq_n_u16(vaddq_u16(vaddq_u16(b, one), vshrq_n_u16(b, 8)), 8);
+
+			vst1q_u16(dst, vorrq_u16(vorrq_u16(vshlq_n_u16(r, 11), vshlq_n_u16(g, 5)), b));
+		}
+
+#endif
+		for (; x < w; ++x, src += 3, ++dst) {
+			const unsigned thresh = t[x & 3];
+			const unsigned r = div255(src[0] * 31U + thresh);
+			const unsigned g = div255(src[1] * 63U + thresh);
+			const unsigned b = div255(src[2] * 31U + thresh);
+
+			*dst = uint16_t(r << 11 | g << 5 | b);
+		}
+	}
+}
+
+} // namespace
+
+size_t pix_format_size(
+	const PixFormat format)
+{
+	switch (format) {
+	case PIX_FORMAT_RGBA8888:
+		return 4;
+	case PIX_FORMAT_RGB565:
+	case PIX_FORMAT_RG88:
+		return 2;
+	default:
+		return 3;
+	}
+}
+
+void convert_rgb888(
+	const PixFormat format,
+	const uint8_t* const src,
+	const unsigned w,
+	const unsigned h,
+	void* const dst)
+{
+	assert(0 != src && 0 != dst);
+
+	const size_t num_pix = size_t(w) * h;
+
+	switch (format) {
+	case PIX_FORMAT_RGBA8888:
+		convertToRGBA8888(src, num_pix, reinterpret_cast< uint8_t* >(dst));
+		break;
+	case PIX_FORMAT_RGB565:
+		convertToRGB565(src, w, h, reinterpret_cast< uint16_t* >(dst));
+		break;
+	case PIX_FORMAT_RG88:
+		convertToRG88(src, num_pix, reinterpret_cast< uint8_t* >(dst));
+		break;
+	default:
+		memcpy(dst, src, num_pix * 3);
+		break;
+	}
+}
+
+} // namespace util
@@ -0,0 +1,39 @@
+#ifndef util_pix_H__
+#define util_pix_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace util {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// conversion of tightly packed RGB888 images to the pixel formats the GL takes without repacking;
+// SSSE3 and NEON kernels where available, scalar otherwise. Converted images are tightly packed too.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+enum PixFormat {
+	PIX_FORMAT_RGB888,		// as stored; GL_RGB of GL_UNSIGNED_BYTE
+	PIX_FORMAT_RGBA8888,	// alpha of 255; GL_RGBA of GL_UNSIGNED_BYTE
+	PIX_FORMAT_RGB565,		// ordered-dithered; GL_RGB of GL_UNSIGNED_SHORT_5_6_5
+	PIX_FORMAT_RG88,		// r and g only, e.g. the x and y of a normal map; GL_RG of GL_UNSIGNED_BYTE
+
+	PIX_FORMAT_COUNT,
+	PIX_FORMAT_FORCE_UINT = -1U
+};
+
+// bytes per pixel of the specified format
+size_t pix_format_size(
+	const PixFormat format);
+
+// convert an RGB888 image to the specified format; dst must be at least pix_format_size(format) * w * h
+// bytes; RGB565 pixels are native-endian
+void convert_rgb888(
+	const PixFormat format,
+	const uint8_t* const src,
+	const unsigned w,
+	const unsigned h,
+	void* const dst);
+
+} // namespace util
+
+#endif // util_pix_H__
@@ -0,0 +1,641 @@
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util_preload.hpp"
+#include "util_pack.hpp"
+
+namespace util {
+
+file_preload::file_preload()
+: num_files(0)
+, in_flight(0)
+, ring_fd(-1)
+, sq_ring(MAP_FAILED)
+, cq_ring(MAP_FAILED)
+, sq_ring_size(0)
+, cq_ring_size(0)
+, sqes(MAP_FAILED)
+, sqes_size(0)
+, sq_head(0)
+, sq_tail(0)
+, sq_mask(0)
+, sq_array(0)
+, cq_head(0)
+, cq_tail(0)
+, cq_mask(0)
+, cqes(0)
+, sq_entries(0)
+, num_workers(0)
+, workers_quit(false)
+{
+	for (unsigned i = 0; i < max_reads; ++i)
+		read[i].busy = false;
+
+	pthread_mutex_init(&mutex, 0);
+	pthread_cond_init(&cond, 0);
+}
+
+file_preload::~file_preload()
+{
+	drop();
+	closeRing();
+
+	pthread_cond_destroy(&cond);
+	pthread_mutex_destroy(&mutex);
+}
+
+bool file_preload::setupRing()
+{
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+	if (-1 != ring_fd)
+		return true;
+
+	io_uring_params params;
+	memset(&params, 0, sizeof(params));
+
+	// seccomp-filtered or pre-5.1 kernels fail this, leaving the pool to do the reads
+	ring_fd = int(syscall(__NR_io_uring_setup, unsigned(max_reads), &params));
+
+	if (-1 == ring_fd)
+		return false;
+
+	sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+	const bool single_mmap = 0 != (params.features & IORING_FEAT_SINGLE_MMAP);
+
+	if (single_mmap) {
+		if (sq_ring_size < cq_ring_size)
+			sq_ring_size = cq_ring_size;
+		cq_ring_size = sq_ring_size;
+	}
+
+	sq_ring = mmap(0, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+	cq_ring = single_mmap ? sq_ring :
+		mmap(0, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+
+	sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+	sqes = mmap(0, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+
+	if (MAP_FAILED == sq_ring || MAP_FAILED == cq_ring || MAP_FAILED == sqes) {
+		closeRing();
+		return false;
+	}
+
+	uint8_t* const sq = reinterpret_cast< uint8_t* >(sq_ring);
+	uint8_t* const cq = reinterpret_cast< uint8_t* >(cq_ring);
+
+	sq_head = reinterpret_cast< unsigned* >(sq + params.sq_off.head);
+	sq_tail = reinterpret_cast< unsigned* >(sq + params.sq_off.tail);
+	sq_mask = reinterpret_cast< unsigned* >(sq + params.sq_off.ring_mask);
+	sq_array = reinterpret_cast< unsigned* >(sq + params.sq_off.array);
+	cq_head = reinterpret_cast< unsigned* >(cq + params.cq_off.head);
+	cq_tail = reinterpret_cast< unsigned* >(cq + params.cq_off.tail);
+	cq_mask = reinterpret_cast< unsigned* >(cq + params.cq_off.ring_mask);
+	cqes = cq + params.cq_off.cqes;
+	sq_entries = params.sq_entries;
+
+	return true;
+
+#else
+	return false;
+
+#endif
+}
+
+void file_preload::closeRing()
+{
+	const bool single_mmap = cq_ring == sq_ring;
+
+	if (MAP_FAILED != sqes)
+		munmap(sqes, sqes_size);
+
+	if (MAP_FAILED != cq_ring && !single_mmap)
+		munmap(cq_ring, cq_ring_size);
+
+	if (MAP_FAILED != sq_ring)
+		munmap(sq_ring, sq_ring_size);
+
+	if (-1 != ring_fd)
+		close(ring_fd);
+
+	ring_fd = -1;
+	sq_ring = MAP_FAILED;
+	cq_ring = MAP_FAILED;
+	sqes = MAP_FAILED;
+}
+
+int file_preload::findFile(
+	const char* const filename) const
+{
+	for (unsigned i = 0; i < num_files; ++i)
+		if (0 != file[i].data && 0 == strcmp(file[i].name, filename))
+			return int(i);
+
+	return -1;
+}
+
+void file_preload::finishFile(
+	File& f,
+	const bool failed)
+{
+	if (failed)
+		f.failed = true;
+
+	// reads still out on a failed file hold on to its descriptor
+	if (-1 != f.fd && (0 == f.remaining || (f.failed && f.next == f.size))) {
+		bool out = false;
+
+		for (unsigned i = 0; i < max_reads && !out; ++i)
+			out = read[i].busy && &file[read[i].file] == &f;
+
+		if (!out) {
+			close(f.fd);
+			f.fd = -1;
+		}
+	}
+
+	pthread_cond_broadcast(&cond);
+}
+
+unsigned file_preload::request(
+	const char* const* filenames,
+	const unsigned count)
+{
+	assert(0 != filenames);
+
+	const asset_pack& pack = shared_asset_pack();
+	unsigned requested = 0;
+
+	pthread_mutex_lock(&mutex);
+
+	for (unsigned i = 0; i < count; ++i) {
+		const char* const filename = filenames[i];
+
+		if (0 == filename || 0 != pack.find(filename) || -1 != findFile(filename))
+			continue;
+
+		// recycle the slots of files taken
+		unsigned slot = 0;
+
+		while (slot < num_files && 0 != file[slot].data)
+			++slot;
+
+		if (max_files == slot || sizeof(file[slot].name) <= strlen(filename)) {
+			fprintf(stderr, "%s cannot preload '%s'\n", __FUNCTION__, filename);
+			continue;
+		}
+
+		const int fd = open(filename, O_RDONLY);
+
+		if (-1 == fd)
+			continue;
+
+		struct stat filestat;
+
+		if (-1 == fstat(fd, &filestat) || !S_ISREG(filestat.st_mode)) {
+			close(fd);
+			continue;
+		}
+
+		const size_t size = size_t(filestat.st_size);
+		uint8_t* const data = reinterpret_cast< uint8_t* >(malloc(size + guardband));
+
+		if (0 == data) {
+			close(fd);
+			continue;
+		}
+
+		memset(data + size, 0, guardband);
+
+		File& f = file[slot];
+		strcpy(f.name, filename);
+		f.fd = fd;
+		f.data = data;
+		f.size = size;
+		f.next = 0;
+		f.remaining = size;
+		f.failed = false;
+
+		if (num_files == slot)
+			++num_files;
+
+		// empty files are done as they are
+		finishFile(f, false);
+		++requested;
+	}
+
+	if (0 != requested) {
+		if (setupRing())
+			issue();
+		else
+		// spawn the pool on first need; without workers the reads go in line at take
+		if (0 == num_workers) {
+			workers_quit = false;
+
+			for (; num_workers < max_workers; ++num_workers)
+				if (0 != pthread_create(worker + num_workers, 0, workerMain, this))
+					break;
+		}
+		else
+			pthread_cond_broadcast(&cond);
+	}
+
+	pthread_mutex_unlock(&mutex);
+	return requested;
+}
+
+unsigned file_preload::warm(
+	const char* const* filenames,
+	const unsigned count)
+{
+	assert(0 != filenames);
+
+	const asset_pack& pack = shared_asset_pack();
+	unsigned warmed = 0;
+
+	for (unsigned i = 0; i < count; ++i) {
+		const char* const filename = filenames[i];
+
+		if (0 == filename || 0 != pack.find(filename))
+			continue;
+
+		const int fd = open(filename, O_RDONLY);
+
+		if (-1 == fd)
+			continue;
+
+		// the readahead goes out asynchronously and outlives the descriptor
+		if (0 == posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED))
+			++warmed;
+
+		close(fd);
+	}
+
+	return warmed;
+}
+
+unsigned file_preload::issue()
+{
+	unsigned queued = 0;
+	unsigned index = 0;
+
+	for (unsigned i = 0; i < num_files; ++i) {
+		File& f = file[i];
+
+		while (0 != f.data && !f.failed && f.next < f.size) {
+			while (index < max_reads && read[index].busy)
+				++index;
+
+			if (max_reads == index || in_flight == sq_entries)
+				break;
+
+			const size_t length = f.size - f.next < size_t(read_size) ? f.size - f.next : size_t(read_size);
+
+			Read& r = read[index];
+			r.file = i;
+			r.offset = f.next;
+			r.iov.iov_base = f.data + f.next;
+			r.iov.iov_len = length;
+			r.busy = true;
+
+			f.next += length;
+			submit(index);
+			++queued;
+		}
+	}
+
+	// the whole batch goes to the kernel in one call
+	if (0 != queued)
+		enter(0);
+
+	return queued;
+}
+
+void file_preload::submit(
+	const unsigned index)
+{
+	const Read& r = read[index];
+	const unsigned tail = *sq_tail;
+	const unsigned entry = tail & *sq_mask;
+
+	io_uring_sqe& sqe = reinterpret_cast< io_uring_sqe* >(sqes)[entry];
+	memset(&sqe, 0, sizeof(sqe));
+	sqe.opcode = IORING_OP_READV;
+	sqe.fd = file[r.file].fd;
+	sqe.addr = uint64_t(uintptr_t(&r.iov));
+	sqe.len = 1;
+	sqe.off = r.offset;
+	sqe.user_data = index;
+
+	sq_array[entry] = entry;
+	__atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+	++in_flight;
+}
+
+bool file_preload::enter(
+	const unsigned min_complete)
+{
+#if defined(__NR_io_uring_enter)
+	// entries left over from a failed submission go along
+	const unsigned to_submit = *sq_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+
+	if (0 <= syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete,
+			0 != min_complete ? IORING_ENTER_GETEVENTS : 0, 0, 0) || EINTR == errno)
+		return true;
+
+	fprintf(stderr, "%s failed, errno %d\n", __FUNCTION__, errno);
+
+#endif
+	return false;
+}
+
+bool file_preload::reap()
+{
+	unsigned head = *cq_head;
+
+	if (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE) && !enter(1))
+		return false;
+
+	const unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+	unsigned resubmit = 0;
+
+	for (; head != tail; ++head) {
+		const io_uring_cqe& cqe = reinterpret_cast< const io_uring_cqe* >(cqes)[head & *cq_mask];
+		const unsigned index = unsigned(cqe.user_data);
+		const long res = cqe.res;
+
+		--in_flight;
+		complete(index, res);
+
+		// short reads go back for the rest
+		if (read[index].busy) {
+			submit(index);
+			++resubmit;
+		}
+	}
+
+	__atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+
+	if (0 != resubmit)
+		enter(0);
+
+	return true;
+}
+
+void file_preload::complete(
+	const unsigned index,
+	const long res)
+{
+	Read& r = read[index];
+	File& f = file[r.file];
+
+	if (-EINTR == res || -EAGAIN == res)
+		return;
+
+	// an error, or the end of a file that shrunk since
+	if (0 >= res) {
+		fprintf(stderr, "%s failed to read '%s', errno %ld\n", __FUNCTION__, f.name, -res);
+		r.busy = false;
+		f.next = f.size;
+		finishFile(f, true);
+		return;
+	}
+
+	f.remaining -= size_t(res);
+
+	if (size_t(res) < r.iov.iov_len) {
+		r.offset += size_t(res);
+		r.iov.iov_base = reinterpret_cast< uint8_t* >(r.iov.iov_base) + res;
+		r.iov.iov_len -= size_t(res);
+		return;
+	}
+
+	r.busy = false;
+	finishFile(f, false);
+}
+
+void* file_preload::workerMain(
+	void* arg)
+{
+	reinterpret_cast< file_preload* >(arg)->workerLoop();
+	return 0;
+}
+
+void file_preload::workerLoop()
+{
+	pthread_mutex_lock(&mutex);
+
+	while (true) {
+		// claim the next read of any file, in the order requested
+		unsigned i = 0;
+
+		while (i < num_files && (0 == file[i].data || file[i].failed || file[i].next == file[i].size))
+			++i;
+
+		if (num_files == i) {
+			if (workers_quit)
+				break;
+
+			pthread_cond_wait(&cond, &mutex);
+			continue;
+		}
+
+		File& f = file[i];
+		const size_t offset = f.next;
+		const size_t length = f.size - offset < size_t(read_size) ? f.size - offset : size_t(read_size);
+		uint8_t* const dst = f.data + offset;
+		const int fd = f.fd;
+
+		f.next += length;
+
+		// hold off closing the descriptor while this read is out
+		unsigned index = 0;
+
+		while (read[index].busy)
+			++index;
+
+		read[index].file = i;
+		read[index].busy = true;
+
+		pthread_mutex_unlock(&mutex);
+
+		size_t done = 0;
+		long res = 1;
+
+		while (done < length) {
+			res = long(pread(fd, dst + done, length - done, off_t(offset + done)));
+
+			if (0 > res && EINTR == errno)
+				continue;
+
+			if (0 >= res)
+				break;
+
+			done += size_t(res);
+		}
+
+		const int error = errno;
+		pthread_mutex_lock(&mutex);
+
+		read[index].busy = false;
+		f.remaining -= done;
+
+		if (done < length) {
+			fprintf(stderr, "%s failed to read '%s', errno %d\n", __FUNCTION__, f.name, 0 > res ? error : 0);
+			f.next = f.size;
+			finishFile(f, true);
+		}
+		else
+			finishFile(f, false);
+	}
+
+	pthread_mutex_unlock(&mutex);
+}
+
+void file_preload::stopWorkers()
+{
+	if (0 == num_workers)
+		return;
+
+	pthread_mutex_lock(&mutex);
+	workers_quit = true;
+	pthread_cond_broadcast(&cond);
+	pthread_mutex_unlock(&mutex);
+
+	for (unsigned i = 0; i < num_workers; ++i)
+		pthread_join(worker[i], 0);
+
+	num_workers = 0;
+}
+
+uint8_t* file_preload::take(
+	const char* const filename,
+	size_t& size,
+	const size_t tail)
+{
+	assert(0 != filename);
+
+	pthread_mutex_lock(&mutex);
+
+	const int i = 0 != num_files ? findFile(filename) : -1;
+
+	if (-1 == i) {
+		pthread_mutex_unlock(&mutex);
+		return 0;
+	}
+
+	File& f = file[i];
+
+	while (0 != f.remaining && !f.failed) {
+		if (-1 != ring_fd) {
+			if (0 == in_flight && 0 == issue())
+				break;
+
+			if (!reap())
+				break;
+
+			issue();
+		}
+		else
+		if (0 != num_workers)
+			pthread_cond_wait(&cond, &mutex);
+		else {
+			// no pool -- read in line
+			const ssize_t res = pread(f.fd, f.data + f.size - f.remaining, f.remaining, off_t(f.size - f.remaining));
+
+			if (0 > res && EINTR == errno)
+				continue;
+
+			if (0 >= res) {
+				f.failed = true;
+				break;
+			}
+
+			f.remaining -= size_t(res);
+		}
+	}
+
+	f.next = f.size;
+	finishFile(f, 0 != f.remaining);
+
+	uint8_t* data = f.data;
+	size = f.size;
+
+	// with reads still out the buffer stays until drop
+	const bool release = -1 == f.fd;
+
+	if (!f.failed && release)
+		f.data = 0;
+	else
+		data = 0;
+
+	pthread_mutex_unlock(&mutex);
+
+	if (0 != data && size_t(guardband) < tail) {
+		uint8_t* const grown = reinterpret_cast< uint8_t* >(realloc(data, size + tail));
+
+		if (0 == grown) {
+			free(data);
+			return 0;
+		}
+
+		data = grown;
+		memset(data + size + guardband, 0, tail - guardband);
+	}
+
+	return data;
+}
+
+void file_preload::drop()
+{
+	pthread_mutex_lock(&mutex);
+
+	// the kernel writes to the buffers till the last read completes
+	while (-1 != ring_fd && 0 != in_flight)
+		if (!reap())
+			break;
+
+	for (unsigned i = 0; i < num_files; ++i)
+		if (0 != file[i].data)
+			file[i].next = file[i].size;
+
+	pthread_mutex_unlock(&mutex);
+
+	stopWorkers();
+
+	for (unsigned i = 0; i < num_files; ++i) {
+		File& f = file[i];
+
+		if (-1 != f.fd)
+			close(f.fd);
+
+		free(f.data);
+		f.fd = -1;
+		f.data = 0;
+	}
+
+	for (unsigned i = 0; i < max_reads; ++i)
+		read[i].busy = false;
+
+	num_files = 0;
+	in_flight = 0;
+}
+
+file_preload& shared_file_preload()
+{
+	static file_preload preload;
+	return preload;
+}
+
+} // namespace util
@@ -0,0 +1,143 @@
+#ifndef util_preload_H__
+#define util_preload_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include "scoped.hpp"
+
+namespace util {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// batched reads of loose files: an app requests the files it can name up front in one go, and the reads
+// go to the kernel together, through an io_uring where available, or to a pool of threads doing
+// blocking reads otherwise, so the storage sees them queued. get_buffer_from_file and open_file
+// resolve names through the process-wide preload ahead of loose files, each waiting on the read of its
+// own file only, so the parsing of an asset starts as soon as its read completes. Files consumed through
+// mapped_file get warmed in the page cache instead, so that their mappings keep sharing its pages.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class file_preload : non_copyable
+{
+public:
+	enum {
+		max_files = 64,
+		max_reads = 64,			// reads in flight
+		max_workers = 4,
+		read_size = 1 << 20,	// of the largest read
+		guardband = 16			// zeroed bytes past the content of the buffers
+	};
+
+	file_preload();
+	~file_preload();
+
+	// issue the reads of the specified files, skipping those of the asset pack and those that cannot be
+	// opened; return the number of files requested
+	unsigned request(
+		const char* const* filenames,
+		const unsigned count);
+
+	// have the kernel read ahead the specified files into the page cache, skipping those of the asset
+	// pack and those that cannot be opened; return the number of files warmed
+	unsigned warm(
+		const char* const* filenames,
+		const unsigned count);
+
+	// take over the content of a requested file, waiting for its read to complete, as a heap buffer to
+	// free, with at least the specified number of zeroed bytes past the content; return null if the
+	// file was not requested or its read failed
+	uint8_t* take(
+		const char* const filename,
+		size_t& size,
+		const size_t tail = guardband);
+
+	// wait out all reads and release the files not taken
+	void drop();
+
+private:
+	struct File
+	{
+		char name[256];
+		int fd;
+		uint8_t* data;
+		size_t size;
+		size_t next;		// offset of the next read to issue
+		size_t remaining;	// bytes yet to read
+		bool failed;
+	};
+
+	struct Read
+	{
+		unsigned file;
+		size_t offset;
+		struct iovec iov;
+		bool busy;
+	};
+
+	File file[max_files];
+	Read read[max_reads];
+	unsigned num_files;
+	unsigned in_flight;
+
+	// io_uring
+	int ring_fd;
+	void* sq_ring;
+	void* cq_ring;
+	size_t sq_ring_size;
+	size_t cq_ring_size;
+	void* sqes;
+	size_t sqes_size;
+	unsigned* sq_head;
+	unsigned* sq_tail;
+	unsigned* sq_mask;
+	unsigned* sq_array;
+	unsigned* cq_head;
+	unsigned* cq_tail;
+	unsigned* cq_mask;
+	void* cqes;
+	unsigned sq_entries;
+
+	// pool fallback
+	pthread_t worker[max_workers];
+	unsigned num_workers;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	bool workers_quit;
+
+	bool setupRing();
+	void closeRing();
+
+	// queue reads of pending files into free read slots; return the number queued
+	unsigned issue();
+	void submit(const unsigned index);
+
+	// submit the queued entries to the ring, waiting for the specified number of completions
+	bool enter(const unsigned min_complete);
+
+	// reap completed reads, waiting for at least one; return false upon failure of the ring
+	bool reap();
+
+	// account for a completed read of the specified byte count, or negative errno
+	void complete(
+		const unsigned index,
+		const long res);
+
+	void finishFile(
+		File& f,
+		const bool failed);
+
+	int findFile(
+		const char* const filename) const;
+
+	static void* workerMain(void* arg);
+	void workerLoop();
+	void stopWorkers();
+};
+
+// process-wide preload the loaders resolve names through
+file_preload& shared_file_preload();
+
+} // namespace util
+
+#endif // util_preload_H__
@@ -1,9 +1,16 @@
+#if PLATFORM_GLES
+	#include <GLES3/gl3.h>
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
+#include <vector>
 
 #include "scoped.hpp"
 #include "util_file.hpp"
+#include "util_mip.hpp"
 #include "util_tex.hpp"
 #include "util_misc.hpp"
 
@@ -45,13 +52,18 @@ static size_t next_multiple_of_pix_integral(
 	return (unaligned_size + integralSize) & ~integralSize;
 }
 
+// .raw layout: 32-bit width and height, followed by level 0 in tightly packed RGB888, optionally
+// followed by the rest of the full mip chain, level by level; alternatively, followed by an 8-bit
+// height map, which makes for a normal map
 static bool fill_from_file(
 	const pix* const buffer,
 	unsigned& tex_w,
 	unsigned& tex_h,
+	unsigned& num_levels,
+	bool& height,
 	const size_t fileSize)
 {
-	if (0 == buffer)
+	if (0 == buffer || fileSize < sizeof(uint32_t[2]))
 		return false;
 
 	const uint32_t* header = reinterpret_cast< const uint32_t* >(buffer);
@@ -59,9 +71,33 @@ static bool fill_from_file(
 	const uint32_t w = header[0];
 	const uint32_t h = header[1];
 
-	if (size_t(w) * size_t(h) * sizeof(pix) == fileSize - sizeof(uint32_t[2])) {
+	if (0 == w || 0 == h)
+		return false;
+
+	const size_t payload = fileSize - sizeof(uint32_t[2]);
+	height = false;
+
+	if (size_t(w) * size_t(h) == payload) {
+		tex_w = w;
+		tex_h = h;
+		num_levels = 1;
+		height = true;
+		return true;
+	}
+
+	if (size_t(w) * size_t(h) * sizeof(pix) == payload) {
+		tex_w = w;
+		tex_h = h;
+		num_levels = 1;
+		return true;
+	}
+
+	const unsigned chain_len = mip_level_count(w, h);
+
+	if (mip_chain_size(w, h, 0, chain_len) == payload) {
 		tex_w = w;
 		tex_h = h;
+		num_levels = chain_len;
 		return true;
 	}
 
@@ -85,6 +121,87 @@ static void fill_with_checker(
 		}
 }
 
+#ifndef GL_COMPRESSED_RG11_EAC
+#define GL_COMPRESSED_RG11_EAC 0x9272
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2 0x9274
+#endif
+#ifndef GL_RG
+#define GL_RG 0x8227
+#endif
+#ifndef GL_RG8
+#define GL_RG8 0x822B
+#endif
+#ifndef GL_RGB8
+#define GL_RGB8 0x8051
+#endif
+#ifndef GL_RGBA8
+#define GL_RGBA8 0x8058
+#endif
+#ifndef GL_RGB565
+#define GL_RGB565 0x8D62
+#endif
+
+// normal maps from height maps, short of specific parameters
+static const HeightDesc default_height_desc = { 4.f, HEIGHT_FILTER_SCHARR, HEIGHT_WRAP_REPEAT };
+
+// major version of the GLES context, or zero for non-ES
+static unsigned gles_major_version()
+{
+	const char* const version = reinterpret_cast< const char* >(glGetString(GL_VERSION));
+	unsigned major = 0;
+
+	if (0 == version || 1 != sscanf(version, "OpenGL ES %u", &major))
+		return 0;
+
+	return major;
+}
+
+// whether the GL can sample NPOT textures with mips: ES2 needs an extension, ES3 and desktop GL do not
+static bool npot_mipmap_supported()
+{
+#if PLATFORM_GL
+	return true;
+#else
+	return 3 <= gles_major_version() || hasGLExtension("GL_OES_texture_npot");
+#endif
+}
+
+// whether the GL can sample ETC2 and EAC textures: ES3 and GL 4.3 can
+static bool etc2_supported()
+{
+#if PLATFORM_GL
+	return hasGLExtension("GL_ARB_ES3_compatibility");
+#else
+	return 3 <= gles_major_version();
+#endif
+}
+
+// whether the GL can sample two-component textures: ES3 and GL 3.0 can, ES2 needs an extension
+static bool rg_supported()
+{
+#if PLATFORM_GL
+	return true;
+#else
+	return 3 <= gles_major_version() || hasGLExtension("GL_EXT_texture_rg");
+#endif
+}
+
+// query the texture facilities of the current context
+void queryTexCaps(
+	TexCaps& caps)
+{
+#if PLATFORM_GL
+	caps.storage = false;
+#else
+	caps.storage = 3 <= gles_major_version();
+#endif
+	caps.npot_mipmap = npot_mipmap_supported();
+	caps.etc2 = etc2_supported();
+	caps.rg = rg_supported();
+}
+
 bool setupTexture2D(
 	const GLuint tex_name,
 	const pix* const buffer,
@@ -96,34 +213,519 @@ bool setupTexture2D(
 	assert(0 != buffer);
 	assert(0 != tex_w && 0 != tex_h);
 
-	const size_t pix_size = sizeof(pix);
-	const size_t tex_size = tex_h * tex_w * pix_size;
+	const size_t tex_size = tex_h * tex_w * sizeof(pix);
+
+	fprintf(stdout, "%u x %u x %u bpp, %u bytes\n", tex_w, tex_h, unsigned(sizeof(pix) * 8), unsigned(tex_size));
 
-	fprintf(stdout, "%u x %u x %u bpp, %u bytes\n", tex_w, tex_h, unsigned(pix_size * 8), unsigned(tex_size));
+	TexCaps caps;
+	queryTexCaps(caps);
 
+	// POT textures get their mips from the GL
 	const bool pot = 0 == (tex_w & tex_w - 1) && 0 == (tex_h & tex_h - 1);
+	const bool mips = pot && (tex_w > 1 || tex_h > 1);
 
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, tex_name);
 
 	if (sampleNearest) {
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, pot ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mips ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST);
 	}
 	else {
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, pot ? GL_LINEAR_MIPMAP_NEAREST : GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mips ? GL_LINEAR_MIPMAP_NEAREST : GL_LINEAR);
 	}
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, tex_w, tex_h, 0, GL_RGB, GL_UNSIGNED_BYTE, 0);
-	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, tex_w, tex_h, GL_RGB, GL_UNSIGNED_BYTE, buffer);
+	// rows of pixels are tightly packed
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-	if (pot) {
+#if PLATFORM_GLES
+	if (caps.storage) {
+		glTexStorage2D(GL_TEXTURE_2D, mips ? mip_level_count(tex_w, tex_h) : 1, GL_RGB8, tex_w, tex_h);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, tex_w, tex_h, GL_RGB, GL_UNSIGNED_BYTE, buffer);
+	}
+	else
+
+#endif
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, tex_w, tex_h, 0, GL_RGB, GL_UNSIGNED_BYTE, buffer);
+
+	if (mips) {
 		glGenerateMipmap(GL_TEXTURE_2D);
 	}
 
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	const bool success = !reportGLError(stderr);
+	return success;
+}
+
+static const uint8_t ktx_identifier[12] = {
+	0xab, 'K', 'T', 'X', ' ', '1', '1', 0xbb, '\r', '\n', 0x1a, '\n'
+};
+
+// KTX v1 header, past the identifier
+struct KtxHeader {
+	uint32_t endianness;
+	uint32_t glType;
+	uint32_t glTypeSize;
+	uint32_t glFormat;
+	uint32_t glInternalFormat;
+	uint32_t glBaseInternalFormat;
+	uint32_t pixelWidth;
+	uint32_t pixelHeight;
+	uint32_t pixelDepth;
+	uint32_t numberOfArrayElements;
+	uint32_t numberOfFaces;
+	uint32_t numberOfMipmapLevels;
+	uint32_t bytesOfKeyValueData;
+};
+
+static bool is_ktx(
+	const uint8_t* const file,
+	const size_t fileSize)
+{
+	return fileSize >= sizeof(ktx_identifier) && 0 == memcmp(file, ktx_identifier, sizeof(ktx_identifier));
+}
+
+tex_source::tex_source()
+: w(0)
+, h(0)
+, num_levels(0)
+, internal_format(0)
+, format(0)
+, type(0)
+, base_format(0)
+, alignment(1)
+, pix_format(PIX_FORMAT_RGB888)
+, mip_mode(MIP_MODE_LINEAR)
+, height(false)
+, ktx(false)
+, compressed(false)
+, prepared(false)
+{
+	height_desc = default_height_desc;
+}
+
+void tex_source::close()
+{
+	file.close();
+	std::vector< uint8_t >().swap(normal_src);
+	std::vector< uint8_t >().swap(mip_src);
+
+	w = 0;
+	h = 0;
+	num_levels = 0;
+	height = false;
+	ktx = false;
+	compressed = false;
+	prepared = false;
+}
+
+bool tex_source::open(
+	const char* const filename,
+	const MipMode mipMode,
+	const PixFormat pixFormat,
+	const HeightDesc* const heightDesc,
+	const TexCaps& caps)
+{
+	assert(0 != filename);
+
+	close();
+
+	// provide some guardband as pixels are of non-word-multiple size
+	if (!file.open(filename, true, integral_size(sizeof(pix))))
+		return false;
+
+	mip_mode = mipMode;
+	height_desc = 0 != heightDesc ? *heightDesc : default_height_desc;
+
+	// KTX files carry their own format and mips
+	if (is_ktx(file.data(), file.length())) {
+		fprintf(stdout, "texture KTX '%s' ", filename);
+
+		if (open_ktx(caps))
+			return true;
+	}
+	else
+	if (open_raw(pixFormat, caps)) {
+		fprintf(stdout, "texture %s '%s' %u x %u x %u bpp, %u levels\n", height ? "height map" : "bitmap", filename,
+			w, h, unsigned(pix_format_size(pix_format) * 8), num_levels);
+		return true;
+	}
+
+	close();
+	return false;
+}
+
+// a KTX v1 texture of ETC2 RGB8 or EAC RG11, or of uncompressed RGB888, RGBA8888, RGB565 or RG88, used
+// straight from the file; the mips get used only if the file carries the full chain
+bool tex_source::open_ktx(
+	const TexCaps& caps)
+{
+	const uint8_t* const data = file.data();
+	const size_t fileSize = file.length();
+	KtxHeader header;
+
+	if (fileSize < sizeof(ktx_identifier) + sizeof(header)) {
+		fprintf(stderr, "%s encountered truncated header\n", __FUNCTION__);
+		return false;
+	}
+
+	memcpy(&header, data + sizeof(ktx_identifier), sizeof(header));
+
+	if (0x04030201 != header.endianness ||
+		0 == header.pixelWidth || 0 == header.pixelHeight || 1 < header.pixelDepth ||
+		0 != header.numberOfArrayElements || 1 != header.numberOfFaces) {
+
+		fprintf(stderr, "%s encountered non-2D or foreign-endian texture\n", __FUNCTION__);
+		return false;
+	}
+
+	// compressed levels come in blocks of 4x4 texels, uncompressed ones in rows padded to 4 bytes
+	compressed = 0 == header.glType && 0 == header.glFormat;
+	size_t block_size = 0;
+	size_t pix_size = 0;
+
+	if (compressed)
+		switch (header.glInternalFormat) {
+		case GL_COMPRESSED_RGB8_ETC2:
+			block_size = 8;
+			break;
+		case GL_COMPRESSED_RG11_EAC:
+			block_size = 16;
+			break;
+		}
+	else
+		switch (header.glType) {
+		case GL_UNSIGNED_BYTE:
+			switch (header.glFormat) {
+			case GL_RGB:
+				pix_size = 3;
+				internal_format = GL_RGB8;
+				break;
+			case GL_RGBA:
+				pix_size = 4;
+				internal_format = GL_RGBA8;
+				break;
+			case GL_RG:
+				pix_size = 2;
+				internal_format = GL_RG8;
+				break;
+			}
+			break;
+		case GL_UNSIGNED_SHORT_5_6_5:
+			pix_size = GL_RGB == header.glFormat ? 2 : 0;
+			internal_format = GL_RGB565;
+			break;
+		}
+
+	if (0 == block_size && 0 == pix_size) {
+		fprintf(stderr, "%s encountered unsupported format 0x%04x of type 0x%04x\n", __FUNCTION__,
+			compressed ? header.glInternalFormat : header.glFormat, header.glType);
+		return false;
+	}
+
+	if (compressed && !caps.etc2) {
+		fprintf(stderr, "%s found no ETC2/EAC support in the GL\n", __FUNCTION__);
+		return false;
+	}
+
+	if (GL_RG == header.glFormat && !caps.rg) {
+		fprintf(stderr, "%s found no two-component texture support in the GL\n", __FUNCTION__);
+		return false;
+	}
+
+	const unsigned chain_len = mip_level_count(header.pixelWidth, header.pixelHeight);
+	const unsigned file_levels = header.numberOfMipmapLevels ? header.numberOfMipmapLevels : 1;
+
+	if (file_levels > chain_len) {
+		fprintf(stderr, "%s encountered excess mip levels\n", __FUNCTION__);
+		return false;
+	}
+
+	w = header.pixelWidth;
+	h = header.pixelHeight;
+
+	// levels in use: all of the full chain, as long as the GL can sample it, or just the base
+	const bool pot = 0 == (w & (w - 1)) && 0 == (h & (h - 1));
+	num_levels = file_levels == chain_len && (pot || caps.npot_mipmap) ? file_levels : 1;
+
+	size_t offset = sizeof(ktx_identifier) + sizeof(header);
+
+	if (fileSize - offset < header.bytesOfKeyValueData) {
+		fprintf(stderr, "%s encountered truncated key/value data\n", __FUNCTION__);
+		return false;
+	}
+
+	offset += header.bytesOfKeyValueData;
+
+	for (unsigned i = 0; i < num_levels; ++i) {
+		const size_t level_w = mip_level_dim(w, i);
+		const size_t level_h = mip_level_dim(h, i);
+
+		level_stride[i] = compressed
+			? (level_w + 3) / 4 * block_size
+			: (level_w * pix_size + 3) & ~size_t(3);
+
+		const size_t expected = compressed
+			? level_stride[i] * ((level_h + 3) / 4)
+			: level_stride[i] * level_h;
+
+		uint32_t level_size;
+
+		if (fileSize - offset < sizeof(level_size)) {
+			fprintf(stderr, "%s encountered truncated level %u\n", __FUNCTION__, i);
+			return false;
+		}
+
+		memcpy(&level_size, data + offset, sizeof(level_size));
+		offset += sizeof(level_size);
+
+		if (expected != level_size || fileSize - offset < level_size) {
+			fprintf(stderr, "%s encountered truncated or mis-sized level %u\n", __FUNCTION__, i);
+			return false;
+		}
+
+		level_src[i] = data + offset;
+		offset += (level_size + 3) & ~size_t(3);
+		offset = offset < fileSize ? offset : fileSize;
+	}
+
+	if (compressed)
+		internal_format = header.glInternalFormat;
+
+	format = header.glFormat;
+	type = header.glType;
+	base_format = compressed ? header.glInternalFormat : header.glFormat;
+	alignment = 4;
+	pix_format = PIX_FORMAT_RGB888;
+	ktx = true;
+	prepared = true;
+
+	fprintf(stdout, "%u x %u, format 0x%04x, %u bytes, %u levels\n", w, h,
+		base_format, unsigned(band_size(0, h)), num_levels);
+
+	return true;
+}
+
+// a .raw texture along with its mip chain, the chain to be produced if the file carries none, in the
+// specified pixel format, RG88 falling back to RGB888 where unsupported
+bool tex_source::open_raw(
+	const PixFormat pixFormat,
+	const TexCaps& caps)
+{
+	unsigned file_levels = 1;
+
+	if (!fill_from_file(reinterpret_cast< const pix* >(file.data()), w, h, file_levels, height, file.length()))
+		return false;
+
+	const bool pot = 0 == (w & (w - 1)) && 0 == (h & (h - 1));
+	const size_t header_size = sizeof(uint32_t[2]);
+
+	// no mips in the file -- produce them upon preparation rather than leave them to the GL, or go
+	// without for NPOT
+	if (1 == file_levels && (w > 1 || h > 1) && (pot || caps.npot_mipmap))
+		num_levels = mip_level_count(w, h);
+	else
+		num_levels = pot || caps.npot_mipmap ? file_levels : 1;
+
+	// level sources of height maps and of produced mips are known upon preparation
+	level_src[0] = file.data() + header_size;
+
+	for (unsigned i = 1; i < file_levels && i < num_levels; ++i)
+		level_src[i] = level_src[i - 1] + size_t(mip_level_dim(w, i - 1)) * mip_level_dim(h, i - 1) * sizeof(pix);
+
+	// two-component textures need GL support; otherwise keep all three components
+	pix_format = PIX_FORMAT_RG88 != pixFormat || caps.rg ? pixFormat : PIX_FORMAT_RGB888;
+
+	switch (pix_format) {
+	case PIX_FORMAT_RGBA8888:
+		internal_format = GL_RGBA8;
+		format = GL_RGBA;
+		type = GL_UNSIGNED_BYTE;
+		break;
+	case PIX_FORMAT_RGB565:
+		internal_format = GL_RGB565;
+		format = GL_RGB;
+		type = GL_UNSIGNED_SHORT_5_6_5;
+		break;
+	case PIX_FORMAT_RG88:
+		internal_format = GL_RG8;
+		format = GL_RG;
+		type = GL_UNSIGNED_BYTE;
+		break;
+	default:
+		internal_format = GL_RGB8;
+		format = GL_RGB;
+		type = GL_UNSIGNED_BYTE;
+		break;
+	}
+
+	for (unsigned i = 0; i < num_levels; ++i)
+		level_stride[i] = size_t(mip_level_dim(w, i)) * pix_format_size(pix_format);
+
+	// rows of pixels are tightly packed, at any level
+	base_format = format;
+	alignment = 1;
+	prepared = !height && file_levels == num_levels;
+	return true;
+}
+
+void tex_source::prepare()
+{
+	if (prepared)
+		return;
+
+	const uint8_t* level0 = level_src[0];
+
+	// height maps make for normal maps, which take the place of the file content
+	if (height) {
+		normal_src.resize(size_t(w) * h * sizeof(pix));
+		normal_from_height(level0, w, h, height_desc, &normal_src[0]);
+		level0 = &normal_src[0];
+		level_src[0] = level0;
+	}
+
+	if (1 < num_levels) {
+		mip_src.resize(mip_chain_size(w, h, 1, num_levels - 1));
+		build_mip_chain(level0, w, h, MIP_FILTER_BOX, height ? MIP_MODE_NORMAL : mip_mode, &mip_src[0]);
+
+		level_src[1] = &mip_src[0];
+
+		for (unsigned i = 2; i < num_levels; ++i)
+			level_src[i] = level_src[i - 1] + size_t(mip_level_dim(w, i - 1)) * mip_level_dim(h, i - 1) * sizeof(pix);
+	}
+
+	prepared = true;
+}
+
+size_t tex_source::band_size(
+	const unsigned level,
+	const unsigned num_rows) const
+{
+	assert(level < num_levels);
+
+	return compressed
+		? level_stride[level] * ((num_rows + 3) / 4)
+		: level_stride[level] * num_rows;
+}
+
+void tex_source::write_band(
+	const unsigned level,
+	const unsigned first_row,
+	const unsigned num_rows,
+	uint8_t* const dst) const
+{
+	assert(prepared);
+	assert(level < num_levels);
+	assert(0 == first_row % band_granularity);
+	assert(first_row + num_rows <= mip_level_dim(h, level));
+
+	// KTX levels go as stored
+	if (ktx) {
+		memcpy(dst, level_src[level] + band_size(level, first_row), band_size(level, num_rows));
+		return;
+	}
+
+	const unsigned level_w = mip_level_dim(w, level);
+	const uint8_t* const src = level_src[level] + size_t(first_row) * level_w * sizeof(pix);
+
+	if (PIX_FORMAT_RGB888 == pix_format) {
+		memcpy(dst, src, size_t(num_rows) * level_w * sizeof(pix));
+		return;
+	}
+
+	// bands start at multiples of the dither period, so the dither stays seamless
+	convert_rgb888(pix_format, src, level_w, num_rows, dst);
+}
+
+const uint8_t* tex_source::level_data(
+	const unsigned level) const
+{
+	assert(prepared);
+	assert(level < num_levels);
+
+	return PIX_FORMAT_RGB888 == pix_format ? level_src[level] : 0;
+}
+
+void allocTexture2D(
+	const GLuint tex_name,
+	const tex_source& src,
+	const bool sampleNearest,
+	const bool storage)
+{
+	assert(0 != tex_name);
+	assert(0 != src.num_levels);
+
+	const bool mips = 1 < src.num_levels;
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, tex_name);
+
+	if (sampleNearest) {
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mips ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST);
+	}
+	else {
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mips ? GL_LINEAR_MIPMAP_NEAREST : GL_LINEAR);
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+#if PLATFORM_GLES
+	if (storage)
+		glTexStorage2D(GL_TEXTURE_2D, src.num_levels, src.internal_format, src.w, src.h);
+
+#else
+	(void) storage;
+
+#endif
+}
+
+// upload all levels of a texture from client memory
+static bool uploadTexture2D(
+	const GLuint tex_name,
+	const tex_source& src,
+	const bool sampleNearest,
+	const bool storage)
+{
+	allocTexture2D(tex_name, src, sampleNearest, storage);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, src.alignment);
+
+	// scratch for the written levels, sized for the base
+	std::vector< uint8_t > scratch;
+
+	for (unsigned i = 0; i < src.num_levels; ++i) {
+		const unsigned w = mip_level_dim(src.w, i);
+		const unsigned h = mip_level_dim(src.h, i);
+		const uint8_t* level_data = src.level_data(i);
+		const size_t level_size = src.band_size(i, h);
+
+		if (0 == level_data) {
+			scratch.resize(level_size);
+			src.write_band(i, 0, h, &scratch[0]);
+			level_data = &scratch[0];
+		}
+
+		if (storage) {
+			if (0 == src.format)
+				glCompressedTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, w, h, src.internal_format, level_size, level_data);
+			else
+				glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, w, h, src.format, src.type, level_data);
+		}
+		else {
+			if (0 == src.format)
+				glCompressedTexImage2D(GL_TEXTURE_2D, i, src.internal_format, w, h, 0, level_size, level_data);
+			else
+				glTexImage2D(GL_TEXTURE_2D, i, src.format, w, h, 0, src.format, src.type, level_data);
+		}
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 	glBindTexture(GL_TEXTURE_2D, 0);
 
 	const bool success = !reportGLError(stderr);
@@ -135,47 +737,69 @@ bool setupTexture2D(
 	const char* const filename,
 	unsigned& tex_w,
 	unsigned& tex_h,
-	const bool sampleNearest)
+	const bool sampleNearest,
+	const MipMode mipMode,
+	const PixFormat pixFormat,
+	GLenum* const format,
+	const HeightDesc* const heightDesc)
 {
 	assert(0 != tex_name);
 	assert(0 != filename);
 	assert(0 != tex_w && 0 != tex_h);
 
-	const size_t pix_size = sizeof(pix);
-	const pix* start = 0;
-	size_t fileSize;
+	if (0 != format)
+		*format = GL_RGB;
 
-	// provide some guardband as pixels are of non-word-multiple size
-	scoped_ptr< pix, generic_free > tex_src(
-		reinterpret_cast< pix* >(get_buffer_from_file(filename, fileSize, integral_size(sizeof(pix)))));
+	TexCaps caps;
+	queryTexCaps(caps);
 
-	if (0 != tex_src() && fill_from_file(tex_src(), tex_w, tex_h, fileSize)) {
-		fprintf(stdout, "texture bitmap '%s' ", filename);
-		const size_t header_size = sizeof(uint32_t[2]);
+	tex_source src;
+
+	// upon failure to use the file, default to checker below
+	if (src.open(filename, mipMode, pixFormat, heightDesc, caps)) {
+		src.prepare();
+
+		if (!uploadTexture2D(tex_name, src, sampleNearest, caps.storage))
+			return false;
 
-		start = reinterpret_cast< pix*>(
-			reinterpret_cast< uint8_t* >(tex_src()) + header_size);
+		tex_w = src.w;
+		tex_h = src.h;
+
+		if (0 != format)
+			*format = src.base_format;
+
+		return true;
 	}
-	else { // default to checker texture
-		const size_t tex_size = tex_w * tex_h * pix_size;
 
-		// provide some guardband as pixels are of non-word-multiple size
-		scoped_ptr< pix, generic_free > chk_src(
-			reinterpret_cast< pix* >(malloc(next_multiple_of_pix_integral(tex_size))));
+	const size_t tex_size = tex_w * tex_h * sizeof(pix);
 
-		if (0 == chk_src()) {
-			fprintf(stderr, "%s failed to allocate texture checker\n", __FUNCTION__);
-			return false;
-		}
+	// provide some guardband as pixels are of non-word-multiple size
+	scoped_ptr< pix, generic_free > alloc(
+		reinterpret_cast< pix* >(malloc(next_multiple_of_pix_integral(tex_size))));
 
-		fill_with_checker(chk_src(), tex_w * pix_size, tex_w, tex_h);
-		fprintf(stdout, "texture checker ");
+	if (0 == alloc()) {
+		fprintf(stderr, "%s failed to allocate texture checker\n", __FUNCTION__);
+		return false;
+	}
+
+	fill_with_checker(alloc(), tex_w * sizeof(pix), tex_w, tex_h);
+	fprintf(stdout, "texture checker ");
 
-		start = chk_src();
-		tex_src.swap(chk_src);
+	return setupTexture2D(tex_name, alloc(), tex_w, tex_h, sampleNearest);
+}
+
+unsigned textureFormatComponents(
+	const GLenum format)
+{
+	switch (format) {
+	case GL_COMPRESSED_RG11_EAC:
+	case GL_RG:
+		return 2;
+	case GL_RGBA:
+		return 4;
 	}
 
-	return setupTexture2D(tex_name, start, tex_w, tex_h, sampleNearest);
+	return 3;
 }
 
 } // namespace util
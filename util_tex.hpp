@@ -2,6 +2,12 @@
 #define util_tex_H__
 
 #include <stdint.h>
+#include <vector>
+#include "scoped.hpp"
+#include "util_file.hpp"
+#include "util_mip.hpp"
+#include "util_pix.hpp"
+#include "util_height.hpp"
 #if PLATFORM_GL
 	#include <GL/gl.h>
 #else
@@ -32,12 +38,126 @@ bool setupTexture2D(
 	const unsigned tex_h,
 	const bool sampleNearest = false);
 
+// load a .raw texture along with its mip chain, or produce the chain if the file carries none,
+// filtering per the specified mode, and convert it to the specified pixel format, RG88 falling back
+// to RGB888 where unsupported; a .raw of an 8-bit height map makes for a normal map, derived per the
+// optional height parameters; alternatively, load a KTX texture of ETC2 RGB8 or EAC RG11, or of
+// uncompressed RGB888, RGBA8888, RGB565 or RG88, as supported by the GL, and as stored; default
+// to a checker texture of the specified dimensions; the format of the outcome is optionally returned
 bool setupTexture2D(
 	const GLuint tex_name,
 	const char* const filename,
 	unsigned& tex_w,
 	unsigned& tex_h,
-	const bool sampleNearest = false);
+	const bool sampleNearest = false,
+	const MipMode mipMode = MIP_MODE_LINEAR,
+	const PixFormat pixFormat = PIX_FORMAT_RGB888,
+	GLenum* const format = 0,
+	const HeightDesc* const heightDesc = 0);
+
+// number of components of a texture format returned by setupTexture2D; normal maps of two carry
+// just x and y, leaving z to reconstruct
+unsigned textureFormatComponents(
+	const GLenum format);
+
+// GL capabilities texture loading depends on; query with a current context
+struct TexCaps {
+	bool storage;		// immutable storage, pixel unpack buffers and fences, as of ES3
+	bool npot_mipmap;	// mips of NPOT textures
+	bool etc2;			// ETC2 and EAC
+	bool rg;			// two-component textures
+};
+
+void queryTexCaps(
+	TexCaps& caps);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// texture file as setupTexture2D takes it, parsed into its layout in the GL: opening the file only
+// parses it, preparing it does the CPU work of height maps and mips, and writing bands of rows of a
+// level produces those in the upload format. Neither preparing nor writing touches the GL, so they
+// can take place off the GL thread, while the GL thread allocates the storage per the layout. A file
+// in the block container of util_lz opens decompressed to the heap, and bands get written from there,
+// not decompressed into their destination directly.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class tex_source : non_copyable
+{
+public:
+	enum {
+		max_levels = 32,
+		band_granularity = 4 // rows in a band are a multiple of this, short of the last band of a level
+	};
+
+	unsigned w;
+	unsigned h;
+	unsigned num_levels;
+	GLenum internal_format;	// sized format for glTexStorage2D, or the compressed format
+	GLenum format;			// of the client data, or zero for compressed data
+	GLenum type;
+	GLenum base_format;		// as setupTexture2D returns it
+	unsigned alignment;		// unpack alignment of rows
+
+	tex_source();
+
+	// parse a .raw or KTX texture for the specified capabilities of the GL; return false if the file
+	// is missing or unusable
+	bool open(
+		const char* const filename,
+		const MipMode mipMode,
+		const PixFormat pixFormat,
+		const HeightDesc* const heightDesc,
+		const TexCaps& caps);
+
+	void close();
+
+	// produce normal maps from height maps and mips missing from the file; idempotent
+	void prepare();
+
+	// byte size of a band of rows of a level, as written
+	size_t band_size(
+		const unsigned level,
+		const unsigned num_rows) const;
+
+	// write a band of rows of a level in the upload format; requires prepare
+	void write_band(
+		const unsigned level,
+		const unsigned first_row,
+		const unsigned num_rows,
+		uint8_t* const dst) const;
+
+	// level data ready for upload as is, or null if the level needs writing; requires prepare
+	const uint8_t* level_data(
+		const unsigned level) const;
+
+private:
+	mapped_file file;
+	std::vector< uint8_t > normal_src;
+	std::vector< uint8_t > mip_src;
+	const uint8_t* level_src[max_levels];	// RGB888 for .raw, as stored for KTX
+	size_t level_stride[max_levels];		// of rows of 4 texels for compressed levels
+	PixFormat pix_format;					// of the upload; RGB888 for KTX
+	MipMode mip_mode;
+	HeightDesc height_desc;
+	bool height;
+	bool ktx;
+	bool compressed;
+	bool prepared;
+
+	bool open_ktx(
+		const TexCaps& caps);
+
+	bool open_raw(
+		const PixFormat pixFormat,
+		const TexCaps& caps);
+};
+
+// allocate storage for a texture of the specified layout and set its sampling; with immutable storage
+// the levels get specified by glTexSubImage2D, otherwise by glTexImage2D; leaves the texture bound
+void allocTexture2D(
+	const GLuint tex_name,
+	const tex_source& src,
+	const bool sampleNearest,
+	const bool storage);
 
 } // namespace util
 
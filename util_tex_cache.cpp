@@ -0,0 +1,235 @@
+#include <stdio.h>
+#include <assert.h>
+
+#include "util_tex_cache.hpp"
+#include "util_tex_stream.hpp"
+
+#ifndef GL_COMPRESSED_RG11_EAC
+#define GL_COMPRESSED_RG11_EAC 0x9272
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2 0x9274
+#endif
+#ifndef GL_RG
+#define GL_RG 0x8227
+#endif
+
+namespace util {
+
+// GPU memory taken by a texture along with its full mip chain, as estimated from its format
+static size_t texture_size(
+	const GLenum format,
+	const PixFormat pixFormat,
+	const unsigned w,
+	const unsigned h)
+{
+	unsigned bits;
+
+	switch (format) {
+	case GL_COMPRESSED_RGB8_ETC2:
+		bits = 4;
+		break;
+	case GL_COMPRESSED_RG11_EAC:
+		bits = 8;
+		break;
+	case GL_RG:
+		bits = 16;
+		break;
+	case GL_RGBA:
+		bits = 32;
+		break;
+	default:
+		bits = PIX_FORMAT_RGB565 == pixFormat ? 16 : 24;
+		break;
+	}
+
+	const size_t num_texels = mip_chain_size(w, h, 0, mip_level_count(w, h)) / 3;
+	return num_texels * bits / 8;
+}
+
+texture_cache::texture_cache(
+	const size_t budget)
+: streamer(0)
+, budget(budget)
+, clock(0)
+{
+	stat.hits = 0;
+	stat.misses = 0;
+	stat.evictions = 0;
+	stat.num_resident = 0;
+	stat.bytes_resident = 0;
+}
+
+texture_cache::handle texture_cache::acquire(
+	const char* const filename,
+	unsigned& tex_w,
+	unsigned& tex_h,
+	const bool sampleNearest,
+	const MipMode mipMode,
+	const PixFormat pixFormat,
+	GLenum* const format,
+	const HeightDesc* const heightDesc)
+{
+	assert(0 != filename);
+
+	size_t vacant = entries.size();
+
+	for (size_t i = 0; i < entries.size(); ++i) {
+		entry& e = entries[i];
+
+		if (0 == e.name) {
+			vacant = i;
+			continue;
+		}
+
+		if (e.filename == filename &&
+			e.mip_mode == mipMode &&
+			e.pix_format == pixFormat &&
+			e.sample_nearest == sampleNearest &&
+			e.height_desc_valid == (0 != heightDesc) &&
+			(0 == heightDesc ||
+				(e.height_desc.strength == heightDesc->strength &&
+				e.height_desc.filter == heightDesc->filter &&
+				e.height_desc.wrap == heightDesc->wrap))) {
+
+			e.ref_count += 1;
+			e.last_use = ++clock;
+			stat.hits += 1;
+
+			tex_w = e.w;
+			tex_h = e.h;
+
+			if (0 != format)
+				*format = e.format;
+
+			return handle(i + 1);
+		}
+	}
+
+	stat.misses += 1;
+
+	GLuint name = 0;
+	GLenum tex_format;
+	glGenTextures(1, &name);
+
+	const bool success = 0 != name && (0 != streamer
+		? streamer->request(name, filename, tex_w, tex_h, sampleNearest, mipMode, pixFormat, &tex_format, heightDesc)
+		: setupTexture2D(name, filename, tex_w, tex_h, sampleNearest, mipMode, pixFormat, &tex_format, heightDesc));
+
+	if (!success) {
+		fprintf(stderr, "%s failed to set up texture '%s'\n", __FUNCTION__, filename);
+		glDeleteTextures(1, &name);
+		return 0;
+	}
+
+	if (entries.size() == vacant)
+		entries.resize(vacant + 1);
+
+	entry& e = entries[vacant];
+	e.filename = filename;
+	e.mip_mode = mipMode;
+	e.pix_format = pixFormat;
+	e.sample_nearest = sampleNearest;
+	e.height_desc_valid = 0 != heightDesc;
+
+	if (0 != heightDesc)
+		e.height_desc = *heightDesc;
+
+	e.name = name;
+	e.w = tex_w;
+	e.h = tex_h;
+	e.format = tex_format;
+	e.size = texture_size(tex_format, pixFormat, tex_w, tex_h);
+	e.ref_count = 1;
+	e.last_use = ++clock;
+
+	stat.num_resident += 1;
+	stat.bytes_resident += e.size;
+
+	// make room for the newcomer among the unreferenced
+	trim();
+
+	if (0 != format)
+		*format = tex_format;
+
+	return handle(vacant + 1);
+}
+
+void texture_cache::release(
+	const handle h)
+{
+	assert(0 != h && h <= entries.size());
+	assert(0 != entries[h - 1].name && 0 != entries[h - 1].ref_count);
+
+	entries[h - 1].ref_count -= 1;
+	trim();
+}
+
+GLuint texture_cache::get_name(
+	const handle h) const
+{
+	assert(0 != h && h <= entries.size());
+
+	return entries[h - 1].name;
+}
+
+void texture_cache::set_budget(
+	const size_t budget)
+{
+	this->budget = budget;
+	trim();
+}
+
+void texture_cache::purge()
+{
+	for (size_t i = 0; i < entries.size(); ++i)
+		if (0 != entries[i].name && 0 == entries[i].ref_count)
+			evict(i);
+}
+
+void texture_cache::evict(
+	const size_t index)
+{
+	entry& e = entries[index];
+
+	assert(0 != e.name && 0 == e.ref_count);
+
+	if (0 != streamer)
+		streamer->cancel(e.name);
+
+	glDeleteTextures(1, &e.name);
+	e.name = 0;
+	e.filename.clear();
+
+	stat.evictions += 1;
+	stat.num_resident -= 1;
+	stat.bytes_resident -= e.size;
+}
+
+// evict unreferenced textures, least recently used first, until within budget
+void texture_cache::trim()
+{
+	while (stat.bytes_resident > budget) {
+		size_t lru = entries.size();
+
+		for (size_t i = 0; i < entries.size(); ++i)
+			if (0 != entries[i].name && 0 == entries[i].ref_count &&
+				(entries.size() == lru || entries[i].last_use < entries[lru].last_use)) {
+
+				lru = i;
+			}
+
+		if (entries.size() == lru)
+			break;
+
+		evict(lru);
+	}
+}
+
+texture_cache& shared_texture_cache()
+{
+	static texture_cache cache;
+	return cache;
+}
+
+} // namespace util
@@ -0,0 +1,119 @@
+#ifndef util_tex_cache_H__
+#define util_tex_cache_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "scoped.hpp"
+#include "util_tex.hpp"
+
+namespace util {
+
+class texture_streamer;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// texture cache atop setupTexture2D: textures are shared by filename and upload parameters, and
+// reference-counted by handle. Textures left unreferenced stay resident for later requests, until
+// the GPU memory they take exceeds the budget of the cache, whereupon the least recently used of them
+// get deleted. Textures belong to the GL context current at their upload; purge the cache before
+// that context goes away. Given a streamer, textures not resident get requested from it, and so have
+// their content uploaded asynchronously.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class texture_cache : non_copyable
+{
+public:
+	typedef unsigned handle; // zero for none
+
+	struct stats {
+		unsigned hits;
+		unsigned misses;
+		unsigned evictions;
+		unsigned num_resident;
+		size_t bytes_resident;
+	};
+
+	explicit texture_cache(
+		const size_t budget = size_t(256) << 20);
+
+	// get a texture by filename, uploading it if not resident, per the semantics of setupTexture2D;
+	// the dimensions are those of the checker default on input, of the texture on output; return a
+	// handle of a newly acquired reference, or zero upon failure
+	handle acquire(
+		const char* const filename,
+		unsigned& tex_w,
+		unsigned& tex_h,
+		const bool sampleNearest = false,
+		const MipMode mipMode = MIP_MODE_LINEAR,
+		const PixFormat pixFormat = PIX_FORMAT_RGB888,
+		GLenum* const format = 0,
+		const HeightDesc* const heightDesc = 0);
+
+	// drop a reference acquired earlier; an unreferenced texture may get evicted past the budget
+	void release(
+		const handle h);
+
+	// GL name of the texture of a handle
+	GLuint get_name(
+		const handle h) const;
+
+	// set the GPU memory budget in bytes, evicting as necessary; referenced textures never get evicted,
+	// so they can exceed the budget
+	void set_budget(
+		const size_t budget);
+
+	size_t get_budget() const {
+		return budget;
+	}
+
+	// delete all unreferenced textures
+	void purge();
+
+	// have textures not resident from the specified streamer, or synchronously for null
+	void set_streamer(
+		texture_streamer* const streamer) {
+		this->streamer = streamer;
+	}
+
+	const stats& get_stats() const {
+		return stat;
+	}
+
+private:
+	struct entry {
+		std::string filename;
+		MipMode mip_mode;
+		PixFormat pix_format;
+		bool sample_nearest;
+		bool height_desc_valid;
+		HeightDesc height_desc;
+
+		GLuint name; // zero for a vacant entry
+		unsigned w;
+		unsigned h;
+		GLenum format;
+		size_t size;
+
+		unsigned ref_count;
+		uint64_t last_use;
+	};
+
+	std::vector< entry > entries;
+	texture_streamer* streamer;
+	size_t budget;
+	uint64_t clock;
+	stats stat;
+
+	void evict(
+		const size_t index);
+
+	void trim();
+};
+
+// process-wide cache, for sharing textures among apps and materials of the same GL context
+texture_cache& shared_texture_cache();
+
+} // namespace util
+
+#endif // util_tex_cache_H__
@@ -0,0 +1,746 @@
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <vector>
+
+#include "util_tex_stream.hpp"
+#include "util_misc.hpp"
+
+namespace util {
+
+// largest dimension of a level
+static unsigned level_dim(
+	const tex_source& src,
+	const unsigned level)
+{
+	const unsigned w = mip_level_dim(src.w, level);
+	const unsigned h = mip_level_dim(src.h, level);
+
+	return w > h ? w : h;
+}
+
+// finest level of the mip tail
+static unsigned tail_level(
+	const tex_source& src)
+{
+	unsigned level = 0;
+
+	while (level + 1 < src.num_levels && level_dim(src, level) > texture_streamer::tail_dim)
+		++level;
+
+	return level;
+}
+
+// whether a level of one texture goes before a level of another: the coarser goes first, and the one
+// of the larger on-screen extent among equals
+static bool goes_first(
+	const unsigned dim_a,
+	const float extent_a,
+	const unsigned dim_b,
+	const float extent_b)
+{
+	return dim_a < dim_b || (dim_a == dim_b && extent_a > extent_b);
+}
+
+texture_streamer::texture_streamer()
+: num_slots(0)
+, slot_size(0)
+, initialized(false)
+, on_demand(false)
+, worker_running(false)
+, worker_quit(false)
+{
+	memset(&caps, 0, sizeof(caps));
+
+	for (unsigned i = 0; i < max_slots; ++i) {
+		slot[i].pbo = 0;
+		slot[i].fence = 0;
+		slot[i].data = 0;
+		slot[i].state = Slot::STATE_FREE;
+	}
+
+	for (unsigned i = 0; i < max_jobs; ++i) {
+		job[i].name = 0;
+		job[i].active = false;
+	}
+
+	pthread_mutex_init(&mutex, 0);
+	pthread_cond_init(&cond, 0);
+}
+
+texture_streamer::~texture_streamer()
+{
+	stopWorker();
+
+	pthread_cond_destroy(&cond);
+	pthread_mutex_destroy(&mutex);
+}
+
+void texture_streamer::stopWorker()
+{
+	if (!worker_running)
+		return;
+
+	pthread_mutex_lock(&mutex);
+	worker_quit = true;
+	pthread_cond_signal(&cond);
+	pthread_mutex_unlock(&mutex);
+
+	pthread_join(worker, 0);
+	worker_running = false;
+}
+
+void* texture_streamer::workerMain(
+	void* arg)
+{
+	reinterpret_cast< texture_streamer* >(arg)->workerLoop();
+	return 0;
+}
+
+void texture_streamer::workerLoop()
+{
+	pthread_mutex_lock(&mutex);
+
+	while (!worker_quit) {
+		unsigned slot_index;
+		unsigned job_index;
+
+		if (!claimWork(slot_index, job_index)) {
+			pthread_cond_wait(&cond, &mutex);
+			continue;
+		}
+
+		// claimed slots and busy jobs are the worker's; work without the lock
+		pthread_mutex_unlock(&mutex);
+		doWork(slot_index, job_index);
+		pthread_mutex_lock(&mutex);
+
+		job[job_index].busy = false;
+		job[job_index].prepared = true;
+
+		if (max_slots != slot_index)
+			slot[slot_index].state = Slot::STATE_FILLED;
+	}
+
+	pthread_mutex_unlock(&mutex);
+}
+
+bool texture_streamer::claimWork(
+	unsigned& slot_index,
+	unsigned& job_index)
+{
+	// re-specification: prepare the first job unprepared
+	if (0 == num_slots) {
+		for (unsigned i = 0; i < max_jobs; ++i) {
+			Job& jb = job[i];
+
+			if (jb.active && !jb.cancelled && !jb.prepared && !jb.busy) {
+				jb.busy = true;
+				slot_index = max_slots;
+				job_index = i;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	unsigned s = 0;
+
+	while (s < num_slots && Slot::STATE_MAPPED != slot[s].state)
+		++s;
+
+	if (num_slots == s)
+		return false;
+
+	// the next band of the coarsest level due goes first
+	unsigned j = max_jobs;
+
+	for (unsigned i = 0; i < max_jobs; ++i) {
+		const Job& jb = job[i];
+
+		if (!jb.active || jb.cancelled || jb.written || jb.next_level < jb.due_level)
+			continue;
+
+		if (max_jobs == j || goes_first(
+				level_dim(jb.src, jb.next_level), jb.extent,
+				level_dim(job[j].src, job[j].next_level), job[j].extent)) {
+
+			j = i;
+		}
+	}
+
+	if (max_jobs == j)
+		return false;
+
+	Job& jb = job[j];
+	const tex_source& src = jb.src;
+	const unsigned level_h = mip_level_dim(src.h, jb.next_level);
+
+	// as many rows as fit, in multiples of the band granularity
+	const size_t granule_size = src.band_size(jb.next_level, tex_source::band_granularity);
+	const unsigned rows_fit = unsigned(slot_size / granule_size) * tex_source::band_granularity;
+	const unsigned num_rows = level_h - jb.next_row < rows_fit ? level_h - jb.next_row : rows_fit;
+
+	slot[s].state = Slot::STATE_WRITING;
+	slot[s].job = j;
+	slot[s].level = jb.next_level;
+	slot[s].first_row = jb.next_row;
+	slot[s].num_rows = num_rows;
+
+	jb.busy = true;
+	jb.num_filled += 1;
+	jb.next_row += num_rows;
+
+	if (level_h == jb.next_row) {
+		jb.next_row = 0;
+
+		if (0 == jb.next_level)
+			jb.written = true;
+		else
+			jb.next_level -= 1;
+	}
+
+	slot_index = s;
+	job_index = j;
+	return true;
+}
+
+void texture_streamer::doWork(
+	const unsigned slot_index,
+	const unsigned job_index)
+{
+	tex_source& src = job[job_index].src;
+
+	// the first work on a texture is its CPU work
+	src.prepare();
+
+	if (max_slots == slot_index)
+		return;
+
+	const Slot& s = slot[slot_index];
+	src.write_band(s.level, s.first_row, s.num_rows, s.data);
+}
+
+bool texture_streamer::init(
+	const size_t slot_size,
+	const unsigned num_slots)
+{
+	assert(!initialized);
+	assert(0 != slot_size && 0 != num_slots);
+
+	queryTexCaps(caps);
+
+	this->slot_size = slot_size;
+	this->num_slots = 0;
+
+#if PLATFORM_GLES
+	if (caps.storage) {
+		this->num_slots = num_slots < unsigned(max_slots) ? num_slots : unsigned(max_slots);
+
+		for (unsigned i = 0; i < this->num_slots; ++i) {
+			glGenBuffers(1, &slot[i].pbo);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot[i].pbo);
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, slot_size, 0, GL_STREAM_DRAW);
+
+			slot[i].fence = 0;
+			slot[i].data = 0;
+			slot[i].state = Slot::STATE_FREE;
+		}
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+#endif
+	if (reportGLError(stderr)) {
+		deinit();
+		return false;
+	}
+
+	// should the worker fail to spawn, update works in line
+	worker_quit = false;
+	worker_running = 0 == pthread_create(&worker, 0, workerMain, this);
+	initialized = true;
+
+	if (0 != this->num_slots)
+		fprintf(stdout, "texture streamer: %u buffers of %u bytes\n", this->num_slots, unsigned(slot_size));
+	else
+		fprintf(stdout, "texture streamer: re-specification\n");
+
+	return true;
+}
+
+void texture_streamer::deinit()
+{
+	stopWorker();
+
+#if PLATFORM_GLES
+	for (unsigned i = 0; i < num_slots; ++i) {
+		Slot& s = slot[i];
+
+		if (0 != s.data) {
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, s.pbo);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		}
+
+		if (0 != s.fence)
+			glDeleteSync(s.fence);
+
+		glDeleteBuffers(1, &s.pbo);
+
+		s.pbo = 0;
+		s.fence = 0;
+		s.data = 0;
+		s.state = Slot::STATE_FREE;
+	}
+
+	if (0 != num_slots)
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+#endif
+	for (unsigned i = 0; i < max_jobs; ++i)
+		if (job[i].active)
+			retireJob(job[i]);
+
+	num_slots = 0;
+	initialized = false;
+}
+
+bool texture_streamer::request(
+	const GLuint tex_name,
+	const char* const filename,
+	unsigned& tex_w,
+	unsigned& tex_h,
+	const bool sampleNearest,
+	const MipMode mipMode,
+	const PixFormat pixFormat,
+	GLenum* const format,
+	const HeightDesc* const heightDesc)
+{
+	assert(0 != tex_name);
+	assert(0 != filename);
+
+	unsigned j = 0;
+
+	if (initialized) {
+		pthread_mutex_lock(&mutex);
+
+		while (j < max_jobs && job[j].active)
+			++j;
+
+		pthread_mutex_unlock(&mutex);
+	}
+
+	// vacant jobs are not the worker's
+	if (!initialized || max_jobs == j ||
+		!job[j].src.open(filename, mipMode, pixFormat, heightDesc, caps) ||
+		(0 != num_slots && job[j].src.band_size(0, tex_source::band_granularity) > slot_size)) {
+
+		if (initialized && max_jobs != j)
+			job[j].src.close();
+
+		return setupTexture2D(tex_name, filename, tex_w, tex_h, sampleNearest, mipMode, pixFormat, format, heightDesc);
+	}
+
+	const tex_source& src = job[j].src;
+
+	allocTexture2D(tex_name, src, sampleNearest, 0 != num_slots);
+
+#if PLATFORM_GLES
+	// nothing is resident yet; the smallest level goes first
+	if (0 != num_slots)
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, src.num_levels - 1);
+
+#endif
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	if (reportGLError(stderr)) {
+		job[j].src.close();
+		return false;
+	}
+
+	tex_w = src.w;
+	tex_h = src.h;
+
+	if (0 != format)
+		*format = src.base_format;
+
+	Job& jb = job[j];
+
+	jb.resident_level = src.num_levels;
+	memset(jb.level_rows, 0, sizeof(jb.level_rows));
+
+	pthread_mutex_lock(&mutex);
+
+	jb.name = tex_name;
+	jb.active = true;
+	jb.cancelled = false;
+	jb.busy = false;
+	jb.prepared = false;
+	jb.written = false;
+	jb.next_level = src.num_levels - 1;
+	jb.next_row = 0;
+	jb.num_filled = 0;
+	jb.due_level = on_demand ? tail_level(src) : 0;
+	jb.extent = 0.f;
+
+	pthread_cond_signal(&cond);
+	pthread_mutex_unlock(&mutex);
+	return true;
+}
+
+void texture_streamer::set_demand(
+	const GLuint tex_name,
+	const float extent)
+{
+	if (!(0.f < extent))
+		return;
+
+	pthread_mutex_lock(&mutex);
+
+	for (unsigned i = 0; i < max_jobs; ++i) {
+		Job& jb = job[i];
+
+		if (!jb.active || jb.name != tex_name)
+			continue;
+
+		// the coarsest level of no fewer texels across than pixels
+		const float ratio = float(jb.src.w) / extent;
+		unsigned level = 1.f < ratio ? unsigned(floorf(log2f(ratio))) : 0;
+
+		if (level >= jb.src.num_levels)
+			level = jb.src.num_levels - 1;
+
+		if (level < jb.due_level)
+			jb.due_level = level;
+
+		if (extent > jb.extent)
+			jb.extent = extent;
+	}
+
+	pthread_cond_signal(&cond);
+	pthread_mutex_unlock(&mutex);
+}
+
+void texture_streamer::cancel(
+	const GLuint tex_name)
+{
+	pthread_mutex_lock(&mutex);
+
+	for (unsigned i = 0; i < max_jobs; ++i)
+		if (job[i].active && job[i].name == tex_name)
+			job[i].cancelled = true;
+
+	pthread_mutex_unlock(&mutex);
+}
+
+bool texture_streamer::is_pending(
+	const GLuint tex_name) const
+{
+	bool pending = false;
+
+	pthread_mutex_lock(&mutex);
+
+	for (unsigned i = 0; i < max_jobs && !pending; ++i)
+		pending = job[i].active && !job[i].cancelled && job[i].name == tex_name;
+
+	pthread_mutex_unlock(&mutex);
+	return pending;
+}
+
+void texture_streamer::retireJob(
+	Job& j)
+{
+	j.src.close();
+	j.name = 0;
+	j.active = false;
+}
+
+bool texture_streamer::uploadBand(
+	Slot& s,
+	const bool cancelled)
+{
+#if PLATFORM_GLES
+	Job& j = job[s.job];
+	const tex_source& src = j.src;
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, s.pbo);
+
+	// an unmap can report the content lost, in which case the band goes missing
+	const bool intact = GL_FALSE != glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	s.data = 0;
+
+	if (!intact)
+		fprintf(stderr, "%s lost a band of texture %u\n", __FUNCTION__, j.name);
+
+	if (cancelled || !intact)
+		return false;
+
+	const unsigned w = mip_level_dim(src.w, s.level);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, j.name);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, src.alignment);
+
+	if (0 == src.format)
+		glCompressedTexSubImage2D(GL_TEXTURE_2D, s.level, 0, s.first_row, w, s.num_rows, src.internal_format,
+			src.band_size(s.level, s.num_rows), 0);
+	else
+		glTexSubImage2D(GL_TEXTURE_2D, s.level, 0, s.first_row, w, s.num_rows, src.format, src.type, 0);
+
+	residentBand(j, s.level, s.num_rows);
+
+	s.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	return true;
+
+#else
+	return false;
+
+#endif
+}
+
+void texture_streamer::residentBand(
+	Job& j,
+	const unsigned level,
+	const unsigned num_rows)
+{
+	const unsigned prior = j.resident_level;
+
+	j.level_rows[level] += num_rows;
+
+	while (0 != j.resident_level &&
+		j.level_rows[j.resident_level - 1] == mip_level_dim(j.src.h, j.resident_level - 1)) {
+
+		j.resident_level -= 1;
+	}
+
+#if PLATFORM_GLES
+	// sampling past the uploads sees them, as per the GL command order
+	if (prior != j.resident_level)
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, j.resident_level);
+
+#endif
+}
+
+void texture_streamer::respecify(
+	Job& j,
+	const unsigned level)
+{
+	const tex_source& src = j.src;
+	std::vector< uint8_t > scratch;
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, j.name);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, src.alignment);
+
+	// the specified level becomes the base of the chain
+	for (unsigned i = level; i < src.num_levels; ++i) {
+		const unsigned w = mip_level_dim(src.w, i);
+		const unsigned h = mip_level_dim(src.h, i);
+		const size_t size = src.band_size(i, h);
+		const uint8_t* data = src.level_data(i);
+
+		if (0 == data) {
+			scratch.resize(size);
+			src.write_band(i, 0, h, &scratch.front());
+			data = &scratch.front();
+		}
+
+		if (0 == src.format)
+			glCompressedTexImage2D(GL_TEXTURE_2D, i - level, src.internal_format, w, h, 0, size, data);
+		else
+			glTexImage2D(GL_TEXTURE_2D, i - level, src.format, w, h, 0, src.format, src.type, data);
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	j.resident_level = level;
+}
+
+void texture_streamer::update()
+{
+	if (!initialized)
+		return;
+
+	if (0 == num_slots) {
+		/////////////////////////////////////////////////////////////////
+		// re-specification: of the prepared jobs, the one of the coarsest level due -- first the tail, then
+		// the demand -- one per frame
+
+		pthread_mutex_lock(&mutex);
+
+		unsigned j = max_jobs;
+		unsigned j_level = 0;
+
+		for (unsigned i = 0; i < max_jobs; ++i) {
+			Job& jb = job[i];
+
+			if (jb.active && jb.cancelled && !jb.busy)
+				retireJob(jb);
+
+			if (!jb.active || jb.cancelled || !jb.prepared || jb.resident_level <= jb.due_level)
+				continue;
+
+			const unsigned tail = tail_level(jb.src);
+			const unsigned level = jb.src.num_levels == jb.resident_level && tail > jb.due_level ? tail : jb.due_level;
+
+			if (max_jobs == j || goes_first(
+					level_dim(jb.src, level), jb.extent,
+					level_dim(job[j].src, j_level), job[j].extent)) {
+
+				j = i;
+				j_level = level;
+			}
+		}
+
+		pthread_mutex_unlock(&mutex);
+
+		// prepared jobs are the GL thread's
+		if (max_jobs != j) {
+			respecify(job[j], j_level);
+
+			if (0 == j_level) {
+				pthread_mutex_lock(&mutex);
+				retireJob(job[j]);
+				pthread_mutex_unlock(&mutex);
+			}
+		}
+	}
+
+#if PLATFORM_GLES
+	else {
+		bool bound = false;
+
+		for (unsigned i = 0; i < num_slots; ++i) {
+			Slot& s = slot[i];
+
+			pthread_mutex_lock(&mutex);
+			const Slot::State state = s.state;
+			pthread_mutex_unlock(&mutex);
+
+			// buffers the GL is done with go back to the ring
+			if (Slot::STATE_IN_FLIGHT == state) {
+				const GLenum res = glClientWaitSync(s.fence, 0, 0);
+
+				if (GL_ALREADY_SIGNALED != res && GL_CONDITION_SATISFIED != res)
+					continue;
+
+				glDeleteSync(s.fence);
+				s.fence = 0;
+
+				pthread_mutex_lock(&mutex);
+				s.state = Slot::STATE_FREE;
+				pthread_mutex_unlock(&mutex);
+				continue;
+			}
+
+			if (Slot::STATE_FILLED != state)
+				continue;
+
+			// filled slots are the GL thread's; their jobs stay put until all their bands get uploaded
+			pthread_mutex_lock(&mutex);
+			const bool cancelled = job[s.job].cancelled;
+			pthread_mutex_unlock(&mutex);
+
+			const bool in_flight = uploadBand(s, cancelled);
+			bound = true;
+
+			pthread_mutex_lock(&mutex);
+			s.state = in_flight ? Slot::STATE_IN_FLIGHT : Slot::STATE_FREE;
+
+			Job& j = job[s.job];
+			j.num_filled -= 1;
+
+			if (0 == j.num_filled && !j.busy && (j.written || j.cancelled))
+				retireJob(j);
+
+			pthread_mutex_unlock(&mutex);
+		}
+
+		/////////////////////////////////////////////////////////////////
+		// retire cancelled jobs out of the ring, and map free buffers for bands due
+
+		pthread_mutex_lock(&mutex);
+		bool pending = false;
+
+		for (unsigned i = 0; i < max_jobs; ++i) {
+			Job& j = job[i];
+
+			if (j.active && j.cancelled && 0 == j.num_filled && !j.busy)
+				retireJob(j);
+
+			pending = pending || (j.active && !j.cancelled && !j.written && j.next_level >= j.due_level);
+		}
+
+		pthread_mutex_unlock(&mutex);
+
+		for (unsigned i = 0; i < num_slots && pending; ++i) {
+			Slot& s = slot[i];
+
+			pthread_mutex_lock(&mutex);
+			const Slot::State state = s.state;
+			pthread_mutex_unlock(&mutex);
+
+			if (Slot::STATE_FREE != state)
+				continue;
+
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, s.pbo);
+			bound = true;
+
+			// the fence of the buffer has signaled, so there is nothing to synchronize with
+			void* const data = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, slot_size,
+				GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+
+			if (0 == data)
+				break;
+
+			pthread_mutex_lock(&mutex);
+			s.data = reinterpret_cast< uint8_t* >(data);
+			s.state = Slot::STATE_MAPPED;
+			pthread_mutex_unlock(&mutex);
+		}
+
+		// client-memory uploads elsewhere need the unpack buffer unbound
+		if (bound) {
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			glBindTexture(GL_TEXTURE_2D, 0);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		}
+	}
+
+#endif
+	pthread_mutex_lock(&mutex);
+	pthread_cond_signal(&cond);
+	pthread_mutex_unlock(&mutex);
+
+	if (worker_running)
+		return;
+
+	// no worker -- work in line
+	unsigned slot_index;
+	unsigned job_index;
+
+	pthread_mutex_lock(&mutex);
+
+	while (claimWork(slot_index, job_index)) {
+		doWork(slot_index, job_index);
+
+		job[job_index].busy = false;
+		job[job_index].prepared = true;
+
+		if (max_slots != slot_index)
+			slot[slot_index].state = Slot::STATE_FILLED;
+	}
+
+	pthread_mutex_unlock(&mutex);
+}
+
+texture_streamer& shared_texture_streamer()
+{
+	static texture_streamer streamer;
+	return streamer;
+}
+
+} // namespace util
@@ -0,0 +1,187 @@
+#ifndef util_tex_stream_H__
+#define util_tex_stream_H__
+
+#include <stddef.h>
+#include <pthread.h>
+#include "scoped.hpp"
+#include "util_tex.hpp"
+#if PLATFORM_GL
+	#include <GL/gl.h>
+#else
+	#include <GLES3/gl3.h>
+#endif
+
+namespace util {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// asynchronous texture uploads: a request parses the texture file and sets up the texture right away,
+// while the content follows level by level, smallest levels first, the texture sampling only the levels
+// already resident. On GLES3 the texture gets immutable storage, its content goes in bands of rows that
+// a worker thread produces straight into a ring of pixel unpack buffers mapped unsynchronized, and the
+// per-frame update issues the uploads from those buffers, fencing each buffer before it goes back to the
+// worker; GL_TEXTURE_BASE_LEVEL tracks the resident levels. On GLES2 the worker does the CPU work of the
+// texture, and the update re-specifies the texture from the finest level due, down, once per frame.
+//
+// on-demand textures stream past their mip tail only as far as the screen calls for: their users report
+// the on-screen extent of the texture, which decides the finest level due, while the coarsest pending
+// levels of all textures go first, and the largest extents among equals.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class texture_streamer : non_copyable
+{
+public:
+	enum {
+		max_slots = 8,
+		max_jobs = 64,
+		tail_dim = 32 // largest dimension of the levels of the mip tail
+	};
+
+	texture_streamer();
+	~texture_streamer();
+
+	// set up the worker, and on GLES3 a ring of the specified number of buffers of the specified size;
+	// requires a current GL context -- return false upon failure
+	bool init(
+		const size_t slot_size = size_t(1) << 20,
+		const unsigned num_slots = 4);
+
+	// drop pending content and release the ring; requires the context of init
+	void deinit();
+
+	// have subsequent requests stream on demand, as per set_demand, or in full
+	void set_on_demand(
+		const bool on_demand) {
+		this->on_demand = on_demand;
+	}
+
+	// set up a texture per the semantics of setupTexture2D, its content to follow by update; textures
+	// whose files cannot stream, and all textures short of init or past max_jobs, upload synchronously
+	bool request(
+		const GLuint tex_name,
+		const char* const filename,
+		unsigned& tex_w,
+		unsigned& tex_h,
+		const bool sampleNearest = false,
+		const MipMode mipMode = MIP_MODE_LINEAR,
+		const PixFormat pixFormat = PIX_FORMAT_RGB888,
+		GLenum* const format = 0,
+		const HeightDesc* const heightDesc = 0);
+
+	// report the on-screen extent in pixels across which the full width of a texture maps; the finest
+	// level due is the one of no more texels than pixels across; demand never decreases
+	void set_demand(
+		const GLuint tex_name,
+		const float extent);
+
+	// drop the pending content of a texture, e.g. before its deletion
+	void cancel(
+		const GLuint tex_name);
+
+	// upload the content the worker has produced, recycle the buffers the GL is done with, and hand free
+	// buffers to the worker; call once per frame
+	void update();
+
+	// whether a texture has content yet to upload
+	bool is_pending(
+		const GLuint tex_name) const;
+
+private:
+	// buffer of the ring
+	struct Slot
+	{
+		enum State {
+			STATE_FREE,
+			STATE_MAPPED,		// awaiting a band
+			STATE_WRITING,		// owned by the worker
+			STATE_FILLED,		// awaiting upload
+			STATE_IN_FLIGHT,	// uploading, as per the fence
+
+			STATE_FORCE_UINT = -1U
+		};
+
+		GLuint pbo;
+		GLsync fence;
+		uint8_t* data;
+		State state;
+
+		unsigned job;
+		unsigned level;
+		unsigned first_row;
+		unsigned num_rows;
+	};
+
+	// texture with content yet to upload
+	struct Job
+	{
+		tex_source src;
+		GLuint name;
+		bool active;
+		bool cancelled;
+		bool busy;				// source in use by the worker
+		bool prepared;			// source prepared by the worker
+		bool written;			// all bands handed out
+		unsigned next_level;	// of the next band; levels go from the smallest up
+		unsigned next_row;
+		unsigned num_filled;	// bands in the ring yet to upload
+		unsigned due_level;		// finest level due
+		float extent;			// on-screen extent, as of the largest demand
+
+		// of the GL thread
+		unsigned resident_level;	// finest level resident; num_levels for none
+		unsigned level_rows[tex_source::max_levels]; // rows uploaded per level
+	};
+
+	Slot slot[max_slots];
+	Job job[max_jobs];
+	unsigned num_slots;	// zero for re-specification
+	size_t slot_size;
+	TexCaps caps;
+	bool initialized;
+	bool on_demand;
+
+	pthread_t worker;
+	mutable pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	bool worker_running;
+	bool worker_quit;
+
+	static void* workerMain(void* arg);
+	void workerLoop();
+	void stopWorker();
+
+	// claim work for the worker: a band to write into a mapped slot, or else a job to prepare for
+	// re-specification; return false if there is none
+	bool claimWork(
+		unsigned& slot_index,
+		unsigned& job_index);
+
+	void doWork(
+		const unsigned slot_index,
+		const unsigned job_index);
+
+	// upload a filled band, unless cancelled; return whether the slot went in flight
+	bool uploadBand(
+		Slot& s,
+		const bool cancelled);
+
+	// note the upload of a band, and have the texture sample the levels resident
+	void residentBand(
+		Job& j,
+		const unsigned level,
+		const unsigned num_rows);
+
+	// re-specify a texture from the specified level down
+	void respecify(
+		Job& j,
+		const unsigned level);
+
+	void retireJob(
+		Job& j);
+};
+
+// process-wide streamer, to go along with the process-wide texture cache
+texture_streamer& shared_texture_streamer();
+
+} // namespace util
+
+#endif // util_tex_stream_H__